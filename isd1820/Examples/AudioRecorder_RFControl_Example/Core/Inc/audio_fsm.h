@@ -0,0 +1,125 @@
+/**
+ * audio_fsm.h
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+Remote-controlled audio flow state machine
+----------------------------------------------------------------------
+Hierarchical state machine driving the ISD1820 from RF buttons and
+driver completion events. Transitions live in a const [state][event]
+table (flash), so dispatch is one table lookup, plus at most one lookup
+in the parent state when the child does not handle the event.
+
+	IDLE          A: record 10s, then play 8s -> QUEUED
+	              B: play 5s                  -> PLAYING
+	              C: listen for voice         -> LISTENING
+	              D: feed through on          -> FEEDTHROUGH
+	ACTIVE        C: cancel                   -> IDLE
+	(parent)      aborted, driver idle        -> IDLE
+	  RECORDING   B: queue a 5s play          -> QUEUED
+	              record done                 -> IDLE
+	  QUEUED      record done: play queued    -> PLAYING
+	  PLAYING     B: restart 5s play          -> PLAYING
+	              C: record 10s (preempts)    -> RECORDING
+	              D: play the whole message   -> PLAYING
+	              play done                   -> IDLE
+	  LISTENING   voice: record, 10s at most  -> VOICE
+	              C: stop listening           -> IDLE
+	  VOICE       voice ended: stop recording -> VOICE
+	              record done                 -> IDLE
+	              C: cancel                   -> IDLE
+	FEEDTHROUGH   D: feed through off         -> IDLE
+
+LISTENING keeps the ADC capture and the voice activity detector running
+(see recorder.h and vad.h), whose voice start and end events hold REC
+for as long as someone speaks, plus the detector hangover, instead of
+the whole 10s.
+
+Events not listed are ignored. FSM_Dispatch() must only be called from
+one context (the scheduler); ISRs post their events through it. No
+action waits: timed operations, the PE pulse included, run on the
+ISD1820 async timer, so a dispatch takes microseconds.
+----------------------------------------------------------------------
+ */
+#ifndef AUDIO_FSM_H
+#define AUDIO_FSM_H
+
+/* C++ detection */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stm32f4xx_hal.h"
+
+typedef enum {
+	FSM_STATE_IDLE = 0,
+	FSM_STATE_ACTIVE, //parent of RECORDING, QUEUED, PLAYING, LISTENING and VOICE, never current
+	FSM_STATE_RECORDING,
+	FSM_STATE_QUEUED, //recording, with a play queued behind it
+	FSM_STATE_PLAYING,
+	FSM_STATE_FEEDTHROUGH,
+	FSM_STATE_LISTENING, //capturing, waiting for voice
+	FSM_STATE_VOICE,     //recording while voice is active
+	FSM_STATE_COUNT,
+	FSM_STATE_NONE = FSM_STATE_COUNT
+} FSM_StateTypeDef;
+
+typedef enum {
+	FSM_EVENT_BUTTON_A = 0,
+	FSM_EVENT_BUTTON_B,
+	FSM_EVENT_BUTTON_C,
+	FSM_EVENT_BUTTON_D,
+	FSM_EVENT_RECORD_DONE,
+	FSM_EVENT_PLAY_DONE,
+	FSM_EVENT_ABORTED,
+	FSM_EVENT_VOICE_START,
+	FSM_EVENT_VOICE_END,
+	FSM_EVENT_COUNT,
+	FSM_EVENT_NONE = FSM_EVENT_COUNT
+} FSM_EventTypeDef;
+
+void FSM_Init(void);
+/**
+ * @brief  Enters IDLE and selects the ISD1820 preemption policy the table relies on.
+ * @retval None
+ */
+
+FSM_StateTypeDef FSM_Dispatch(FSM_EventTypeDef event);
+/**
+ * @brief  Runs the transition for {event} in the current state.
+ * @note   If the transition action fails (ie. the driver rejects the request), the state does not change.
+ * @param  event: Event to process.
+ * @retval New current state.
+ */
+
+FSM_StateTypeDef FSM_GetState(void);
+/**
+ * @brief  Returns the current state.
+ * @retval Current state.
+ */
+
+FSM_EventTypeDef FSM_EventFromStatus(uint32_t status);
+/**
+ * @brief  Maps the status word of a completed ISD1820 operation to its completion event.
+ * @param  status: Status word passed to ISD1820_OperationCpltCallback().
+ * @retval FSM_EVENT_RECORD_DONE, FSM_EVENT_PLAY_DONE or FSM_EVENT_NONE (pauses).
+ */
+
+/* C++ detection */
+#ifdef __cplusplus
+}
+#endif
+
+#endif
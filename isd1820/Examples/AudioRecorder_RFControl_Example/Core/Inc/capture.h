@@ -0,0 +1,108 @@
+/**
+ * capture.h
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+ADC audio capture
+----------------------------------------------------------------------
+ADC1 samples the microphone line on PA1 (ADC1_IN1) on every TIM2 update
+(TRGO), at CAPTURE_SAMPLE_RATE. DMA2 Stream0 runs in double-buffer mode
+over a ring of CAPTURE_BLOCKS blocks: each time DMA finishes one block
+and moves on to the other memory register, the interrupt points the
+finished register to the next free block of the ring. The CPU never
+copies samples and only ever touches complete blocks.
+
+The ring is single-producer (DMA interrupt) single-consumer (main loop)
+and lock-free: the interrupt only advances the filled count, the
+consumer only advances the released count. If the consumer falls
+CAPTURE_BLOCKS - 2 blocks behind, DMA is pointed to a scratch block and
+the audio is dropped and counted, never overwritten under the consumer.
+
+The ADC is configured through its registers: the HAL ADC module is not
+part of this project.
+
+Host/Sim/capture_sim plays a WAV file through the capture, the recorder
+and the flash writer, and measures the main loop time it takes.
+----------------------------------------------------------------------
+ */
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+/* C++ detection */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stm32f4xx_hal.h"
+
+#define CAPTURE_SAMPLE_RATE 16000U //Hz, set by the TIM2 period
+#define CAPTURE_BLOCK_SIZE  256U   //samples, 16ms at 16kHz
+#define CAPTURE_BLOCKS      8U     //must be a power of two
+
+void CAPTURE_Init(TIM_HandleTypeDef* tim);
+/**
+ * @brief  Configures PA1, ADC1 and its DMA stream. Sampling starts with CAPTURE_Start().
+ * @param  tim: Timer whose TRGO (update) triggers the conversions: TIM2.
+ * @retval None
+ */
+
+HAL_StatusTypeDef CAPTURE_Start(void);
+/**
+ * @brief  Empties the ring and starts sampling.
+ * @retval HAL_OK, or HAL_BUSY if already running.
+ */
+
+void CAPTURE_Stop(void);
+/**
+ * @brief  Stops sampling. Blocks already captured stay readable.
+ * @retval None
+ */
+
+int16_t* CAPTURE_GetBlock(void);
+/**
+ * @brief  Returns the oldest complete block as Q15 samples, converted in place. Main loop context only.
+ * @retval CAPTURE_BLOCK_SIZE samples, valid until CAPTURE_ReleaseBlock(), or NULL if no block is ready.
+ */
+
+void CAPTURE_ReleaseBlock(void);
+/**
+ * @brief  Gives the block returned by CAPTURE_GetBlock() back to DMA.
+ * @retval None
+ */
+
+uint32_t CAPTURE_GetBacklog(void);
+/**
+ * @brief  Returns how many complete blocks wait for the consumer. CAPTURE_BLOCKS - 2 is the overrun limit.
+ * @retval Block count.
+ */
+
+uint32_t CAPTURE_GetOverruns(void);
+/**
+ * @brief  Returns how many blocks were dropped because the consumer was too slow.
+ * @retval Dropped block count.
+ */
+
+void CAPTURE_BlockCpltCallback(void);
+/**
+ * @brief  Called from the DMA interrupt every time a block is complete.
+ * @retval None
+ */
+
+/* C++ detection */
+#ifdef __cplusplus
+}
+#endif
+
+#endif
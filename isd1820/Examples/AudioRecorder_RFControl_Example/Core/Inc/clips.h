@@ -0,0 +1,145 @@
+/**
+ * clips.h
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+Flash clip library
+----------------------------------------------------------------------
+A read-only image of audio clips in flash sector 5 (0x08020000, 128K,
+the CLIPS region of the linker scripts). It is programmed on its own,
+so flashing the application leaves it in place, e.g.
+	st-flash write clips.bin 0x08020000
+or linked into the application as an object with a ".clips" section.
+
+Image layout, little-endian:
+	header  CLIPS_HeaderTypeDef
+	index   count x CLIPS_EntryTypeDef, sorted by id
+	data    clip samples, each clip word aligned
+The header crc covers the index. Each entry crc covers its data.
+Both use the STM32 CRC unit, like the UART frames (see crc32.h):
+CRC-32/MPEG-2 over little-endian words, zero-padded to 4 bytes.
+CLIPS_Init() checks every clip against its crc, about 1.5ms for a full
+sector, and leaves out the ones that fail: CLIPS_Find() does not return
+them, so CLIPS_Play(), CLIPS_Mix() and OFFLOAD_Start() never play or
+send corrupt data, and no start pays for a check. Host/Tools/clips_pack
+builds images from WAV files.
+
+Clips in CLIPS_FORMAT_DAC are stored the way the DAC takes them
+(unsigned 12-bit left-aligned, i.e. Q15 ^ 0x8000) and played with no
+copy: DMA reads them straight from flash (see playback.h). A lookup is
+a binary search over the index, with no RAM copy either. Lookup and
+start times go to the METRICS_CLIP_LOOKUP and METRICS_CLIP_START
+histograms (see metrics.h).
+
+Clips in the codec formats (see codec.h) are stored as a stream of
+CODEC_EncodeBlock() blocks of CODEC_BLOCK_SAMPLES samples, the last one
+possibly shorter, and decoded into the playback buffer as they play:
+2 to 4 times more audio in the sector. Their sample rate is converted
+to PLAYBACK_SAMPLE_RATE on the fly (see resample.h), so clips recorded
+at ISD1820 rates, or at up to 48kHz, play as they are.
+CLIPS_FORMAT_PCM16 clips can also be layered by the mixer, straight
+from flash (see mixer.h).
+----------------------------------------------------------------------
+ */
+#ifndef CLIPS_H
+#define CLIPS_H
+
+/* C++ detection */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stm32f4xx_hal.h"
+#include "playback.h"
+#include "codec.h"
+
+#define CLIPS_MAGIC     0x50494C43UL //"CLIP"
+#define CLIPS_VERSION   1U
+#define CLIPS_MAX_COUNT 1024U //index entries
+
+typedef enum {
+	CLIPS_FORMAT_DAC = 0, //uint16_t, Q15 ^ 0x8000
+	CLIPS_FORMAT_PCM16 = CODEC_FORMAT_PCM16,
+	CLIPS_FORMAT_ULAW = CODEC_FORMAT_ULAW,
+	CLIPS_FORMAT_IMA_ADPCM = CODEC_FORMAT_IMA_ADPCM
+} CLIPS_FormatTypeDef;
+
+typedef struct {
+	uint32_t magic;
+	uint16_t version;
+	uint16_t count;  //index entries
+	uint32_t size;   //whole image [bytes]
+	uint32_t crc;    //of the index
+} CLIPS_HeaderTypeDef;
+
+typedef struct {
+	uint16_t id;
+	uint8_t format;      //CLIPS_FormatTypeDef
+	uint8_t reserved;
+	uint32_t offset;     //from the image start [bytes]
+	uint32_t length;     //[samples]
+	uint32_t sampleRate; //[Hz]
+	uint32_t crc;        //of the data
+} CLIPS_EntryTypeDef;
+
+HAL_StatusTypeDef CLIPS_Init(void);
+/**
+ * @brief  Checks the image header and index, then the data of every clip. Without a valid image, the library is empty.
+ * @retval HAL_OK, or HAL_ERROR if no valid image is programmed. Clips failing their crc are left out, not an error.
+ */
+
+uint16_t CLIPS_GetCount(void);
+/**
+ * @brief  Returns the number of clips in the library.
+ * @retval Clip count.
+ */
+
+const CLIPS_EntryTypeDef* CLIPS_Find(uint16_t id);
+/**
+ * @brief  Looks up clip {id} in the index.
+ * @retval Index entry, in flash, or NULL if there is no such clip or its data failed CLIPS_Init()'s check.
+ */
+
+const void* CLIPS_GetData(const CLIPS_EntryTypeDef* clip);
+/**
+ * @brief  Returns the address of the data of {clip}, in flash.
+ * @retval Samples or codec blocks, by format.
+ */
+
+HAL_StatusTypeDef CLIPS_Verify(const CLIPS_EntryTypeDef* clip);
+/**
+ * @brief  Checks the data of {clip} against its crc. Takes about 1 cycle per byte.
+ * @retval HAL_OK, or HAL_ERROR on mismatch.
+ */
+
+HAL_StatusTypeDef CLIPS_Play(uint16_t id, PLAYBACK_RouteTypeDef route);
+/**
+ * @brief  Starts playing clip {id} straight from flash.
+ * @retval HAL_OK, HAL_ERROR if there is no such clip or it cannot play at its rate, or HAL_BUSY if already playing.
+ */
+
+HAL_StatusTypeDef CLIPS_Mix(uint16_t id, uint8_t stream, uint16_t gain, PLAYBACK_RouteTypeDef route);
+/**
+ * @brief  Plays clip {id} on mixer stream {stream}, over what the mixer already plays (see mixer.h).
+ * @param  gain: Q15, MIXER_GAIN_UNITY at most.
+ * @retval HAL_OK, HAL_ERROR if there is no such CLIPS_FORMAT_PCM16 clip at PLAYBACK_SAMPLE_RATE, or HAL_BUSY if {stream} or the DAC is in use.
+ */
+
+/* C++ detection */
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,119 @@
+/**
+ * codec.h
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+u-law and IMA-ADPCM audio codecs
+----------------------------------------------------------------------
+Kernels for Q15 samples, bit-exact with the reference implementations:
+	u-law      G.711, as in the Sun g711.c linear2ulaw()/ulaw2linear(): 2:1
+	IMA-ADPCM  IMA/DVI, as in the Intel/DVI adpcm.c coder: 4:1
+Decoders write samples in pairs, as words, the odd last one alone.
+
+Both avoid data-dependent branches: the u-law encoder takes the
+magnitude with the sign mask, clips it with a conditional move and
+finds the segment with __CLZ; the ADPCM quantizer turns its three
+comparisons into masks, and clamps with __SSAT. The step size table is
+looked up, never searched.
+
+Streams are cut into blocks of up to CODEC_BLOCK_SAMPLES samples, each
+decodable on its own. An IMA-ADPCM block starts with the coder state,
+like a WAV IMA-ADPCM block:
+	[predictor:2][index:1][0:1][codes:(samples+1)/2, low nibble first]
+so a lost block costs that block only. An odd block ends in a byte
+with a 0 high nibble, which decodes as one more sample.
+
+Encode and decode times per block go to the METRICS_ENCODE_BLOCK and
+METRICS_DECODE_BLOCK histograms (see metrics.h).
+----------------------------------------------------------------------
+ */
+#ifndef CODEC_H
+#define CODEC_H
+
+/* C++ detection */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stm32f4xx_hal.h"
+
+#define CODEC_BLOCK_SAMPLES      256U
+#define CODEC_ADPCM_HEADER_SIZE  4U
+#define CODEC_MAX_BLOCK_SIZE     (CODEC_BLOCK_SAMPLES * sizeof(int16_t)) //bytes, PCM16
+
+typedef enum {
+	CODEC_FORMAT_PCM16 = 1, //Q15
+	CODEC_FORMAT_ULAW,
+	CODEC_FORMAT_IMA_ADPCM
+} CODEC_FormatTypeDef;
+
+typedef struct {
+	int16_t predictor;
+	uint8_t index;
+} CODEC_AdpcmStateTypeDef;
+
+void CODEC_UlawEncode(const int16_t* in, uint8_t* out, uint32_t count);
+/**
+ * @brief  Encodes {count} samples to u-law.
+ * @retval None
+ */
+
+void CODEC_UlawDecode(const uint8_t* in, int16_t* out, uint32_t count);
+/**
+ * @brief  Decodes {count} u-law samples.
+ * @param  out: Samples, word aligned.
+ * @retval None
+ */
+
+void CODEC_AdpcmEncode(CODEC_AdpcmStateTypeDef* state, const int16_t* in, uint8_t* out, uint32_t count);
+/**
+ * @brief  Encodes {count} samples to IMA-ADPCM codes, two per byte, low nibble first, and updates {state}.
+ * @note   An odd last sample takes a byte of its own, high nibble 0.
+ * @retval None
+ */
+
+void CODEC_AdpcmDecode(CODEC_AdpcmStateTypeDef* state, const uint8_t* in, int16_t* out, uint32_t count);
+/**
+ * @brief  Decodes {count} samples from IMA-ADPCM codes and updates {state}.
+ * @retval None
+ */
+
+uint32_t CODEC_BlockSize(CODEC_FormatTypeDef format, uint32_t count);
+/**
+ * @brief  Returns the size of a block of {count} samples.
+ * @retval Size [bytes], 0 for an unknown format.
+ */
+
+uint32_t CODEC_EncodeBlock(CODEC_FormatTypeDef format, CODEC_AdpcmStateTypeDef* state, const int16_t* in, uint32_t count, void* out);
+/**
+ * @brief  Encodes {count} samples, at most CODEC_BLOCK_SAMPLES, as one block.
+ * @param  state: IMA-ADPCM coder state, carried from block to block. Unused by other formats.
+ * @param  out: Block, CODEC_BlockSize() bytes.
+ * @retval Block size [bytes], 0 for an unknown format.
+ */
+
+uint32_t CODEC_DecodeBlock(CODEC_FormatTypeDef format, const void* in, uint32_t size, int16_t* out);
+/**
+ * @brief  Decodes the block at {in}: CODEC_BLOCK_SAMPLES samples, or fewer if {size} bytes do not hold a full block.
+ * @param  out: Samples, word aligned.
+ * @retval Sample count, 0 for an unknown format. The block took CODEC_BlockSize() bytes.
+ */
+
+/* C++ detection */
+#ifdef __cplusplus
+}
+#endif
+
+#endif
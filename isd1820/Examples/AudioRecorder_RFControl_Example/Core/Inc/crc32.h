@@ -0,0 +1,52 @@
+/**
+ * crc32.h
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+CRC-32 on the CRC unit
+----------------------------------------------------------------------
+CRC-32/MPEG-2 (polynomial 0x04C11DB7, initial value 0xFFFFFFFF, no
+reflection, no final xor) of byte strings, as the host computes it for
+command frames (see uart_cmd.h), the clip library (see clips.h) and
+offload frames (see offload.h). The unit takes 32-bit words: bytes are
+fed 4 at a time in memory order, the last 1 to 3 zero padded to a word.
+
+The unit has a single running value: calls must not interleave, so use
+it from the main loop context only.
+----------------------------------------------------------------------
+ */
+#ifndef CRC32_H
+#define CRC32_H
+
+/* C++ detection */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stm32f4xx_hal.h"
+
+uint32_t CRC32_Compute(const void* data, uint32_t len);
+/**
+ * @brief  Computes the CRC of {len} bytes at {data}, any alignment.
+ * @note   Main loop context only. The CRC unit clock must be enabled.
+ * @retval CRC-32/MPEG-2 of the bytes.
+ */
+
+/* C++ detection */
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,86 @@
+/**
+ * dtmf.h
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+DTMF detector
+----------------------------------------------------------------------
+Decodes telephone keypad tones from capture blocks, e.g. to drive the
+same actions as the RF remote (see main.c).
+
+Each block is decimated to 8kHz (pairs averaged) and run through a
+bank of 8 Goertzel filters, one per DTMF frequency, in fixed point:
+Q14 coefficients, 32-bit state, 64-bit products. At 16kHz a 256
+sample block gives 128 samples and a 62.5Hz resolution, enough to
+tell the row frequencies apart (73Hz at the closest). A block holds a
+key when:
+	- its mean square is above DTMF_MIN_ENERGY,
+	- the strongest row and column tones hold at least half the block
+	  energy (speech and noise spread theirs),
+	- every other row, and every other column, is 9dB below them,
+	- the column tone is at most 8dB below the row tone, and at most
+	  4dB above it (twist).
+
+A key is pressed after DTMF_ON_BLOCKS blocks in a row hold it, and
+released after DTMF_OFF_BLOCKS blocks hold no key: a tone of 40ms or
+more is reported once, 32 to 48ms after it starts, and a block lost to
+noise in the middle of a tone does not repeat it. DTMF_KeyCallback()
+reports each press.
+
+Block times go to the METRICS_DTMF_BLOCK histogram (see metrics.h),
+about 1% of the CPU at 16kHz.
+----------------------------------------------------------------------
+ */
+#ifndef DTMF_H
+#define DTMF_H
+
+/* C++ detection */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stm32f4xx_hal.h"
+
+#define DTMF_SAMPLE_RATE 16000U  //Hz, input rate the filters are tuned for
+#define DTMF_MAX_BLOCK   256U    //samples per DTMF_Process() call
+#define DTMF_MIN_ENERGY  10000UL //mean square, about -50dBFS
+#define DTMF_ON_BLOCKS   2U
+#define DTMF_OFF_BLOCKS  2U
+
+void DTMF_Reset(void);
+/**
+ * @brief  Forgets the key held, e.g. when a capture starts.
+ * @retval None
+ */
+
+char DTMF_Process(const int16_t* block, uint32_t count);
+/**
+ * @brief  Looks for a key in the next {count} samples.
+ * @param  count: Even, DTMF_MAX_BLOCK at most.
+ * @retval Key in this block ('0' to '9', '*', '#', 'A' to 'D'), or 0 if none.
+ */
+
+void DTMF_KeyCallback(char key);
+/**
+ * @brief  Called from DTMF_Process() when a key is pressed.
+ * @retval None
+ */
+
+/* C++ detection */
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,150 @@
+/**
+ * flash_writer.h
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+Streaming flash writer
+----------------------------------------------------------------------
+Records a stream into flash sectors 6 and 7 (0x08040000, 256K, the
+RECORD region of the linker scripts): 8s of 16kHz Q15 audio, more once
+encoded (see codec.h).
+
+The F446 has a single flash bank: while a sector erases (1s typical, 2s
+at most for 128K) every fetch from flash stalls, interrupts included.
+FLASHWR_Erase() is therefore a blocking stall of 2 to 4s for the two
+sectors, not a background task: the flash interrupt only chains the
+second sector, and nothing but DMA between peripherals and RAM runs
+meanwhile. The region is erased ahead of time, with nothing running
+that the stall would break (see RECORDER_Erase()), and a recording only
+starts on an erased region. While recording, only word programming
+happens (16us a word at most, DMA keeps sampling meanwhile): data is
+queued in a RAM staging ring by FLASHWR_Write() and programmed from
+the scheduler, FLASHWR_BURST_WORDS words at a time, by a loop running
+from RAM so the CPU does not stall on its own fetches between words.
+A full staging ring is reported as HAL_BUSY: the caller keeps its data
+and retries, which pushes back on the capture ring (see capture.h).
+
+The first word of the region holds the recorded length [bytes],
+programmed by FLASHWR_End(), so a recording survives a reset. The
+second holds a tag given to FLASHWR_Begin(), telling the reader how the
+data is encoded (a CODEC_FormatTypeDef, see recorder.h).
+
+Burst times go to the METRICS_FLASH_BURST histogram, and the capture
+backlog seen by the consumer to METRICS_CAPTURE_BACKLOG (see metrics.h):
+throughput is FLASHWR_BURST_WORDS * 4 bytes per burst time, and the
+backlog shows how close the capture came to an overrun.
+----------------------------------------------------------------------
+ */
+#ifndef FLASH_WRITER_H
+#define FLASH_WRITER_H
+
+/* C++ detection */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stm32f4xx_hal.h"
+
+#define FLASHWR_QUEUE_WORDS 2048U //RAM staging ring, 8K
+#define FLASHWR_BURST_WORDS 64U   //programmed per scheduler call, 1ms at most
+
+typedef enum {
+	FLASHWR_STATE_UNKNOWN = 0, //region content unknown: erase before recording
+	FLASHWR_STATE_ERASING,
+	FLASHWR_STATE_ERASED,
+	FLASHWR_STATE_RECORDING,
+	FLASHWR_STATE_DONE,        //holds a recording
+	FLASHWR_STATE_ERROR
+} FLASHWR_StateTypeDef;
+
+void FLASHWR_Init(void);
+/**
+ * @brief  Finds out whether the region holds a recording or is erased.
+ * @retval None
+ */
+
+HAL_StatusTypeDef FLASHWR_Erase(void);
+/**
+ * @brief  Erases the region, one sector after the other from the flash interrupt. The CPU stalls 2 to 4s meanwhile.
+ * @note   Do not run while capturing, playing or sending anything: use RECORDER_Erase().
+ * @retval HAL_OK, or HAL_BUSY while erasing or recording.
+ */
+
+HAL_StatusTypeDef FLASHWR_Begin(uint32_t tag);
+/**
+ * @brief  Starts a recording.
+ * @param  tag: Stored with the recording, returned by FLASHWR_GetRecording().
+ * @retval HAL_OK, HAL_BUSY while erasing or recording, or HAL_ERROR if the region is not erased.
+ */
+
+HAL_StatusTypeDef FLASHWR_Write(const void* data, uint32_t len);
+/**
+ * @brief  Queues {len} bytes for programming. Main loop context only.
+ * @param  data: Data, word aligned.
+ * @param  len: Length [bytes], a multiple of 4.
+ * @retval HAL_OK, HAL_BUSY if the staging ring is full (retry later), or HAL_ERROR if not recording or the region is full.
+ */
+
+void FLASHWR_End(void);
+/**
+ * @brief  Ends the recording once the staging ring is programmed, and programs its length.
+ * @retval None
+ */
+
+void FLASHWR_EndAt(uint32_t length);
+/**
+ * @brief  Like FLASHWR_End(), but keeps the first {length} bytes only, e.g. to trim trailing silence.
+ * @param  length: Recording length [bytes], as returned by FLASHWR_GetLength() at the cut.
+ * @retval None
+ */
+
+uint32_t FLASHWR_GetLength(void);
+/**
+ * @brief  Returns how much of the running recording is queued so far.
+ * @retval Length [bytes], 0 if not recording.
+ */
+
+FLASHWR_StateTypeDef FLASHWR_GetState(void);
+/**
+ * @brief  Returns the writer state.
+ * @retval FLASHWR_STATE_x.
+ */
+
+uint32_t FLASHWR_GetRecording(const void** data, uint32_t* tag);
+/**
+ * @brief  Returns the recording in flash.
+ * @param  data: Receives the recording address.
+ * @param  tag: Receives the tag given to FLASHWR_Begin().
+ * @retval Recording length [bytes], 0 if there is none.
+ */
+
+void FLASHWR_EndOfOperationCallback(uint32_t value);
+/**
+ * @brief  Call from HAL_FLASH_EndOfOperationCallback().
+ * @retval None
+ */
+
+void FLASHWR_OperationErrorCallback(uint32_t value);
+/**
+ * @brief  Call from HAL_FLASH_OperationErrorCallback().
+ * @retval None
+ */
+
+/* C++ detection */
+#ifdef __cplusplus
+}
+#endif
+
+#endif
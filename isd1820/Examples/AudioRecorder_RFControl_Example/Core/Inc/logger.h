@@ -0,0 +1,97 @@
+/**
+ * logger.h
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+Deferred-format binary logging
+----------------------------------------------------------------------
+LOG("fmt", args...) does no formatting on the target. The format string
+is placed in the .log_fmt section, which the linker script keeps in the
+ELF but never loads into flash, and its address in that section is the
+message id. A log call stores the id, the tick and up to 4 raw 32-bit
+arguments in a RAM ring (a few stores with interrupts masked), and
+LOG_Drain() later moves them to the telemetry stream as TELEM_REC_LOG
+records:
+	[TELEM_REC_LOG][tick][id][tick at LOG()][arg]...
+(all varints, see telemetry.h).
+The host rebuilds each message by reading the string at offset {id} of
+the .log_fmt section of the .elf and formatting it with the arguments:
+	Host/Tools/telem_decode -e firmware.elf capture
+
+Arguments are sent as 32-bit integers: %d, %u, %x, %c and %p work. %s
+does not (the string may be gone by the time the host reads the id) and
+neither does %f (floats are converted to integers).
+
+printf() still works: _write() is retargeted to send its bytes as
+TELEM_REC_TEXT records through the same non-blocking stream, instead of
+blocking on the UART.
+----------------------------------------------------------------------
+ */
+#ifndef LOGGER_H
+#define LOGGER_H
+
+/* C++ detection */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stm32f4xx_hal.h"
+
+#define LOG_RING_SIZE 256U //32-bit words, must be a power of two
+#define LOG_MAX_ARGS  4U
+
+/* Message id: address of the format string in the non-loaded .log_fmt section */
+#define LOG_ID(fmt) __extension__({ \
+		static const char _LOG_fmt[] __attribute__((section(".log_fmt"), used)) = fmt; \
+		(uint32_t)_LOG_fmt; \
+	})
+
+/* Counts up to 8 arguments, so that passing more than LOG_MAX_ARGS fails to compile */
+#define _LOG_NARGS(...) _LOG_NARGS_(0, ##__VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define _LOG_NARGS_(_0, _1, _2, _3, _4, _5, _6, _7, _8, n, ...) n
+
+#define LOG(fmt, ...) do{ \
+		_Static_assert(_LOG_NARGS(__VA_ARGS__) <= LOG_MAX_ARGS, "LOG() takes at most LOG_MAX_ARGS arguments"); \
+		LOG_Write(LOG_ID(fmt), _LOG_NARGS(__VA_ARGS__), (const uint32_t[]){0, ##__VA_ARGS__} + 1); \
+	}while(0)
+
+void LOG_Write(uint32_t id, uint32_t count, const uint32_t* args);
+/**
+ * @brief  Stores a message in the RAM ring. Use the LOG() macro instead. Safe to call from an ISR.
+ * @param  id: Message id, from LOG_ID().
+ * @param  count: Number of arguments, at most LOG_MAX_ARGS: the ones after are dropped.
+ * @param  args: Arguments.
+ * @retval None
+ */
+
+void LOG_Drain(uint32_t arg);
+/**
+ * @brief  Moves the stored messages to the telemetry stream. Main loop context only.
+ * @param  arg: Unused, for SCHED_HandlerTypeDef.
+ * @retval None
+ */
+
+uint32_t LOG_GetDropped(void);
+/**
+ * @brief  Returns how many messages were dropped because the ring was full.
+ * @retval Dropped message count.
+ */
+
+/* C++ detection */
+#ifdef __cplusplus
+}
+#endif
+
+#endif
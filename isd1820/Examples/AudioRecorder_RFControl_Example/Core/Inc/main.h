@@ -32,6 +32,8 @@ extern "C" {
 
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
+#include "trace.h"
+#include "metrics.h"
 
 /* USER CODE END Includes */
 
@@ -90,6 +92,11 @@ void Error_Handler(void);
 #define RF_D2_Pin GPIO_PIN_6
 #define RF_D2_GPIO_Port GPIOB
 /* USER CODE BEGIN Private defines */
+#define ISD1820_TIM_IRQHandler TIM5_IRQHandler //isd1820.c owns the TIM5 vector
+#define ISD1820_TRACE(event, value) (TRACE(TRACE_PORT_COMMAND + (event), (value)), METRICS_DriverEvent((event), (value))) //driver events on ITM ports 1 to 5 and histograms
+#define SCHED_TRACE_POST(handler) TRACE(TRACE_PORT_POST, (handler))
+#define SCHED_TRACE_RUN(handler)  TRACE(TRACE_PORT_RUN, (handler))
+#define SCHED_TRACE_DEPTH(depth)  METRICS_Record(METRICS_QUEUE_DEPTH, (depth))
 
 /* USER CODE END Private defines */
 
@@ -0,0 +1,153 @@
+/**
+ * metrics.h
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+Always-on latency histograms
+----------------------------------------------------------------------
+Fixed-size log-linear (HDR style) histograms: values below
+METRICS_SUB_BUCKETS get one bucket each, and every power of two above
+that is split into METRICS_SUB_BUCKETS linear buckets, so the relative
+error stays under 1/METRICS_SUB_BUCKETS (12.5%) over the whole range.
+Recording a sample is a CLZ, two shifts and an LDREX/STREX increment,
+safe from any context.
+
+Bucket i covers values from
+	i                                       if i < METRICS_SUB_BUCKETS
+	(METRICS_SUB_BUCKETS + i % 8) << (i / 8 - 1)   otherwise
+up to the next bucket. The last bucket also holds every larger value.
+
+Histograms:
+	METRICS_CMD_TO_EDGE   RF button or UART command to the REC/PL/PE rising edge [CPU cycles]
+	METRICS_EXTI_SERVICE  RF EXTI interrupt service time [CPU cycles]
+	METRICS_PULSE_ERROR   |actual - requested| REC/PL/PE pulse width [us]
+	METRICS_QUEUE_DEPTH   scheduler queue depth when an event is taken [events]
+	METRICS_CLIP_LOOKUP   clip library index search [CPU cycles]
+	METRICS_CLIP_START    clip play request to DMA and timer running [CPU cycles]
+	METRICS_FLASH_BURST   flash writer burst of FLASHWR_BURST_WORDS words [CPU cycles]
+	METRICS_CAPTURE_BACKLOG  capture blocks waiting when the consumer runs [blocks]
+	METRICS_ENCODE_BLOCK  codec block encode, CODEC_BLOCK_SAMPLES samples [CPU cycles]
+	METRICS_DECODE_BLOCK  codec block decode, CODEC_BLOCK_SAMPLES samples [CPU cycles]
+	METRICS_MIX_BLOCK     mixer refill, PLAYBACK_HALF_SIZE samples [CPU cycles]
+	METRICS_RESAMPLE      sample rate conversion, per output sample [CPU cycles]
+	METRICS_VAD_BLOCK     voice activity detection, CAPTURE_BLOCK_SIZE samples [CPU cycles]
+	METRICS_WSOLA_HOP     time-stretch, per WSOLA_HOP output samples [CPU cycles]
+	METRICS_DTMF_BLOCK    DTMF detection, CAPTURE_BLOCK_SIZE samples [CPU cycles]
+	METRICS_STREAM_LATENCY  host stream buffer, per refill [samples]
+	METRICS_OFFLOAD_FRAME offload frame build, OFFLOAD_FRAME_SAMPLES samples [CPU cycles]
+
+UARTCMD_METRICS (see uart_cmd.h) dumps one histogram on the telemetry
+stream as TELEM_REC_HISTOGRAM records, with values
+	histogram, first bucket index, count, count, ...
+Runs of empty buckets are skipped by starting a new record.
+When the telemetry buffer is full, the dump stops at the record that
+did not fit and METRICS_DumpPoll() resumes it from there, so no bucket
+is lost. With a reset, the counts sent are taken off their buckets, and
+samples recorded while the dump runs are kept.
+----------------------------------------------------------------------
+ */
+#ifndef METRICS_H
+#define METRICS_H
+
+/* C++ detection */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stm32f4xx_hal.h"
+
+#define METRICS_SUB_BITS    3U
+#define METRICS_SUB_BUCKETS (1UL << METRICS_SUB_BITS)
+#define METRICS_RANGE_BITS  24U //values from 2^24 up share the last bucket
+#define METRICS_BUCKETS     ((METRICS_RANGE_BITS - METRICS_SUB_BITS + 1U) * METRICS_SUB_BUCKETS)
+
+typedef enum {
+	METRICS_CMD_TO_EDGE = 0,
+	METRICS_EXTI_SERVICE,
+	METRICS_PULSE_ERROR,
+	METRICS_QUEUE_DEPTH,
+	METRICS_CLIP_LOOKUP,
+	METRICS_CLIP_START,
+	METRICS_FLASH_BURST,
+	METRICS_CAPTURE_BACKLOG,
+	METRICS_ENCODE_BLOCK,
+	METRICS_DECODE_BLOCK,
+	METRICS_MIX_BLOCK,
+	METRICS_RESAMPLE,
+	METRICS_VAD_BLOCK,
+	METRICS_WSOLA_HOP,
+	METRICS_DTMF_BLOCK,
+	METRICS_STREAM_LATENCY,
+	METRICS_OFFLOAD_FRAME,
+	METRICS_COUNT
+} METRICS_HistogramTypeDef;
+
+extern volatile uint32_t _METRICS_histograms[METRICS_COUNT][METRICS_BUCKETS];
+
+static inline uint32_t METRICS_Bucket(uint32_t value){
+	uint32_t msb;
+	if(value < METRICS_SUB_BUCKETS) return value;
+	if(value >= (1UL << METRICS_RANGE_BITS)) return METRICS_BUCKETS - 1U;
+	msb = 31U - __CLZ(value);
+	return ((msb - METRICS_SUB_BITS + 1U) << METRICS_SUB_BITS) | ((value >> (msb - METRICS_SUB_BITS)) & (METRICS_SUB_BUCKETS - 1U));
+}
+
+static inline void METRICS_Record(METRICS_HistogramTypeDef histogram, uint32_t value){
+	volatile uint32_t* count = &_METRICS_histograms[histogram][METRICS_Bucket(value)];
+	do{
+	}while(__STREXW(__LDREXW(count) + 1U, count));
+}
+
+void METRICS_Mark(void);
+/**
+ * @brief  Marks the arrival of a command (RF button or UART frame) for METRICS_CMD_TO_EDGE.
+ * @retval None
+ */
+
+void METRICS_DriverEvent(uint32_t event, uint32_t value);
+/**
+ * @brief  Feeds the command-to-edge and pulse width histograms. Meant to be called from ISD1820_TRACE().
+ * @param  event: ISD1820_TRACE_x.
+ * @param  value: Event value, as documented in isd1820.h.
+ * @retval None
+ */
+
+HAL_StatusTypeDef METRICS_Dump(METRICS_HistogramTypeDef histogram, uint8_t reset);
+/**
+ * @brief  Sends {histogram} on the telemetry stream, as far as it fits: METRICS_DumpPoll() sends the rest. Main loop context only.
+ * @param  reset: 1 to take the counts sent off the histogram.
+ * @retval HAL_OK, HAL_BUSY if a dump is running or HAL_ERROR if there is no such histogram.
+ */
+
+void METRICS_DumpPoll(uint32_t arg);
+/**
+ * @brief  Resumes the running dump from the record that did not fit.
+ * @note   Main loop context only: run it as a scheduler handler (periodic timer).
+ * @param  arg: Unused, for SCHED_HandlerTypeDef.
+ * @retval None
+ */
+
+void METRICS_Reset(METRICS_HistogramTypeDef histogram);
+/**
+ * @brief  Empties {histogram}.
+ * @retval None
+ */
+
+/* C++ detection */
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,105 @@
+/**
+ * mixer.h
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+Q15 audio mixer
+----------------------------------------------------------------------
+Layers up to MIXER_STREAMS streams, e.g. a chime under speech, into
+the playback buffer: MIXER_Source() is a playback source (see
+playback.h), started with MIXER_Start(). Streams can join or leave
+while it plays; playback ends when the last stream does.
+
+A stream is either Q15 samples in memory (RAM, or flash: a
+CLIPS_FORMAT_PCM16 clip, see clips.h), mixed straight from where they
+are, or any playback source, read into a scratch block first. Each has
+a Q15 gain, from 0 to MIXER_GAIN_UNITY.
+
+MIXER_Mix() is the kernel: it adds a stream into the block being
+filled, in place, two samples per word: __SMUAD/__SMUADX against the
+gain in the bottom halfword scale both halves, __PKHBT packs them back
+and __QADD16 adds with saturation. A stream at unity gain skips the
+multiplies. Each stream saturates as it is added, so the order of the
+streams matters only when clipping.
+
+Refill times go to the METRICS_MIX_BLOCK histogram (see metrics.h).
+----------------------------------------------------------------------
+ */
+#ifndef MIXER_H
+#define MIXER_H
+
+/* C++ detection */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stm32f4xx_hal.h"
+#include "playback.h"
+
+#define MIXER_STREAMS    4U
+#define MIXER_GAIN_UNITY 0x8000U //Q15 1.0
+
+void MIXER_Mix(int16_t* out, const int16_t* in, uint32_t count, uint16_t gain);
+/**
+ * @brief  Adds {count} samples of {in} times {gain} to {out}, with saturation.
+ * @param  out: Samples, word aligned.
+ * @param  in: Samples, word aligned.
+ * @param  gain: Q15, MIXER_GAIN_UNITY at most.
+ * @retval None
+ */
+
+HAL_StatusTypeDef MIXER_AddClip(uint8_t stream, const int16_t* samples, uint32_t length, uint16_t gain);
+/**
+ * @brief  Plays {length} Q15 samples on {stream}.
+ * @param  samples: Samples, word aligned.
+ * @retval HAL_OK, HAL_BUSY if {stream} is playing, or HAL_ERROR if there is no such stream.
+ */
+
+HAL_StatusTypeDef MIXER_AddSource(uint8_t stream, PLAYBACK_SourceTypeDef source, uint16_t gain);
+/**
+ * @brief  Plays {source} on {stream} until it returns 0.
+ * @retval HAL_OK, HAL_BUSY if {stream} is playing, or HAL_ERROR if there is no such stream.
+ */
+
+void MIXER_SetGain(uint8_t stream, uint16_t gain);
+/**
+ * @brief  Changes the gain of {stream}, from the next refill on.
+ * @retval None
+ */
+
+void MIXER_Remove(uint8_t stream);
+/**
+ * @brief  Stops {stream}.
+ * @retval None
+ */
+
+HAL_StatusTypeDef MIXER_Start(PLAYBACK_RouteTypeDef route);
+/**
+ * @brief  Starts playing the mix, unless it already plays.
+ * @retval HAL_OK, HAL_BUSY if something else is playing, or HAL_ERROR if no stream has anything to play.
+ */
+
+uint32_t MIXER_Source(int16_t* buffer, uint32_t count);
+/**
+ * @brief  Playback source mixing the streams, see PLAYBACK_SourceTypeDef.
+ * @retval {count}, or 0 once no stream is left.
+ */
+
+/* C++ detection */
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,130 @@
+/**
+ * offload.h
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+Audio offload to the host
+----------------------------------------------------------------------
+Sends the flash recording (see recorder.h) or a clip of the library
+(see clips.h) to the host over USART2, as a WAV file: 16-bit PCM, mono,
+at the rate it was recorded at. Whatever the stored format, samples
+are decoded as they play (see codec.h), before any rate conversion, so
+the host gets what the DAC or the ISD1820 was given, and only has to
+write the bytes out.
+
+The file goes out in frames numbered from 0: frame 0 holds the 44 byte
+WAV header, every other frame OFFLOAD_FRAME_SAMPLES samples (2 codec
+blocks), the last one fewer. The host knows the frame count from the
+header. Each frame is
+	[UARTCMD_OFFLOAD_DATA | UARTCMD_REPLY][seq:2][bytes:n][crc:4]
+with the crc and COBS encoding of the command frames (see uart_cmd.h),
+and is sent by DMA straight from its own buffer, not through the
+telemetry buffers: frames are up to 1KB, and telemetry and replies go
+out between them (see telemetry.h).
+
+Flow control is a go-back-N sliding window: up to OFFLOAD_WINDOW frames
+are sent ahead of the oldest frame not acknowledged. The host
+acknowledges with UARTCMD_OFFLOAD_ACK and the number of the next frame
+it expects, which acknowledges every frame before it; when a frame is
+missing or fails its crc, it asks for it again (resend flag) and drops
+what follows until it comes. Without a new acknowledgement for
+OFFLOAD_TIMEOUT ms, sending goes back to the oldest frame too, which
+covers a lost acknowledgement or resend request, and after
+OFFLOAD_RETRIES of these in a row the transfer is given up. Frames are
+decoded again from flash when resent: nothing is buffered for them.
+
+At 2Mbaud the line carries about 200KB/s, 6 times real time at 16kHz,
+if the window covers the host round trip (8KB in flight is 40ms). To
+keep the line busy, the next frame is built while DMA sends the one
+before. Frame build times go to the METRICS_OFFLOAD_FRAME histogram
+(see metrics.h), and each transfer is logged with its duration and the
+frames sent again. Host/Tools/offload_recv is the host side, writing
+the WAV file; Host/Sim/offload_sim runs it against the firmware on a
+timed line and reports how busy the line stays.
+----------------------------------------------------------------------
+ */
+#ifndef OFFLOAD_H
+#define OFFLOAD_H
+
+/* C++ detection */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stm32f4xx_hal.h"
+
+#define OFFLOAD_FRAME_SAMPLES 512U //samples per frame, 1KB, a multiple of CODEC_BLOCK_SAMPLES
+#define OFFLOAD_WINDOW        8U   //frames sent ahead of the oldest one not acknowledged
+#define OFFLOAD_TIMEOUT       100U //ms without an acknowledgement before going back to the oldest frame
+#define OFFLOAD_RETRIES       20U  //timeouts in a row before the transfer is given up
+
+typedef enum {
+	OFFLOAD_SOURCE_RECORDING = 0, //the flash recording
+	OFFLOAD_SOURCE_CLIP           //a clip of the library
+} OFFLOAD_SourceTypeDef;
+
+void OFFLOAD_Init(UART_HandleTypeDef* huart);
+/**
+ * @brief  Sets the UART the file goes out on. Call after TELEM_Init(), on the same UART.
+ * @param  huart: UART handle with a DMA TX channel linked.
+ * @retval None
+ */
+
+HAL_StatusTypeDef OFFLOAD_Start(OFFLOAD_SourceTypeDef source, uint16_t id);
+/**
+ * @brief  Starts sending the recording, or clip {id}, from frame 0.
+ * @param  id: Clip id, unused for the recording.
+ * @retval HAL_OK, HAL_BUSY if a transfer runs, or HAL_ERROR if there is no such recording or clip.
+ */
+
+void OFFLOAD_Cancel(void);
+/**
+ * @brief  Stops the transfer. The frame on the line, if any, still goes out.
+ * @retval None
+ */
+
+HAL_StatusTypeDef OFFLOAD_Ack(uint16_t seq, uint8_t resend);
+/**
+ * @brief  Acknowledges every frame before {seq}, and sends again from {seq} on if {resend} is 1.
+ * @retval HAL_OK, or HAL_ERROR with no transfer or for a frame not sent yet.
+ */
+
+uint32_t OFFLOAD_GetAck(void);
+/**
+ * @brief  Returns the transfer state for the host.
+ * @retval Oldest frame not acknowledged (bits 0-15) | frame count << 16, 0 with no transfer.
+ */
+
+void OFFLOAD_Poll(uint32_t arg);
+/**
+ * @brief  Sends the next frame if the window and the line allow, and handles the timeout.
+ * @note   Main loop context only: run it as a scheduler handler (periodic timer and TX complete).
+ * @param  arg: Unused, for SCHED_HandlerTypeDef.
+ * @retval None
+ */
+
+void OFFLOAD_TxCpltCallback(UART_HandleTypeDef* huart);
+/**
+ * @brief  Call from HAL_UART_TxCpltCallback(), after TELEM_TxCpltCallback(). Schedules the next frame.
+ * @param  huart: UART handle.
+ * @retval None
+ */
+
+/* C++ detection */
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,176 @@
+/**
+ * playback.h
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+DAC audio playback
+----------------------------------------------------------------------
+DAC1 drives PA4 from a buffer of 2 x PLAYBACK_HALF_SIZE samples. Every
+TIM6 update requests a DMA transfer (DMA1 Stream1, circular) of one
+sample to DAC->DHR12L1, with the DAC trigger disabled: the timer paces
+the output and the DAC stream, DMA1 Stream5, stays free for USART2 RX.
+
+Each half-transfer and transfer-complete interrupt refills the half DMA
+has just left from a source function, then converts it from Q15 to the
+DAC's left-aligned offset binary two samples at a time. That is the
+only CPU work: well under 1% of the CPU at 16kHz for a copy from
+memory. A source that returns fewer samples than asked is padded with
+silence and counted as an underrun; a source that returns 0 ends
+playback once the last samples are out. A DMA transfer error ends
+playback at once, as PLAYBACK_Stop() would, and is counted. Clips queued with PLAYBACK_QueueClip() follow the current one
+within the same half, with no gap.
+
+PLAYBACK_StartDirect() plays samples already in the DAC format straight
+from memory-mapped flash: DMA reads the clip itself in normal mode, up
+to 65535 samples per transfer, with no buffer and no CPU work but one
+interrupt per transfer. The timer period is set from the clip sample
+rate; TIM6 is 16-bit, so rates under about 1.3kHz are refused.
+
+Host/Tests/test_playback feeds a source late on purpose and counts the
+underruns, for a given jitter and margin.
+
+PLAYBACK_StartEncoded() plays a stream of codec blocks (see codec.h),
+decoding one block of CODEC_BLOCK_SAMPLES samples whenever the refills
+have used up the previous one. A stream at another sample rate goes
+through the sample rate converter (see resample.h) on its way. The
+decoded stream then goes through the time-stretch (see wsola.h), at
+the speed set with PLAYBACK_SetSpeed(), so stored messages can be
+heard up to twice as fast at the same pitch; at 1.0x it passes the
+samples through unchanged.
+
+With PLAYBACK_ROUTE_FEEDTHROUGH, PA4 is expected to be wired to the
+ISD1820 MIC input: feed-through is enabled for the duration of the
+playback, so the clip goes out through the ISD1820 speaker amplifier.
+With PLAYBACK_ROUTE_RECORD, same wiring, the ISD1820 records the clip
+instead: REC rises as the timer starts, one sample period before the
+first sample, and falls when the half holding the last sample is out.
+The recording is rejected (HAL_BUSY) if the ISD1820 driver does not
+take it, see ISD1820_SetPolicy().
+----------------------------------------------------------------------
+ */
+#ifndef PLAYBACK_H
+#define PLAYBACK_H
+
+/* C++ detection */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stm32f4xx_hal.h"
+#include "codec.h"
+
+#define PLAYBACK_SAMPLE_RATE 16000U //Hz, set by the TIM6 period
+#define PLAYBACK_HALF_SIZE   128U   //samples refilled per interrupt, 8ms at 16kHz
+
+typedef enum {
+	PLAYBACK_ROUTE_DAC = 0,     //PA4 only
+	PLAYBACK_ROUTE_FEEDTHROUGH, //PA4, through the ISD1820 feed-through
+	PLAYBACK_ROUTE_RECORD       //PA4, recorded by the ISD1820
+} PLAYBACK_RouteTypeDef;
+
+typedef uint32_t (*PLAYBACK_SourceTypeDef)(int16_t* buffer, uint32_t count);
+//Writes up to {count} Q15 samples to {buffer} and returns how many. Called from the DMA interrupt.
+
+void PLAYBACK_Init(TIM_HandleTypeDef* tim);
+/**
+ * @brief  Enables DAC1 on PA4 at mid-scale. Playback starts with PLAYBACK_Start().
+ * @param  tim: Timer pacing the samples, with a DMA stream linked to its update request: TIM6, its period set for PLAYBACK_SAMPLE_RATE.
+ * @retval None
+ */
+
+HAL_StatusTypeDef PLAYBACK_Start(PLAYBACK_SourceTypeDef source, PLAYBACK_RouteTypeDef route);
+/**
+ * @brief  Fills the buffer from {source} and starts playback.
+ * @param  source: Sample source, see PLAYBACK_SourceTypeDef.
+ * @param  route: Output route.
+ * @retval HAL_OK, HAL_BUSY if already playing, or HAL_ERROR if {source} has nothing to play.
+ */
+
+HAL_StatusTypeDef PLAYBACK_StartClip(const int16_t* samples, uint32_t length, PLAYBACK_RouteTypeDef route);
+/**
+ * @brief  Plays {length} Q15 samples from memory (RAM or flash).
+ * @retval HAL_OK, or HAL_BUSY if already playing.
+ */
+
+HAL_StatusTypeDef PLAYBACK_StartDirect(const uint16_t* samples, uint32_t length, uint32_t sampleRate, PLAYBACK_RouteTypeDef route);
+/**
+ * @brief  Plays {length} samples in the DAC format (left-aligned offset binary, Q15 ^ 0x8000) without copying them.
+ * @param  samples: Samples, halfword aligned, in flash or RAM.
+ * @param  sampleRate: Sample rate [Hz].
+ * @retval HAL_OK, HAL_BUSY if already playing, or HAL_ERROR if {length} is 0 or TIM6 cannot run at {sampleRate}.
+ */
+
+HAL_StatusTypeDef PLAYBACK_StartEncoded(const void* data, uint32_t size, CODEC_FormatTypeDef format, uint32_t sampleRate, PLAYBACK_RouteTypeDef route);
+/**
+ * @brief  Plays {size} bytes of blocks encoded by CODEC_EncodeBlock().
+ * @param  sampleRate: Sample rate of the stream [Hz], converted to PLAYBACK_SAMPLE_RATE.
+ * @retval HAL_OK, HAL_BUSY if already playing, or HAL_ERROR for an unknown format, an empty stream or a rate the converter does not take.
+ */
+
+HAL_StatusTypeDef PLAYBACK_SetSpeed(uint32_t speed);
+/**
+ * @brief  Sets the speed of PLAYBACK_StartEncoded() streams, the current one from its next hop on.
+ * @param  speed: Q16.16, from WSOLA_SPEED_MIN (1.0x) to WSOLA_SPEED_MAX (2.0x).
+ * @retval HAL_OK, or HAL_ERROR if {speed} is out of range.
+ */
+
+HAL_StatusTypeDef PLAYBACK_QueueClip(const int16_t* samples, uint32_t length);
+/**
+ * @brief  Queues a clip to follow the one started with PLAYBACK_StartClip(), gapless.
+ * @retval HAL_OK, or HAL_BUSY if a clip is already queued or the current clip has ended.
+ */
+
+void PLAYBACK_Stop(void);
+/**
+ * @brief  Stops playback now and calls PLAYBACK_CompleteCallback().
+ * @retval None
+ */
+
+uint8_t PLAYBACK_IsPlaying(void);
+/**
+ * @brief  Returns 1 while playing.
+ * @retval 1 or 0.
+ */
+
+PLAYBACK_SourceTypeDef PLAYBACK_GetSource(void);
+/**
+ * @brief  Returns the source given to PLAYBACK_Start().
+ * @retval Source, NULL if not playing or playing in direct mode.
+ */
+
+uint32_t PLAYBACK_GetUnderruns(void);
+/**
+ * @brief  Returns how many refills the source could not fully serve.
+ * @retval Underrun count.
+ */
+
+uint32_t PLAYBACK_GetErrors(void);
+/**
+ * @brief  Returns how many DMA transfer errors ended playback.
+ * @retval Error count.
+ */
+
+void PLAYBACK_CompleteCallback(void);
+/**
+ * @brief  Called when playback ends or is stopped, from the DMA interrupt or PLAYBACK_Stop().
+ * @retval None
+ */
+
+/* C++ detection */
+#ifdef __cplusplus
+}
+#endif
+
+#endif
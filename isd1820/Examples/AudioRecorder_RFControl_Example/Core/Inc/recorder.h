@@ -0,0 +1,102 @@
+/**
+ * recorder.h
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+Capture to flash recorder
+----------------------------------------------------------------------
+Consumes the capture ring (capture.h) block by block and, while a
+recording runs, encodes each block (codec.h) and hands it to the flash
+writer (flash_writer.h). The recording format is stored with the
+recording, so it plays back whatever it was recorded with.
+
+Every block also goes through the voice activity detector (vad.h), and
+recordings are trimmed: blocks are stored from the VAD_ONSET_BLOCKS
+blocks before voice is confirmed on, and the recording is cut 2 blocks
+(32ms) after the last speech block. RECORDER_Listen() keeps the capture,
+and the detector, running between recordings, e.g. to start the ISD1820
+REC on voice (see audio_fsm.h). Every block goes through the DTMF
+detector (dtmf.h) too, and RECORDER_ListenTones() keeps the capture
+running for it, so keypad tones can stand in for the RF remote.
+
+At 16kHz the flash region holds 8s of PCM16, 16s of u-law or about 31s
+of IMA-ADPCM.
+----------------------------------------------------------------------
+ */
+#ifndef RECORDER_H
+#define RECORDER_H
+
+/* C++ detection */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stm32f4xx_hal.h"
+#include "codec.h"
+#include "playback.h"
+
+HAL_StatusTypeDef RECORDER_Start(CODEC_FormatTypeDef format);
+/**
+ * @brief  Starts capturing into flash, on an erased region (see FLASHWR_Erase()).
+ * @retval HAL_OK, HAL_BUSY while erasing or recording, or HAL_ERROR if the region is not erased.
+ */
+
+void RECORDER_Stop(void);
+/**
+ * @brief  Stops capturing, unless listening, writes the blocks still in the capture ring and ends the recording.
+ * @retval None
+ */
+
+HAL_StatusTypeDef RECORDER_Listen(uint8_t enable);
+/**
+ * @brief  Keeps the capture running for the voice activity detector (1), or lets it stop (0).
+ * @retval HAL_OK, or HAL_BUSY if the capture does not start.
+ */
+
+HAL_StatusTypeDef RECORDER_ListenTones(uint8_t enable);
+/**
+ * @brief  Keeps the capture running for the DTMF detector (1), or lets it stop (0).
+ * @retval HAL_OK, or HAL_BUSY if the capture does not start.
+ */
+
+HAL_StatusTypeDef RECORDER_Erase(void);
+/**
+ * @brief  Stops capturing, listening for voice or tones included, and erases the recording region: the CPU stalls 2 to 4s.
+ *         The listening restarts from the first RECORDER_Process() after the erase, unless changed meanwhile.
+ * @note   Commands received meanwhile wait in the UART DMA ring, which DMA keeps filling: the host sends nothing more
+ *         than UARTCMD_RX_BUFFER_SIZE bytes until the erase ends, or the excess is dropped (UARTCMD_GetOverruns()).
+ * @retval HAL_OK, or HAL_BUSY while erasing or recording, while the DAC plays (clips, streams, mixer), an offload
+ *         runs or the ISD1820 is busy: their timing would not survive the stall.
+ */
+
+void RECORDER_Process(void);
+/**
+ * @brief  Takes every complete capture block, recording it if a recording runs. Main loop context only.
+ * @note   Call it when an erase ends too (HAL_FLASH_EndOfOperationCallback()), to restart the listening it stopped.
+ * @retval None
+ */
+
+HAL_StatusTypeDef RECORDER_Play(PLAYBACK_RouteTypeDef route);
+/**
+ * @brief  Plays the recording in flash.
+ * @retval HAL_OK, HAL_ERROR if there is no recording, or HAL_BUSY if already playing.
+ */
+
+/* C++ detection */
+#ifdef __cplusplus
+}
+#endif
+
+#endif
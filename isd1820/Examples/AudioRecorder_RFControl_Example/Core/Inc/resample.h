@@ -0,0 +1,105 @@
+/**
+ * resample.h
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+Polyphase sample rate converter
+----------------------------------------------------------------------
+Converts a Q15 stream to another rate, e.g. a clip recorded at an
+ISD1820 rate (see RESAMPLE_ISD1820_RATE()) to PLAYBACK_SAMPLE_RATE.
+
+The output is pulled: RESAMPLE_Read() asks its input function for
+RESAMPLE_BLOCK_SIZE samples whenever its buffer runs low, so it works
+inside a playback source with no allocation and no copy of the whole
+stream. The position in the input advances by a Q16.16 step, input
+rate / output rate, per output sample.
+
+Each output sample is a FIR over the input, with the coefficients of
+one of RESAMPLE_PHASES phases of a Kaiser windowed sinc (beta 5),
+picked by the top bits of the step fraction. The Q15 tables are const,
+in flash; each phase sums to 1.0 so DC passes unchanged. The taps are
+applied two at a time with __SMLAD.
+
+RESAMPLE_Init() picks the table by step, the cutoff scaled so nothing
+above the output Nyquist aliases back:
+	step up to  taps  cutoff (x input Nyquist)
+	1.0625      16    0.85      interpolation, drift around 1:1
+	2           32    0.85 / 2  e.g. 22.05, 24 or 32kHz to 16kHz
+	3           48    0.85 / 3  e.g. 44.1 or 48kHz to 16kHz
+The taps grow with the step, so the cost per input sample stays about
+the same. A step just over a table's limit gets the next table, with a
+cutoff below the output Nyquist: treble is lost, never aliased.
+
+Cycles per output sample go to the METRICS_RESAMPLE histogram (see
+metrics.h).
+----------------------------------------------------------------------
+ */
+#ifndef RESAMPLE_H
+#define RESAMPLE_H
+
+/* C++ detection */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stm32f4xx_hal.h"
+
+#define RESAMPLE_MAX_TAPS   48U
+#define RESAMPLE_PHASE_BITS 5U
+#define RESAMPLE_PHASES     (1UL << RESAMPLE_PHASE_BITS)
+#define RESAMPLE_BLOCK_SIZE 128U     //input samples read at a time
+#define RESAMPLE_MAX_STEP   0x30000UL //Q16.16, 3.0
+
+#define RESAMPLE_ISD1820_RATE(r4) (640000000UL / (r4)) //Hz, ISD1820 sample rate for R4 [ohm]: 6.4kHz for 100k
+
+typedef uint32_t (*RESAMPLE_InputTypeDef)(int16_t* buffer, uint32_t count);
+//Writes up to {count} Q15 input samples to {buffer} and returns how many, 0 at the end of the stream.
+
+typedef struct {
+	RESAMPLE_InputTypeDef input;
+	uint32_t step;     //Q16.16 input samples per output sample
+	uint32_t position; //Q16.16 of the next output sample in buffer, minus taps / 2 - 1
+	uint32_t filled;   //samples in buffer
+	uint8_t ended;
+	uint8_t filter;    //coefficient table, by step
+	int16_t buffer[RESAMPLE_MAX_TAPS + RESAMPLE_BLOCK_SIZE] __ALIGNED(4);
+} RESAMPLE_StateTypeDef;
+
+HAL_StatusTypeDef RESAMPLE_Init(RESAMPLE_StateTypeDef* state, RESAMPLE_InputTypeDef input, uint32_t inRate, uint32_t outRate);
+/**
+ * @brief  Starts converting the stream from {input}, from {inRate} to {outRate} [Hz].
+ * @retval HAL_OK, or HAL_ERROR if a rate is 0 or {inRate} is above RESAMPLE_MAX_STEP x {outRate}.
+ */
+
+HAL_StatusTypeDef RESAMPLE_SetStep(RESAMPLE_StateTypeDef* state, uint32_t step);
+/**
+ * @brief  Changes the ratio from the next output sample on, e.g. to follow the clock of a stream.
+ * @param  step: Q16.16 input samples per output sample.
+ * @note   The table stays the one RESAMPLE_Init() picked: {step} must be within its limit.
+ * @retval HAL_OK, or HAL_ERROR if {step} is 0 or above the limit of the table.
+ */
+
+uint32_t RESAMPLE_Read(RESAMPLE_StateTypeDef* state, int16_t* out, uint32_t count);
+/**
+ * @brief  Writes up to {count} output samples to {out}.
+ * @retval Sample count, fewer than {count} once the input has ended.
+ */
+
+/* C++ detection */
+#ifdef __cplusplus
+}
+#endif
+
+#endif
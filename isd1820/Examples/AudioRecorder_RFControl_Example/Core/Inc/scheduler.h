@@ -0,0 +1,109 @@
+/**
+ * scheduler.h
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+Cooperative run-to-completion scheduler
+----------------------------------------------------------------------
+Events are a handler plus a 32-bit argument, posted into one of three
+priority queues from interrupts or from the main loop. SCHED_Run() always
+runs the oldest event of the highest non-empty priority to completion,
+so handlers never preempt each other and need no locking between them.
+Software timers are checked against the HAL tick and post their handler
+as a normal priority event when they expire.
+The CPU sleeps (WFI) while there is nothing to do.
+Define SCHED_TRACE_POST(handler) and SCHED_TRACE_RUN(handler) in main.h
+to trace posts and handler runs (handler is 0 when a run ends), and
+SCHED_TRACE_DEPTH(depth) to sample the queue depth on every run.
+----------------------------------------------------------------------
+ */
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+/* C++ detection */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stm32f4xx_hal.h"
+
+#define SCHED_QUEUE_SIZE 16U //events per priority level, must be a power of two
+#define SCHED_TIMERS     8U
+
+typedef enum {
+	SCHED_PRIO_HIGH = 0,
+	SCHED_PRIO_NORMAL,
+	SCHED_PRIO_LOW,
+	SCHED_PRIO_COUNT
+} SCHED_PriorityTypeDef;
+
+typedef void (*SCHED_HandlerTypeDef)(uint32_t arg);
+
+void SCHED_Init(void);
+/**
+ * @brief  Empties every queue and stops every timer.
+ * @retval None
+ */
+
+HAL_StatusTypeDef SCHED_Post(SCHED_PriorityTypeDef prio, SCHED_HandlerTypeDef handler, uint32_t arg);
+/**
+ * @brief  Queues {handler}({arg}) to run later from SCHED_Run(). Safe to call from an ISR.
+ * @param  prio: Queue to post into.
+ * @param  handler: Function to run.
+ * @param  arg: Argument passed to {handler}.
+ * @retval HAL_OK, or HAL_BUSY if the queue is full (the event is dropped and counted).
+ */
+
+HAL_StatusTypeDef SCHED_TimerStart(uint8_t timer, uint32_t delay, uint32_t period, SCHED_HandlerTypeDef handler, uint32_t arg);
+/**
+ * @brief  (Re)starts software timer {timer}. Main loop context only.
+ * @param  timer: Timer index, below SCHED_TIMERS.
+ * @param  delay: Time until the first expiry [milliseconds].
+ * @param  period: Reload time [milliseconds], 0 for a one-shot timer.
+ * @param  handler: Function posted at normal priority on every expiry.
+ * @param  arg: Argument passed to {handler}.
+ * @retval HAL_OK, or HAL_ERROR for an invalid timer index.
+ */
+
+void SCHED_TimerStop(uint8_t timer);
+/**
+ * @brief  Stops software timer {timer}. Main loop context only.
+ * @retval None
+ */
+
+uint8_t SCHED_RunOnce(void);
+/**
+ * @brief  Fires expired timers and runs at most one event.
+ * @retval 1 if an event was run, 0 if every queue was empty.
+ */
+
+void SCHED_Run(void);
+/**
+ * @brief  Runs events forever, sleeping until the next interrupt whenever the queues are empty.
+ * @retval None
+ */
+
+uint32_t SCHED_GetDropped(void);
+/**
+ * @brief  Returns how many events were dropped because their queue was full.
+ * @retval Dropped event count.
+ */
+
+/* C++ detection */
+#ifdef __cplusplus
+}
+#endif
+
+#endif
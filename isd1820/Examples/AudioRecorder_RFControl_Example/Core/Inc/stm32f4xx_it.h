@@ -56,8 +56,14 @@ void SVC_Handler(void);
 void DebugMon_Handler(void);
 void PendSV_Handler(void);
 void SysTick_Handler(void);
+void FLASH_IRQHandler(void);
 void EXTI0_IRQHandler(void);
+void DMA1_Stream1_IRQHandler(void);
+void DMA1_Stream5_IRQHandler(void);
+void DMA1_Stream6_IRQHandler(void);
+void USART2_IRQHandler(void);
 /* USER CODE BEGIN EFP */
+void DMA2_Stream0_IRQHandler(void);
 
 /* USER CODE END EFP */
 
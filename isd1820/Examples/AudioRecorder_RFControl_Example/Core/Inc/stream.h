@@ -0,0 +1,146 @@
+/**
+ * stream.h
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+Host audio stream
+----------------------------------------------------------------------
+Plays audio sent by the host in UART frames (see uart_cmd.h) through a
+jitter buffer: a ring of STREAM_BUFFER_SIZE Q15 samples, written by
+STREAM_Write() from the main loop as frames arrive, decoded on the way
+in, and read by STREAM_Source() from the playback DMA interrupt. The
+ring is single-producer single-consumer and lock-free, like the
+capture ring.
+
+The stream is PCM16, u-law or IMA-ADPCM (one coder state from
+STREAM_Start() on, no block headers) at PLAYBACK_SAMPLE_RATE. Playback
+starts once STREAM_PREFILL samples are buffered (STREAM_LIVE_TARGET in
+live mode), or at STREAM_End() for a shorter stream, and stops when
+the buffer is empty after STREAM_End(). A refill that finds the buffer
+empty before that plays silence and counts an underrun.
+
+Flow control is by sequence number: each STREAM_Write() carries the
+next one, and is refused with HAL_BUSY while the buffer has no room,
+so the host may send faster than real time and retry. Writes out of
+sequence are refused, repeats of the last one accepted without
+writing. STREAM_GetAck() gives the next number and the room left, for
+the host to go back to and to size its window (see uart_cmd.h).
+
+In STREAM_MODE_BUFFERED (uploads, see below) that is all. In
+STREAM_MODE_LIVE the host sends in real time on its own clock, which
+drifts from the DAC timer, with UART jitter on top, so the buffer
+adapts:
+	- drift: every refill, the fill average (over 16 refills) is
+	  steered to a target fill through the sample rate converter
+	  (see resample.h): the step is 1.0 plus 1 Q16 unit per sample
+	  above the target, plus the sum of those over 1024 refills (PI),
+	  within +/-0.78%, so a host clock running fast is played a little
+	  faster, inaudibly, with no lasting offset from the target;
+	- jitter: every second, the target moves by half the gap between
+	  the lowest fill of that second and a 256 sample margin, within
+	  STREAM_MIN_TARGET and STREAM_MAX_TARGET: steady arrivals shrink
+	  the latency, bursty ones grow it;
+	- underrun: the target grows by 512 samples and playback goes
+	  silent until the buffer is back to it, instead of stuttering.
+
+The fill, plus the half being played, goes to the
+METRICS_STREAM_LATENCY histogram on every refill: the latency from
+arrival to the DAC [samples], the converter adding up to
+RESAMPLE_BLOCK_SIZE. Underruns are counted (STREAM_GetUnderruns()) and
+logged with the final target at the end of each stream.
+
+Host/Tools/stream_send is the host side, streaming a WAV file;
+Host/Sim/stream_sim runs it against the firmware, with lost frames,
+clock drift and jitter.
+
+With PLAYBACK_ROUTE_RECORD the stream programs the ISD1820: REC rises
+with the first sample and falls after the last (see playback.h), with
+PA4 wired to the ISD1820 MIC input.
+----------------------------------------------------------------------
+ */
+#ifndef STREAM_H
+#define STREAM_H
+
+/* C++ detection */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stm32f4xx_hal.h"
+#include "codec.h"
+#include "playback.h"
+
+#define STREAM_BUFFER_SIZE 4096U //samples, 256ms at 16kHz, must be a power of two
+#define STREAM_PREFILL     2048U //samples buffered before playback starts, 128ms at 16kHz
+#define STREAM_MAX_WRITE   256U  //samples per STREAM_Write()
+#define STREAM_LIVE_TARGET 1024U //live: first target fill [samples], 64ms at 16kHz
+#define STREAM_MIN_TARGET  512U  //live: target fill range [samples]
+#define STREAM_MAX_TARGET  3072U
+
+typedef enum {
+	STREAM_MODE_BUFFERED = 0, //the host may run ahead: plays at the DAC rate, with back-pressure
+	STREAM_MODE_LIVE          //the host sends in real time: adaptive buffer, follows the host clock
+} STREAM_ModeTypeDef;
+
+HAL_StatusTypeDef STREAM_Start(CODEC_FormatTypeDef format, PLAYBACK_RouteTypeDef route, STREAM_ModeTypeDef mode);
+/**
+ * @brief  Empties the buffer and waits for sequence number 0. Playback starts once enough is buffered.
+ * @retval HAL_OK, HAL_BUSY if something is playing, or HAL_ERROR for an unknown format or mode.
+ */
+
+HAL_StatusTypeDef STREAM_Write(uint16_t seq, const uint8_t* data, uint32_t size);
+/**
+ * @brief  Decodes {size} bytes of the stream into the buffer. Main loop context only.
+ * @param  seq: Sequence number, one more than the last accepted write.
+ * @retval HAL_OK if written, or already written; HAL_BUSY if the buffer has no room, or HAL_ERROR out of
+ *         sequence, with no stream, or for more than STREAM_MAX_WRITE samples or part of one.
+ */
+
+HAL_StatusTypeDef STREAM_End(uint8_t abort);
+/**
+ * @brief  Ends the stream: what is buffered is played out (0) or dropped with playback stopped now (1).
+ * @retval HAL_OK, or HAL_ERROR if no stream runs.
+ */
+
+uint32_t STREAM_GetAck(void);
+/**
+ * @brief  Returns the stream state for the host.
+ * @retval Next sequence number expected (bits 0-15) | free room in the buffer [samples] << 16.
+ */
+
+uint32_t STREAM_GetUnderruns(void);
+/**
+ * @brief  Returns how many refills found the buffer empty, since STREAM_Start().
+ * @retval Underrun count.
+ */
+
+uint32_t STREAM_GetTarget(void);
+/**
+ * @brief  Returns the fill the buffer is steered to in live mode, or starts at in buffered mode.
+ * @retval Target [samples].
+ */
+
+uint32_t STREAM_Source(int16_t* buffer, uint32_t count);
+/**
+ * @brief  Playback source reading the buffer, see PLAYBACK_SourceTypeDef.
+ * @retval {count}, or 0 once the buffer is empty after STREAM_End().
+ */
+
+/* C++ detection */
+#ifdef __cplusplus
+}
+#endif
+
+#endif
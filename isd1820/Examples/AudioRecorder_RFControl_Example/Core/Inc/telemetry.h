@@ -0,0 +1,135 @@
+/**
+ * telemetry.h
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+USART2 telemetry stream
+----------------------------------------------------------------------
+Everything sent on USART2 goes through two ping-pong buffers: producers
+(ISRs or the main loop) append frames to one buffer while DMA sends the
+other. Appending is lock-free: space is reserved and committed with
+LDREX/STREX on a single state word, so a producer interrupted by another
+one never blocks it, and buffers are only swapped once every reserved
+frame is committed. When the fill buffer is full, frames are dropped and
+counted instead of waiting.
+
+Every frame is COBS-encoded and ends with 0x00, so telemetry records and
+command replies (see uart_cmd.h) share the line. A telemetry record is
+	[type:1][tick:varint][value:varint]...
+tick is HAL_GetTick() [ms]. Varints are LEB128: 7 bits per byte, least
+significant group first, bit 7 set on every byte but the last. Frames
+whose first byte has bit 7 set are command replies.
+
+Records, with their values in order:
+	TELEM_REC_DRIVER     ISD1820 status word (see isd1820.h)
+	TELEM_REC_FSM        event, new state (see audio_fsm.h)
+	TELEM_REC_TIMING     metric id, duration [CPU cycles]
+	TELEM_REC_WATERMARK  heap used [bytes], stack used [bytes]
+	TELEM_REC_LOG        message id, tick at LOG(), arguments (see logger.h)
+	TELEM_REC_HISTOGRAM  histogram, first bucket, counts (see metrics.h)
+TELEM_REC_TEXT frames carry printf() output instead: [type:1][text:n],
+with no tick.
+
+The host decoder, Host/Tools/telem_decode, turns each frame into one
+CSV line:
+	tick,type,value0,value1,...
+----------------------------------------------------------------------
+ */
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+/* C++ detection */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stm32f4xx_hal.h"
+
+#define TELEM_BUFFER_SIZE 512U //bytes per ping-pong buffer, at most 2047
+#define TELEM_MAX_FRAME   64U  //bytes before COBS encoding
+#define TELEM_MAX_VALUES  8U
+
+/* Record types */
+#define TELEM_REC_DRIVER     0x10U
+#define TELEM_REC_FSM        0x11U
+#define TELEM_REC_TIMING     0x12U
+#define TELEM_REC_WATERMARK  0x13U
+#define TELEM_REC_LOG        0x14U
+#define TELEM_REC_TEXT       0x15U
+#define TELEM_REC_HISTOGRAM  0x16U
+
+/* Timing metric ids */
+#define TELEM_TIMING_FSM_DISPATCH 0U
+#define TELEM_TIMING_CAPTURE_BLOCK 1U
+
+void TELEM_Init(UART_HandleTypeDef* huart);
+/**
+ * @brief  Empties both buffers, starts the DWT cycle counter and paints the stack for watermarking.
+ * @note   Call from main() before the stack gets deep.
+ * @param  huart: UART handle with a DMA TX channel linked.
+ * @retval None
+ */
+
+HAL_StatusTypeDef TELEM_Write(const uint8_t* frame, uint16_t len);
+/**
+ * @brief  COBS-encodes {frame} and appends it to the fill buffer. Safe to call from an ISR.
+ * @param  frame: Frame to send.
+ * @param  len: Frame size, at most TELEM_MAX_FRAME.
+ * @retval HAL_OK, HAL_BUSY if the fill buffer is full or HAL_ERROR if {len} is too big (the frame is dropped and counted).
+ */
+
+HAL_StatusTypeDef TELEM_Record(uint8_t type, const uint32_t* values, uint8_t count);
+/**
+ * @brief  Appends a record stamped with the current tick. Safe to call from an ISR.
+ * @param  type: TELEM_REC_xxx.
+ * @param  values: Record values.
+ * @param  count: Number of values, at most TELEM_MAX_VALUES.
+ * @retval Same as TELEM_Write().
+ */
+
+void TELEM_Flush(uint32_t arg);
+/**
+ * @brief  Hands the fill buffer to DMA if the line is free and every reserved frame was committed.
+ * @note   Main loop context only: run it as a scheduler handler (periodic timer and TX complete).
+ * @param  arg: Unused, for SCHED_HandlerTypeDef.
+ * @retval None
+ */
+
+void TELEM_Watermark(uint32_t arg);
+/**
+ * @brief  Records the heap and stack high watermarks. Main loop context only.
+ * @param  arg: Unused, for SCHED_HandlerTypeDef.
+ * @retval None
+ */
+
+void TELEM_TxCpltCallback(UART_HandleTypeDef* huart);
+/**
+ * @brief  Call from HAL_UART_TxCpltCallback(). Schedules the next flush.
+ * @param  huart: UART handle.
+ * @retval None
+ */
+
+uint32_t TELEM_GetDropped(void);
+/**
+ * @brief  Returns how many frames were dropped because the fill buffer was full.
+ * @retval Dropped frame count.
+ */
+
+/* C++ detection */
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,104 @@
+/**
+ * trace.h
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+ITM/SWO event tracing
+----------------------------------------------------------------------
+TRACE(port, value) is a single store to an ITM stimulus port: the ITM
+adds a timestamp and shifts it out on SWO (PB3) while the CPU keeps
+running. If the ITM FIFO is still busy the event is lost rather than
+waited for, so tracing never stretches the timing-sensitive paths.
+With no probe attached the stores cost the same and go nowhere.
+
+Ports and values:
+	TRACE_PORT_COMMAND  ISD1820 status word of the operation just started
+	TRACE_PORT_PIN      ISD1820_OP_x << 1 | level (ISD1820_OP_IDLE: REC, PL and PE released)
+	TRACE_PORT_TIMER    ISD1820 status word of the operation ended by the async timer
+	TRACE_PORT_FT       feed through level
+	TRACE_PORT_TIM_IRQ  async timer interrupt: 1 on entry, 0 on exit
+	TRACE_PORT_RF       FSM_EVENT_BUTTON_x decoded from the RF receiver
+	TRACE_PORT_ISR      IRQn << 1 | 1 on entry, IRQn << 1 on exit
+	TRACE_PORT_POST     address of the handler posted to the scheduler
+	TRACE_PORT_RUN      address of the handler the scheduler starts, 0 when it returns
+	TRACE_PORT_DTMF     FSM_EVENT_BUTTON_x decoded from a DTMF tone
+
+SWO stream (NRZ, 2 Mbit/s with an 84 MHz core): each event is one ITM
+software packet, header (port << 3) | 0x03 followed by the 4 value bytes
+(little-endian), followed by a local timestamp packet dating it (header
+0xC0, then up to 4 bytes of 7 bits, delta in CPU cycles; or 0x10 to
+0x60 for deltas of 1 to 6). The host decoder, Host/Tools/swo_decode,
+accumulates the deltas and prints one timeline line per software
+packet:
+	cycles,port,value
+
+The same stream maps onto the Chrome trace-event JSON format (viewable
+in Perfetto), with ts = cycles / 84 [us] and handler addresses resolved
+to names from the .elf symbols:
+	TRACE_PORT_ISR, TIM_IRQ  "ph":"B" on entry, "E" on exit, "tid":"isr"
+	TRACE_PORT_RUN           "ph":"B" on start, "E" on 0, "tid":"main"
+	TRACE_PORT_POST          "ph":"i" on "tid":"main", queued handler in args
+	TRACE_PORT_PIN, FT       "ph":"C" counter per pin
+	TRACE_PORT_COMMAND,
+	TIMER, RF, DTMF          "ph":"i" with the value in args
+swo_decode -j [-e firmware.elf] writes it one event per packet, as
+they are decoded, so long captures never need the whole trace in
+memory. The host simulation defines TRACE() itself (Host/Shim/sim.h)
+and writes the same events, dated by the host clock.
+----------------------------------------------------------------------
+ */
+#ifndef TRACE_H
+#define TRACE_H
+
+/* C++ detection */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stm32f4xx_hal.h"
+
+#define TRACE_SWO_BAUD 2000000U
+
+/* Stimulus ports (0 is left to ITM printf) */
+#define TRACE_PORT_COMMAND 1U
+#define TRACE_PORT_PIN     2U
+#define TRACE_PORT_TIMER   3U
+#define TRACE_PORT_FT      4U
+#define TRACE_PORT_TIM_IRQ 5U
+#define TRACE_PORT_RF      6U
+#define TRACE_PORT_ISR     7U
+#define TRACE_PORT_POST    8U
+#define TRACE_PORT_RUN     9U
+#define TRACE_PORT_DTMF    10U
+
+#ifndef TRACE
+#define TRACE(port, value) (ITM->PORT[(port)].u32 = (uint32_t)(value))
+#endif
+#define TRACE_ISR_ENTER(irq) TRACE(TRACE_PORT_ISR, ((uint32_t)(irq) << 1) | 1U)
+#define TRACE_ISR_EXIT(irq)  TRACE(TRACE_PORT_ISR, (uint32_t)(irq) << 1)
+
+void TRACE_Init(void);
+/**
+ * @brief  Routes SWO to PB3 and enables the ITM with timestamps on the TRACE_PORT_x ports.
+ * @note   A debugger configuring SWV overwrites the SWO speed with its own.
+ * @retval None
+ */
+
+/* C++ detection */
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,150 @@
+/**
+ * uart_cmd.h
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+USART2 binary command channel
+----------------------------------------------------------------------
+USART2 receives into a circular DMA buffer. The UART IDLE line, DMA
+half and full transfer events report how far DMA has written, with no
+per-byte interrupt. Frames are parsed later from the scheduler: each
+frame is COBS-decoded in place in the DMA buffer (only frames wrapping
+around the end of the buffer are copied) and read through packed
+structs. The RX events also count the bytes received, so if parsing
+falls a whole buffer behind and DMA writes over bytes not parsed yet,
+this is seen: the frame is dropped and parsing resumes at the next
+delimiter (UARTCMD_GetOverruns()).
+
+Frame format, before COBS encoding; frames are delimited by 0x00:
+	[cmd:1][payload:n][crc:4]
+crc is what the STM32 CRC unit gives for cmd+payload, zero-padded to a
+multiple of 4 bytes and fed as little-endian 32-bit words (CRC-32/MPEG-2:
+poly 0x04C11DB7, init 0xFFFFFFFF, no reflection, no final xor). It is
+sent little-endian.
+
+Every valid command is answered with
+	[cmd | UARTCMD_REPLY][result:1 (HAL_StatusTypeDef)][status:4 (ISD1820 status word)][crc:4]
+using the same encoding, interleaved with the telemetry stream (see
+telemetry.h).
+
+Audio is sent to the jitter buffer (see stream.h) with
+UARTCMD_STREAM_START, then UARTCMD_STREAM_DATA frames numbered from 0,
+then UARTCMD_STREAM_END. The reply to a data frame carries the stream
+state (STREAM_GetAck()) instead of the ISD1820 status word:
+	bits 0-15   next sequence number expected
+	bits 16-31  free room in the buffer [samples]
+so any reply acknowledges every frame before that number, and tells
+how much more may be in flight. A data frame holds up to
+STREAM_MAX_WRITE samples: 512 bytes of PCM16, 256 of u-law or 128 of
+ADPCM. The host keeps sending while there is
+room and goes back to the expected number when a reply shows a frame
+was lost (HAL_ERROR), refused for lack of room (HAL_BUSY) or when
+replies stop.
+
+The flash recording or a clip is pulled off the board with
+UARTCMD_OFFLOAD, as a WAV file in UARTCMD_OFFLOAD_DATA frames sent by
+the device and acknowledged with UARTCMD_OFFLOAD_ACK (see offload.h).
+Replies to both carry the transfer state (OFFLOAD_GetAck()) instead of
+the ISD1820 status word.
+----------------------------------------------------------------------
+ */
+#ifndef UART_CMD_H
+#define UART_CMD_H
+
+/* C++ detection */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stm32f4xx_hal.h"
+
+#define UARTCMD_RX_BUFFER_SIZE 2048U
+#define UARTCMD_MAX_FRAME      520U //decoded bytes, including cmd and crc: a full STREAM_Write() of PCM16
+
+/* Commands */
+#define UARTCMD_RECORD         0x01U //payload: duration [ms] (uint32_t)
+#define UARTCMD_PLAY           0x02U //payload: duration [ms] (uint32_t)
+#define UARTCMD_PLAY_COMPLETE  0x03U //no payload
+#define UARTCMD_CANCEL         0x04U //no payload
+#define UARTCMD_FEEDTHROUGH    0x05U //payload: 1 to enable, 0 to disable (uint8_t)
+#define UARTCMD_STATUS         0x06U //no payload
+#define UARTCMD_METRICS        0x07U //payload: histogram (uint8_t), 1 to take the counts sent off it (uint8_t)
+#define UARTCMD_CAPTURE        0x08U //payload: 1 to start ADC capture and voice detection, 0 to stop them (uint8_t)
+#define UARTCMD_CLIP           0x09U //payload: clip id (uint16_t), PLAYBACK_RouteTypeDef (uint8_t)
+#define UARTCMD_FLASHREC       0x0AU //payload: UARTCMD_FLASHREC_x (uint8_t), CODEC_FormatTypeDef (uint8_t)
+#define UARTCMD_MIX            0x0BU //payload: clip id (uint16_t), mixer stream (uint8_t), Q15 gain (uint16_t), PLAYBACK_RouteTypeDef (uint8_t)
+#define UARTCMD_VAD            0x0CU //payload: voice detection hangover [ms] (uint32_t)
+#define UARTCMD_SPEED          0x0DU //payload: encoded playback speed, Q16.16 from 1.0 to 2.0 (uint32_t)
+#define UARTCMD_DTMF           0x0EU //payload: 1 to keep ADC capture running for keypad tones, 0 to let it stop (uint8_t)
+#define UARTCMD_STREAM_START   0x0FU //payload: CODEC_FormatTypeDef (uint8_t), PLAYBACK_RouteTypeDef (uint8_t), STREAM_ModeTypeDef (uint8_t)
+#define UARTCMD_STREAM_DATA    0x10U //payload: sequence number (uint16_t), then the stream bytes, up to the frame size
+#define UARTCMD_STREAM_END     0x11U //payload: 1 to stop now, 0 to play out what is buffered (uint8_t)
+#define UARTCMD_OFFLOAD        0x12U //payload: UARTCMD_OFFLOAD_x (uint8_t), clip id (uint16_t)
+#define UARTCMD_OFFLOAD_ACK    0x13U //payload: next frame expected (uint16_t), 1 to send again from it (uint8_t)
+#define UARTCMD_OFFLOAD_DATA   0x14U //sent by the device, with UARTCMD_REPLY: frame number (uint16_t), then the file bytes
+#define UARTCMD_REPLY          0x80U
+
+/* UARTCMD_FLASHREC operations, see recorder.h */
+#define UARTCMD_FLASHREC_STOP  0x00U //stops capture and ends the recording
+#define UARTCMD_FLASHREC_START 0x01U //starts capture into flash in the given format, on an erased region
+#define UARTCMD_FLASHREC_ERASE 0x02U //erases the region with capture stopped, stalling the board 2 to 4s
+#define UARTCMD_FLASHREC_PLAY  0x03U //plays the recording on the DAC, in the format it was recorded in
+
+/* UARTCMD_OFFLOAD operations, see offload.h */
+#define UARTCMD_OFFLOAD_CANCEL    0x00U //stops the transfer
+#define UARTCMD_OFFLOAD_RECORDING 0x01U //sends the flash recording, the clip id is unused
+#define UARTCMD_OFFLOAD_CLIP      0x02U //sends the clip
+
+void UARTCMD_Init(UART_HandleTypeDef* huart);
+/**
+ * @brief  Enables the CRC unit and starts circular DMA reception on {huart}.
+ * @param  huart: UART handle with a circular DMA RX channel linked.
+ * @retval None
+ */
+
+void UARTCMD_RxEventCallback(UART_HandleTypeDef* huart, uint16_t pos);
+/**
+ * @brief  Call from HAL_UARTEx_RxEventCallback(). Records how far DMA has written and defers parsing to the scheduler.
+ * @param  huart: UART handle.
+ * @param  pos: Write position in the DMA buffer, as given to HAL_UARTEx_RxEventCallback().
+ * @retval None
+ */
+
+void UARTCMD_ErrorCallback(UART_HandleTypeDef* huart);
+/**
+ * @brief  Call from HAL_UART_ErrorCallback(). Restarts reception after a line error.
+ * @param  huart: UART handle.
+ * @retval None
+ */
+
+uint32_t UARTCMD_GetErrors(void);
+/**
+ * @brief  Returns how many frames were dropped (bad COBS, bad CRC, too long, unknown command or overrun).
+ * @retval Dropped frame count.
+ */
+
+uint32_t UARTCMD_GetOverruns(void);
+/**
+ * @brief  Returns how many times DMA wrote over bytes not parsed yet. The frame they were in is
+ *         dropped, counted by UARTCMD_GetErrors(), and parsing resumes at the next delimiter.
+ * @retval Overrun count.
+ */
+
+/* C++ detection */
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,105 @@
+/**
+ * vad.h
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+Voice activity detector
+----------------------------------------------------------------------
+Classifies each capture block as speech or not from two fixed point
+features:
+	energy  mean square of the samples (__SMLALD, two at a time)
+	zcr     zero crossings in the block
+against a noise floor that follows the energy of the blocks: down at
+once, up by 1/64 of the gap per non-speech block, and by 1/1024 per
+speech block. A block is speech when its energy is 6dB above the floor
+and above VAD_MIN_ENERGY, and either 12dB above the floor or with fewer
+than 3/8 zero crossings per sample (broadband hiss crosses zero about
+every other sample, voiced speech much less often).
+
+The slow rise during speech lets a loud background that sets in, a fan
+or a hum, end voice rather than hold it for good: after about 1s for
+hiss, 5s for a hum, with 16ms blocks. Speech itself keeps the floor
+down with the quiet blocks between its syllables.
+
+Voice becomes active after VAD_ONSET_BLOCKS speech blocks in a row,
+and inactive after the hangover (VAD_SetHangover()) without speech;
+VAD_ChangeCallback() reports both.
+
+Block times go to the METRICS_VAD_BLOCK histogram (see metrics.h).
+----------------------------------------------------------------------
+ */
+#ifndef VAD_H
+#define VAD_H
+
+/* C++ detection */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stm32f4xx_hal.h"
+
+#define VAD_MIN_ENERGY        10000UL //mean square, about -50dBFS
+#define VAD_ONSET_BLOCKS      2U
+#define VAD_HANGOVER_DEFAULT  500U    //ms
+
+typedef enum {
+	VAD_SILENCE = 0,
+	VAD_SPEECH,   //speech in this block
+	VAD_HANGOVER  //no speech in this block, but voice is still active
+} VAD_ResultTypeDef;
+
+void VAD_Init(uint32_t sampleRate);
+/**
+ * @brief  Sets the sample rate of the blocks and resets the detector.
+ * @retval None
+ */
+
+void VAD_Reset(void);
+/**
+ * @brief  Forgets the noise floor and the voice state, e.g. when a capture starts.
+ * @retval None
+ */
+
+void VAD_SetHangover(uint32_t ms);
+/**
+ * @brief  Sets how long voice stays active after the last speech block.
+ * @retval None
+ */
+
+VAD_ResultTypeDef VAD_Process(const int16_t* block, uint32_t count);
+/**
+ * @brief  Classifies the next {count} samples.
+ * @param  block: Samples, word aligned.
+ * @retval VAD_SPEECH, VAD_HANGOVER or VAD_SILENCE. Voice is active unless VAD_SILENCE.
+ */
+
+uint8_t VAD_IsActive(void);
+/**
+ * @brief  Returns 1 while voice is active.
+ * @retval 1 or 0.
+ */
+
+void VAD_ChangeCallback(uint8_t active);
+/**
+ * @brief  Called from VAD_Process() when voice becomes active (1) or inactive (0).
+ * @retval None
+ */
+
+/* C++ detection */
+#ifdef __cplusplus
+}
+#endif
+
+#endif
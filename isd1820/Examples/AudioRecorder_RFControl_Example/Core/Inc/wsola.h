@@ -0,0 +1,105 @@
+/**
+ * wsola.h
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+WSOLA time-scale modification
+----------------------------------------------------------------------
+Plays a Q15 stream faster, 1.0x to 2.0x, without changing its pitch
+(waveform similarity overlap-add).
+
+The output is built WSOLA_HOP samples at a time. Each hop cross-fades
+(raised cosine, Q15) from the natural continuation of the previous
+segment into a new segment, taken from the input a speed x WSOLA_HOP
+step further on: the input advances faster than the output, the
+waveform inside each segment keeps its period. The new segment starts
+where it best matches the natural continuation, within +/-WSOLA_SEEK
+samples of its nominal position: the cross-correlation over the whole
+hop is computed at every other lag with __SMLALD, two samples at a
+time, then refined at the two lags around the best. The search is the
+same fixed size whatever the signal, about 10.5k __SMLALD (21k
+multiply-accumulates) per hop.
+
+At 1.0x the search is skipped and the segment is the natural
+continuation itself, so the output is the input, bit for bit, and the
+speed can change while playing without a glitch.
+
+At the end of the stream, the input is padded with just enough zeros
+for a segment to start on its last sample: the output ends with at
+most one hop of silence.
+
+The output is pulled like the sample rate converter's (see
+resample.h). Hop times go to the METRICS_WSOLA_HOP histogram (see
+metrics.h): a hop must take well under WSOLA_HOP sample periods.
+----------------------------------------------------------------------
+ */
+#ifndef WSOLA_H
+#define WSOLA_H
+
+/* C++ detection */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stm32f4xx_hal.h"
+
+#define WSOLA_HOP         160U    //output samples per segment, 10ms at 16kHz
+#define WSOLA_SEEK        128U    //search range around the nominal position [samples], 8ms at 16kHz
+#define WSOLA_BUFFER_SIZE 1024U   //input samples, at least 2 x (WSOLA_SEEK + WSOLA_HOP) + the speed step
+#define WSOLA_SPEED_MIN   0x10000UL //Q16.16, 1.0x
+#define WSOLA_SPEED_MAX   0x20000UL //Q16.16, 2.0x
+
+typedef uint32_t (*WSOLA_InputTypeDef)(int16_t* buffer, uint32_t count);
+//Writes up to {count} Q15 input samples to {buffer} and returns how many, 0 at the end of the stream.
+
+typedef struct {
+	WSOLA_InputTypeDef input;
+	volatile uint32_t speed; //Q16.16
+	uint32_t nominal;        //Q16.16 position of the next segment in buffer, before the search
+	uint32_t natural;        //position of the natural continuation of the last segment in buffer
+	uint32_t filled;         //samples in buffer
+	uint32_t outPos;         //next sample of out to read
+	uint8_t primed;          //a segment has been output
+	uint8_t ended;
+	int16_t tail[WSOLA_HOP] __ALIGNED(4); //natural continuation of the last segment
+	int16_t out[WSOLA_HOP];
+	int16_t buffer[WSOLA_BUFFER_SIZE] __ALIGNED(4);
+} WSOLA_StateTypeDef;
+
+HAL_StatusTypeDef WSOLA_Init(WSOLA_StateTypeDef* state, WSOLA_InputTypeDef input, uint32_t speed);
+/**
+ * @brief  Starts modifying the stream from {input}.
+ * @param  speed: Q16.16, from WSOLA_SPEED_MIN to WSOLA_SPEED_MAX.
+ * @retval HAL_OK, or HAL_ERROR if {speed} is out of range.
+ */
+
+HAL_StatusTypeDef WSOLA_SetSpeed(WSOLA_StateTypeDef* state, uint32_t speed);
+/**
+ * @brief  Changes the speed from the next hop on.
+ * @retval HAL_OK, or HAL_ERROR if {speed} is out of range.
+ */
+
+uint32_t WSOLA_Read(WSOLA_StateTypeDef* state, int16_t* out, uint32_t count);
+/**
+ * @brief  Writes up to {count} output samples to {out}.
+ * @retval Sample count, fewer than {count} once the input has ended.
+ */
+
+/* C++ detection */
+#ifdef __cplusplus
+}
+#endif
+
+#endif
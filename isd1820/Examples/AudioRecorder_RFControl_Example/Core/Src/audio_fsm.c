@@ -0,0 +1,266 @@
+/**
+ * audio_fsm.c
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+Remote-controlled audio flow state machine
+----------------------------------------------------------------------
+ */
+#include "audio_fsm.h"
+#include "isd1820.h"
+#include "recorder.h"
+
+#define FSM_RECORD_TIME       10000U
+#define FSM_PLAY_TIME         5000U
+#define FSM_QUEUED_PLAY_TIME  8000U
+#define FSM_RECORD_PLAY_GAP   100U
+#define FSM_PLAY_COMPLETE_PE  100U //PE pulse: the chip then plays the whole message on its own
+
+typedef uint8_t (*FSM_ActionTypeDef)(void); //returns 0 to stay in the current state
+
+typedef struct {
+	FSM_ActionTypeDef action;
+	uint8_t next; //FSM_StateTypeDef, FSM_STATE_NONE if the event is not handled
+} FSM_TransitionTypeDef;
+
+static FSM_StateTypeDef _FSM_state;
+static uint32_t _FSM_queuedPlay;
+static ISD1820_StepTypeDef _FSM_playSteps[2];
+
+static const ISD1820_StepTypeDef _FSM_playComplete[] = {
+	{ISD1820_OP_PLAY_COMPLETE, FSM_PLAY_COMPLETE_PE}
+};
+
+static uint8_t _FSM_Record(void){
+	return ISD1820_RecordAsync(ISD1820_AsyncMsToCounts(FSM_RECORD_TIME)) == HAL_OK;
+}
+
+static uint8_t _FSM_RecordThenPlay(void){
+	if(!_FSM_Record()) return 0;
+	_FSM_queuedPlay = FSM_QUEUED_PLAY_TIME;
+	return 1;
+}
+
+static uint8_t _FSM_QueuePlay(void){
+	_FSM_queuedPlay = FSM_PLAY_TIME;
+	return 1;
+}
+
+static uint8_t _FSM_PlayQueued(void){
+	_FSM_playSteps[0].op = ISD1820_OP_IDLE;
+	_FSM_playSteps[0].duration = FSM_RECORD_PLAY_GAP;
+	_FSM_playSteps[1].op = ISD1820_OP_PLAY;
+	_FSM_playSteps[1].duration = _FSM_queuedPlay;
+	return ISD1820_SequenceStart(_FSM_playSteps, 2) == HAL_OK;
+}
+
+static uint8_t _FSM_Play(void){
+	return ISD1820_PlayAsync(ISD1820_AsyncMsToCounts(FSM_PLAY_TIME)) == HAL_OK;
+}
+
+//The PE pulse runs on the async timer: dispatch does not wait for it.
+static uint8_t _FSM_PlayComplete(void){
+	return ISD1820_SequenceStart(_FSM_playComplete, 1) == HAL_OK;
+}
+
+static uint8_t _FSM_Cancel(void){
+	ISD1820_Cancel();
+	return 1;
+}
+
+static uint8_t _FSM_DriverIdle(void){
+	return !(ISD1820_GetStatus() & ISD1820_STATUS_BUSY); //abort left over from a preemption: stay
+}
+
+static uint8_t _FSM_Listen(void){
+	return RECORDER_Listen(1) == HAL_OK;
+}
+
+static uint8_t _FSM_StopListening(void){
+	RECORDER_Listen(0);
+	return 1;
+}
+
+//Records until the voice ends, FSM_RECORD_TIME at most.
+static uint8_t _FSM_VoiceRecord(void){
+	return _FSM_Record();
+}
+
+static uint8_t _FSM_VoiceEnd(void){
+	ISD1820_StopRecording(); //record done follows
+	return 1;
+}
+
+static uint8_t _FSM_VoiceCancel(void){
+	ISD1820_Cancel();
+	return _FSM_StopListening();
+}
+
+static uint8_t _FSM_VoiceAborted(void){
+	if(!_FSM_DriverIdle()) return 0;
+	return _FSM_StopListening();
+}
+
+static uint8_t _FSM_FeedThroughOn(void){
+	ISD1820_EnableFeedThrough();
+	return 1;
+}
+
+static uint8_t _FSM_FeedThroughOff(void){
+	ISD1820_DisableFeedThrough();
+	return 1;
+}
+
+#define FSM_UNHANDLED {NULL, FSM_STATE_NONE}
+
+static const uint8_t _FSM_parent[FSM_STATE_COUNT] = {
+	[FSM_STATE_IDLE]        = FSM_STATE_NONE,
+	[FSM_STATE_ACTIVE]      = FSM_STATE_NONE,
+	[FSM_STATE_RECORDING]   = FSM_STATE_ACTIVE,
+	[FSM_STATE_QUEUED]      = FSM_STATE_ACTIVE,
+	[FSM_STATE_PLAYING]     = FSM_STATE_ACTIVE,
+	[FSM_STATE_FEEDTHROUGH] = FSM_STATE_NONE,
+	[FSM_STATE_LISTENING]   = FSM_STATE_ACTIVE,
+	[FSM_STATE_VOICE]       = FSM_STATE_ACTIVE,
+};
+
+static const FSM_TransitionTypeDef _FSM_table[FSM_STATE_COUNT][FSM_EVENT_COUNT] = {
+	[FSM_STATE_IDLE] = {
+		[FSM_EVENT_BUTTON_A]    = {_FSM_RecordThenPlay, FSM_STATE_QUEUED},
+		[FSM_EVENT_BUTTON_B]    = {_FSM_Play, FSM_STATE_PLAYING},
+		[FSM_EVENT_BUTTON_C]    = {_FSM_Listen, FSM_STATE_LISTENING},
+		[FSM_EVENT_BUTTON_D]    = {_FSM_FeedThroughOn, FSM_STATE_FEEDTHROUGH},
+		[FSM_EVENT_RECORD_DONE] = FSM_UNHANDLED,
+		[FSM_EVENT_PLAY_DONE]   = FSM_UNHANDLED,
+		[FSM_EVENT_ABORTED]     = FSM_UNHANDLED,
+		[FSM_EVENT_VOICE_START] = FSM_UNHANDLED,
+		[FSM_EVENT_VOICE_END]   = FSM_UNHANDLED,
+	},
+	[FSM_STATE_ACTIVE] = {
+		[FSM_EVENT_BUTTON_A]    = FSM_UNHANDLED,
+		[FSM_EVENT_BUTTON_B]    = FSM_UNHANDLED,
+		[FSM_EVENT_BUTTON_C]    = {_FSM_Cancel, FSM_STATE_IDLE},
+		[FSM_EVENT_BUTTON_D]    = FSM_UNHANDLED,
+		[FSM_EVENT_RECORD_DONE] = FSM_UNHANDLED,
+		[FSM_EVENT_PLAY_DONE]   = FSM_UNHANDLED,
+		[FSM_EVENT_ABORTED]     = {_FSM_DriverIdle, FSM_STATE_IDLE},
+		[FSM_EVENT_VOICE_START] = FSM_UNHANDLED,
+		[FSM_EVENT_VOICE_END]   = FSM_UNHANDLED,
+	},
+	[FSM_STATE_RECORDING] = {
+		[FSM_EVENT_BUTTON_A]    = FSM_UNHANDLED,
+		[FSM_EVENT_BUTTON_B]    = {_FSM_QueuePlay, FSM_STATE_QUEUED},
+		[FSM_EVENT_BUTTON_C]    = FSM_UNHANDLED,
+		[FSM_EVENT_BUTTON_D]    = FSM_UNHANDLED,
+		[FSM_EVENT_RECORD_DONE] = {NULL, FSM_STATE_IDLE},
+		[FSM_EVENT_PLAY_DONE]   = FSM_UNHANDLED,
+		[FSM_EVENT_ABORTED]     = FSM_UNHANDLED,
+		[FSM_EVENT_VOICE_START] = FSM_UNHANDLED,
+		[FSM_EVENT_VOICE_END]   = FSM_UNHANDLED,
+	},
+	[FSM_STATE_QUEUED] = {
+		[FSM_EVENT_BUTTON_A]    = FSM_UNHANDLED,
+		[FSM_EVENT_BUTTON_B]    = FSM_UNHANDLED,
+		[FSM_EVENT_BUTTON_C]    = FSM_UNHANDLED,
+		[FSM_EVENT_BUTTON_D]    = FSM_UNHANDLED,
+		[FSM_EVENT_RECORD_DONE] = {_FSM_PlayQueued, FSM_STATE_PLAYING},
+		[FSM_EVENT_PLAY_DONE]   = FSM_UNHANDLED,
+		[FSM_EVENT_ABORTED]     = FSM_UNHANDLED,
+		[FSM_EVENT_VOICE_START] = FSM_UNHANDLED,
+		[FSM_EVENT_VOICE_END]   = FSM_UNHANDLED,
+	},
+	[FSM_STATE_PLAYING] = {
+		[FSM_EVENT_BUTTON_A]    = FSM_UNHANDLED,
+		[FSM_EVENT_BUTTON_B]    = {_FSM_Play, FSM_STATE_PLAYING},
+		[FSM_EVENT_BUTTON_C]    = {_FSM_Record, FSM_STATE_RECORDING},
+		[FSM_EVENT_BUTTON_D]    = {_FSM_PlayComplete, FSM_STATE_PLAYING},
+		[FSM_EVENT_RECORD_DONE] = FSM_UNHANDLED,
+		[FSM_EVENT_PLAY_DONE]   = {NULL, FSM_STATE_IDLE},
+		[FSM_EVENT_ABORTED]     = FSM_UNHANDLED,
+		[FSM_EVENT_VOICE_START] = FSM_UNHANDLED,
+		[FSM_EVENT_VOICE_END]   = FSM_UNHANDLED,
+	},
+	[FSM_STATE_FEEDTHROUGH] = {
+		[FSM_EVENT_BUTTON_A]    = FSM_UNHANDLED,
+		[FSM_EVENT_BUTTON_B]    = FSM_UNHANDLED,
+		[FSM_EVENT_BUTTON_C]    = FSM_UNHANDLED,
+		[FSM_EVENT_BUTTON_D]    = {_FSM_FeedThroughOff, FSM_STATE_IDLE},
+		[FSM_EVENT_RECORD_DONE] = FSM_UNHANDLED,
+		[FSM_EVENT_PLAY_DONE]   = FSM_UNHANDLED,
+		[FSM_EVENT_ABORTED]     = FSM_UNHANDLED,
+		[FSM_EVENT_VOICE_START] = FSM_UNHANDLED,
+		[FSM_EVENT_VOICE_END]   = FSM_UNHANDLED,
+	},
+	[FSM_STATE_LISTENING] = {
+		[FSM_EVENT_BUTTON_A]    = FSM_UNHANDLED,
+		[FSM_EVENT_BUTTON_B]    = FSM_UNHANDLED,
+		[FSM_EVENT_BUTTON_C]    = {_FSM_StopListening, FSM_STATE_IDLE},
+		[FSM_EVENT_BUTTON_D]    = FSM_UNHANDLED,
+		[FSM_EVENT_RECORD_DONE] = FSM_UNHANDLED,
+		[FSM_EVENT_PLAY_DONE]   = FSM_UNHANDLED,
+		[FSM_EVENT_ABORTED]     = {NULL, FSM_STATE_LISTENING}, //left over from a preemption: keep listening
+		[FSM_EVENT_VOICE_START] = {_FSM_VoiceRecord, FSM_STATE_VOICE},
+		[FSM_EVENT_VOICE_END]   = FSM_UNHANDLED,
+	},
+	[FSM_STATE_VOICE] = {
+		[FSM_EVENT_BUTTON_A]    = FSM_UNHANDLED,
+		[FSM_EVENT_BUTTON_B]    = FSM_UNHANDLED,
+		[FSM_EVENT_BUTTON_C]    = {_FSM_VoiceCancel, FSM_STATE_IDLE},
+		[FSM_EVENT_BUTTON_D]    = FSM_UNHANDLED,
+		[FSM_EVENT_RECORD_DONE] = {_FSM_StopListening, FSM_STATE_IDLE},
+		[FSM_EVENT_PLAY_DONE]   = FSM_UNHANDLED,
+		[FSM_EVENT_ABORTED]     = {_FSM_VoiceAborted, FSM_STATE_IDLE},
+		[FSM_EVENT_VOICE_START] = FSM_UNHANDLED,
+		[FSM_EVENT_VOICE_END]   = {_FSM_VoiceEnd, FSM_STATE_VOICE},
+	},
+};
+
+void FSM_Init(void){
+	_FSM_state = FSM_STATE_IDLE;
+	_FSM_queuedPlay = 0;
+	ISD1820_SetPolicy(ISD1820_POLICY_PLAY_REPLACES_PLAY); //PLAYING+B restarts the play
+}
+
+FSM_StateTypeDef FSM_Dispatch(FSM_EventTypeDef event){
+	const FSM_TransitionTypeDef* transition;
+	uint8_t state = _FSM_state;
+	if(event >= FSM_EVENT_COUNT) return _FSM_state;
+	transition = &_FSM_table[state][event];
+	if(transition->next == FSM_STATE_NONE){
+		state = _FSM_parent[state];
+		if(state == FSM_STATE_NONE) return _FSM_state;
+		transition = &_FSM_table[state][event];
+		if(transition->next == FSM_STATE_NONE) return _FSM_state;
+	}
+	if(transition->action != NULL && !transition->action()) return _FSM_state;
+	_FSM_state = (FSM_StateTypeDef)transition->next;
+	return _FSM_state;
+}
+
+FSM_StateTypeDef FSM_GetState(void){
+	return _FSM_state;
+}
+
+FSM_EventTypeDef FSM_EventFromStatus(uint32_t status){
+	switch(ISD1820_STATUS_OP(status)){
+		case ISD1820_OP_RECORD:
+			return FSM_EVENT_RECORD_DONE;
+		case ISD1820_OP_PLAY:
+		case ISD1820_OP_PLAY_COMPLETE:
+			return FSM_EVENT_PLAY_DONE;
+		default:
+			return FSM_EVENT_NONE;
+	}
+}
@@ -0,0 +1,169 @@
+/**
+ * capture.c
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+ADC audio capture
+----------------------------------------------------------------------
+ */
+#include "capture.h"
+#include "main.h"
+
+#define CAPTURE_RING_MASK (CAPTURE_BLOCKS - 1U)
+#define CAPTURE_SAMPLE_84 (ADC_SMPR2_SMP1_2) //84 ADC cycles: the line has a high source impedance
+#define CAPTURE_TRIGGER   (ADC_CR2_EXTEN_0 | ADC_CR2_EXTSEL_1 | ADC_CR2_EXTSEL_2) //TIM2 TRGO, rising edge
+
+#if (CAPTURE_BLOCKS & CAPTURE_RING_MASK) != 0 || CAPTURE_BLOCKS < 4U
+#error "CAPTURE_BLOCKS must be a power of two, at least 4"
+#endif
+
+DMA_HandleTypeDef hdma_adc1;
+
+static TIM_HandleTypeDef* _CAPTURE_tim;
+static uint16_t _CAPTURE_blocks[CAPTURE_BLOCKS][CAPTURE_BLOCK_SIZE] __ALIGNED(4);
+static uint16_t _CAPTURE_scratch[CAPTURE_BLOCK_SIZE] __ALIGNED(4); //DMA target while the ring is full
+static volatile uint32_t _CAPTURE_filled;   //blocks completed by DMA, written by the interrupt only
+static volatile uint32_t _CAPTURE_released; //blocks given back, written by the consumer only
+static uint32_t _CAPTURE_next;              //next block to hand to DMA
+static uint8_t _CAPTURE_dropping[2];        //memory register points to the scratch block
+static uint8_t _CAPTURE_converted;          //block at _CAPTURE_released is already Q15
+static volatile uint32_t _CAPTURE_overruns;
+
+//Points the memory register DMA just finished with to the next free block.
+static void _CAPTURE_Complete(HAL_DMA_MemoryTypeDef memory){
+	uint32_t address;
+	if(!_CAPTURE_dropping[memory]){
+		_CAPTURE_filled++; //blocks are handed out and completed in order
+		CAPTURE_BlockCpltCallback();
+	}
+	if(_CAPTURE_next - _CAPTURE_released < CAPTURE_BLOCKS){
+		address = (uint32_t)_CAPTURE_blocks[_CAPTURE_next++ & CAPTURE_RING_MASK];
+		_CAPTURE_dropping[memory] = 0;
+	}else{
+		address = (uint32_t)_CAPTURE_scratch;
+		_CAPTURE_dropping[memory] = 1;
+		_CAPTURE_overruns++;
+	}
+	HAL_DMAEx_ChangeMemory(&hdma_adc1, address, memory);
+}
+
+static void _CAPTURE_M0Cplt(DMA_HandleTypeDef* hdma){
+	UNUSED(hdma);
+	_CAPTURE_Complete(MEMORY0);
+}
+
+static void _CAPTURE_M1Cplt(DMA_HandleTypeDef* hdma){
+	UNUSED(hdma);
+	_CAPTURE_Complete(MEMORY1);
+}
+
+static void _CAPTURE_Error(DMA_HandleTypeDef* hdma){
+	UNUSED(hdma);
+	_CAPTURE_overruns++;
+}
+
+void CAPTURE_Init(TIM_HandleTypeDef* tim){
+	GPIO_InitTypeDef GPIO_InitStruct = {0};
+	_CAPTURE_tim = tim;
+
+	__HAL_RCC_GPIOA_CLK_ENABLE();
+	GPIO_InitStruct.Pin = GPIO_PIN_1;
+	GPIO_InitStruct.Mode = GPIO_MODE_ANALOG;
+	GPIO_InitStruct.Pull = GPIO_NOPULL;
+	HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
+
+	__HAL_RCC_ADC1_CLK_ENABLE();
+	ADC->CCR = (ADC->CCR & ~ADC_CCR_ADCPRE) | ADC_CCR_ADCPRE_0; //PCLK2/4 = 21MHz
+	ADC1->CR1 = 0; //12 bits, single channel
+	ADC1->SMPR2 = CAPTURE_SAMPLE_84;
+	ADC1->SQR1 = 0; //1 conversion
+	ADC1->SQR3 = 1U; //channel 1
+	ADC1->CR2 = ADC_CR2_ALIGN | ADC_CR2_DMA | ADC_CR2_DDS | CAPTURE_TRIGGER | ADC_CR2_ADON;
+
+	__HAL_RCC_DMA2_CLK_ENABLE();
+	hdma_adc1.Instance = DMA2_Stream0;
+	hdma_adc1.Init.Channel = DMA_CHANNEL_0;
+	hdma_adc1.Init.Direction = DMA_PERIPH_TO_MEMORY;
+	hdma_adc1.Init.PeriphInc = DMA_PINC_DISABLE;
+	hdma_adc1.Init.MemInc = DMA_MINC_ENABLE;
+	hdma_adc1.Init.PeriphDataAlignment = DMA_PDATAALIGN_HALFWORD;
+	hdma_adc1.Init.MemDataAlignment = DMA_MDATAALIGN_HALFWORD;
+	hdma_adc1.Init.Mode = DMA_CIRCULAR;
+	hdma_adc1.Init.Priority = DMA_PRIORITY_HIGH;
+	hdma_adc1.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+	if(HAL_DMA_Init(&hdma_adc1) != HAL_OK){
+		Error_Handler();
+	}
+	hdma_adc1.XferCpltCallback = _CAPTURE_M0Cplt;
+	hdma_adc1.XferM1CpltCallback = _CAPTURE_M1Cplt;
+	hdma_adc1.XferErrorCallback = _CAPTURE_Error;
+	HAL_NVIC_SetPriority(DMA2_Stream0_IRQn, 0, 0);
+	HAL_NVIC_EnableIRQ(DMA2_Stream0_IRQn);
+}
+
+HAL_StatusTypeDef CAPTURE_Start(void){
+	if(hdma_adc1.State != HAL_DMA_STATE_READY) return HAL_BUSY;
+	_CAPTURE_filled = 0;
+	_CAPTURE_released = 0;
+	_CAPTURE_next = 2;
+	_CAPTURE_dropping[MEMORY0] = 0;
+	_CAPTURE_dropping[MEMORY1] = 0;
+	_CAPTURE_converted = 0;
+	ADC1->SR = 0;
+	if(HAL_DMAEx_MultiBufferStart_IT(&hdma_adc1, (uint32_t)&ADC1->DR, (uint32_t)_CAPTURE_blocks[0],
+			(uint32_t)_CAPTURE_blocks[1], CAPTURE_BLOCK_SIZE) != HAL_OK) return HAL_BUSY;
+	return HAL_TIM_Base_Start(_CAPTURE_tim);
+}
+
+void CAPTURE_Stop(void){
+	HAL_TIM_Base_Stop(_CAPTURE_tim);
+	HAL_DMA_Abort(&hdma_adc1);
+	ADC1->CR2 &= ~ADC_CR2_DMA; //clears a DMA overrun, if any
+	ADC1->CR2 |= ADC_CR2_DMA;
+}
+
+int16_t* CAPTURE_GetBlock(void){
+	uint32_t* words;
+	uint32_t i;
+	if(_CAPTURE_released == _CAPTURE_filled) return NULL;
+	words = (uint32_t*)_CAPTURE_blocks[_CAPTURE_released & CAPTURE_RING_MASK];
+	if(!_CAPTURE_converted){
+		for(i = 0; i < CAPTURE_BLOCK_SIZE / 2U; i++){
+			words[i] ^= 0x80008000UL; //left-aligned offset binary to Q15, two samples at a time
+		}
+		_CAPTURE_converted = 1;
+	}
+	return (int16_t*)words;
+}
+
+void CAPTURE_ReleaseBlock(void){
+	if(_CAPTURE_released == _CAPTURE_filled) return;
+	_CAPTURE_converted = 0;
+	_CAPTURE_released++;
+}
+
+uint32_t CAPTURE_GetBacklog(void){
+	return _CAPTURE_filled - _CAPTURE_released;
+}
+
+uint32_t CAPTURE_GetOverruns(void){
+	return _CAPTURE_overruns;
+}
+
+__weak void CAPTURE_BlockCpltCallback(void){
+	/* NOTE : This function should not be modified, when the callback is needed,
+	          the CAPTURE_BlockCpltCallback could be implemented in the user file
+	 */
+}
@@ -0,0 +1,122 @@
+/**
+ * clips.c
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+Flash clip library
+----------------------------------------------------------------------
+ */
+#include "clips.h"
+#include "crc32.h"
+#include "metrics.h"
+#include "mixer.h"
+#include "logger.h"
+#include <string.h>
+
+extern const uint8_t _sclips[]; //linker script: start of the CLIPS region
+extern const uint8_t _eclips[]; //linker script: end of the CLIPS region
+
+static const CLIPS_EntryTypeDef* _CLIPS_index;
+static uint16_t _CLIPS_count;
+static uint32_t _CLIPS_corrupt[(CLIPS_MAX_COUNT + 31U) / 32U]; //bit per index entry: its data fail their crc
+
+//Size of the clip data [bytes], 0 for an unknown format.
+static uint32_t _CLIPS_Size(const CLIPS_EntryTypeDef* clip){
+	uint32_t remainder = clip->length % CODEC_BLOCK_SAMPLES;
+	if(clip->format == CLIPS_FORMAT_DAC) return clip->length * sizeof(uint16_t);
+	return (clip->length / CODEC_BLOCK_SAMPLES) * CODEC_BlockSize((CODEC_FormatTypeDef)clip->format, CODEC_BLOCK_SAMPLES) +
+			(remainder ? CODEC_BlockSize((CODEC_FormatTypeDef)clip->format, remainder) : 0);
+}
+
+HAL_StatusTypeDef CLIPS_Init(void){
+	const CLIPS_HeaderTypeDef* header = (const CLIPS_HeaderTypeDef*)_sclips;
+	const CLIPS_EntryTypeDef* index = (const CLIPS_EntryTypeDef*)(header + 1);
+	uint32_t indexSize, i;
+	_CLIPS_index = NULL;
+	_CLIPS_count = 0;
+	__HAL_RCC_CRC_CLK_ENABLE();
+	if(header->magic != CLIPS_MAGIC || header->version != CLIPS_VERSION || header->count > CLIPS_MAX_COUNT) return HAL_ERROR;
+	indexSize = header->count * sizeof(CLIPS_EntryTypeDef);
+	if(header->size > (uint32_t)(_eclips - _sclips) || sizeof(CLIPS_HeaderTypeDef) + indexSize > header->size) return HAL_ERROR;
+	if(CRC32_Compute(index, indexSize) != header->crc) return HAL_ERROR;
+	for(i = 0; i < header->count; i++){
+		if((index[i].offset & 3U) || index[i].offset > header->size || index[i].length > 2U * header->size) return HAL_ERROR; //no format packs more than 2 samples a byte
+		if(_CLIPS_Size(&index[i]) > header->size - index[i].offset) return HAL_ERROR;
+		if(i && index[i].id <= index[i - 1U].id) return HAL_ERROR; //not sorted
+	}
+	memset(_CLIPS_corrupt, 0, sizeof(_CLIPS_corrupt));
+	for(i = 0; i < header->count; i++){ //once, here: no play pays for it
+		if(CLIPS_Verify(&index[i]) == HAL_OK) continue;
+		_CLIPS_corrupt[i >> 5] |= 1UL << (i & 31U);
+		LOG("clips: clip %u fails its crc", index[i].id);
+	}
+	_CLIPS_index = index;
+	_CLIPS_count = header->count;
+	return HAL_OK;
+}
+
+uint16_t CLIPS_GetCount(void){
+	return _CLIPS_count;
+}
+
+const CLIPS_EntryTypeDef* CLIPS_Find(uint16_t id){
+	uint32_t low = 0, high = _CLIPS_count, middle;
+	while(low < high){
+		middle = (low + high) >> 1;
+		if(_CLIPS_index[middle].id < id){
+			low = middle + 1U;
+		}else{
+			high = middle;
+		}
+	}
+	if(low >= _CLIPS_count || _CLIPS_index[low].id != id) return NULL;
+	if(_CLIPS_corrupt[low >> 5] & (1UL << (low & 31U))) return NULL;
+	return &_CLIPS_index[low];
+}
+
+const void* CLIPS_GetData(const CLIPS_EntryTypeDef* clip){
+	return &_sclips[clip->offset];
+}
+
+HAL_StatusTypeDef CLIPS_Verify(const CLIPS_EntryTypeDef* clip){
+	if(CRC32_Compute(CLIPS_GetData(clip), _CLIPS_Size(clip)) != clip->crc) return HAL_ERROR;
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef CLIPS_Play(uint16_t id, PLAYBACK_RouteTypeDef route){
+	uint32_t start = DWT->CYCCNT;
+	const CLIPS_EntryTypeDef* clip = CLIPS_Find(id);
+	HAL_StatusTypeDef result;
+	METRICS_Record(METRICS_CLIP_LOOKUP, DWT->CYCCNT - start);
+	if(clip == NULL) return HAL_ERROR;
+	if(clip->format == CLIPS_FORMAT_DAC){
+		result = PLAYBACK_StartDirect(CLIPS_GetData(clip), clip->length, clip->sampleRate, route);
+	}else{ //decoded, and converted to its rate, through the playback buffer
+		result = PLAYBACK_StartEncoded(CLIPS_GetData(clip), _CLIPS_Size(clip), (CODEC_FormatTypeDef)clip->format, clip->sampleRate, route);
+	}
+	if(result == HAL_OK) METRICS_Record(METRICS_CLIP_START, DWT->CYCCNT - start);
+	return result;
+}
+
+HAL_StatusTypeDef CLIPS_Mix(uint16_t id, uint8_t stream, uint16_t gain, PLAYBACK_RouteTypeDef route){
+	const CLIPS_EntryTypeDef* clip = CLIPS_Find(id);
+	HAL_StatusTypeDef result;
+	if(clip == NULL || clip->format != CLIPS_FORMAT_PCM16 || clip->sampleRate != PLAYBACK_SAMPLE_RATE) return HAL_ERROR;
+	result = MIXER_AddClip(stream, CLIPS_GetData(clip), clip->length, gain); //PCM16 blocks are plain Q15 samples
+	if(result != HAL_OK) return result;
+	result = MIXER_Start(route);
+	if(result != HAL_OK) MIXER_Remove(stream);
+	return result;
+}
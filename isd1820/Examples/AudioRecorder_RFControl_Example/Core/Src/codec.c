@@ -0,0 +1,216 @@
+/**
+ * codec.c
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+u-law and IMA-ADPCM audio codecs
+----------------------------------------------------------------------
+ */
+#include "codec.h"
+#include "metrics.h"
+#include <string.h>
+
+#define CODEC_ULAW_BIAS     0x84U  //on 16-bit samples, 0x21 on the 14-bit magnitude
+#define CODEC_ULAW_CLIP     0x1FDEU //8158: the biased magnitude stays below 0x2000, same codes as clipping at 8159
+#define CODEC_ADPCM_INDEX_MAX 88U
+
+static const int16_t _CODEC_steps[CODEC_ADPCM_INDEX_MAX + 1U] = {
+	7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+	50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230,
+	253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963,
+	1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327,
+	3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442,
+	11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794,
+	32767
+};
+
+static const int8_t _CODEC_indexes[16] = {
+	-1, -1, -1, -1, 2, 4, 6, 8,
+	-1, -1, -1, -1, 2, 4, 6, 8
+};
+
+//{biased}: 14-bit magnitude + 0x21, from 0x21 to 0x1FFF.
+static inline uint8_t _CODEC_UlawCompress(uint32_t biased, uint32_t negative){
+	uint32_t segment = 26U - __CLZ(biased); //31 - clz is the top bit, 5 for segment 0
+	return (uint8_t)(((segment << 4) | ((biased >> (segment + 1U)) & 0x0FU)) ^ (negative ? 0x7FU : 0xFFU));
+}
+
+//One sample: magnitude and sign of its top 14 bits, clipped and biased.
+static inline uint8_t _CODEC_UlawSample(int32_t sample){
+	int32_t value = sample >> 2, sign = value >> 31;
+	uint32_t magnitude = (uint32_t)((value ^ sign) - sign);
+	if(magnitude > CODEC_ULAW_CLIP) magnitude = CODEC_ULAW_CLIP; //a conditional move, not a branch
+	return _CODEC_UlawCompress(magnitude + (CODEC_ULAW_BIAS >> 2), (uint32_t)sign);
+}
+
+void CODEC_UlawEncode(const int16_t* in, uint8_t* out, uint32_t count){
+	uint32_t i;
+	for(i = 0; i < count; i++){
+		out[i] = _CODEC_UlawSample(in[i]);
+	}
+}
+
+static inline int32_t _CODEC_UlawExpand(uint32_t code){
+	int32_t t;
+	code = ~code;
+	t = (int32_t)((((code & 0x0FU) << 3) + CODEC_ULAW_BIAS) << ((code & 0x70U) >> 4));
+	return (code & 0x80U) ? (int32_t)CODEC_ULAW_BIAS - t : t - (int32_t)CODEC_ULAW_BIAS;
+}
+
+void CODEC_UlawDecode(const uint8_t* in, int16_t* out, uint32_t count){
+	uint32_t* pairs = (uint32_t*)out;
+	uint32_t i;
+	for(i = 0; i < count / 2U; i++){
+		pairs[i] = __PKHBT(_CODEC_UlawExpand(in[2U * i]), _CODEC_UlawExpand(in[2U * i + 1U]), 16);
+	}
+	if(count & 1U) out[count - 1U] = (int16_t)_CODEC_UlawExpand(in[count - 1U]);
+}
+
+static inline uint32_t _CODEC_AdpcmClampIndex(int32_t index){
+	uint32_t clamped = __USAT(index, 7);
+	return clamped > CODEC_ADPCM_INDEX_MAX ? CODEC_ADPCM_INDEX_MAX : clamped;
+}
+
+//Adds or subtracts {vpdiff} by the sign bit of {code}, saturated to 16 bits.
+static inline int32_t _CODEC_AdpcmPredict(int32_t predictor, int32_t vpdiff, uint32_t code){
+	int32_t sign = -(int32_t)((code >> 3) & 1U);
+	return __SSAT(predictor + ((vpdiff ^ sign) - sign), 16);
+}
+
+static inline uint32_t _CODEC_AdpcmQuantize(int32_t* predictor, uint32_t* index, int32_t sample){
+	int32_t step = _CODEC_steps[*index], diff = sample - *predictor;
+	int32_t vpdiff = step >> 3, mask;
+	uint32_t code = (uint32_t)(diff >> 31) & 8U;
+	diff = (diff ^ (diff >> 31)) - (diff >> 31);
+	mask = (step - 1 - diff) >> 31; //-1 where diff >= step
+	code |= 4U & (uint32_t)mask;
+	diff -= step & mask;
+	vpdiff += step & mask;
+	mask = ((step >> 1) - 1 - diff) >> 31;
+	code |= 2U & (uint32_t)mask;
+	diff -= (step >> 1) & mask;
+	vpdiff += (step >> 1) & mask;
+	mask = ((step >> 2) - 1 - diff) >> 31;
+	code |= 1U & (uint32_t)mask;
+	vpdiff += (step >> 2) & mask;
+	*predictor = _CODEC_AdpcmPredict(*predictor, vpdiff, code);
+	*index = _CODEC_AdpcmClampIndex((int32_t)*index + _CODEC_indexes[code]);
+	return code;
+}
+
+static inline int32_t _CODEC_AdpcmExpand(int32_t* predictor, uint32_t* index, uint32_t code){
+	int32_t step = _CODEC_steps[*index];
+	int32_t vpdiff = (step >> 3) + (step & -(int32_t)((code >> 2) & 1U)) + ((step >> 1) & -(int32_t)((code >> 1) & 1U)) + ((step >> 2) & -(int32_t)(code & 1U));
+	*predictor = _CODEC_AdpcmPredict(*predictor, vpdiff, code);
+	*index = _CODEC_AdpcmClampIndex((int32_t)*index + _CODEC_indexes[code]);
+	return *predictor;
+}
+
+void CODEC_AdpcmEncode(CODEC_AdpcmStateTypeDef* state, const int16_t* in, uint8_t* out, uint32_t count){
+	int32_t predictor = state->predictor;
+	uint32_t index = state->index, i, low;
+	for(i = 0; i < count / 2U; i++){
+		low = _CODEC_AdpcmQuantize(&predictor, &index, in[2U * i]);
+		out[i] = (uint8_t)(low | (_CODEC_AdpcmQuantize(&predictor, &index, in[2U * i + 1U]) << 4));
+	}
+	if(count & 1U) out[i] = (uint8_t)_CODEC_AdpcmQuantize(&predictor, &index, in[count - 1U]); //high nibble 0
+	state->predictor = (int16_t)predictor;
+	state->index = (uint8_t)index;
+}
+
+void CODEC_AdpcmDecode(CODEC_AdpcmStateTypeDef* state, const uint8_t* in, int16_t* out, uint32_t count){
+	uint32_t* pairs = (uint32_t*)out;
+	int32_t predictor = state->predictor, low;
+	uint32_t index = state->index, i;
+	for(i = 0; i < count / 2U; i++){
+		low = _CODEC_AdpcmExpand(&predictor, &index, in[i] & 0x0FU);
+		pairs[i] = __PKHBT(low, _CODEC_AdpcmExpand(&predictor, &index, in[i] >> 4), 16);
+	}
+	if(count & 1U) out[count - 1U] = (int16_t)_CODEC_AdpcmExpand(&predictor, &index, in[i] & 0x0FU);
+	state->predictor = (int16_t)predictor;
+	state->index = (uint8_t)index;
+}
+
+uint32_t CODEC_BlockSize(CODEC_FormatTypeDef format, uint32_t count){
+	switch(format){
+		case CODEC_FORMAT_PCM16:
+			return count * sizeof(int16_t);
+		case CODEC_FORMAT_ULAW:
+			return count;
+		case CODEC_FORMAT_IMA_ADPCM:
+			return CODEC_ADPCM_HEADER_SIZE + (count + 1U) / 2U;
+		default:
+			return 0;
+	}
+}
+
+uint32_t CODEC_EncodeBlock(CODEC_FormatTypeDef format, CODEC_AdpcmStateTypeDef* state, const int16_t* in, uint32_t count, void* out){
+	uint32_t start = DWT->CYCCNT;
+	uint8_t* bytes = out;
+	if(count > CODEC_BLOCK_SAMPLES) count = CODEC_BLOCK_SAMPLES;
+	switch(format){
+		case CODEC_FORMAT_PCM16:
+			memcpy(out, in, count * sizeof(int16_t));
+			break;
+		case CODEC_FORMAT_ULAW:
+			CODEC_UlawEncode(in, bytes, count);
+			break;
+		case CODEC_FORMAT_IMA_ADPCM:
+			memcpy(bytes, &state->predictor, sizeof(int16_t));
+			bytes[2] = state->index;
+			bytes[3] = 0;
+			CODEC_AdpcmEncode(state, in, &bytes[CODEC_ADPCM_HEADER_SIZE], count);
+			break;
+		default:
+			return 0;
+	}
+	METRICS_Record(METRICS_ENCODE_BLOCK, DWT->CYCCNT - start);
+	return CODEC_BlockSize(format, count);
+}
+
+uint32_t CODEC_DecodeBlock(CODEC_FormatTypeDef format, const void* in, uint32_t size, int16_t* out){
+	uint32_t start = DWT->CYCCNT, count;
+	const uint8_t* bytes = in;
+	CODEC_AdpcmStateTypeDef state;
+	switch(format){
+		case CODEC_FORMAT_PCM16:
+			count = size / sizeof(int16_t);
+			break;
+		case CODEC_FORMAT_ULAW:
+			count = size;
+			break;
+		case CODEC_FORMAT_IMA_ADPCM:
+			count = (size > CODEC_ADPCM_HEADER_SIZE) ? (size - CODEC_ADPCM_HEADER_SIZE) * 2U : 0;
+			break;
+		default:
+			return 0;
+	}
+	if(count > CODEC_BLOCK_SAMPLES) count = CODEC_BLOCK_SAMPLES;
+	switch(format){
+		case CODEC_FORMAT_PCM16:
+			memcpy(out, in, count * sizeof(int16_t));
+			break;
+		case CODEC_FORMAT_ULAW:
+			CODEC_UlawDecode(bytes, out, count);
+			break;
+		default:
+			memcpy(&state.predictor, bytes, sizeof(int16_t));
+			state.index = (uint8_t)_CODEC_AdpcmClampIndex(bytes[2]);
+			CODEC_AdpcmDecode(&state, &bytes[CODEC_ADPCM_HEADER_SIZE], out, count);
+			break;
+	}
+	METRICS_Record(METRICS_DECODE_BLOCK, DWT->CYCCNT - start);
+	return count;
+}
@@ -0,0 +1,40 @@
+/**
+ * crc32.c
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+CRC-32 on the CRC unit
+----------------------------------------------------------------------
+ */
+#include "crc32.h"
+#include <string.h>
+
+uint32_t CRC32_Compute(const void* data, uint32_t len){
+	const uint8_t* bytes = (const uint8_t*)data;
+	uint32_t word;
+	CRC->CR = CRC_CR_RESET;
+	while(len >= 4U){
+		memcpy(&word, bytes, 4U); //a single unaligned load
+		CRC->DR = word;
+		bytes += 4U;
+		len -= 4U;
+	}
+	if(len){
+		word = 0;
+		memcpy(&word, bytes, len);
+		CRC->DR = word;
+	}
+	return CRC->DR;
+}
@@ -0,0 +1,121 @@
+/**
+ * dtmf.c
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+DTMF detector
+----------------------------------------------------------------------
+ */
+#include "dtmf.h"
+#include "metrics.h"
+
+#define DTMF_TONES      8U //4 rows, then 4 columns
+#define DTMF_COEF_SHIFT 14U
+
+//2cos(2pi f / 8000), Q14: 697, 770, 852, 941, 1209, 1336, 1477, 1633Hz
+static const int32_t _DTMF_coefs[DTMF_TONES] = {27980, 26956, 25701, 24219, 19073, 16325, 13085, 9315};
+static const char _DTMF_keys[4][4] = {
+	{'1', '2', '3', 'A'},
+	{'4', '5', '6', 'B'},
+	{'7', '8', '9', 'C'},
+	{'*', '0', '#', 'D'}
+};
+
+static char _DTMF_key;       //key held, 0 if none
+static char _DTMF_candidate; //key of the last blocks
+static uint32_t _DTMF_count; //blocks in a row with the candidate
+
+//Goertzel power of {x} at one frequency, (A x n / 2)^2 for a sine of amplitude A.
+static uint64_t _DTMF_Power(const int16_t* x, uint32_t n, int32_t coef){
+	int32_t s0, s1 = 0, s2 = 0;
+	uint32_t i;
+	for(i = 0; i < n; i++){
+		s0 = x[i] + (int32_t)(((int64_t)coef * s1) >> DTMF_COEF_SHIFT) - s2;
+		s2 = s1;
+		s1 = s0;
+	}
+	return (uint64_t)((int64_t)s1 * s1 + (int64_t)s2 * s2 - (((int64_t)coef * s1 >> DTMF_COEF_SHIFT) * s2));
+}
+
+//Index of the strongest of 4 tones, or -1 if another one is less than 9dB below it.
+static int32_t _DTMF_Peak(const uint64_t* power){
+	uint32_t best = 0, i;
+	for(i = 1; i < 4U; i++){
+		if(power[i] > power[best]) best = i;
+	}
+	for(i = 0; i < 4U; i++){
+		if(i != best && power[i] * 8U > power[best]) return -1;
+	}
+	return (int32_t)best;
+}
+
+//Key held by the decimated block {x}, or 0.
+static char _DTMF_Detect(const int16_t* x, uint32_t n, uint64_t energy){
+	uint64_t power[DTMF_TONES], row, column;
+	int32_t r, c;
+	uint32_t i;
+	if(energy <= (uint64_t)DTMF_MIN_ENERGY * n) return 0;
+	for(i = 0; i < DTMF_TONES; i++){
+		power[i] = _DTMF_Power(x, n, _DTMF_coefs[i]);
+	}
+	r = _DTMF_Peak(&power[0]);
+	c = _DTMF_Peak(&power[4]);
+	if(r < 0 || c < 0) return 0;
+	row = power[r];
+	column = power[4 + c];
+	if(4U * (row + column) < energy * n) return 0; //tones below half the energy
+	if(column * 6U < row || 2U * column > 5U * row) return 0; //twist
+	return _DTMF_keys[r][c];
+}
+
+void DTMF_Reset(void){
+	_DTMF_key = 0;
+	_DTMF_candidate = 0;
+	_DTMF_count = 0;
+}
+
+char DTMF_Process(const int16_t* block, uint32_t count){
+	int16_t x[DTMF_MAX_BLOCK / 2U];
+	uint32_t start = DWT->CYCCNT, n = count / 2U, i;
+	uint64_t energy = 0;
+	char key;
+	if(n > DTMF_MAX_BLOCK / 2U) n = DTMF_MAX_BLOCK / 2U;
+	for(i = 0; i < n; i++){ //8kHz, the pair average is the anti-alias filter
+		x[i] = (int16_t)((block[2U * i] + block[2U * i + 1U]) >> 1);
+		energy += (uint32_t)(x[i] * x[i]);
+	}
+	key = n ? _DTMF_Detect(x, n, energy) : 0;
+	if(key == _DTMF_candidate){
+		_DTMF_count++;
+	}else{
+		_DTMF_candidate = key;
+		_DTMF_count = 1;
+	}
+	if(key && _DTMF_count == DTMF_ON_BLOCKS && key != _DTMF_key){
+		_DTMF_key = key;
+		DTMF_KeyCallback(key);
+	}else if(!key && _DTMF_count >= DTMF_OFF_BLOCKS){
+		_DTMF_key = 0;
+	}
+	METRICS_Record(METRICS_DTMF_BLOCK, DWT->CYCCNT - start);
+	return key;
+}
+
+__weak void DTMF_KeyCallback(char key){
+	UNUSED(key);
+	/* NOTE : This function should not be modified, when the callback is needed,
+	          the DTMF_KeyCallback could be implemented in the user file
+	 */
+}
@@ -0,0 +1,215 @@
+/**
+ * flash_writer.c
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+Streaming flash writer
+----------------------------------------------------------------------
+ */
+#include "flash_writer.h"
+#include "scheduler.h"
+#include "metrics.h"
+#include "logger.h"
+
+#define FLASHWR_QUEUE_MASK (FLASHWR_QUEUE_WORDS - 1U)
+#define FLASHWR_ERASED     0xFFFFFFFFUL
+#define FLASHWR_SR_ERRORS  (FLASH_FLAG_OPERR | FLASH_FLAG_WRPERR | FLASH_FLAG_PGAERR | FLASH_FLAG_PGPERR | FLASH_FLAG_PGSERR | FLASH_FLAG_RDERR)
+
+#if (FLASHWR_QUEUE_WORDS & FLASHWR_QUEUE_MASK) != 0
+#error "FLASHWR_QUEUE_WORDS must be a power of two"
+#endif
+
+extern uint32_t _srecord[]; //linker script: start of the RECORD region
+extern uint32_t _erecord[]; //linker script: end of the RECORD region
+
+static uint32_t _FLASHWR_queue[FLASHWR_QUEUE_WORDS];
+static uint32_t _FLASHWR_head;     //words queued, written by FLASHWR_Write() only
+static uint32_t _FLASHWR_tail;     //words programmed, written by the service only
+static uint32_t* _FLASHWR_address; //next word to program
+static uint8_t _FLASHWR_posted;    //service pending in the scheduler
+static uint8_t _FLASHWR_ending;
+static uint32_t _FLASHWR_limit;    //recording length programmed at the end, at most [bytes]
+static volatile FLASHWR_StateTypeDef _FLASHWR_state;
+
+//Runs from RAM: the CPU only stalls on flash fetches from interrupts while a word programs.
+__RAM_FUNC __NOINLINE static uint32_t _FLASHWR_Program(uint32_t* address, const uint32_t* data, uint32_t words){
+	uint32_t i;
+	FLASH->CR = (FLASH->CR & ~FLASH_CR_PSIZE) | FLASH_PSIZE_WORD | FLASH_CR_PG;
+	for(i = 0; i < words; i++){
+		address[i] = data[i];
+		__DSB();
+		while(FLASH->SR & FLASH_SR_BSY);
+		if(FLASH->SR & FLASHWR_SR_ERRORS) break;
+	}
+	FLASH->CR &= ~FLASH_CR_PG;
+	return i;
+}
+
+static void _FLASHWR_Fail(void){
+	LOG("flash_writer: program error at %08lx, SR %08lx", (uint32_t)_FLASHWR_address, FLASH->SR);
+	FLASH->SR = FLASHWR_SR_ERRORS; //write 1 to clear
+	HAL_FLASH_Lock();
+	_FLASHWR_state = FLASHWR_STATE_ERROR;
+}
+
+//Programs the length word. The data cache may hold the erased values of the recording.
+static void _FLASHWR_Finish(void){
+	uint32_t length = (uint32_t)(_FLASHWR_address - _srecord - 2) * sizeof(uint32_t);
+	if(length > _FLASHWR_limit) length = _FLASHWR_limit;
+	if(_FLASHWR_Program(_srecord, &length, 1) != 1U){
+		_FLASHWR_Fail();
+		return;
+	}
+	HAL_FLASH_Lock();
+	__HAL_FLASH_DATA_CACHE_DISABLE();
+	__HAL_FLASH_DATA_CACHE_RESET();
+	__HAL_FLASH_DATA_CACHE_ENABLE();
+	_FLASHWR_state = FLASHWR_STATE_DONE;
+}
+
+static void _FLASHWR_Service(uint32_t arg){
+	uint32_t tail = _FLASHWR_tail, index = tail & FLASHWR_QUEUE_MASK;
+	uint32_t n = _FLASHWR_head - tail, done, start;
+	UNUSED(arg);
+	if(_FLASHWR_state != FLASHWR_STATE_RECORDING){
+		_FLASHWR_posted = 0;
+		return;
+	}
+	if(n > FLASHWR_BURST_WORDS) n = FLASHWR_BURST_WORDS;
+	if(index + n > FLASHWR_QUEUE_WORDS) n = FLASHWR_QUEUE_WORDS - index; //up to the end of the ring
+	start = DWT->CYCCNT;
+	done = _FLASHWR_Program(_FLASHWR_address, &_FLASHWR_queue[index], n);
+	METRICS_Record(METRICS_FLASH_BURST, DWT->CYCCNT - start);
+	_FLASHWR_address += done;
+	_FLASHWR_tail = tail + done;
+	if(done != n){
+		_FLASHWR_posted = 0;
+		_FLASHWR_Fail();
+		return;
+	}
+	if(_FLASHWR_head != _FLASHWR_tail && SCHED_Post(SCHED_PRIO_LOW, _FLASHWR_Service, 0) == HAL_OK) return;
+	_FLASHWR_posted = 0;
+	if(_FLASHWR_ending && _FLASHWR_head == _FLASHWR_tail) _FLASHWR_Finish();
+}
+
+void FLASHWR_Init(void){
+	const uint32_t* word;
+	if(*_srecord != FLASHWR_ERASED){
+		_FLASHWR_state = FLASHWR_STATE_DONE;
+		return;
+	}
+	for(word = _srecord; word < _erecord; word++){
+		if(*word != FLASHWR_ERASED){
+			_FLASHWR_state = FLASHWR_STATE_UNKNOWN; //a recording interrupted by a reset
+			return;
+		}
+	}
+	_FLASHWR_state = FLASHWR_STATE_ERASED;
+}
+
+HAL_StatusTypeDef FLASHWR_Erase(void){
+	FLASH_EraseInitTypeDef erase = {0};
+	if(_FLASHWR_state == FLASHWR_STATE_ERASING || _FLASHWR_state == FLASHWR_STATE_RECORDING) return HAL_BUSY;
+	erase.TypeErase = FLASH_TYPEERASE_SECTORS;
+	erase.Sector = FLASH_SECTOR_6;
+	erase.NbSectors = 2;
+	erase.VoltageRange = FLASH_VOLTAGE_RANGE_3;
+	HAL_FLASH_Unlock();
+	FLASH->SR = FLASHWR_SR_ERRORS;
+	_FLASHWR_state = FLASHWR_STATE_ERASING;
+	if(HAL_FLASHEx_Erase_IT(&erase) != HAL_OK){
+		HAL_FLASH_Lock();
+		_FLASHWR_state = FLASHWR_STATE_UNKNOWN;
+		return HAL_BUSY;
+	}
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef FLASHWR_Begin(uint32_t tag){
+	if(_FLASHWR_state == FLASHWR_STATE_ERASING || _FLASHWR_state == FLASHWR_STATE_RECORDING) return HAL_BUSY;
+	if(_FLASHWR_state != FLASHWR_STATE_ERASED) return HAL_ERROR;
+	_FLASHWR_head = 0;
+	_FLASHWR_tail = 0;
+	_FLASHWR_ending = 0;
+	HAL_FLASH_Unlock();
+	FLASH->SR = FLASHWR_SR_ERRORS;
+	if(_FLASHWR_Program(_srecord + 1, &tag, 1) != 1U){ //the first word is the length, the second the tag
+		_FLASHWR_Fail();
+		return HAL_ERROR;
+	}
+	_FLASHWR_address = _srecord + 2;
+	_FLASHWR_state = FLASHWR_STATE_RECORDING;
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef FLASHWR_Write(const void* data, uint32_t len){
+	const uint32_t* words = data;
+	uint32_t count = len / sizeof(uint32_t), head = _FLASHWR_head, i;
+	if(_FLASHWR_state != FLASHWR_STATE_RECORDING || _FLASHWR_ending) return HAL_ERROR;
+	if((uint32_t)(_erecord - _FLASHWR_address) - (head - _FLASHWR_tail) < count) return HAL_ERROR; //region full
+	if(FLASHWR_QUEUE_WORDS - (head - _FLASHWR_tail) < count) return HAL_BUSY;
+	for(i = 0; i < count; i++){
+		_FLASHWR_queue[(head + i) & FLASHWR_QUEUE_MASK] = words[i];
+	}
+	_FLASHWR_head = head + count;
+	if(!_FLASHWR_posted && SCHED_Post(SCHED_PRIO_LOW, _FLASHWR_Service, 0) == HAL_OK) _FLASHWR_posted = 1;
+	return HAL_OK;
+}
+
+void FLASHWR_End(void){
+	FLASHWR_EndAt(0xFFFFFFFFUL);
+}
+
+void FLASHWR_EndAt(uint32_t length){
+	if(_FLASHWR_state != FLASHWR_STATE_RECORDING || _FLASHWR_ending) return;
+	_FLASHWR_limit = length & ~3UL;
+	_FLASHWR_ending = 1;
+	if(!_FLASHWR_posted){
+		if(_FLASHWR_head == _FLASHWR_tail){
+			_FLASHWR_Finish();
+		}else if(SCHED_Post(SCHED_PRIO_LOW, _FLASHWR_Service, 0) == HAL_OK){
+			_FLASHWR_posted = 1;
+		}
+	}
+}
+
+uint32_t FLASHWR_GetLength(void){
+	return (_FLASHWR_state == FLASHWR_STATE_RECORDING) ? _FLASHWR_head * sizeof(uint32_t) : 0;
+}
+
+FLASHWR_StateTypeDef FLASHWR_GetState(void){
+	return _FLASHWR_state;
+}
+
+uint32_t FLASHWR_GetRecording(const void** data, uint32_t* tag){
+	uint32_t length = *_srecord;
+	*data = _srecord + 2;
+	*tag = _srecord[1];
+	if(_FLASHWR_state != FLASHWR_STATE_DONE || length > (uint32_t)(_erecord - _srecord - 2) * sizeof(uint32_t)) return 0;
+	return length;
+}
+
+void FLASHWR_EndOfOperationCallback(uint32_t value){
+	if(_FLASHWR_state != FLASHWR_STATE_ERASING || value != 0xFFFFFFFFUL) return; //one sector erased, more to go
+	HAL_FLASH_Lock();
+	_FLASHWR_state = FLASHWR_STATE_ERASED;
+}
+
+void FLASHWR_OperationErrorCallback(uint32_t value){
+	UNUSED(value);
+	if(_FLASHWR_state != FLASHWR_STATE_ERASING) return;
+	HAL_FLASH_Lock();
+	_FLASHWR_state = FLASHWR_STATE_ERROR;
+}
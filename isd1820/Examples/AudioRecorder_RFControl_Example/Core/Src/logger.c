@@ -0,0 +1,93 @@
+/**
+ * logger.c
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+Deferred-format binary logging
+----------------------------------------------------------------------
+ */
+#include "logger.h"
+#include "telemetry.h"
+#include <string.h>
+
+#define LOG_RING_MASK   (LOG_RING_SIZE - 1U)
+#define LOG_COUNT_Msk   0xFFU
+#define LOG_ID_Pos      8U
+#define LOG_HEADER_SIZE 2U //words: id and count, tick
+
+#if (LOG_RING_SIZE & LOG_RING_MASK) != 0
+#error "LOG_RING_SIZE must be a power of two"
+#endif
+
+/* Ring entry: [id << LOG_ID_Pos | count][tick][arg]... */
+static uint32_t _LOG_ring[LOG_RING_SIZE];
+static volatile uint16_t _LOG_head; //written by LOG_Write(), with interrupts masked
+static volatile uint16_t _LOG_tail; //written by LOG_Drain() only
+static volatile uint32_t _LOG_dropped;
+
+void LOG_Write(uint32_t id, uint32_t count, const uint32_t* args){
+	uint32_t primask = __get_PRIMASK();
+	uint32_t head, i;
+	if(count > LOG_MAX_ARGS) count = LOG_MAX_ARGS; //the drain has room for no more
+	__disable_irq();
+	head = _LOG_head;
+	if(((_LOG_tail - head - 1U) & LOG_RING_MASK) < LOG_HEADER_SIZE + count){
+		_LOG_dropped++;
+		__set_PRIMASK(primask);
+		return;
+	}
+	_LOG_ring[head] = (id << LOG_ID_Pos) | count;
+	_LOG_ring[(head + 1U) & LOG_RING_MASK] = uwTick;
+	for(i = 0; i < count; i++){
+		_LOG_ring[(head + LOG_HEADER_SIZE + i) & LOG_RING_MASK] = args[i];
+	}
+	_LOG_head = (head + LOG_HEADER_SIZE + count) & LOG_RING_MASK;
+	__set_PRIMASK(primask);
+}
+
+void LOG_Drain(uint32_t arg){
+	uint32_t values[LOG_HEADER_SIZE + LOG_MAX_ARGS];
+	uint32_t tail = _LOG_tail, count, i;
+	UNUSED(arg);
+	while(tail != _LOG_head){
+		count = _LOG_ring[tail] & LOG_COUNT_Msk;
+		values[0] = _LOG_ring[tail] >> LOG_ID_Pos;
+		for(i = 1; i < LOG_HEADER_SIZE + count; i++){
+			values[i] = _LOG_ring[(tail + i) & LOG_RING_MASK];
+		}
+		if(TELEM_Record(TELEM_REC_LOG, values, LOG_HEADER_SIZE + count) == HAL_BUSY) break; //stream full: retry on the next drain
+		tail = (tail + LOG_HEADER_SIZE + count) & LOG_RING_MASK;
+		_LOG_tail = tail;
+	}
+}
+
+uint32_t LOG_GetDropped(void){
+	return _LOG_dropped;
+}
+
+int _write(int file, char *ptr, int len){
+	uint8_t frame[TELEM_MAX_FRAME];
+	int sent = 0;
+	uint16_t chunk;
+	UNUSED(file);
+	frame[0] = TELEM_REC_TEXT;
+	while(sent < len){
+		chunk = (len - sent > TELEM_MAX_FRAME - 1) ? TELEM_MAX_FRAME - 1 : len - sent;
+		memcpy(&frame[1], &ptr[sent], chunk);
+		if(TELEM_Write(frame, chunk + 1U) != HAL_OK) break; //never blocks: the rest of the text is dropped
+		sent += chunk;
+	}
+	return len;
+}
@@ -23,6 +23,19 @@
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
 #include "isd1820.h"
+#include "scheduler.h"
+#include "audio_fsm.h"
+#include "uart_cmd.h"
+#include "telemetry.h"
+#include "logger.h"
+#include "capture.h"
+#include "playback.h"
+#include "clips.h"
+#include "flash_writer.h"
+#include "recorder.h"
+#include "vad.h"
+#include "dtmf.h"
+#include "offload.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -32,6 +45,12 @@
 
 /* Private define ------------------------------------------------------------*/
 /* USER CODE BEGIN PD */
+#define LED_TIMER       0U
+#define TELEM_TIMER     1U
+#define WATERMARK_TIMER 2U
+#define LOG_TIMER       3U
+#define OFFLOAD_TIMER   4U
+#define METRICS_TIMER   5U
 /* USER CODE END PD */
 
 /* Private macro -------------------------------------------------------------*/
@@ -40,7 +59,14 @@
 /* USER CODE END PM */
 
 /* Private variables ---------------------------------------------------------*/
+TIM_HandleTypeDef htim2;
+TIM_HandleTypeDef htim5;
+TIM_HandleTypeDef htim6;
+DMA_HandleTypeDef hdma_tim6_up;
+
 UART_HandleTypeDef huart2;
+DMA_HandleTypeDef hdma_usart2_rx;
+DMA_HandleTypeDef hdma_usart2_tx;
 
 /* USER CODE BEGIN PV */
 
@@ -49,14 +75,53 @@ UART_HandleTypeDef huart2;
 /* Private function prototypes -----------------------------------------------*/
 void SystemClock_Config(void);
 static void MX_GPIO_Init(void);
+static void MX_DMA_Init(void);
 static void MX_USART2_UART_Init(void);
+static void MX_TIM5_Init(void);
+static void MX_TIM2_Init(void);
+static void MX_TIM6_Init(void);
 /* USER CODE BEGIN PFP */
-
+static void Audio_EventHandler(uint32_t event);
+static void LED_Handler(uint32_t arg);
+static void Capture_Handler(uint32_t arg);
 /* USER CODE END PFP */
 
 /* Private user code ---------------------------------------------------------*/
 /* USER CODE BEGIN 0 */
-uint8_t state = 0;
+static void Audio_EventHandler(uint32_t event){
+	uint32_t start = DWT->CYCCNT;
+	FSM_StateTypeDef state = FSM_Dispatch((FSM_EventTypeDef)event);
+	uint32_t values[2];
+	values[0] = TELEM_TIMING_FSM_DISPATCH;
+	values[1] = DWT->CYCCNT - start;
+	TELEM_Record(TELEM_REC_TIMING, values, 2);
+	values[0] = event;
+	values[1] = state;
+	TELEM_Record(TELEM_REC_FSM, values, 2);
+	values[0] = ISD1820_GetStatus(); //operation the transition started, if any
+	TELEM_Record(TELEM_REC_DRIVER, values, 1);
+	if(state == FSM_STATE_IDLE){
+		HAL_GPIO_WritePin(LD2_GPIO_Port, LD2_Pin, 0); //turn LED off
+		SCHED_TimerStop(LED_TIMER);
+	}else{
+		SCHED_TimerStart(LED_TIMER, 250, 250, LED_Handler, 0);
+	}
+}
+
+static void LED_Handler(uint32_t arg){
+	UNUSED(arg);
+	HAL_GPIO_TogglePin(LD2_GPIO_Port, LD2_Pin); //blink while not idle
+}
+
+static void Capture_Handler(uint32_t arg){
+	uint32_t start = DWT->CYCCNT;
+	uint32_t values[2];
+	UNUSED(arg);
+	RECORDER_Process();
+	values[0] = TELEM_TIMING_CAPTURE_BLOCK;
+	values[1] = DWT->CYCCNT - start;
+	TELEM_Record(TELEM_REC_TIMING, values, 2);
+}
 /* USER CODE END 0 */
 
 /**
@@ -87,8 +152,34 @@ int main(void)
 
   /* Initialize all configured peripherals */
   MX_GPIO_Init();
+  MX_DMA_Init();
   MX_USART2_UART_Init();
+  MX_TIM5_Init();
+  MX_TIM2_Init();
+  MX_TIM6_Init();
   /* USER CODE BEGIN 2 */
+  TRACE_Init();
+  SCHED_Init();
+  ISD1820_AsyncInit(&htim5);
+  FSM_Init();
+  TELEM_Init(&huart2);
+  UARTCMD_Init(&huart2);
+  OFFLOAD_Init(&huart2);
+  CAPTURE_Init(&htim2);
+  VAD_Init(CAPTURE_SAMPLE_RATE);
+  PLAYBACK_Init(&htim6);
+  if(CLIPS_Init() != HAL_OK){
+    LOG("clips: no clip library in flash");
+  }
+  FLASHWR_Init();
+  if(RECORDER_ListenTones(1) != HAL_OK){ //keypad tones work like the RF remote
+    LOG("dtmf: capture does not start");
+  }
+  SCHED_TimerStart(TELEM_TIMER, 10, 10, TELEM_Flush, 0);
+  SCHED_TimerStart(WATERMARK_TIMER, 1000, 1000, TELEM_Watermark, 0);
+  SCHED_TimerStart(LOG_TIMER, 10, 10, LOG_Drain, 0);
+  SCHED_TimerStart(OFFLOAD_TIMER, 10, 10, OFFLOAD_Poll, 0);
+  SCHED_TimerStart(METRICS_TIMER, 10, 10, METRICS_DumpPoll, 0);
   ///ISD1820_RecordAndPlay(10000, 5000);
   /* USER CODE END 2 */
 
@@ -97,31 +188,9 @@ int main(void)
   while (1)
   {
     /* USER CODE END WHILE */
-	  switch (state) {
-	  	case 0:
-	  		HAL_GPIO_WritePin(LD2_GPIO_Port, LD2_Pin, 0); //turn LED off
-	  		break;
-
-		case 1://button A
-			ISD1820_RecordAndPlay(10000, 8000); //records 10 seconds and plays 8 seconds
-			state = 0;
-			break;
-		case 2://button B
-			ISD1820_Play(5000); //play 5 seconds
-			state = 0;
-			break;
-		case 3://button C
-			ISD1820_Record(10000);
-			state = 0;
-			break;
-		case 4://button D
-			ISD1820_PlayComplete();
-			state = 0;
-			break;
-		default:
-			break;
-	}
+
     /* USER CODE BEGIN 3 */
+	  SCHED_Run(); //runs RF, driver and LED events through the state machine forever, sleeping in between
   }
   /* USER CODE END 3 */
 }
@@ -171,6 +240,134 @@ void SystemClock_Config(void)
   }
 }
 
+/**
+  * @brief TIM2 Initialization Function
+  * @param None
+  * @retval None
+  */
+static void MX_TIM2_Init(void)
+{
+
+  /* USER CODE BEGIN TIM2_Init 0 */
+
+  /* USER CODE END TIM2_Init 0 */
+
+  TIM_ClockConfigTypeDef sClockSourceConfig = {0};
+  TIM_MasterConfigTypeDef sMasterConfig = {0};
+
+  /* USER CODE BEGIN TIM2_Init 1 */
+
+  /* USER CODE END TIM2_Init 1 */
+  htim2.Instance = TIM2;
+  htim2.Init.Prescaler = 0;
+  htim2.Init.CounterMode = TIM_COUNTERMODE_UP;
+  htim2.Init.Period = 5249;
+  htim2.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+  htim2.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
+  if (HAL_TIM_Base_Init(&htim2) != HAL_OK)
+  {
+    Error_Handler();
+  }
+  sClockSourceConfig.ClockSource = TIM_CLOCKSOURCE_INTERNAL;
+  if (HAL_TIM_ConfigClockSource(&htim2, &sClockSourceConfig) != HAL_OK)
+  {
+    Error_Handler();
+  }
+  sMasterConfig.MasterOutputTrigger = TIM_TRGO_UPDATE;
+  sMasterConfig.MasterSlaveMode = TIM_MASTERSLAVEMODE_DISABLE;
+  if (HAL_TIMEx_MasterConfigSynchronization(&htim2, &sMasterConfig) != HAL_OK)
+  {
+    Error_Handler();
+  }
+  /* USER CODE BEGIN TIM2_Init 2 */
+
+  /* USER CODE END TIM2_Init 2 */
+
+}
+
+/**
+  * @brief TIM5 Initialization Function
+  * @param None
+  * @retval None
+  */
+static void MX_TIM5_Init(void)
+{
+
+  /* USER CODE BEGIN TIM5_Init 0 */
+
+  /* USER CODE END TIM5_Init 0 */
+
+  TIM_ClockConfigTypeDef sClockSourceConfig = {0};
+  TIM_MasterConfigTypeDef sMasterConfig = {0};
+
+  /* USER CODE BEGIN TIM5_Init 1 */
+
+  /* USER CODE END TIM5_Init 1 */
+  htim5.Instance = TIM5;
+  htim5.Init.Prescaler = 8399;
+  htim5.Init.CounterMode = TIM_COUNTERMODE_UP;
+  htim5.Init.Period = 99999;
+  htim5.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+  htim5.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
+  if (HAL_TIM_Base_Init(&htim5) != HAL_OK)
+  {
+    Error_Handler();
+  }
+  sClockSourceConfig.ClockSource = TIM_CLOCKSOURCE_INTERNAL;
+  if (HAL_TIM_ConfigClockSource(&htim5, &sClockSourceConfig) != HAL_OK)
+  {
+    Error_Handler();
+  }
+  sMasterConfig.MasterOutputTrigger = TIM_TRGO_RESET;
+  sMasterConfig.MasterSlaveMode = TIM_MASTERSLAVEMODE_DISABLE;
+  if (HAL_TIMEx_MasterConfigSynchronization(&htim5, &sMasterConfig) != HAL_OK)
+  {
+    Error_Handler();
+  }
+  /* USER CODE BEGIN TIM5_Init 2 */
+
+  /* USER CODE END TIM5_Init 2 */
+
+}
+
+/**
+  * @brief TIM6 Initialization Function
+  * @param None
+  * @retval None
+  */
+static void MX_TIM6_Init(void)
+{
+
+  /* USER CODE BEGIN TIM6_Init 0 */
+
+  /* USER CODE END TIM6_Init 0 */
+
+  TIM_MasterConfigTypeDef sMasterConfig = {0};
+
+  /* USER CODE BEGIN TIM6_Init 1 */
+
+  /* USER CODE END TIM6_Init 1 */
+  htim6.Instance = TIM6;
+  htim6.Init.Prescaler = 0;
+  htim6.Init.CounterMode = TIM_COUNTERMODE_UP;
+  htim6.Init.Period = 5249;
+  htim6.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
+  if (HAL_TIM_Base_Init(&htim6) != HAL_OK)
+  {
+    Error_Handler();
+  }
+  sMasterConfig.MasterOutputTrigger = TIM_TRGO_RESET;
+  sMasterConfig.MasterSlaveMode = TIM_MASTERSLAVEMODE_DISABLE;
+  if (HAL_TIMEx_MasterConfigSynchronization(&htim6, &sMasterConfig) != HAL_OK)
+  {
+    Error_Handler();
+  }
+  /* USER CODE BEGIN TIM6_Init 2 */
+
+  /* USER CODE END TIM6_Init 2 */
+
+}
+
 /**
   * @brief USART2 Initialization Function
   * @param None
@@ -187,7 +384,7 @@ static void MX_USART2_UART_Init(void)
 
   /* USER CODE END USART2_Init 1 */
   huart2.Instance = USART2;
-  huart2.Init.BaudRate = 115200;
+  huart2.Init.BaudRate = 2000000;
   huart2.Init.WordLength = UART_WORDLENGTH_8B;
   huart2.Init.StopBits = UART_STOPBITS_1;
   huart2.Init.Parity = UART_PARITY_NONE;
@@ -204,6 +401,28 @@ static void MX_USART2_UART_Init(void)
 
 }
 
+/**
+  * Enable DMA controller clock
+  */
+static void MX_DMA_Init(void)
+{
+
+  /* DMA controller clock enable */
+  __HAL_RCC_DMA1_CLK_ENABLE();
+
+  /* DMA interrupt init */
+  /* DMA1_Stream1_IRQn interrupt configuration */
+  HAL_NVIC_SetPriority(DMA1_Stream1_IRQn, 0, 0);
+  HAL_NVIC_EnableIRQ(DMA1_Stream1_IRQn);
+  /* DMA1_Stream5_IRQn interrupt configuration */
+  HAL_NVIC_SetPriority(DMA1_Stream5_IRQn, 0, 0);
+  HAL_NVIC_EnableIRQ(DMA1_Stream5_IRQn);
+  /* DMA1_Stream6_IRQn interrupt configuration */
+  HAL_NVIC_SetPriority(DMA1_Stream6_IRQn, 0, 0);
+  HAL_NVIC_EnableIRQ(DMA1_Stream6_IRQn);
+
+}
+
 /**
   * @brief GPIO Initialization Function
   * @param None
@@ -272,17 +491,96 @@ static void MX_GPIO_Init(void)
 /* USER CODE BEGIN 4 */
 void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin){
 	if (GPIO_Pin == RF_VT_Pin){
+		FSM_EventTypeDef event;
 		HAL_GPIO_WritePin(LD2_GPIO_Port, LD2_Pin, 1); //turn LED on
 		if(HAL_GPIO_ReadPin(RF_D3_GPIO_Port, RF_D3_Pin)){ //button C
-			state = 3;
+			event = FSM_EVENT_BUTTON_C;
 		}else if(HAL_GPIO_ReadPin(RF_D2_GPIO_Port, RF_D2_Pin)){ //button A
-			state = 1;
+			event = FSM_EVENT_BUTTON_A;
 		}else if(HAL_GPIO_ReadPin(RF_D1_GPIO_Port, RF_D1_Pin)){ //button D
-			state = 4;
+			event = FSM_EVENT_BUTTON_D;
 		}else{ //button B
-			state = 2;
+			event = FSM_EVENT_BUTTON_B;
 		}
+		TRACE(TRACE_PORT_RF, event);
+		METRICS_Mark();
+		SCHED_Post(SCHED_PRIO_HIGH, Audio_EventHandler, event);
+	}
+}
+
+void ISD1820_OperationCpltCallback(uint32_t status){
+	FSM_EventTypeDef event = FSM_EventFromStatus(status);
+	TELEM_Record(TELEM_REC_DRIVER, &status, 1);
+	if(event != FSM_EVENT_NONE){
+		SCHED_Post(SCHED_PRIO_HIGH, Audio_EventHandler, event);
+	}
+}
+
+void ISD1820_OperationAbortCallback(uint32_t status){
+	TELEM_Record(TELEM_REC_DRIVER, &status, 1);
+	LOG("isd1820: operation %lu aborted", ISD1820_STATUS_OP(status));
+	SCHED_Post(SCHED_PRIO_HIGH, Audio_EventHandler, FSM_EVENT_ABORTED);
+}
+
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size){
+	if(huart->Instance == USART2) UARTCMD_RxEventCallback(huart, Size);
+}
+
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart){
+	if(huart->Instance == USART2){
+		TELEM_TxCpltCallback(huart); //telemetry goes out between offload frames
+		OFFLOAD_TxCpltCallback(huart);
+	}
+}
+
+void CAPTURE_BlockCpltCallback(void){
+	SCHED_Post(SCHED_PRIO_NORMAL, Capture_Handler, 0);
+}
+
+void VAD_ChangeCallback(uint8_t active){
+	SCHED_Post(SCHED_PRIO_HIGH, Audio_EventHandler, active ? FSM_EVENT_VOICE_START : FSM_EVENT_VOICE_END);
+}
+
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart){
+	if(huart->Instance == USART2) UARTCMD_ErrorCallback(huart);
+}
+
+//Same keymap as the RF remote: A to D, or 1 to 4 on keypads without them.
+void DTMF_KeyCallback(char key){
+	FSM_EventTypeDef event;
+	switch(key){
+		case 'A':
+		case '1':
+			event = FSM_EVENT_BUTTON_A;
+			break;
+		case 'B':
+		case '2':
+			event = FSM_EVENT_BUTTON_B;
+			break;
+		case 'C':
+		case '3':
+			event = FSM_EVENT_BUTTON_C;
+			break;
+		case 'D':
+		case '4':
+			event = FSM_EVENT_BUTTON_D;
+			break;
+		default:
+			return;
 	}
+	TRACE(TRACE_PORT_DTMF, event);
+	METRICS_Mark();
+	SCHED_Post(SCHED_PRIO_HIGH, Audio_EventHandler, event);
+}
+
+void HAL_FLASH_EndOfOperationCallback(uint32_t ReturnValue){
+	FLASHWR_EndOfOperationCallback(ReturnValue);
+	SCHED_Post(SCHED_PRIO_NORMAL, Capture_Handler, 0); //restarts the listening the erase stopped
+}
+
+void HAL_FLASH_OperationErrorCallback(uint32_t ReturnValue){
+	FLASHWR_OperationErrorCallback(ReturnValue);
+	SCHED_Post(SCHED_PRIO_NORMAL, Capture_Handler, 0);
 }
 /* USER CODE END 4 */
 
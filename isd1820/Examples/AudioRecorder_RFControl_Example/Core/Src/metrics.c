@@ -0,0 +1,115 @@
+/**
+ * metrics.c
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+Always-on latency histograms
+----------------------------------------------------------------------
+ */
+#include "metrics.h"
+#include "isd1820.h"
+#include "telemetry.h"
+
+#define METRICS_DUMP_COUNTS (TELEM_MAX_VALUES - 2U)
+#define METRICS_DEADLINE_MAX (ISD1820_STATUS_DEADLINE_Msk >> ISD1820_STATUS_DEADLINE_Pos)
+#define METRICS_MARK_TIMEOUT (SystemCoreClock / 100U) //10ms: the command did not start an operation
+
+volatile uint32_t _METRICS_histograms[METRICS_COUNT][METRICS_BUCKETS];
+
+static volatile uint32_t _METRICS_commandMark; //DWT cycle count of the last command, 0 once used
+static uint32_t _METRICS_pulseStart;           //DWT cycle count of the last rising edge
+static uint32_t _METRICS_pulseRequested;       //requested width of the running operation [ms], 0 if open-ended
+static uint8_t _METRICS_dumping;
+static uint8_t _METRICS_dumpReset;
+static METRICS_HistogramTypeDef _METRICS_dumpHistogram;
+static uint32_t _METRICS_dumpBucket;            //first bucket not sent yet
+
+void METRICS_Mark(void){
+	_METRICS_commandMark = DWT->CYCCNT | 1U; //never 0
+}
+
+//Called from the driver, with interrupts disabled.
+void METRICS_DriverEvent(uint32_t event, uint32_t value){
+	uint32_t now = DWT->CYCCNT, width;
+	switch(event){
+		case ISD1820_TRACE_COMMAND:
+			_METRICS_pulseRequested = (ISD1820_STATUS_DEADLINE(value) - uwTick) & METRICS_DEADLINE_MAX;
+			break;
+		case ISD1820_TRACE_PIN:
+			if((value >> 1) == ISD1820_OP_IDLE) break; //abort: no edge to measure
+			if(value & 1U){
+				_METRICS_pulseStart = now;
+				if(_METRICS_commandMark && now - _METRICS_commandMark < METRICS_MARK_TIMEOUT){
+					METRICS_Record(METRICS_CMD_TO_EDGE, now - _METRICS_commandMark);
+				}
+				_METRICS_commandMark = 0;
+			}else if(_METRICS_pulseRequested){
+				width = (now - _METRICS_pulseStart) / (SystemCoreClock / 1000000U);
+				METRICS_Record(METRICS_PULSE_ERROR, (width > _METRICS_pulseRequested * 1000U) ?
+						width - _METRICS_pulseRequested * 1000U : _METRICS_pulseRequested * 1000U - width);
+				_METRICS_pulseRequested = 0;
+			}
+			break;
+		default:
+			break;
+	}
+}
+
+HAL_StatusTypeDef METRICS_Dump(METRICS_HistogramTypeDef histogram, uint8_t reset){
+	if(histogram >= METRICS_COUNT) return HAL_ERROR;
+	if(_METRICS_dumping) return HAL_BUSY;
+	_METRICS_dumping = 1;
+	_METRICS_dumpReset = reset;
+	_METRICS_dumpHistogram = histogram;
+	_METRICS_dumpBucket = 0;
+	METRICS_DumpPoll(0);
+	return HAL_OK;
+}
+
+void METRICS_DumpPoll(uint32_t arg){
+	uint32_t values[TELEM_MAX_VALUES];
+	volatile uint32_t* counts;
+	uint32_t bucket, count, n = 0, i;
+	UNUSED(arg);
+	if(!_METRICS_dumping) return;
+	counts = _METRICS_histograms[_METRICS_dumpHistogram];
+	values[0] = _METRICS_dumpHistogram;
+	for(bucket = _METRICS_dumpBucket; bucket < METRICS_BUCKETS; bucket++){
+		count = counts[bucket];
+		if(count){
+			if(n == 0) values[1] = bucket;
+			values[2 + n++] = count;
+		}
+		if(n && (!count || n == METRICS_DUMP_COUNTS || bucket == METRICS_BUCKETS - 1U)){
+			if(TELEM_Record(TELEM_REC_HISTOGRAM, values, 2 + n) != HAL_OK) return; //stream full: resume from here on the next poll
+			for(i = 0; _METRICS_dumpReset && i < n; i++){
+				count = values[2 + i];
+				do{ //samples recorded since the read stay
+				}while(__STREXW(__LDREXW(&counts[values[1] + i]) - count, &counts[values[1] + i]));
+			}
+			_METRICS_dumpBucket = bucket + 1U;
+			n = 0;
+		}
+	}
+	_METRICS_dumping = 0;
+}
+
+void METRICS_Reset(METRICS_HistogramTypeDef histogram){
+	uint32_t bucket;
+	if(histogram >= METRICS_COUNT) return;
+	for(bucket = 0; bucket < METRICS_BUCKETS; bucket++){
+		_METRICS_histograms[histogram][bucket] = 0;
+	}
+}
@@ -0,0 +1,130 @@
+/**
+ * mixer.c
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+Q15 audio mixer
+----------------------------------------------------------------------
+ */
+#include "mixer.h"
+#include "metrics.h"
+#include <string.h>
+
+typedef struct {
+	const int16_t* samples;        //clip stream, NULL for a source stream
+	uint32_t length;               //clip samples left
+	PLAYBACK_SourceTypeDef source;
+	uint16_t gain;
+	uint8_t active;
+} MIXER_StreamTypeDef;
+
+static MIXER_StreamTypeDef _MIXER_streams[MIXER_STREAMS];
+static int16_t _MIXER_scratch[PLAYBACK_HALF_SIZE] __ALIGNED(4);
+static volatile uint8_t _MIXER_running; //MIXER_Source() feeds the playback
+
+void MIXER_Mix(int16_t* out, const int16_t* in, uint32_t count, uint16_t gain){
+	uint32_t* outPairs = (uint32_t*)out;
+	const uint32_t* inPairs = (const uint32_t*)in;
+	uint32_t pair, i;
+	if(gain >= MIXER_GAIN_UNITY){
+		for(i = 0; i < count / 2U; i++){
+			outPairs[i] = __QADD16(outPairs[i], inPairs[i]);
+		}
+		if(count & 1U) out[count - 1U] = (int16_t)__SSAT((int32_t)out[count - 1U] + in[count - 1U], 16);
+		return;
+	}
+	for(i = 0; i < count / 2U; i++){
+		pair = inPairs[i];
+		//the top half of {gain} is 0: __SMUAD scales the bottom sample, __SMUADX the top one. |in x gain| < 2^15, no saturation needed
+		pair = __PKHBT((int32_t)__SMUAD(pair, gain) >> 15, (int32_t)__SMUADX(pair, gain) >> 15, 16);
+		outPairs[i] = __QADD16(outPairs[i], pair);
+	}
+	if(count & 1U) out[count - 1U] = (int16_t)__SSAT((int32_t)out[count - 1U] + (((int32_t)in[count - 1U] * gain) >> 15), 16);
+}
+
+//Adds stream {s} to {buffer}. Returns 0 once the stream has ended.
+static uint32_t _MIXER_MixStream(MIXER_StreamTypeDef* s, int16_t* buffer, uint32_t count){
+	uint32_t n;
+	if(s->samples != NULL){
+		n = (count > s->length) ? s->length : count;
+		MIXER_Mix(buffer, s->samples, n, s->gain);
+		s->samples += n;
+		s->length -= n;
+	}else{
+		n = s->source(_MIXER_scratch, count);
+		MIXER_Mix(buffer, _MIXER_scratch, n, s->gain);
+	}
+	return n;
+}
+
+static HAL_StatusTypeDef _MIXER_Add(uint8_t stream, const int16_t* samples, uint32_t length, PLAYBACK_SourceTypeDef source, uint16_t gain){
+	MIXER_StreamTypeDef* s;
+	uint32_t primask;
+	if(stream >= MIXER_STREAMS) return HAL_ERROR;
+	s = &_MIXER_streams[stream];
+	if(s->active) return HAL_BUSY;
+	primask = __get_PRIMASK();
+	__disable_irq();
+	s->samples = samples;
+	s->length = length;
+	s->source = source;
+	s->gain = gain;
+	s->active = 1;
+	__set_PRIMASK(primask);
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef MIXER_AddClip(uint8_t stream, const int16_t* samples, uint32_t length, uint16_t gain){
+	return _MIXER_Add(stream, samples, length, NULL, gain);
+}
+
+HAL_StatusTypeDef MIXER_AddSource(uint8_t stream, PLAYBACK_SourceTypeDef source, uint16_t gain){
+	if(source == NULL) return HAL_ERROR;
+	return _MIXER_Add(stream, NULL, 0, source, gain);
+}
+
+void MIXER_SetGain(uint8_t stream, uint16_t gain){
+	if(stream >= MIXER_STREAMS) return;
+	_MIXER_streams[stream].gain = gain; //a halfword store: atomic
+}
+
+void MIXER_Remove(uint8_t stream){
+	if(stream >= MIXER_STREAMS) return;
+	_MIXER_streams[stream].active = 0;
+}
+
+HAL_StatusTypeDef MIXER_Start(PLAYBACK_RouteTypeDef route){
+	if(PLAYBACK_IsPlaying()) return (PLAYBACK_GetSource() == MIXER_Source && _MIXER_running) ? HAL_OK : HAL_BUSY; //joined at the next refill
+	return PLAYBACK_Start(MIXER_Source, route);
+}
+
+//Called from the DMA interrupt.
+uint32_t MIXER_Source(int16_t* buffer, uint32_t count){
+	uint32_t start = DWT->CYCCNT, i;
+	uint8_t playing = 0;
+	if(count > PLAYBACK_HALF_SIZE) count = PLAYBACK_HALF_SIZE;
+	memset(buffer, 0, count * sizeof(int16_t));
+	for(i = 0; i < MIXER_STREAMS; i++){
+		if(!_MIXER_streams[i].active) continue;
+		if(_MIXER_MixStream(&_MIXER_streams[i], buffer, count) == 0){
+			_MIXER_streams[i].active = 0;
+		}else{
+			playing = 1;
+		}
+	}
+	_MIXER_running = playing;
+	METRICS_Record(METRICS_MIX_BLOCK, DWT->CYCCNT - start);
+	return playing ? count : 0;
+}
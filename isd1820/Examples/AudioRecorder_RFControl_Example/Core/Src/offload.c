@@ -0,0 +1,289 @@
+/**
+ * offload.c
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+Audio offload to the host
+----------------------------------------------------------------------
+ */
+#include "offload.h"
+#include "crc32.h"
+#include "uart_cmd.h"
+#include "scheduler.h"
+#include "clips.h"
+#include "codec.h"
+#include "capture.h"
+#include "flash_writer.h"
+#include "logger.h"
+#include "metrics.h"
+#include <string.h>
+
+#define OFFLOAD_HEADER_SIZE 3U //cmd, seq
+#define OFFLOAD_CRC_SIZE    4U
+#define OFFLOAD_MAX_FRAME   (OFFLOAD_HEADER_SIZE + OFFLOAD_FRAME_SAMPLES * sizeof(int16_t) + OFFLOAD_CRC_SIZE)
+#define OFFLOAD_MAX_ENCODED (OFFLOAD_MAX_FRAME + OFFLOAD_MAX_FRAME / 254U + 2U) //COBS overhead and delimiter
+#define OFFLOAD_NONE        0xFFFFFFFFUL
+
+#if OFFLOAD_FRAME_SAMPLES % CODEC_BLOCK_SAMPLES != 0
+#error "A frame must hold whole codec blocks"
+#endif
+
+typedef __PACKED_STRUCT {
+	char riff[4];
+	uint32_t riffSize;   //file size - 8 [bytes]
+	char wave[4];
+	char fmt[4];
+	uint32_t fmtSize;
+	uint16_t formatTag;  //1, PCM
+	uint16_t channels;
+	uint32_t sampleRate; //[Hz]
+	uint32_t byteRate;   //[bytes/s]
+	uint16_t blockAlign; //[bytes per sample]
+	uint16_t bitsPerSample;
+	char data[4];
+	uint32_t dataSize;   //[bytes]
+} OFFLOAD_WavHeaderTypeDef;
+
+static UART_HandleTypeDef* _OFFLOAD_huart;
+static uint8_t _OFFLOAD_running;
+static OFFLOAD_SourceTypeDef _OFFLOAD_source;
+static const void* _OFFLOAD_data;   //stored samples or codec blocks, in flash
+static CLIPS_FormatTypeDef _OFFLOAD_format;
+static uint32_t _OFFLOAD_sampleRate;
+static uint32_t _OFFLOAD_samples;
+static uint32_t _OFFLOAD_count;     //frames, the header included
+static uint32_t _OFFLOAD_base;      //oldest frame not acknowledged
+static uint32_t _OFFLOAD_next;      //next frame to send
+static uint32_t _OFFLOAD_high;      //frames sent at least once
+static uint32_t _OFFLOAD_resent;    //frames sent again
+static uint32_t _OFFLOAD_timeouts;  //in a row, with no progress
+static uint32_t _OFFLOAD_tick;      //last progress, for the timeout
+static uint32_t _OFFLOAD_startTick;
+static uint32_t _OFFLOAD_ready;     //frame built in the spare buffer, OFFLOAD_NONE if none
+static uint16_t _OFFLOAD_readyLen;  //its encoded size
+static uint8_t _OFFLOAD_spare;      //buffer not on the line
+static uint8_t _OFFLOAD_frame[OFFLOAD_MAX_FRAME];
+static int16_t _OFFLOAD_pcm[OFFLOAD_FRAME_SAMPLES] __ALIGNED(4);
+static uint8_t _OFFLOAD_tx[2][OFFLOAD_MAX_ENCODED];
+
+static uint16_t _OFFLOAD_CobsEncode(const uint8_t* src, uint16_t len, uint8_t* dst){
+	uint16_t read = 0, write = 1, codePos = 0;
+	uint8_t code = 1;
+	while(read < len){
+		if(src[read] == 0){
+			dst[codePos] = code;
+			codePos = write++;
+			code = 1;
+		}else{
+			dst[write++] = src[read];
+			if(++code == 0xFF){
+				dst[codePos] = code;
+				codePos = write++;
+				code = 1;
+			}
+		}
+		read++;
+	}
+	dst[codePos] = code;
+	dst[write++] = 0;
+	return write;
+}
+
+//Sample count of {size} bytes of codec blocks, as CODEC_DecodeBlock() reads them.
+static uint32_t _OFFLOAD_Samples(CODEC_FormatTypeDef format, uint32_t size){
+	uint32_t block = CODEC_BlockSize(format, CODEC_BLOCK_SAMPLES), rest, n;
+	if(block == 0) return 0;
+	rest = size % block;
+	for(n = CODEC_BLOCK_SAMPLES; n && CODEC_BlockSize(format, n) > rest; n--);
+	return size / block * CODEC_BLOCK_SAMPLES + n;
+}
+
+static uint32_t _OFFLOAD_Header(uint8_t* out){
+	OFFLOAD_WavHeaderTypeDef header;
+	memcpy(header.riff, "RIFF", 4U);
+	memcpy(header.wave, "WAVE", 4U);
+	memcpy(header.fmt, "fmt ", 4U);
+	memcpy(header.data, "data", 4U);
+	header.dataSize = _OFFLOAD_samples * sizeof(int16_t);
+	header.riffSize = header.dataSize + sizeof(header) - 8U;
+	header.fmtSize = 16U;
+	header.formatTag = 1U;
+	header.channels = 1U;
+	header.sampleRate = _OFFLOAD_sampleRate;
+	header.byteRate = _OFFLOAD_sampleRate * sizeof(int16_t);
+	header.blockAlign = sizeof(int16_t);
+	header.bitsPerSample = 16U;
+	memcpy(out, &header, sizeof(header));
+	return sizeof(header);
+}
+
+//Decodes the samples of frame {seq}, 1 on, to _OFFLOAD_pcm. Returns the sample count.
+static uint32_t _OFFLOAD_Decode(uint32_t seq){
+	uint32_t first = (seq - 1U) * OFFLOAD_FRAME_SAMPLES, count = _OFFLOAD_samples - first, n, size, i;
+	const uint16_t* dac;
+	const uint8_t* block;
+	if(count > OFFLOAD_FRAME_SAMPLES) count = OFFLOAD_FRAME_SAMPLES;
+	if(_OFFLOAD_format == CLIPS_FORMAT_DAC){
+		dac = (const uint16_t*)_OFFLOAD_data + first;
+		for(i = 0; i < count; i++){
+			_OFFLOAD_pcm[i] = (int16_t)(dac[i] ^ 0x8000U);
+		}
+		return count;
+	}
+	block = (const uint8_t*)_OFFLOAD_data + first / CODEC_BLOCK_SAMPLES * CODEC_BlockSize((CODEC_FormatTypeDef)_OFFLOAD_format, CODEC_BLOCK_SAMPLES);
+	for(i = 0; i < count; i += n){
+		n = count - i;
+		if(n > CODEC_BLOCK_SAMPLES) n = CODEC_BLOCK_SAMPLES;
+		size = CODEC_BlockSize((CODEC_FormatTypeDef)_OFFLOAD_format, n);
+		CODEC_DecodeBlock((CODEC_FormatTypeDef)_OFFLOAD_format, block, size, &_OFFLOAD_pcm[i]);
+		block += size;
+	}
+	return count;
+}
+
+//Builds frame {seq} in the spare buffer.
+static void _OFFLOAD_Build(uint32_t seq){
+	uint32_t start = DWT->CYCCNT, len = OFFLOAD_HEADER_SIZE, crc;
+	_OFFLOAD_frame[0] = UARTCMD_OFFLOAD_DATA | UARTCMD_REPLY;
+	_OFFLOAD_frame[1] = (uint8_t)seq;
+	_OFFLOAD_frame[2] = (uint8_t)(seq >> 8);
+	if(seq == 0){
+		len += _OFFLOAD_Header(&_OFFLOAD_frame[len]);
+	}else{
+		len += _OFFLOAD_Decode(seq) * sizeof(int16_t);
+		memcpy(&_OFFLOAD_frame[OFFLOAD_HEADER_SIZE], _OFFLOAD_pcm, len - OFFLOAD_HEADER_SIZE);
+	}
+	crc = CRC32_Compute(_OFFLOAD_frame, len);
+	memcpy(&_OFFLOAD_frame[len], &crc, OFFLOAD_CRC_SIZE);
+	_OFFLOAD_readyLen = _OFFLOAD_CobsEncode(_OFFLOAD_frame, len + OFFLOAD_CRC_SIZE, _OFFLOAD_tx[_OFFLOAD_spare]);
+	_OFFLOAD_ready = seq;
+	METRICS_Record(METRICS_OFFLOAD_FRAME, DWT->CYCCNT - start);
+}
+
+void OFFLOAD_Init(UART_HandleTypeDef* huart){
+	_OFFLOAD_huart = huart;
+	_OFFLOAD_running = 0;
+}
+
+HAL_StatusTypeDef OFFLOAD_Start(OFFLOAD_SourceTypeDef source, uint16_t id){
+	const CLIPS_EntryTypeDef* clip;
+	uint32_t size, tag;
+	if(_OFFLOAD_running) return HAL_BUSY;
+	switch(source){
+		case OFFLOAD_SOURCE_RECORDING:
+			size = FLASHWR_GetRecording(&_OFFLOAD_data, &tag);
+			if(size == 0) return HAL_ERROR;
+			_OFFLOAD_format = (CLIPS_FormatTypeDef)tag;
+			_OFFLOAD_sampleRate = CAPTURE_SAMPLE_RATE;
+			_OFFLOAD_samples = _OFFLOAD_Samples((CODEC_FormatTypeDef)tag, size);
+			break;
+		case OFFLOAD_SOURCE_CLIP:
+			clip = CLIPS_Find(id);
+			if(clip == NULL) return HAL_ERROR;
+			_OFFLOAD_data = CLIPS_GetData(clip);
+			_OFFLOAD_format = (CLIPS_FormatTypeDef)clip->format;
+			_OFFLOAD_sampleRate = clip->sampleRate;
+			_OFFLOAD_samples = clip->length;
+			if(_OFFLOAD_format != CLIPS_FORMAT_DAC){
+				if(CODEC_BlockSize((CODEC_FormatTypeDef)_OFFLOAD_format, CODEC_BLOCK_SAMPLES) == 0) return HAL_ERROR;
+				_OFFLOAD_samples &= ~1UL; //codec blocks decode in pairs
+			}
+			break;
+		default:
+			return HAL_ERROR;
+	}
+	if(_OFFLOAD_samples == 0) return HAL_ERROR;
+	_OFFLOAD_source = source;
+	_OFFLOAD_count = 1U + (_OFFLOAD_samples + OFFLOAD_FRAME_SAMPLES - 1U) / OFFLOAD_FRAME_SAMPLES;
+	_OFFLOAD_base = 0;
+	_OFFLOAD_next = 0;
+	_OFFLOAD_high = 0;
+	_OFFLOAD_resent = 0;
+	_OFFLOAD_timeouts = 0;
+	_OFFLOAD_ready = OFFLOAD_NONE;
+	_OFFLOAD_startTick = HAL_GetTick();
+	_OFFLOAD_tick = _OFFLOAD_startTick;
+	_OFFLOAD_running = 1;
+	SCHED_Post(SCHED_PRIO_LOW, OFFLOAD_Poll, 0);
+	return HAL_OK;
+}
+
+void OFFLOAD_Cancel(void){
+	if(_OFFLOAD_running) LOG("offload: cancelled at frame %lu of %lu", _OFFLOAD_base, _OFFLOAD_count);
+	_OFFLOAD_running = 0;
+}
+
+HAL_StatusTypeDef OFFLOAD_Ack(uint16_t seq, uint8_t resend){
+	if(!_OFFLOAD_running || seq > _OFFLOAD_high) return HAL_ERROR;
+	if(seq > _OFFLOAD_base){
+		_OFFLOAD_base = seq;
+		_OFFLOAD_tick = HAL_GetTick();
+		_OFFLOAD_timeouts = 0;
+	}
+	if(resend || _OFFLOAD_next < _OFFLOAD_base){ //go back: what was sent after the missing frame is dropped by the host
+		_OFFLOAD_next = _OFFLOAD_base;
+		_OFFLOAD_tick = HAL_GetTick();
+	}
+	SCHED_Post(SCHED_PRIO_LOW, OFFLOAD_Poll, 0); //the window moved
+	return HAL_OK;
+}
+
+uint32_t OFFLOAD_GetAck(void){
+	if(!_OFFLOAD_running) return 0;
+	return (_OFFLOAD_base & 0xFFFFU) | (_OFFLOAD_count << 16);
+}
+
+void OFFLOAD_Poll(uint32_t arg){
+	UNUSED(arg);
+	if(!_OFFLOAD_running) return;
+	if(_OFFLOAD_source == OFFLOAD_SOURCE_RECORDING && FLASHWR_GetState() != FLASHWR_STATE_DONE){
+		LOG("offload: recording erased at frame %lu", _OFFLOAD_base);
+		_OFFLOAD_running = 0;
+		return;
+	}
+	if(_OFFLOAD_base == _OFFLOAD_count){
+		LOG("offload: %lu frames in %lu ms, %lu sent again", _OFFLOAD_count, HAL_GetTick() - _OFFLOAD_startTick, _OFFLOAD_resent);
+		_OFFLOAD_running = 0;
+		return;
+	}
+	if(_OFFLOAD_next != _OFFLOAD_base && HAL_GetTick() - _OFFLOAD_tick >= OFFLOAD_TIMEOUT){
+		if(++_OFFLOAD_timeouts > OFFLOAD_RETRIES){
+			LOG("offload: no acknowledgement, stopped at frame %lu of %lu", _OFFLOAD_base, _OFFLOAD_count);
+			_OFFLOAD_running = 0;
+			return;
+		}
+		_OFFLOAD_next = _OFFLOAD_base; //acknowledgement or resend request lost
+		_OFFLOAD_tick = HAL_GetTick();
+	}
+	if(_OFFLOAD_next == _OFFLOAD_count || _OFFLOAD_next - _OFFLOAD_base >= OFFLOAD_WINDOW) return;
+	if(_OFFLOAD_ready != _OFFLOAD_next) _OFFLOAD_Build(_OFFLOAD_next);
+	if(_OFFLOAD_huart->gState != HAL_UART_STATE_READY) return; //telemetry or the last frame still going out
+	if(HAL_UART_Transmit_DMA(_OFFLOAD_huart, _OFFLOAD_tx[_OFFLOAD_spare], _OFFLOAD_readyLen) != HAL_OK) return;
+	if(_OFFLOAD_next == _OFFLOAD_base) _OFFLOAD_tick = HAL_GetTick(); //the timeout runs from the first frame in flight
+	if(_OFFLOAD_next < _OFFLOAD_high){
+		_OFFLOAD_resent++;
+	}else{
+		_OFFLOAD_high = _OFFLOAD_next + 1U;
+	}
+	_OFFLOAD_next++;
+	_OFFLOAD_spare ^= 1U;
+	_OFFLOAD_ready = OFFLOAD_NONE;
+	if(_OFFLOAD_next < _OFFLOAD_count) _OFFLOAD_Build(_OFFLOAD_next); //while DMA sends the last one
+}
+
+void OFFLOAD_TxCpltCallback(UART_HandleTypeDef* huart){
+	if(huart != _OFFLOAD_huart || !_OFFLOAD_running) return;
+	SCHED_Post(SCHED_PRIO_LOW, OFFLOAD_Poll, 0);
+}
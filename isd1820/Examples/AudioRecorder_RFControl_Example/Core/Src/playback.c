@@ -0,0 +1,352 @@
+/**
+ * playback.c
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+DAC audio playback
+----------------------------------------------------------------------
+ */
+#include "playback.h"
+#include "isd1820.h"
+#include "codec.h"
+#include "resample.h"
+#include "wsola.h"
+#include <string.h>
+
+#define PLAYBACK_MIDSCALE 0x8000U //Q15 0 on the left-aligned DAC
+#define PLAYBACK_DMA_MAX  0xFFFFU //samples per DMA transfer
+
+#if (PLAYBACK_HALF_SIZE & 1U) != 0
+#error "PLAYBACK_HALF_SIZE must be even"
+#endif
+
+static TIM_HandleTypeDef* _PLAYBACK_tim;
+static uint32_t _PLAYBACK_ticks; //timer ticks per sample at PLAYBACK_SAMPLE_RATE: the autoreload changes with the rate
+static uint16_t _PLAYBACK_buffer[2][PLAYBACK_HALF_SIZE] __ALIGNED(4);
+static PLAYBACK_SourceTypeDef _PLAYBACK_source;
+static PLAYBACK_RouteTypeDef _PLAYBACK_route;
+static volatile uint8_t _PLAYBACK_playing;
+static volatile uint8_t _PLAYBACK_ending; //the source is exhausted, stop when the half playing now is out
+static volatile uint32_t _PLAYBACK_underruns;
+static volatile uint32_t _PLAYBACK_errors;
+
+static const int16_t* _PLAYBACK_clip;
+static uint32_t _PLAYBACK_clipLength;
+static const int16_t* _PLAYBACK_next;
+static volatile uint32_t _PLAYBACK_nextLength; //0 if nothing is queued
+
+static const uint8_t* _PLAYBACK_encoded;      //codec blocks left to decode
+static uint32_t _PLAYBACK_encodedSize;
+static CODEC_FormatTypeDef _PLAYBACK_format;
+static int16_t _PLAYBACK_decoded[CODEC_BLOCK_SAMPLES] __ALIGNED(4);
+static uint32_t _PLAYBACK_decodedCount;
+static uint32_t _PLAYBACK_decodedPos;
+
+static RESAMPLE_StateTypeDef _PLAYBACK_resample;
+static WSOLA_StateTypeDef _PLAYBACK_wsola;
+static uint32_t _PLAYBACK_speed = WSOLA_SPEED_MIN;
+
+static const uint16_t* _PLAYBACK_direct;       //DAC format samples left to play in direct mode
+static uint32_t _PLAYBACK_directLength;
+
+//Source for PLAYBACK_StartClip(): chains queued clips and pads the end of the last one.
+static uint32_t _PLAYBACK_ClipSource(int16_t* buffer, uint32_t count){
+	uint32_t written = 0, n;
+	while(written < count){
+		if(_PLAYBACK_clipLength == 0){
+			if(_PLAYBACK_nextLength == 0) break;
+			_PLAYBACK_clip = _PLAYBACK_next;
+			_PLAYBACK_clipLength = _PLAYBACK_nextLength;
+			_PLAYBACK_nextLength = 0;
+		}
+		n = count - written;
+		if(n > _PLAYBACK_clipLength) n = _PLAYBACK_clipLength;
+		memcpy(&buffer[written], _PLAYBACK_clip, n * sizeof(int16_t));
+		_PLAYBACK_clip += n;
+		_PLAYBACK_clipLength -= n;
+		written += n;
+	}
+	if(written == 0) return 0;
+	memset(&buffer[written], 0, (count - written) * sizeof(int16_t)); //end of the last clip, not an underrun
+	return count;
+}
+
+//Source for PLAYBACK_StartEncoded(): decodes a block whenever the last one is used up.
+static uint32_t _PLAYBACK_EncodedSource(int16_t* buffer, uint32_t count){
+	uint32_t written = 0, n;
+	while(written < count){
+		if(_PLAYBACK_decodedPos == _PLAYBACK_decodedCount){
+			if(_PLAYBACK_encodedSize == 0) break;
+			n = CODEC_DecodeBlock(_PLAYBACK_format, _PLAYBACK_encoded, _PLAYBACK_encodedSize, _PLAYBACK_decoded);
+			if(n == 0){ //truncated block
+				_PLAYBACK_encodedSize = 0;
+				break;
+			}
+			_PLAYBACK_encoded += CODEC_BlockSize(_PLAYBACK_format, n);
+			_PLAYBACK_encodedSize -= CODEC_BlockSize(_PLAYBACK_format, n);
+			_PLAYBACK_decodedCount = n;
+			_PLAYBACK_decodedPos = 0;
+		}
+		n = count - written;
+		if(n > _PLAYBACK_decodedCount - _PLAYBACK_decodedPos) n = _PLAYBACK_decodedCount - _PLAYBACK_decodedPos;
+		memcpy(&buffer[written], &_PLAYBACK_decoded[_PLAYBACK_decodedPos], n * sizeof(int16_t));
+		_PLAYBACK_decodedPos += n;
+		written += n;
+	}
+	if(written == 0) return 0;
+	memset(&buffer[written], 0, (count - written) * sizeof(int16_t)); //end of the stream, not an underrun
+	return count;
+}
+
+//Source for PLAYBACK_StartEncoded() at another rate: the encoded source through the resampler.
+static uint32_t _PLAYBACK_ResampledSource(int16_t* buffer, uint32_t count){
+	uint32_t written = RESAMPLE_Read(&_PLAYBACK_resample, buffer, count);
+	if(written == 0) return 0;
+	memset(&buffer[written], 0, (count - written) * sizeof(int16_t)); //end of the stream, not an underrun
+	return count;
+}
+
+//Source for PLAYBACK_StartEncoded(): the decoded (and resampled) stream through the time-stretch.
+static uint32_t _PLAYBACK_StretchedSource(int16_t* buffer, uint32_t count){
+	uint32_t written = WSOLA_Read(&_PLAYBACK_wsola, buffer, count);
+	if(written == 0) return 0;
+	memset(&buffer[written], 0, (count - written) * sizeof(int16_t)); //end of the stream, not an underrun
+	return count;
+}
+
+static void _PLAYBACK_Finish(void){
+	if(!_PLAYBACK_playing) return;
+	__HAL_TIM_DISABLE_DMA(_PLAYBACK_tim, TIM_DMA_UPDATE);
+	HAL_TIM_Base_Stop(_PLAYBACK_tim);
+	if(_PLAYBACK_route == PLAYBACK_ROUTE_RECORD) ISD1820_StopRecording(); //the last sample is out
+	HAL_DMA_Abort(_PLAYBACK_tim->hdma[TIM_DMA_ID_UPDATE]);
+	DAC1->DHR12L1 = PLAYBACK_MIDSCALE;
+	if(_PLAYBACK_route == PLAYBACK_ROUTE_FEEDTHROUGH) ISD1820_DisableFeedThrough();
+	_PLAYBACK_playing = 0;
+	PLAYBACK_CompleteCallback();
+}
+
+//Refills the half DMA has just left. Returns 0 once the source is exhausted.
+static uint32_t _PLAYBACK_Fill(uint16_t* half){
+	uint32_t* words = (uint32_t*)half;
+	uint32_t n, i;
+	n = _PLAYBACK_source((int16_t*)half, PLAYBACK_HALF_SIZE);
+	if(n == 0){
+		_PLAYBACK_ending = 1;
+	}else if(n < PLAYBACK_HALF_SIZE){
+		_PLAYBACK_underruns++;
+	}
+	for(i = n; i < PLAYBACK_HALF_SIZE; i++){
+		half[i] = 0;
+	}
+	for(i = 0; i < PLAYBACK_HALF_SIZE / 2U; i++){
+		words[i] ^= 0x80008000UL; //Q15 to left-aligned offset binary, two samples at a time
+	}
+	return n;
+}
+
+static void _PLAYBACK_Refill(uint16_t* half){
+	if(_PLAYBACK_ending){
+		_PLAYBACK_Finish(); //the last samples are out
+	}else{
+		_PLAYBACK_Fill(half);
+	}
+}
+
+static void _PLAYBACK_HalfCplt(DMA_HandleTypeDef* hdma){
+	UNUSED(hdma);
+	_PLAYBACK_Refill(_PLAYBACK_buffer[0]);
+}
+
+static void _PLAYBACK_Cplt(DMA_HandleTypeDef* hdma){
+	UNUSED(hdma);
+	_PLAYBACK_Refill(_PLAYBACK_buffer[1]);
+}
+
+//Starts the DMA transfer of the next chunk of a direct mode clip.
+static HAL_StatusTypeDef _PLAYBACK_DirectNext(void){
+	uint32_t n = _PLAYBACK_directLength;
+	if(n > PLAYBACK_DMA_MAX) n = PLAYBACK_DMA_MAX;
+	if(HAL_DMA_Start_IT(_PLAYBACK_tim->hdma[TIM_DMA_ID_UPDATE], (uint32_t)_PLAYBACK_direct, (uint32_t)&DAC1->DHR12L1, n) != HAL_OK) return HAL_BUSY;
+	_PLAYBACK_direct += n;
+	_PLAYBACK_directLength -= n;
+	return HAL_OK;
+}
+
+//A pending TIM6 request is served as soon as the next chunk starts: no sample is lost between chunks.
+static void _PLAYBACK_DirectCplt(DMA_HandleTypeDef* hdma){
+	UNUSED(hdma);
+	if(_PLAYBACK_directLength == 0 || _PLAYBACK_DirectNext() != HAL_OK){
+		_PLAYBACK_Finish();
+	}
+}
+
+//The HAL has stopped the stream on a transfer error: nothing more reaches the DAC, so playback ends and REC or feed-through goes.
+static void _PLAYBACK_Error(DMA_HandleTypeDef* hdma){
+	UNUSED(hdma);
+	_PLAYBACK_errors++;
+	_PLAYBACK_Finish();
+}
+
+//TIM6 is 16-bit: rates the autoreload cannot reach are refused rather than wrapped.
+static HAL_StatusTypeDef _PLAYBACK_SetRate(uint32_t sampleRate){
+	uint64_t period;
+	if(sampleRate == 0) return HAL_ERROR;
+	period = (uint64_t)_PLAYBACK_ticks * PLAYBACK_SAMPLE_RATE / sampleRate;
+	if(period == 0 || period - 1U > 0xFFFFU) return HAL_ERROR;
+	__HAL_TIM_SET_AUTORELOAD(_PLAYBACK_tim, (uint32_t)period - 1U);
+	__HAL_TIM_SET_COUNTER(_PLAYBACK_tim, 0);
+	return HAL_OK;
+}
+
+//Starts the timer once the DMA stream is running.
+static HAL_StatusTypeDef _PLAYBACK_Run(PLAYBACK_RouteTypeDef route){
+	uint32_t primask = __get_PRIMASK();
+	HAL_StatusTypeDef result;
+	__disable_irq(); //REC and the timer start together: the first sample is out one sample period after REC rises
+	if(route == PLAYBACK_ROUTE_RECORD && ISD1820_StartRecording() != HAL_OK){
+		__set_PRIMASK(primask);
+		HAL_DMA_Abort(_PLAYBACK_tim->hdma[TIM_DMA_ID_UPDATE]);
+		return HAL_BUSY;
+	}
+	_PLAYBACK_route = route;
+	_PLAYBACK_playing = 1;
+	if(route == PLAYBACK_ROUTE_FEEDTHROUGH) ISD1820_EnableFeedThrough();
+	__HAL_TIM_ENABLE_DMA(_PLAYBACK_tim, TIM_DMA_UPDATE);
+	result = HAL_TIM_Base_Start(_PLAYBACK_tim);
+	__set_PRIMASK(primask);
+	return result;
+}
+
+void PLAYBACK_Init(TIM_HandleTypeDef* tim){
+	GPIO_InitTypeDef GPIO_InitStruct = {0};
+	_PLAYBACK_tim = tim;
+	_PLAYBACK_ticks = tim->Init.Period + 1U;
+
+	__HAL_RCC_GPIOA_CLK_ENABLE();
+	GPIO_InitStruct.Pin = GPIO_PIN_4;
+	GPIO_InitStruct.Mode = GPIO_MODE_ANALOG;
+	GPIO_InitStruct.Pull = GPIO_NOPULL;
+	HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
+
+	__HAL_RCC_DAC_CLK_ENABLE();
+	DAC1->DHR12L1 = PLAYBACK_MIDSCALE;
+	DAC1->CR = DAC_CR_EN1; //output buffer on, no trigger: DHR is copied on the next APB1 clock
+}
+
+HAL_StatusTypeDef PLAYBACK_Start(PLAYBACK_SourceTypeDef source, PLAYBACK_RouteTypeDef route){
+	DMA_HandleTypeDef* hdma = _PLAYBACK_tim->hdma[TIM_DMA_ID_UPDATE];
+	if(_PLAYBACK_playing) return HAL_BUSY;
+	_PLAYBACK_source = source;
+	_PLAYBACK_ending = 0;
+	_PLAYBACK_SetRate(PLAYBACK_SAMPLE_RATE);
+	if(_PLAYBACK_Fill(_PLAYBACK_buffer[0]) == 0) return HAL_ERROR; //nothing to play
+	_PLAYBACK_Fill(_PLAYBACK_buffer[1]); //silence if the source is already exhausted
+	hdma->XferHalfCpltCallback = _PLAYBACK_HalfCplt;
+	hdma->XferCpltCallback = _PLAYBACK_Cplt;
+	hdma->XferErrorCallback = _PLAYBACK_Error;
+	SET_BIT(hdma->Instance->CR, DMA_SxCR_CIRC);
+	if(HAL_DMA_Start_IT(hdma, (uint32_t)_PLAYBACK_buffer, (uint32_t)&DAC1->DHR12L1, 2U * PLAYBACK_HALF_SIZE) != HAL_OK) return HAL_BUSY;
+	return _PLAYBACK_Run(route);
+}
+
+HAL_StatusTypeDef PLAYBACK_StartDirect(const uint16_t* samples, uint32_t length, uint32_t sampleRate, PLAYBACK_RouteTypeDef route){
+	DMA_HandleTypeDef* hdma = _PLAYBACK_tim->hdma[TIM_DMA_ID_UPDATE];
+	if(_PLAYBACK_playing) return HAL_BUSY;
+	if(length == 0 || _PLAYBACK_SetRate(sampleRate) != HAL_OK) return HAL_ERROR;
+	_PLAYBACK_source = NULL;
+	_PLAYBACK_direct = samples;
+	_PLAYBACK_directLength = length;
+	hdma->XferHalfCpltCallback = NULL; //no half transfer interrupt: nothing to refill
+	hdma->XferCpltCallback = _PLAYBACK_DirectCplt;
+	hdma->XferErrorCallback = _PLAYBACK_Error;
+	CLEAR_BIT(hdma->Instance->CR, DMA_SxCR_CIRC);
+	if(_PLAYBACK_DirectNext() != HAL_OK) return HAL_BUSY;
+	return _PLAYBACK_Run(route);
+}
+
+HAL_StatusTypeDef PLAYBACK_StartClip(const int16_t* samples, uint32_t length, PLAYBACK_RouteTypeDef route){
+	if(_PLAYBACK_playing) return HAL_BUSY;
+	_PLAYBACK_clip = samples;
+	_PLAYBACK_clipLength = length;
+	_PLAYBACK_nextLength = 0;
+	return PLAYBACK_Start(_PLAYBACK_ClipSource, route);
+}
+
+HAL_StatusTypeDef PLAYBACK_StartEncoded(const void* data, uint32_t size, CODEC_FormatTypeDef format, uint32_t sampleRate, PLAYBACK_RouteTypeDef route){
+	if(_PLAYBACK_playing) return HAL_BUSY;
+	if(CODEC_BlockSize(format, CODEC_BLOCK_SAMPLES) == 0) return HAL_ERROR;
+	_PLAYBACK_encoded = data;
+	_PLAYBACK_encodedSize = size;
+	_PLAYBACK_format = format;
+	_PLAYBACK_decodedCount = 0;
+	_PLAYBACK_decodedPos = 0;
+	if(sampleRate == PLAYBACK_SAMPLE_RATE){
+		WSOLA_Init(&_PLAYBACK_wsola, _PLAYBACK_EncodedSource, _PLAYBACK_speed);
+	}else{
+		if(RESAMPLE_Init(&_PLAYBACK_resample, _PLAYBACK_EncodedSource, sampleRate, PLAYBACK_SAMPLE_RATE) != HAL_OK) return HAL_ERROR;
+		WSOLA_Init(&_PLAYBACK_wsola, _PLAYBACK_ResampledSource, _PLAYBACK_speed);
+	}
+	return PLAYBACK_Start(_PLAYBACK_StretchedSource, route);
+}
+
+HAL_StatusTypeDef PLAYBACK_SetSpeed(uint32_t speed){
+	if(speed < WSOLA_SPEED_MIN || speed > WSOLA_SPEED_MAX) return HAL_ERROR;
+	_PLAYBACK_speed = speed;
+	return WSOLA_SetSpeed(&_PLAYBACK_wsola, speed); //takes effect at the next hop if playing
+}
+
+HAL_StatusTypeDef PLAYBACK_QueueClip(const int16_t* samples, uint32_t length){
+	uint32_t primask = __get_PRIMASK();
+	HAL_StatusTypeDef result = HAL_OK;
+	__disable_irq();
+	if(!_PLAYBACK_playing || _PLAYBACK_ending || _PLAYBACK_source != _PLAYBACK_ClipSource || _PLAYBACK_nextLength){
+		result = HAL_BUSY;
+	}else{
+		_PLAYBACK_next = samples;
+		_PLAYBACK_nextLength = length;
+	}
+	__set_PRIMASK(primask);
+	return result;
+}
+
+void PLAYBACK_Stop(void){
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	_PLAYBACK_Finish();
+	__set_PRIMASK(primask);
+}
+
+uint8_t PLAYBACK_IsPlaying(void){
+	return _PLAYBACK_playing;
+}
+
+PLAYBACK_SourceTypeDef PLAYBACK_GetSource(void){
+	return _PLAYBACK_playing ? _PLAYBACK_source : NULL;
+}
+
+uint32_t PLAYBACK_GetUnderruns(void){
+	return _PLAYBACK_underruns;
+}
+
+uint32_t PLAYBACK_GetErrors(void){
+	return _PLAYBACK_errors;
+}
+
+__weak void PLAYBACK_CompleteCallback(void){
+	/* NOTE : This function should not be modified, when the callback is needed,
+	          the PLAYBACK_CompleteCallback could be implemented in the user file
+	 */
+}
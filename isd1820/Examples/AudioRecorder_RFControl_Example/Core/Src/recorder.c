@@ -0,0 +1,224 @@
+/**
+ * recorder.c
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+Capture to flash recorder
+----------------------------------------------------------------------
+ */
+#include "recorder.h"
+#include "capture.h"
+#include "flash_writer.h"
+#include "vad.h"
+#include "dtmf.h"
+#include "metrics.h"
+#include "offload.h"
+#include "isd1820.h"
+#include <string.h>
+
+#define RECORDER_PREROLL_BLOCKS VAD_ONSET_BLOCKS //blocks kept before voice is confirmed
+#define RECORDER_TAIL_BLOCKS    2U               //blocks kept after the last speech block
+
+#if CAPTURE_BLOCK_SIZE > CODEC_BLOCK_SAMPLES
+#error "A capture block must fit in one codec block"
+#endif
+#if CAPTURE_SAMPLE_RATE != DTMF_SAMPLE_RATE || CAPTURE_BLOCK_SIZE > DTMF_MAX_BLOCK
+#error "The DTMF detector does not take capture blocks"
+#endif
+
+static CODEC_FormatTypeDef _RECORDER_format;
+static CODEC_AdpcmStateTypeDef _RECORDER_adpcm; //no reset needed: each block carries its state
+static uint32_t _RECORDER_block[CODEC_MAX_BLOCK_SIZE / sizeof(uint32_t)];
+static uint8_t _RECORDER_listening;             //capture runs for the voice detector
+static uint8_t _RECORDER_tones;                 //capture runs for the DTMF detector
+static uint8_t _RECORDER_resumeListening;       //listening stopped by the erase, restarted once it ends
+static uint8_t _RECORDER_resumeTones;
+static uint8_t _RECORDER_voiced;                //speech seen in this recording: blocks are stored
+static uint8_t _RECORDER_classified;            //the first block in the capture ring went through the detector
+static VAD_ResultTypeDef _RECORDER_vad;         //and was classified as
+static uint32_t _RECORDER_cut;                  //recording length to keep [bytes]
+static uint32_t _RECORDER_tail;                 //blocks to keep after the last speech block
+static int16_t _RECORDER_preroll[RECORDER_PREROLL_BLOCKS][CAPTURE_BLOCK_SIZE] __ALIGNED(4);
+static uint32_t _RECORDER_prerollFirst;
+static uint32_t _RECORDER_prerollCount;
+
+//Returns HAL_BUSY if the block has to wait in the capture ring.
+static HAL_StatusTypeDef _RECORDER_Write(const int16_t* samples){
+	CODEC_AdpcmStateTypeDef state = _RECORDER_adpcm;
+	uint32_t size = CODEC_EncodeBlock(_RECORDER_format, &state, samples, CAPTURE_BLOCK_SIZE, _RECORDER_block);
+	HAL_StatusTypeDef result = FLASHWR_Write(_RECORDER_block, size);
+	if(result == HAL_OK) _RECORDER_adpcm = state; //encoded again on retry
+	return result;
+}
+
+//Keeps the last RECORDER_PREROLL_BLOCKS silent blocks, to store ahead of the speech.
+static void _RECORDER_Preroll(const int16_t* samples){
+	uint32_t index = (_RECORDER_prerollFirst + _RECORDER_prerollCount) % RECORDER_PREROLL_BLOCKS;
+	memcpy(_RECORDER_preroll[index], samples, sizeof(_RECORDER_preroll[0]));
+	if(_RECORDER_prerollCount < RECORDER_PREROLL_BLOCKS){
+		_RECORDER_prerollCount++;
+	}else{
+		_RECORDER_prerollFirst = (_RECORDER_prerollFirst + 1U) % RECORDER_PREROLL_BLOCKS;
+	}
+}
+
+//Stores a capture block, leaving out the silence before the first speech.
+static HAL_StatusTypeDef _RECORDER_Store(const int16_t* samples, VAD_ResultTypeDef vad){
+	HAL_StatusTypeDef result;
+	if(!_RECORDER_voiced){
+		if(vad == VAD_SILENCE){
+			_RECORDER_Preroll(samples);
+			return HAL_OK;
+		}
+		while(_RECORDER_prerollCount){
+			result = _RECORDER_Write(_RECORDER_preroll[_RECORDER_prerollFirst]);
+			if(result != HAL_OK) return result;
+			_RECORDER_prerollFirst = (_RECORDER_prerollFirst + 1U) % RECORDER_PREROLL_BLOCKS;
+			_RECORDER_prerollCount--;
+		}
+		_RECORDER_voiced = 1;
+	}
+	result = _RECORDER_Write(samples);
+	if(result != HAL_OK) return result;
+	if(vad == VAD_SPEECH){
+		_RECORDER_tail = RECORDER_TAIL_BLOCKS;
+		_RECORDER_cut = FLASHWR_GetLength();
+	}else if(_RECORDER_tail){
+		_RECORDER_tail--;
+		_RECORDER_cut = FLASHWR_GetLength();
+	}
+	return HAL_OK;
+}
+
+//Takes capture blocks until the ring is empty or the flash writer pushes back.
+static HAL_StatusTypeDef _RECORDER_Drain(void){
+	int16_t* block;
+	HAL_StatusTypeDef result = HAL_OK;
+	while((block = CAPTURE_GetBlock()) != NULL){
+		if(!_RECORDER_classified){ //once per block, even if it waits
+			_RECORDER_vad = VAD_Process(block, CAPTURE_BLOCK_SIZE);
+			DTMF_Process(block, CAPTURE_BLOCK_SIZE);
+			_RECORDER_classified = 1;
+		}
+		if(FLASHWR_GetState() == FLASHWR_STATE_RECORDING){
+			result = _RECORDER_Store(block, _RECORDER_vad);
+			if(result != HAL_OK) break; //HAL_BUSY: staging ring full, the block waits in the capture ring
+		}
+		_RECORDER_classified = 0;
+		CAPTURE_ReleaseBlock();
+	}
+	return result;
+}
+
+//Capture runs between recordings.
+static uint8_t _RECORDER_Monitoring(void){
+	return _RECORDER_listening || _RECORDER_tones;
+}
+
+static HAL_StatusTypeDef _RECORDER_Capture(void){
+	HAL_StatusTypeDef result;
+	if(_RECORDER_Monitoring() || FLASHWR_GetState() == FLASHWR_STATE_RECORDING) return HAL_OK; //already running
+	result = CAPTURE_Start();
+	if(result == HAL_OK){
+		_RECORDER_classified = 0;
+		VAD_Reset();
+		DTMF_Reset();
+	}
+	return result;
+}
+
+//Sets or clears one of the reasons to keep the capture running.
+static HAL_StatusTypeDef _RECORDER_Monitor(uint8_t* flag, uint8_t enable){
+	HAL_StatusTypeDef result = HAL_OK;
+	if(enable && !*flag){
+		result = _RECORDER_Capture();
+		if(result == HAL_OK) *flag = 1;
+	}else if(!enable && *flag){
+		*flag = 0;
+		if(!_RECORDER_Monitoring() && FLASHWR_GetState() != FLASHWR_STATE_RECORDING) CAPTURE_Stop();
+	}
+	return result;
+}
+
+HAL_StatusTypeDef RECORDER_Start(CODEC_FormatTypeDef format){
+	HAL_StatusTypeDef result;
+	if(CODEC_BlockSize(format, CAPTURE_BLOCK_SIZE) == 0) return HAL_ERROR;
+	if(FLASHWR_GetState() == FLASHWR_STATE_RECORDING) return HAL_BUSY;
+	result = _RECORDER_Capture();
+	if(result != HAL_OK) return result;
+	result = FLASHWR_Begin(format);
+	if(result != HAL_OK){
+		if(!_RECORDER_Monitoring()) CAPTURE_Stop();
+		return result;
+	}
+	_RECORDER_format = format;
+	_RECORDER_voiced = 0;
+	_RECORDER_cut = 0;
+	_RECORDER_tail = 0;
+	_RECORDER_prerollFirst = 0;
+	_RECORDER_prerollCount = 0;
+	return HAL_OK;
+}
+
+void RECORDER_Stop(void){
+	if(!_RECORDER_Monitoring()) CAPTURE_Stop();
+	if(FLASHWR_GetState() != FLASHWR_STATE_RECORDING) return;
+	_RECORDER_Drain(); //what is still in the capture ring, as long as the staging ring takes it
+	FLASHWR_EndAt(_RECORDER_cut);
+}
+
+//Restarts the listening the erase stopped, once it has ended. Retried from the next call if the capture does not start.
+static void _RECORDER_Resume(void){
+	if(FLASHWR_GetState() == FLASHWR_STATE_ERASING) return;
+	if(_RECORDER_resumeListening && _RECORDER_Monitor(&_RECORDER_listening, 1) == HAL_OK) _RECORDER_resumeListening = 0;
+	if(_RECORDER_resumeTones && _RECORDER_Monitor(&_RECORDER_tones, 1) == HAL_OK) _RECORDER_resumeTones = 0;
+}
+
+HAL_StatusTypeDef RECORDER_Listen(uint8_t enable){
+	_RECORDER_resumeListening = 0; //the latest request wins
+	return _RECORDER_Monitor(&_RECORDER_listening, enable);
+}
+
+HAL_StatusTypeDef RECORDER_ListenTones(uint8_t enable){
+	_RECORDER_resumeTones = 0;
+	return _RECORDER_Monitor(&_RECORDER_tones, enable);
+}
+
+HAL_StatusTypeDef RECORDER_Erase(void){
+	if(FLASHWR_GetState() == FLASHWR_STATE_RECORDING) return HAL_BUSY;
+	if(PLAYBACK_IsPlaying() || OFFLOAD_GetAck() != 0 || ISD1820_STATUS_OP(ISD1820_GetStatus()) != ISD1820_OP_IDLE) return HAL_BUSY; //would stall for seconds
+	_RECORDER_resumeListening |= _RECORDER_listening;
+	_RECORDER_resumeTones |= _RECORDER_tones;
+	_RECORDER_listening = 0;
+	_RECORDER_tones = 0;
+	CAPTURE_Stop(); //the erase stalls every flash fetch, the capture interrupt included
+	return FLASHWR_Erase();
+}
+
+void RECORDER_Process(void){
+	if(_RECORDER_resumeListening || _RECORDER_resumeTones) _RECORDER_Resume();
+	METRICS_Record(METRICS_CAPTURE_BACKLOG, CAPTURE_GetBacklog());
+	if(_RECORDER_Drain() == HAL_ERROR){ //recording region full
+		if(!_RECORDER_Monitoring()) CAPTURE_Stop();
+		FLASHWR_EndAt(_RECORDER_cut);
+	}
+}
+
+HAL_StatusTypeDef RECORDER_Play(PLAYBACK_RouteTypeDef route){
+	const void* data;
+	uint32_t tag, size = FLASHWR_GetRecording(&data, &tag);
+	if(size == 0) return HAL_ERROR;
+	return PLAYBACK_StartEncoded(data, size, (CODEC_FormatTypeDef)tag, CAPTURE_SAMPLE_RATE, route);
+}
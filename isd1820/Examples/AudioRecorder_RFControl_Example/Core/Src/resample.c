@@ -0,0 +1,311 @@
+/**
+ * resample.c
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+Polyphase sample rate converter
+----------------------------------------------------------------------
+ */
+#include "resample.h"
+#include "metrics.h"
+#include <string.h>
+
+#if RESAMPLE_PHASES != 32U || RESAMPLE_MAX_TAPS != 48U
+#error "The coefficient tables are for 32 phases and up to 48 taps"
+#endif
+
+typedef struct {
+	const int16_t* coefs; //RESAMPLE_PHASES rows of {taps}
+	uint32_t taps;
+	uint32_t maxStep;     //Q16.16
+} RESAMPLE_FilterTypeDef;
+
+//h[k] for buffer[i + k], interpolating between buffer[i + 7] and buffer[i + 8] at phase / 32.
+//Kaiser windowed sinc, cutoff 0.85, beta 5, each phase scaled to sum to 32768.
+static const int16_t _RESAMPLE_coefs[RESAMPLE_PHASES][16] __ALIGNED(4) = {
+	{-27, -124, 563, -1372, 2484, -3664, 4575, 27870, 4575, -3664, 2484, -1372, 563, -124, -27, 28},
+	{-12, -152, 596, -1379, 2400, -3361, 3686, 27831, 5490, -3952, 2552, -1353, 525, -94, -42, 33},
+	{2, -177, 624, -1377, 2302, -3046, 2828, 27727, 6429, -4222, 2603, -1324, 480, -62, -57, 38},
+	{14, -200, 645, -1364, 2191, -2722, 2004, 27558, 7388, -4473, 2638, -1284, 431, -27, -74, 43},
+	{26, -220, 662, -1343, 2068, -2391, 1215, 27323, 8366, -4702, 2654, -1233, 376, 9, -90, 48},
+	{37, -237, 672, -1312, 1935, -2057, 465, 27025, 9357, -4905, 2651, -1171, 316, 46, -107, 53},
+	{47, -252, 678, -1273, 1792, -1720, -246, 26666, 10359, -5082, 2628, -1099, 251, 85, -124, 58},
+	{56, -265, 678, -1226, 1642, -1384, -915, 26243, 11367, -5229, 2586, -1015, 182, 126, -141, 63},
+	{64, -274, 673, -1172, 1485, -1051, -1540, 25762, 12378, -5344, 2522, -921, 109, 167, -158, 68},
+	{71, -281, 664, -1112, 1323, -723, -2121, 25222, 13388, -5424, 2439, -817, 33, 208, -174, 72},
+	{76, -286, 650, -1045, 1157, -402, -2656, 24630, 14393, -5469, 2334, -703, -47, 250, -190, 76},
+	{81, -288, 631, -974, 988, -90, -3145, 23988, 15389, -5476, 2208, -580, -130, 292, -206, 80},
+	{85, -288, 609, -898, 818, 211, -3587, 23295, 16371, -5443, 2062, -449, -215, 334, -220, 83},
+	{87, -286, 584, -818, 648, 500, -3981, 22554, 17337, -5368, 1895, -309, -301, 374, -234, 86},
+	{89, -282, 555, -735, 479, 775, -4328, 21771, 18281, -5250, 1708, -162, -388, 414, -247, 88},
+	{90, -275, 523, -650, 312, 1034, -4628, 20950, 19201, -5088, 1501, -9, -476, 452, -258, 89},
+	{90, -267, 489, -564, 149, 1276, -4881, 20092, 20092, -4881, 1276, 149, -564, 489, -267, 90},
+	{89, -258, 452, -476, -9, 1501, -5088, 19201, 20950, -4628, 1034, 312, -650, 523, -275, 90},
+	{88, -247, 414, -388, -162, 1708, -5250, 18281, 21771, -4328, 775, 479, -735, 555, -282, 89},
+	{86, -234, 374, -301, -309, 1895, -5368, 17337, 22554, -3981, 500, 648, -818, 584, -286, 87},
+	{83, -220, 334, -215, -449, 2062, -5443, 16371, 23295, -3587, 211, 818, -898, 609, -288, 85},
+	{80, -206, 292, -130, -580, 2208, -5476, 15389, 23988, -3145, -90, 988, -974, 631, -288, 81},
+	{76, -190, 250, -47, -703, 2334, -5469, 14393, 24630, -2656, -402, 1157, -1045, 650, -286, 76},
+	{72, -174, 208, 33, -817, 2439, -5424, 13388, 25222, -2121, -723, 1323, -1112, 664, -281, 71},
+	{68, -158, 167, 109, -921, 2522, -5344, 12378, 25762, -1540, -1051, 1485, -1172, 673, -274, 64},
+	{63, -141, 126, 182, -1015, 2586, -5229, 11367, 26243, -915, -1384, 1642, -1226, 678, -265, 56},
+	{58, -124, 85, 251, -1099, 2628, -5082, 10359, 26666, -246, -1720, 1792, -1273, 678, -252, 47},
+	{53, -107, 46, 316, -1171, 2651, -4905, 9357, 27025, 465, -2057, 1935, -1312, 672, -237, 37},
+	{48, -90, 9, 376, -1233, 2654, -4702, 8366, 27323, 1215, -2391, 2068, -1343, 662, -220, 26},
+	{43, -74, -27, 431, -1284, 2638, -4473, 7388, 27558, 2004, -2722, 2191, -1364, 645, -200, 14},
+	{38, -57, -62, 480, -1324, 2603, -4222, 6429, 27727, 2828, -3046, 2302, -1377, 624, -177, 2},
+	{33, -42, -94, 525, -1353, 2552, -3952, 5490, 27831, 3686, -3361, 2400, -1379, 596, -152, -12}
+};
+
+//Decimating by up to 2: as above over 32 taps, between buffer[i + 15] and buffer[i + 16], cutoff 0.85 / 2.
+static const int16_t _RESAMPLE_coefs2[RESAMPLE_PHASES][32] __ALIGNED(4) = {
+	{45, -13, -134, -62, 245, 281, -282, -685, 75, 1241, 639, -1831, -2442, 2286, 10053, 13922,
+		10053, 2286, -2442, -1831, 639, 1241, 75, -685, -282, 281, 245, -62, -134, -13, 45, 14},
+	{45, -10, -131, -69, 236, 290, -260, -688, 35, 1221, 696, -1756, -2497, 2062, 9831, 13923,
+		10269, 2513, -2382, -1904, 579, 1259, 115, -682, -304, 272, 253, -55, -136, -17, 45, 15},
+	{45, -6, -129, -76, 226, 298, -238, -689, -5, 1199, 751, -1680, -2546, 1842, 9606, 13910,
+		10481, 2743, -2315, -1975, 517, 1275, 156, -676, -325, 262, 262, -47, -138, -21, 45, 16},
+	{44, -3, -126, -82, 217, 305, -216, -689, -43, 1176, 804, -1602, -2589, 1626, 9378, 13886,
+		10689, 2976, -2243, -2044, 453, 1289, 198, -670, -347, 251, 270, -39, -139, -25, 45, 18},
+	{44, 1, -123, -88, 207, 312, -194, -688, -81, 1150, 854, -1522, -2626, 1413, 9146, 13853,
+		10892, 3213, -2165, -2110, 388, 1301, 240, -662, -368, 240, 278, -31, -141, -29, 45, 19},
+	{44, 4, -120, -94, 197, 317, -172, -686, -118, 1124, 902, -1442, -2659, 1205, 8910, 13818,
+		11090, 3451, -2081, -2174, 320, 1311, 282, -652, -389, 228, 285, -22, -142, -33, 44, 20},
+	{43, 7, -117, -100, 187, 323, -151, -682, -155, 1095, 948, -1360, -2685, 1002, 8672, 13774,
+		11282, 3693, -1991, -2236, 250, 1318, 324, -642, -409, 215, 292, -14, -143, -37, 44, 21},
+	{42, 10, -114, -105, 177, 327, -129, -677, -190, 1065, 991, -1278, -2706, 802, 8432, 13718,
+		11470, 3936, -1896, -2294, 179, 1323, 367, -630, -429, 202, 299, -5, -144, -41, 43, 23},
+	{42, 13, -110, -110, 167, 331, -107, -671, -224, 1034, 1031, -1195, -2722, 607, 8189, 13655,
+		11651, 4181, -1794, -2350, 106, 1326, 409, -616, -449, 188, 305, 4, -144, -45, 42, 24},
+	{41, 16, -107, -114, 157, 334, -86, -664, -258, 1001, 1069, -1112, -2733, 417, 7944, 13585,
+		11827, 4429, -1686, -2403, 31, 1327, 452, -602, -468, 173, 311, 14, -144, -49, 41, 25},
+	{40, 19, -103, -119, 146, 336, -65, -656, -290, 967, 1104, -1028, -2739, 232, 7697, 13511,
+		11997, 4677, -1573, -2452, -45, 1325, 494, -586, -487, 158, 316, 23, -144, -54, 40, 27},
+	{39, 21, -99, -123, 136, 338, -44, -647, -322, 932, 1137, -944, -2739, 52, 7448, 13424,
+		12161, 4927, -1454, -2498, -122, 1321, 536, -568, -505, 142, 321, 33, -144, -58, 39, 28},
+	{38, 24, -95, -126, 125, 339, -24, -636, -352, 896, 1167, -860, -2735, -123, 7198, 13328,
+		12318, 5179, -1328, -2540, -201, 1314, 578, -549, -523, 126, 325, 43, -143, -62, 38, 29},
+	{37, 26, -91, -129, 115, 339, -4, -625, -381, 859, 1195, -776, -2726, -293, 6947, 13226,
+		12469, 5431, -1197, -2579, -281, 1305, 620, -529, -540, 109, 329, 53, -142, -66, 37, 30},
+	{36, 28, -87, -132, 104, 339, 16, -613, -409, 821, 1219, -692, -2712, -457, 6695, 13122,
+		12613, 5683, -1061, -2614, -361, 1293, 661, -508, -556, 91, 332, 63, -141, -71, 35, 31},
+	{35, 30, -83, -135, 94, 338, 36, -600, -435, 782, 1242, -608, -2694, -617, 6442, 13003,
+		12751, 5936, -918, -2645, -443, 1278, 702, -485, -571, 73, 334, 73, -139, -75, 34, 33},
+	{34, 32, -79, -137, 83, 337, 55, -586, -461, 742, 1261, -525, -2672, -770, 6189, 12881,
+		12881, 6189, -770, -2672, -525, 1261, 742, -461, -586, 55, 337, 83, -137, -79, 32, 34},
+	{33, 34, -75, -139, 73, 334, 73, -571, -485, 702, 1278, -443, -2645, -918, 5936, 12751,
+		13003, 6442, -617, -2694, -608, 1242, 782, -435, -600, 36, 338, 94, -135, -83, 30, 35},
+	{31, 35, -71, -141, 63, 332, 91, -556, -508, 661, 1293, -361, -2614, -1061, 5683, 12613,
+		13122, 6695, -457, -2712, -692, 1219, 821, -409, -613, 16, 339, 104, -132, -87, 28, 36},
+	{30, 37, -66, -142, 53, 329, 109, -540, -529, 620, 1305, -281, -2579, -1197, 5431, 12469,
+		13226, 6947, -293, -2726, -776, 1195, 859, -381, -625, -4, 339, 115, -129, -91, 26, 37},
+	{29, 38, -62, -143, 43, 325, 126, -523, -549, 578, 1314, -201, -2540, -1328, 5179, 12318,
+		13328, 7198, -123, -2735, -860, 1167, 896, -352, -636, -24, 339, 125, -126, -95, 24, 38},
+	{28, 39, -58, -144, 33, 321, 142, -505, -568, 536, 1321, -122, -2498, -1454, 4927, 12161,
+		13424, 7448, 52, -2739, -944, 1137, 932, -322, -647, -44, 338, 136, -123, -99, 21, 39},
+	{27, 40, -54, -144, 23, 316, 158, -487, -586, 494, 1325, -45, -2452, -1573, 4677, 11997,
+		13511, 7697, 232, -2739, -1028, 1104, 967, -290, -656, -65, 336, 146, -119, -103, 19, 40},
+	{25, 41, -49, -144, 14, 311, 173, -468, -602, 452, 1327, 31, -2403, -1686, 4429, 11827,
+		13585, 7944, 417, -2733, -1112, 1069, 1001, -258, -664, -86, 334, 157, -114, -107, 16, 41},
+	{24, 42, -45, -144, 4, 305, 188, -449, -616, 409, 1326, 106, -2350, -1794, 4181, 11651,
+		13655, 8189, 607, -2722, -1195, 1031, 1034, -224, -671, -107, 331, 167, -110, -110, 13, 42},
+	{23, 43, -41, -144, -5, 299, 202, -429, -630, 367, 1323, 179, -2294, -1896, 3936, 11470,
+		13718, 8432, 802, -2706, -1278, 991, 1065, -190, -677, -129, 327, 177, -105, -114, 10, 42},
+	{21, 44, -37, -143, -14, 292, 215, -409, -642, 324, 1318, 250, -2236, -1991, 3693, 11282,
+		13774, 8672, 1002, -2685, -1360, 948, 1095, -155, -682, -151, 323, 187, -100, -117, 7, 43},
+	{20, 44, -33, -142, -22, 285, 228, -389, -652, 282, 1311, 320, -2174, -2081, 3451, 11090,
+		13818, 8910, 1205, -2659, -1442, 902, 1124, -118, -686, -172, 317, 197, -94, -120, 4, 44},
+	{19, 45, -29, -141, -31, 278, 240, -368, -662, 240, 1301, 388, -2110, -2165, 3213, 10892,
+		13853, 9146, 1413, -2626, -1522, 854, 1150, -81, -688, -194, 312, 207, -88, -123, 1, 44},
+	{18, 45, -25, -139, -39, 270, 251, -347, -670, 198, 1289, 453, -2044, -2243, 2976, 10689,
+		13886, 9378, 1626, -2589, -1602, 804, 1176, -43, -689, -216, 305, 217, -82, -126, -3, 44},
+	{16, 45, -21, -138, -47, 262, 262, -325, -676, 156, 1275, 517, -1975, -2315, 2743, 10481,
+		13910, 9606, 1842, -2546, -1680, 751, 1199, -5, -689, -238, 298, 226, -76, -129, -6, 45},
+	{15, 45, -17, -136, -55, 253, 272, -304, -682, 115, 1259, 579, -1904, -2382, 2513, 10269,
+		13923, 9831, 2062, -2497, -1756, 696, 1221, 35, -688, -260, 290, 236, -69, -131, -10, 45}
+};
+
+//Decimating by up to 3: as above over 48 taps, between buffer[i + 23] and buffer[i + 24], cutoff 0.85 / 3.
+static const int16_t _RESAMPLE_coefs3[RESAMPLE_PHASES][48] __ALIGNED(4) = {
+	{26, 27, -9, -67, -96, -41, 93, 213, 188, -34, -333, -457, -208, 348, 827, 751,
+		-64, -1220, -1827, -996, 1524, 5021, 8073, 9281, 8073, 5021, 1524, -996, -1827, -1220, -64, 751,
+		827, 348, -208, -457, -333, -34, 188, 213, 93, -41, -96, -67, -9, 27, 26, 9},
+	{26, 27, -7, -65, -96, -44, 88, 211, 192, -25, -325, -458, -221, 329, 819, 765,
+		-30, -1187, -1826, -1049, 1424, 4911, 7999, 9278, 8144, 5132, 1624, -942, -1826, -1253, -99, 736,
+		836, 367, -194, -455, -341, -43, 184, 215, 97, -38, -96, -69, -10, 26, 27, 10},
+	{25, 27, -6, -64, -96, -48, 83, 208, 195, -16, -316, -459, -235, 311, 809, 778,
+		4, -1154, -1824, -1100, 1325, 4799, 7924, 9283, 8213, 5241, 1726, -886, -1824, -1285, -134, 721,
+		843, 386, -179, -453, -349, -53, 179, 217, 102, -35, -95, -70, -12, 25, 27, 10},
+	{25, 28, -4, -62, -96, -51, 79, 206, 199, -7, -308, -459, -248, 292, 800, 791,
+		37, -1120, -1820, -1149, 1228, 4688, 7847, 9268, 8281, 5351, 1829, -828, -1820, -1316, -169, 705,
+		850, 404, -165, -451, -356, -62, 175, 218, 107, -31, -95, -72, -14, 25, 27, 11},
+	{24, 28, -2, -60, -96, -53, 74, 203, 202, 2, -299, -460, -260, 273, 789, 802,
+		70, -1085, -1815, -1196, 1132, 4576, 7768, 9263, 8346, 5459, 1932, -768, -1815, -1347, -205, 687,
+		856, 423, -150, -448, -363, -72, 170, 220, 111, -28, -94, -74, -16, 24, 28, 12},
+	{24, 29, -1, -58, -96, -56, 69, 200, 205, 11, -291, -459, -272, 254, 778, 813,
+		103, -1050, -1809, -1242, 1036, 4464, 7688, 9250, 8410, 5567, 2036, -707, -1808, -1377, -241, 670,
+		862, 441, -134, -445, -371, -81, 165, 221, 116, -24, -94, -75, -17, 24, 28, 12},
+	{24, 29, 1, -56, -96, -59, 65, 198, 208, 19, -282, -459, -284, 235, 767, 823,
+		135, -1015, -1801, -1286, 942, 4351, 7605, 9240, 8471, 5675, 2142, -644, -1800, -1407, -277, 651,
+		867, 459, -119, -441, -378, -91, 160, 222, 120, -21, -93, -77, -19, 23, 28, 13},
+	{23, 29, 2, -54, -95, -62, 60, 195, 210, 28, -273, -458, -296, 216, 755, 832,
+		167, -979, -1792, -1328, 849, 4239, 7521, 9221, 8531, 5781, 2248, -580, -1790, -1435, -314, 632,
+		872, 477, -103, -437, -384, -100, 155, 224, 125, -17, -92, -78, -21, 22, 29, 13},
+	{23, 29, 3, -53, -95, -64, 56, 192, 213, 36, -264, -456, -307, 197, 743, 841,
+		198, -943, -1781, -1368, 758, 4127, 7436, 9202, 8588, 5887, 2354, -514, -1779, -1463, -350, 612,
+		876, 495, -87, -433, -391, -110, 149, 224, 129, -13, -91, -79, -23, 21, 29, 14},
+	{22, 30, 5, -51, -94, -67, 51, 188, 215, 45, -255, -455, -318, 178, 730, 849,
+		228, -907, -1770, -1407, 668, 4014, 7349, 9185, 8643, 5992, 2462, -446, -1766, -1490, -387, 591,
+		879, 513, -71, -428, -397, -120, 143, 225, 134, -9, -90, -81, -25, 20, 29, 14},
+	{22, 30, 6, -49, -94, -69, 46, 185, 217, 53, -245, -452, -328, 160, 717, 856,
+		258, -870, -1757, -1443, 579, 3901, 7261, 9155, 8697, 6096, 2570, -376, -1751, -1517, -424, 569,
+		881, 530, -54, -423, -403, -130, 138, 226, 138, -5, -89, -82, -26, 20, 29, 15},
+	{21, 30, 7, -47, -93, -71, 42, 182, 219, 61, -236, -450, -338, 141, 703, 862,
+		288, -834, -1743, -1478, 491, 3789, 7171, 9131, 8747, 6200, 2678, -305, -1734, -1542, -461, 547,
+		883, 547, -37, -417, -409, -139, 131, 226, 142, -1, -88, -84, -28, 19, 30, 15},
+	{20, 30, 9, -45, -93, -73, 37, 178, 220, 69, -226, -447, -348, 123, 689, 867,
+		317, -797, -1728, -1512, 405, 3677, 7079, 9105, 8796, 6302, 2788, -232, -1717, -1567, -499, 524,
+		884, 564, -20, -411, -414, -149, 125, 226, 147, 3, -87, -85, -30, 18, 30, 16},
+	{20, 30, 10, -43, -92, -75, 33, 174, 222, 76, -217, -444, -357, 104, 675, 872,
+		345, -760, -1711, -1543, 320, 3564, 6986, 9073, 8843, 6403, 2897, -158, -1697, -1590, -536, 501,
+		885, 581, -3, -405, -419, -159, 119, 226, 151, 7, -86, -86, -32, 17, 30, 17},
+	{19, 30, 11, -41, -91, -77, 28, 171, 223, 84, -207, -441, -366, 86, 660, 876,
+		372, -723, -1694, -1573, 237, 3453, 6892, 9043, 8887, 6503, 3008, -82, -1676, -1613, -573, 476,
+		884, 597, 14, -398, -424, -169, 112, 226, 155, 11, -84, -87, -34, 16, 30, 17},
+	{19, 30, 12, -39, -90, -79, 24, 167, 224, 91, -198, -437, -375, 68, 645, 879,
+		399, -685, -1675, -1601, 155, 3341, 6797, 9009, 8929, 6602, 3118, -5, -1653, -1635, -611, 451,
+		883, 613, 32, -390, -429, -178, 105, 225, 159, 15, -83, -88, -36, 15, 30, 18},
+	{18, 30, 14, -38, -89, -81, 20, 163, 225, 98, -188, -433, -383, 50, 629, 882,
+		426, -648, -1655, -1628, 74, 3229, 6700, 8969, 8969, 6700, 3229, 74, -1628, -1655, -648, 426,
+		882, 629, 50, -383, -433, -188, 98, 225, 163, 20, -81, -89, -38, 14, 30, 18},
+	{18, 30, 15, -36, -88, -83, 15, 159, 225, 105, -178, -429, -390, 32, 613, 883,
+		451, -611, -1635, -1653, -5, 3118, 6602, 8929, 9009, 6797, 3341, 155, -1601, -1675, -685, 399,
+		879, 645, 68, -375, -437, -198, 91, 224, 167, 24, -79, -90, -39, 12, 30, 19},
+	{17, 30, 16, -34, -87, -84, 11, 155, 226, 112, -169, -424, -398, 14, 597, 884,
+		476, -573, -1613, -1676, -82, 3008, 6503, 8887, 9043, 6892, 3453, 237, -1573, -1694, -723, 372,
+		876, 660, 86, -366, -441, -207, 84, 223, 171, 28, -77, -91, -41, 11, 30, 19},
+	{17, 30, 17, -32, -86, -86, 7, 151, 226, 119, -159, -419, -405, -3, 581, 885,
+		501, -536, -1590, -1697, -158, 2897, 6403, 8843, 9073, 6986, 3564, 320, -1543, -1711, -760, 345,
+		872, 675, 104, -357, -444, -217, 76, 222, 174, 33, -75, -92, -43, 10, 30, 20},
+	{16, 30, 18, -30, -85, -87, 3, 147, 226, 125, -149, -414, -411, -20, 564, 884,
+		524, -499, -1567, -1717, -232, 2788, 6302, 8796, 9105, 7079, 3677, 405, -1512, -1728, -797, 317,
+		867, 689, 123, -348, -447, -226, 69, 220, 178, 37, -73, -93, -45, 9, 30, 20},
+	{15, 30, 19, -28, -84, -88, -1, 142, 226, 131, -139, -409, -417, -37, 547, 883,
+		547, -461, -1542, -1734, -305, 2678, 6200, 8747, 9131, 7171, 3789, 491, -1478, -1743, -834, 288,
+		862, 703, 141, -338, -450, -236, 61, 219, 182, 42, -71, -93, -47, 7, 30, 21},
+	{15, 29, 20, -26, -82, -89, -5, 138, 226, 138, -130, -403, -423, -54, 530, 881,
+		569, -424, -1517, -1751, -376, 2570, 6096, 8697, 9155, 7261, 3901, 579, -1443, -1757, -870, 258,
+		856, 717, 160, -328, -452, -245, 53, 217, 185, 46, -69, -94, -49, 6, 30, 22},
+	{14, 29, 20, -25, -81, -90, -9, 134, 225, 143, -120, -397, -428, -71, 513, 879,
+		591, -387, -1490, -1766, -446, 2462, 5992, 8643, 9185, 7349, 4014, 668, -1407, -1770, -907, 228,
+		849, 730, 178, -318, -455, -255, 45, 215, 188, 51, -67, -94, -51, 5, 30, 22},
+	{14, 29, 21, -23, -79, -91, -13, 129, 224, 149, -110, -391, -433, -87, 495, 876,
+		612, -350, -1463, -1779, -514, 2354, 5887, 8588, 9202, 7436, 4127, 758, -1368, -1781, -943, 198,
+		841, 743, 197, -307, -456, -264, 36, 213, 192, 56, -64, -95, -53, 3, 29, 23},
+	{13, 29, 22, -21, -78, -92, -17, 125, 224, 155, -100, -384, -437, -103, 477, 872,
+		632, -314, -1435, -1790, -580, 2248, 5781, 8531, 9221, 7521, 4239, 849, -1328, -1792, -979, 167,
+		832, 755, 216, -296, -458, -273, 28, 210, 195, 60, -62, -95, -54, 2, 29, 23},
+	{13, 28, 23, -19, -77, -93, -21, 120, 222, 160, -91, -378, -441, -119, 459, 867,
+		651, -277, -1407, -1800, -644, 2142, 5675, 8471, 9240, 7605, 4351, 942, -1286, -1801, -1015, 135,
+		823, 767, 235, -284, -459, -282, 19, 208, 198, 65, -59, -96, -56, 1, 29, 24},
+	{12, 28, 24, -17, -75, -94, -24, 116, 221, 165, -81, -371, -445, -134, 441, 862,
+		670, -241, -1377, -1808, -707, 2036, 5567, 8410, 9250, 7688, 4464, 1036, -1242, -1809, -1050, 103,
+		813, 778, 254, -272, -459, -291, 11, 205, 200, 69, -56, -96, -58, -1, 29, 24},
+	{12, 28, 24, -16, -74, -94, -28, 111, 220, 170, -72, -363, -448, -150, 423, 856,
+		687, -205, -1347, -1815, -768, 1932, 5459, 8346, 9263, 7768, 4576, 1132, -1196, -1815, -1085, 70,
+		802, 789, 273, -260, -460, -299, 2, 202, 203, 74, -53, -96, -60, -2, 28, 24},
+	{11, 27, 25, -14, -72, -95, -31, 107, 218, 175, -62, -356, -451, -165, 404, 850,
+		705, -169, -1316, -1820, -828, 1829, 5351, 8281, 9268, 7847, 4688, 1228, -1149, -1820, -1120, 37,
+		791, 800, 292, -248, -459, -308, -7, 199, 206, 79, -51, -96, -62, -4, 28, 25},
+	{10, 27, 25, -12, -70, -95, -35, 102, 217, 179, -53, -349, -453, -179, 386, 843,
+		721, -134, -1285, -1824, -886, 1726, 5241, 8213, 9283, 7924, 4799, 1325, -1100, -1824, -1154, 4,
+		778, 809, 311, -235, -459, -316, -16, 195, 208, 83, -48, -96, -64, -6, 27, 25},
+	{10, 27, 26, -10, -69, -96, -38, 97, 215, 184, -43, -341, -455, -194, 367, 836,
+		736, -99, -1253, -1826, -942, 1624, 5132, 8144, 9278, 7999, 4911, 1424, -1049, -1826, -1187, -30,
+		765, 819, 329, -221, -458, -325, -25, 192, 211, 88, -44, -96, -65, -7, 27, 26}
+};
+
+//By step: the cutoff of each is the output Nyquist at its top step, so nothing above it aliases back.
+static const RESAMPLE_FilterTypeDef _RESAMPLE_filters[] = {
+	{&_RESAMPLE_coefs[0][0], 16U, 0x11000UL},  //1.0625: interpolation and drift around 1:1
+	{&_RESAMPLE_coefs2[0][0], 32U, 0x20000UL},
+	{&_RESAMPLE_coefs3[0][0], 48U, RESAMPLE_MAX_STEP},
+};
+
+HAL_StatusTypeDef RESAMPLE_Init(RESAMPLE_StateTypeDef* state, RESAMPLE_InputTypeDef input, uint32_t inRate, uint32_t outRate){
+	uint64_t step;
+	uint8_t filter = 0;
+	if(inRate == 0 || outRate == 0) return HAL_ERROR;
+	step = ((uint64_t)inRate << 16) / outRate;
+	if(step > RESAMPLE_MAX_STEP) return HAL_ERROR;
+	while(step > _RESAMPLE_filters[filter].maxStep) filter++;
+	state->input = input;
+	state->step = (uint32_t)step;
+	state->position = 0;
+	state->filled = _RESAMPLE_filters[filter].taps / 2U - 1U; //zeros before the first sample, so it is the first output
+	state->ended = 0;
+	state->filter = filter;
+	memset(state->buffer, 0, sizeof(state->buffer));
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef RESAMPLE_SetStep(RESAMPLE_StateTypeDef* state, uint32_t step){
+	if(step == 0 || step > _RESAMPLE_filters[state->filter].maxStep) return HAL_ERROR;
+	state->step = step;
+	return HAL_OK;
+}
+
+//Drops the samples before the window of the next output and reads more. Returns 0 at the end of the stream.
+static uint32_t _RESAMPLE_Refill(RESAMPLE_StateTypeDef* state){
+	uint32_t first = state->position >> 16, half = _RESAMPLE_filters[state->filter].taps / 2U, n;
+	if(state->ended) return 0;
+	if(first > state->filled) first = state->filled;
+	memmove(state->buffer, &state->buffer[first], (state->filled - first) * sizeof(int16_t));
+	state->filled -= first;
+	state->position -= first << 16;
+	n = state->input(&state->buffer[state->filled], RESAMPLE_BLOCK_SIZE);
+	if(n > RESAMPLE_BLOCK_SIZE) n = RESAMPLE_BLOCK_SIZE;
+	if(n == 0){ //flushes the last samples out of the filter
+		memset(&state->buffer[state->filled], 0, half * sizeof(int16_t));
+		n = half;
+		state->ended = 1;
+	}
+	state->filled += n;
+	return n;
+}
+
+uint32_t RESAMPLE_Read(RESAMPLE_StateTypeDef* state, int16_t* out, uint32_t count){
+	const RESAMPLE_FilterTypeDef* filter = &_RESAMPLE_filters[state->filter];
+	uint32_t start = DWT->CYCCNT, produced = 0, i;
+	const int16_t* x;
+	const uint32_t* h;
+	int32_t acc;
+	while(produced < count){
+		if((state->position >> 16) + filter->taps > state->filled){
+			if(_RESAMPLE_Refill(state) == 0) break;
+			continue;
+		}
+		x = &state->buffer[state->position >> 16];
+		h = (const uint32_t*)&filter->coefs[((state->position >> (16U - RESAMPLE_PHASE_BITS)) & (RESAMPLE_PHASES - 1U)) * filter->taps];
+		acc = 1 << 14; //rounding
+		for(i = 0; i < filter->taps / 2U; i++){
+			acc = (int32_t)__SMLAD(__UNALIGNED_UINT32_READ(&x[2U * i]), h[i], (uint32_t)acc); //sum |h| < 2^16: no overflow
+		}
+		out[produced++] = (int16_t)__SSAT(acc >> 15, 16);
+		state->position += state->step;
+	}
+	if(produced) METRICS_Record(METRICS_RESAMPLE, (DWT->CYCCNT - start) / produced);
+	return produced;
+}
@@ -0,0 +1,167 @@
+/**
+ * scheduler.c
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+Cooperative run-to-completion scheduler
+----------------------------------------------------------------------
+ */
+#include "scheduler.h"
+#include "main.h"
+
+#ifndef SCHED_TRACE_POST
+#define SCHED_TRACE_POST(handler) ((void)0)
+#endif
+#ifndef SCHED_TRACE_RUN
+#define SCHED_TRACE_RUN(handler)  ((void)0)
+#endif
+#ifndef SCHED_TRACE_DEPTH
+#define SCHED_TRACE_DEPTH(depth)  ((void)0)
+#endif
+
+#define SCHED_QUEUE_MASK (SCHED_QUEUE_SIZE - 1U)
+
+typedef struct {
+	SCHED_HandlerTypeDef handler;
+	uint32_t arg;
+} SCHED_EventTypeDef;
+
+typedef struct {
+	SCHED_EventTypeDef events[SCHED_QUEUE_SIZE];
+	volatile uint8_t head; //written by producers, with interrupts masked
+	volatile uint8_t tail; //written by SCHED_RunOnce() only
+} SCHED_QueueTypeDef;
+
+typedef struct {
+	SCHED_HandlerTypeDef handler;
+	uint32_t arg;
+	uint32_t deadline;
+	uint32_t period;
+	uint8_t active;
+} SCHED_TimerTypeDef;
+
+static SCHED_QueueTypeDef _SCHED_queues[SCHED_PRIO_COUNT];
+static SCHED_TimerTypeDef _SCHED_timers[SCHED_TIMERS];
+static uint8_t _SCHED_timersActive;
+static volatile uint32_t _SCHED_dropped;
+
+static uint8_t _SCHED_Pending(void){
+	uint8_t prio;
+	for(prio = 0; prio < SCHED_PRIO_COUNT; prio++){
+		if(_SCHED_queues[prio].head != _SCHED_queues[prio].tail) return 1;
+	}
+	return 0;
+}
+
+static void _SCHED_CheckTimers(void){
+	uint32_t now = HAL_GetTick();
+	uint8_t i;
+	SCHED_TimerTypeDef* timer;
+	if(!_SCHED_timersActive) return;
+	for(i = 0; i < SCHED_TIMERS; i++){
+		timer = &_SCHED_timers[i];
+		if(!timer->active || (int32_t)(now - timer->deadline) < 0) continue;
+		if(SCHED_Post(SCHED_PRIO_NORMAL, timer->handler, timer->arg) != HAL_OK) continue; //retry on the next pass
+		if(timer->period){
+			timer->deadline += timer->period;
+		}else{
+			timer->active = 0;
+			_SCHED_timersActive--;
+		}
+	}
+}
+
+void SCHED_Init(void){
+	uint8_t i;
+	for(i = 0; i < SCHED_PRIO_COUNT; i++){
+		_SCHED_queues[i].head = 0;
+		_SCHED_queues[i].tail = 0;
+	}
+	for(i = 0; i < SCHED_TIMERS; i++){
+		_SCHED_timers[i].active = 0;
+	}
+	_SCHED_timersActive = 0;
+	_SCHED_dropped = 0;
+}
+
+HAL_StatusTypeDef SCHED_Post(SCHED_PriorityTypeDef prio, SCHED_HandlerTypeDef handler, uint32_t arg){
+	SCHED_QueueTypeDef* queue = &_SCHED_queues[prio];
+	uint32_t primask = __get_PRIMASK();
+	uint8_t head;
+	__disable_irq();
+	head = queue->head;
+	if(((head + 1U) & SCHED_QUEUE_MASK) == queue->tail){
+		_SCHED_dropped++;
+		__set_PRIMASK(primask);
+		return HAL_BUSY;
+	}
+	queue->events[head].handler = handler;
+	queue->events[head].arg = arg;
+	queue->head = (head + 1U) & SCHED_QUEUE_MASK;
+	__set_PRIMASK(primask);
+	SCHED_TRACE_POST(handler);
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef SCHED_TimerStart(uint8_t timer, uint32_t delay, uint32_t period, SCHED_HandlerTypeDef handler, uint32_t arg){
+	if(timer >= SCHED_TIMERS) return HAL_ERROR;
+	SCHED_TimerStop(timer);
+	_SCHED_timers[timer].handler = handler;
+	_SCHED_timers[timer].arg = arg;
+	_SCHED_timers[timer].deadline = HAL_GetTick() + delay;
+	_SCHED_timers[timer].period = period;
+	_SCHED_timers[timer].active = 1;
+	_SCHED_timersActive++;
+	return HAL_OK;
+}
+
+void SCHED_TimerStop(uint8_t timer){
+	if(timer >= SCHED_TIMERS || !_SCHED_timers[timer].active) return;
+	_SCHED_timers[timer].active = 0;
+	_SCHED_timersActive--;
+}
+
+uint8_t SCHED_RunOnce(void){
+	uint8_t prio, tail;
+	SCHED_QueueTypeDef* queue;
+	SCHED_EventTypeDef event;
+	_SCHED_CheckTimers();
+	for(prio = 0; prio < SCHED_PRIO_COUNT; prio++){
+		queue = &_SCHED_queues[prio];
+		tail = queue->tail;
+		if(queue->head == tail) continue;
+		SCHED_TRACE_DEPTH((queue->head - tail) & SCHED_QUEUE_MASK);
+		event = queue->events[tail];
+		queue->tail = (tail + 1U) & SCHED_QUEUE_MASK;
+		SCHED_TRACE_RUN(event.handler);
+		event.handler(event.arg);
+		SCHED_TRACE_RUN(0);
+		return 1;
+	}
+	return 0;
+}
+
+void SCHED_Run(void){
+	while(1){
+		if(SCHED_RunOnce()) continue;
+		__disable_irq();
+		if(!_SCHED_Pending()) __WFI(); //a pending interrupt still wakes the core with PRIMASK set
+		__enable_irq();
+	}
+}
+
+uint32_t SCHED_GetDropped(void){
+	return _SCHED_dropped;
+}
@@ -56,8 +56,13 @@
 /* USER CODE END 0 */
 
 /* External variables --------------------------------------------------------*/
+extern DMA_HandleTypeDef hdma_tim6_up;
+extern DMA_HandleTypeDef hdma_usart2_rx;
+extern DMA_HandleTypeDef hdma_usart2_tx;
+extern UART_HandleTypeDef huart2;
 
 /* USER CODE BEGIN EV */
+extern DMA_HandleTypeDef hdma_adc1;
 
 /* USER CODE END EV */
 
@@ -199,21 +204,102 @@ void SysTick_Handler(void)
 /* please refer to the startup file (startup_stm32f4xx.s).                    */
 /******************************************************************************/
 
+/**
+  * @brief This function handles Flash global interrupt.
+  */
+void FLASH_IRQHandler(void)
+{
+  /* USER CODE BEGIN FLASH_IRQn 0 */
+
+  /* USER CODE END FLASH_IRQn 0 */
+  HAL_FLASH_IRQHandler();
+  /* USER CODE BEGIN FLASH_IRQn 1 */
+
+  /* USER CODE END FLASH_IRQn 1 */
+}
+
 /**
   * @brief This function handles EXTI line 0 interrupt.
   */
 void EXTI0_IRQHandler(void)
 {
   /* USER CODE BEGIN EXTI0_IRQn 0 */
-
+  uint32_t start = DWT->CYCCNT;
+  TRACE_ISR_ENTER(EXTI0_IRQn);
   /* USER CODE END EXTI0_IRQn 0 */
   HAL_GPIO_EXTI_IRQHandler(GPIO_PIN_0);
   /* USER CODE BEGIN EXTI0_IRQn 1 */
-
+  TRACE_ISR_EXIT(EXTI0_IRQn);
+  METRICS_Record(METRICS_EXTI_SERVICE, DWT->CYCCNT - start);
   /* USER CODE END EXTI0_IRQn 1 */
 }
 
+/**
+  * @brief This function handles DMA1 stream1 global interrupt.
+  */
+void DMA1_Stream1_IRQHandler(void)
+{
+  /* USER CODE BEGIN DMA1_Stream1_IRQn 0 */
+  TRACE_ISR_ENTER(DMA1_Stream1_IRQn);
+  /* USER CODE END DMA1_Stream1_IRQn 0 */
+  HAL_DMA_IRQHandler(&hdma_tim6_up);
+  /* USER CODE BEGIN DMA1_Stream1_IRQn 1 */
+  TRACE_ISR_EXIT(DMA1_Stream1_IRQn);
+  /* USER CODE END DMA1_Stream1_IRQn 1 */
+}
+
+/**
+  * @brief This function handles DMA1 stream5 global interrupt.
+  */
+void DMA1_Stream5_IRQHandler(void)
+{
+  /* USER CODE BEGIN DMA1_Stream5_IRQn 0 */
+  TRACE_ISR_ENTER(DMA1_Stream5_IRQn);
+  /* USER CODE END DMA1_Stream5_IRQn 0 */
+  HAL_DMA_IRQHandler(&hdma_usart2_rx);
+  /* USER CODE BEGIN DMA1_Stream5_IRQn 1 */
+  TRACE_ISR_EXIT(DMA1_Stream5_IRQn);
+  /* USER CODE END DMA1_Stream5_IRQn 1 */
+}
+
+/**
+  * @brief This function handles DMA1 stream6 global interrupt.
+  */
+void DMA1_Stream6_IRQHandler(void)
+{
+  /* USER CODE BEGIN DMA1_Stream6_IRQn 0 */
+  TRACE_ISR_ENTER(DMA1_Stream6_IRQn);
+  /* USER CODE END DMA1_Stream6_IRQn 0 */
+  HAL_DMA_IRQHandler(&hdma_usart2_tx);
+  /* USER CODE BEGIN DMA1_Stream6_IRQn 1 */
+  TRACE_ISR_EXIT(DMA1_Stream6_IRQn);
+  /* USER CODE END DMA1_Stream6_IRQn 1 */
+}
+
+/**
+  * @brief This function handles USART2 global interrupt.
+  */
+void USART2_IRQHandler(void)
+{
+  /* USER CODE BEGIN USART2_IRQn 0 */
+  TRACE_ISR_ENTER(USART2_IRQn);
+  /* USER CODE END USART2_IRQn 0 */
+  HAL_UART_IRQHandler(&huart2);
+  /* USER CODE BEGIN USART2_IRQn 1 */
+  TRACE_ISR_EXIT(USART2_IRQn);
+  /* USER CODE END USART2_IRQn 1 */
+}
+
 /* USER CODE BEGIN 1 */
+/**
+  * @brief This function handles DMA2 stream0 global interrupt (ADC1 capture, configured in capture.c).
+  */
+void DMA2_Stream0_IRQHandler(void)
+{
+  TRACE_ISR_ENTER(DMA2_Stream0_IRQn);
+  HAL_DMA_IRQHandler(&hdma_adc1);
+  TRACE_ISR_EXIT(DMA2_Stream0_IRQn);
+}
 
 /* USER CODE END 1 */
 /************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
@@ -0,0 +1,246 @@
+/**
+ * stream.c
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+Host audio stream
+----------------------------------------------------------------------
+ */
+#include "stream.h"
+#include "resample.h"
+#include "metrics.h"
+#include "logger.h"
+#include <string.h>
+
+#define STREAM_MASK (STREAM_BUFFER_SIZE - 1U)
+
+#if (STREAM_BUFFER_SIZE & STREAM_MASK) != 0
+#error "STREAM_BUFFER_SIZE must be a power of two"
+#endif
+#if STREAM_PREFILL > STREAM_BUFFER_SIZE - STREAM_MAX_WRITE || STREAM_MAX_TARGET > STREAM_BUFFER_SIZE - STREAM_MAX_WRITE
+#error "STREAM_PREFILL or STREAM_MAX_TARGET leaves no room for the next write"
+#endif
+
+#define STREAM_AVERAGE_SHIFT 4U   //fill average over 16 refills, kept in Q4
+#define STREAM_INTEGRAL_SHIFT 10U //step correction: 1 Q16 unit per sample off the target, plus the sum over 1024 refills
+#define STREAM_MAX_DRIFT     512  //Q16 units, 0.78%
+#define STREAM_WINDOW        125U //refills, 1s at 16kHz
+#define STREAM_MARGIN        256U //samples the lowest fill of a window is steered to
+#define STREAM_UNDERRUN_STEP 512U //samples added to the target on an underrun
+
+static int16_t _STREAM_buffer[STREAM_BUFFER_SIZE];
+static int16_t _STREAM_scratch[STREAM_MAX_WRITE] __ALIGNED(4);
+static volatile uint32_t _STREAM_head; //samples written, free running, by the main loop
+static volatile uint32_t _STREAM_tail; //samples read, free running, by the DMA interrupt
+static volatile uint8_t _STREAM_ended; //no more writes: the buffer plays out
+static volatile uint32_t _STREAM_underruns;
+static volatile uint32_t _STREAM_target; //fill to start, or to restart after an underrun, at
+static STREAM_ModeTypeDef _STREAM_mode;
+static RESAMPLE_StateTypeDef _STREAM_resample;
+static uint8_t _STREAM_rebuffering; //live: silence until the fill is back to the target
+static int32_t _STREAM_average;     //live: fill average, Q4
+static int32_t _STREAM_integral;    //live: sum of the fill errors
+static uint32_t _STREAM_low;        //live: lowest fill of the window
+static uint32_t _STREAM_refills;    //live: refills in the window
+static CODEC_FormatTypeDef _STREAM_format;
+static CODEC_AdpcmStateTypeDef _STREAM_adpcm;
+static PLAYBACK_RouteTypeDef _STREAM_route;
+static uint16_t _STREAM_seq;    //next sequence number
+static uint8_t _STREAM_open;    //between STREAM_Start() and STREAM_End()
+static uint8_t _STREAM_written; //a write was accepted: _STREAM_seq - 1 is a repeat
+static uint8_t _STREAM_playing; //playback was started
+
+static uint32_t _STREAM_Read(int16_t* buffer, uint32_t count);
+
+static HAL_StatusTypeDef _STREAM_Play(void){
+	HAL_StatusTypeDef result;
+	if(_STREAM_playing) return HAL_OK;
+	if(_STREAM_mode == STREAM_MODE_LIVE){
+		RESAMPLE_Init(&_STREAM_resample, _STREAM_Read, PLAYBACK_SAMPLE_RATE, PLAYBACK_SAMPLE_RATE);
+		_STREAM_average = (int32_t)((_STREAM_head - _STREAM_tail) << STREAM_AVERAGE_SHIFT);
+		_STREAM_integral = 0;
+		_STREAM_low = STREAM_BUFFER_SIZE;
+		_STREAM_refills = 0;
+	}
+	result = PLAYBACK_Start(STREAM_Source, _STREAM_route);
+	if(result == HAL_OK) _STREAM_playing = 1;
+	return result;
+}
+
+//Returns the number of samples in {size} bytes, 0 if that is not a whole even number.
+static uint32_t _STREAM_Samples(uint32_t size){
+	uint32_t count;
+	switch(_STREAM_format){
+		case CODEC_FORMAT_PCM16:
+			count = (size & 1U) ? 0 : size / 2U;
+			break;
+		case CODEC_FORMAT_ULAW:
+			count = size;
+			break;
+		default:
+			count = size * 2U;
+			break;
+	}
+	return (count & 1U) ? 0 : count;
+}
+
+HAL_StatusTypeDef STREAM_Start(CODEC_FormatTypeDef format, PLAYBACK_RouteTypeDef route, STREAM_ModeTypeDef mode){
+	if(CODEC_BlockSize(format, CODEC_BLOCK_SAMPLES) == 0 || mode > STREAM_MODE_LIVE) return HAL_ERROR;
+	if(PLAYBACK_IsPlaying()) return HAL_BUSY;
+	_STREAM_format = format;
+	_STREAM_route = route;
+	_STREAM_mode = mode;
+	_STREAM_target = mode == STREAM_MODE_LIVE ? STREAM_LIVE_TARGET : STREAM_PREFILL;
+	_STREAM_rebuffering = 0;
+	_STREAM_adpcm.predictor = 0;
+	_STREAM_adpcm.index = 0;
+	_STREAM_head = 0;
+	_STREAM_tail = 0;
+	_STREAM_ended = 0;
+	_STREAM_underruns = 0;
+	_STREAM_seq = 0;
+	_STREAM_written = 0;
+	_STREAM_playing = 0;
+	_STREAM_open = 1;
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef STREAM_Write(uint16_t seq, const uint8_t* data, uint32_t size){
+	uint32_t count, head, first;
+	if(!_STREAM_open) return HAL_ERROR;
+	if(_STREAM_written && seq == (uint16_t)(_STREAM_seq - 1U)) return HAL_OK; //the reply was lost
+	if(seq != _STREAM_seq) return HAL_ERROR;
+	count = _STREAM_Samples(size);
+	if(count == 0 || count > STREAM_MAX_WRITE) return HAL_ERROR;
+	head = _STREAM_head;
+	if(STREAM_BUFFER_SIZE - (head - _STREAM_tail) < count) return HAL_BUSY;
+	switch(_STREAM_format){
+		case CODEC_FORMAT_PCM16:
+			memcpy(_STREAM_scratch, data, size);
+			break;
+		case CODEC_FORMAT_ULAW:
+			CODEC_UlawDecode(data, _STREAM_scratch, count);
+			break;
+		default:
+			CODEC_AdpcmDecode(&_STREAM_adpcm, data, _STREAM_scratch, count);
+			break;
+	}
+	first = STREAM_BUFFER_SIZE - (head & STREAM_MASK);
+	if(first > count) first = count;
+	memcpy(&_STREAM_buffer[head & STREAM_MASK], _STREAM_scratch, first * sizeof(int16_t));
+	memcpy(_STREAM_buffer, &_STREAM_scratch[first], (count - first) * sizeof(int16_t));
+	__DMB(); //the samples are in before the interrupt sees them
+	_STREAM_head = head + count;
+	_STREAM_seq++;
+	_STREAM_written = 1;
+	if(_STREAM_head - _STREAM_tail >= _STREAM_target) _STREAM_Play(); //retried on the next write if playback is busy
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef STREAM_End(uint8_t abort){
+	if(!_STREAM_open) return HAL_ERROR;
+	_STREAM_open = 0;
+	_STREAM_ended = 1;
+	if(abort){
+		if(PLAYBACK_GetSource() == STREAM_Source) PLAYBACK_Stop();
+		return HAL_OK;
+	}
+	return _STREAM_Play(); //a stream shorter than STREAM_PREFILL
+}
+
+uint32_t STREAM_GetAck(void){
+	return ((STREAM_BUFFER_SIZE - (_STREAM_head - _STREAM_tail)) << 16) | _STREAM_seq;
+}
+
+uint32_t STREAM_GetUnderruns(void){
+	return _STREAM_underruns;
+}
+
+uint32_t STREAM_GetTarget(void){
+	return _STREAM_target;
+}
+
+static void _STREAM_SetTarget(int32_t target){
+	if(target < (int32_t)STREAM_MIN_TARGET) target = STREAM_MIN_TARGET;
+	if(target > (int32_t)STREAM_MAX_TARGET) target = STREAM_MAX_TARGET;
+	_STREAM_target = (uint32_t)target;
+}
+
+//Live mode, once per refill: steers the fill average to the target with the converter step, and the target to the jitter.
+static void _STREAM_Track(uint32_t fill){
+	int32_t error, correction;
+	_STREAM_average += ((int32_t)(fill << STREAM_AVERAGE_SHIFT) - _STREAM_average) >> STREAM_AVERAGE_SHIFT;
+	error = (_STREAM_average >> STREAM_AVERAGE_SHIFT) - (int32_t)_STREAM_target;
+	_STREAM_integral += error;
+	if(_STREAM_integral > (STREAM_MAX_DRIFT << STREAM_INTEGRAL_SHIFT)) _STREAM_integral = STREAM_MAX_DRIFT << STREAM_INTEGRAL_SHIFT;
+	if(_STREAM_integral < -(STREAM_MAX_DRIFT << STREAM_INTEGRAL_SHIFT)) _STREAM_integral = -(STREAM_MAX_DRIFT << STREAM_INTEGRAL_SHIFT);
+	correction = error + (_STREAM_integral >> STREAM_INTEGRAL_SHIFT); //PI, damped: the fill settles in about 10s
+	if(correction > STREAM_MAX_DRIFT) correction = STREAM_MAX_DRIFT;
+	if(correction < -STREAM_MAX_DRIFT) correction = -STREAM_MAX_DRIFT;
+	RESAMPLE_SetStep(&_STREAM_resample, (uint32_t)(0x10000 + correction)); //host clock ahead of the DAC: the fill grows, read faster
+	if(fill < _STREAM_low) _STREAM_low = fill;
+	if(++_STREAM_refills == STREAM_WINDOW){ //the lowest fill shows how much of the target the jitter needed
+		_STREAM_SetTarget((int32_t)_STREAM_target + ((int32_t)STREAM_MARGIN - (int32_t)_STREAM_low) / 2);
+		_STREAM_low = STREAM_BUFFER_SIZE;
+		_STREAM_refills = 0;
+	}
+}
+
+//Reads the ring, padding with silence at the end of the stream or on an underrun. Returns 0 once it is over.
+static uint32_t _STREAM_Read(int16_t* buffer, uint32_t count){
+	uint32_t tail = _STREAM_tail, n = _STREAM_head - tail, first;
+	if(n == 0 && _STREAM_ended){
+		LOG("stream: %lu samples, %lu underruns, target %lu", tail, _STREAM_underruns, _STREAM_target);
+		return 0;
+	}
+	if(_STREAM_rebuffering){
+		if(n < _STREAM_target && !_STREAM_ended) n = 0;
+		else _STREAM_rebuffering = 0;
+	}
+	if(n < count){
+		if(!_STREAM_ended && !_STREAM_rebuffering){ //silence until the host catches up
+			_STREAM_underruns++;
+			if(_STREAM_mode == STREAM_MODE_LIVE){ //and a deeper buffer from now on
+				_STREAM_SetTarget((int32_t)(_STREAM_target + STREAM_UNDERRUN_STEP));
+				_STREAM_rebuffering = 1;
+				_STREAM_low = STREAM_BUFFER_SIZE;
+				_STREAM_refills = 0;
+				n = 0;
+			}
+		}
+	}else{
+		n = count;
+	}
+	first = STREAM_BUFFER_SIZE - (tail & STREAM_MASK);
+	if(first > n) first = n;
+	memcpy(buffer, &_STREAM_buffer[tail & STREAM_MASK], first * sizeof(int16_t));
+	memcpy(&buffer[first], _STREAM_buffer, (n - first) * sizeof(int16_t));
+	__DMB(); //the samples are out before the main loop reuses their room
+	_STREAM_tail = tail + n;
+	memset(&buffer[n], 0, (count - n) * sizeof(int16_t));
+	return count;
+}
+
+//Called from the DMA interrupt.
+uint32_t STREAM_Source(int16_t* buffer, uint32_t count){
+	uint32_t fill = _STREAM_head - _STREAM_tail, n;
+	METRICS_Record(METRICS_STREAM_LATENCY, fill + PLAYBACK_HALF_SIZE); //buffered, and the half playing now
+	if(_STREAM_mode == STREAM_MODE_BUFFERED) return _STREAM_Read(buffer, count);
+	if(!_STREAM_rebuffering) _STREAM_Track(fill);
+	n = RESAMPLE_Read(&_STREAM_resample, buffer, count);
+	if(n == 0) return 0;
+	memset(&buffer[n], 0, (count - n) * sizeof(int16_t)); //end of the stream, not an underrun
+	return count;
+}
@@ -0,0 +1,174 @@
+/**
+ * telemetry.c
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+USART2 telemetry stream
+----------------------------------------------------------------------
+ */
+#include "telemetry.h"
+#include "scheduler.h"
+#include <string.h>
+
+/* State word: [index:1][committed:11][reserved:11] */
+#define TELEM_RESERVED_Pos  0U
+#define TELEM_RESERVED_Msk  (0x7FFUL << TELEM_RESERVED_Pos)
+#define TELEM_COMMITTED_Pos 11U
+#define TELEM_COMMITTED_Msk (0x7FFUL << TELEM_COMMITTED_Pos)
+#define TELEM_INDEX_Pos     22U
+#define TELEM_INDEX_Msk     (1UL << TELEM_INDEX_Pos)
+
+#define TELEM_MAX_ENCODED   (TELEM_MAX_FRAME + 2U) //COBS overhead and delimiter
+#define TELEM_STACK_PAINT   0xA5A5A5A5UL
+#define TELEM_STACK_MARGIN  64U //bytes under the stack pointer left unpainted
+
+#if TELEM_BUFFER_SIZE > 2047U
+#error "TELEM_BUFFER_SIZE does not fit the state word"
+#endif
+
+extern uint8_t _end;
+extern uint8_t _estack;
+extern uint32_t _Min_Stack_Size;
+extern void* _sbrk(ptrdiff_t incr);
+
+static UART_HandleTypeDef* _TELEM_huart;
+static uint8_t _TELEM_buffers[2][TELEM_BUFFER_SIZE];
+static volatile uint32_t _TELEM_state;
+static volatile uint32_t _TELEM_dropped;
+
+static uint16_t _TELEM_CobsEncode(const uint8_t* src, uint16_t len, uint8_t* dst){
+	uint16_t read = 0, write = 1, codePos = 0;
+	uint8_t code = 1;
+	while(read < len){
+		if(src[read] == 0){
+			dst[codePos] = code;
+			codePos = write++;
+			code = 1;
+		}else{
+			dst[write++] = src[read];
+			if(++code == 0xFF){
+				dst[codePos] = code;
+				codePos = write++;
+				code = 1;
+			}
+		}
+		read++;
+	}
+	dst[codePos] = code;
+	dst[write++] = 0;
+	return write;
+}
+
+static uint8_t _TELEM_Varint(uint8_t* dst, uint32_t value){
+	uint8_t len = 0;
+	while(value >= 0x80U){
+		dst[len++] = (uint8_t)value | 0x80U;
+		value >>= 7;
+	}
+	dst[len++] = (uint8_t)value;
+	return len;
+}
+
+static uint32_t* _TELEM_StackBottom(void){
+	return (uint32_t*)((uint32_t)&_estack - (uint32_t)&_Min_Stack_Size);
+}
+
+void TELEM_Init(UART_HandleTypeDef* huart){
+	uint32_t* word = _TELEM_StackBottom();
+	uint32_t* top = (uint32_t*)(__get_MSP() - TELEM_STACK_MARGIN);
+	_TELEM_huart = huart;
+	_TELEM_state = 0;
+	_TELEM_dropped = 0;
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CYCCNT = 0;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+	while(word < top){
+		*word++ = TELEM_STACK_PAINT;
+	}
+}
+
+HAL_StatusTypeDef TELEM_Write(const uint8_t* frame, uint16_t len){
+	uint8_t encoded[TELEM_MAX_ENCODED];
+	uint32_t state, offset;
+	if(len > TELEM_MAX_FRAME){
+		_TELEM_dropped++;
+		return HAL_ERROR;
+	}
+	len = _TELEM_CobsEncode(frame, len, encoded);
+	do{ //reserve
+		state = __LDREXW(&_TELEM_state);
+		offset = (state & TELEM_RESERVED_Msk) >> TELEM_RESERVED_Pos;
+		if(offset + len > TELEM_BUFFER_SIZE){
+			__CLREX();
+			_TELEM_dropped++;
+			return HAL_BUSY;
+		}
+	}while(__STREXW(state + (len << TELEM_RESERVED_Pos), &_TELEM_state));
+	memcpy(&_TELEM_buffers[(state & TELEM_INDEX_Msk) >> TELEM_INDEX_Pos][offset], encoded, len);
+	do{ //commit: the buffer cannot be swapped before this
+		state = __LDREXW(&_TELEM_state);
+	}while(__STREXW(state + (len << TELEM_COMMITTED_Pos), &_TELEM_state));
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef TELEM_Record(uint8_t type, const uint32_t* values, uint8_t count){
+	uint8_t frame[1 + 5 * (1 + TELEM_MAX_VALUES)];
+	uint16_t len = 0;
+	uint8_t i;
+	if(count > TELEM_MAX_VALUES){
+		_TELEM_dropped++;
+		return HAL_ERROR;
+	}
+	frame[len++] = type;
+	len += _TELEM_Varint(&frame[len], HAL_GetTick());
+	for(i = 0; i < count; i++){
+		len += _TELEM_Varint(&frame[len], values[i]);
+	}
+	return TELEM_Write(frame, len);
+}
+
+void TELEM_Flush(uint32_t arg){
+	uint32_t state, reserved;
+	UNUSED(arg);
+	if(_TELEM_huart->gState != HAL_UART_STATE_READY) return; //the other buffer is still going out
+	do{
+		state = __LDREXW(&_TELEM_state);
+		reserved = (state & TELEM_RESERVED_Msk) >> TELEM_RESERVED_Pos;
+		if(reserved == 0 || reserved != (state & TELEM_COMMITTED_Msk) >> TELEM_COMMITTED_Pos){
+			__CLREX();
+			return; //nothing to send, or a producer is still copying: retry on the next flush
+		}
+	}while(__STREXW((state ^ TELEM_INDEX_Msk) & TELEM_INDEX_Msk, &_TELEM_state));
+	HAL_UART_Transmit_DMA(_TELEM_huart, _TELEM_buffers[(state & TELEM_INDEX_Msk) >> TELEM_INDEX_Pos], reserved);
+}
+
+void TELEM_Watermark(uint32_t arg){
+	uint32_t values[2];
+	uint32_t* word = _TELEM_StackBottom();
+	UNUSED(arg);
+	while(word < (uint32_t*)&_estack && *word == TELEM_STACK_PAINT) word++;
+	values[0] = (uint32_t)_sbrk(0) - (uint32_t)&_end;
+	values[1] = (uint32_t)&_estack - (uint32_t)word;
+	TELEM_Record(TELEM_REC_WATERMARK, values, 2);
+}
+
+void TELEM_TxCpltCallback(UART_HandleTypeDef* huart){
+	if(huart != _TELEM_huart) return;
+	SCHED_Post(SCHED_PRIO_LOW, TELEM_Flush, 0);
+}
+
+uint32_t TELEM_GetDropped(void){
+	return _TELEM_dropped;
+}
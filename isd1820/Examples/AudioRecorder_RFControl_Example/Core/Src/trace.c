@@ -0,0 +1,37 @@
+/**
+ * trace.c
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+ITM/SWO event tracing
+----------------------------------------------------------------------
+ */
+#include "trace.h"
+
+#define TRACE_ITM_UNLOCK   0xC5ACCE55UL
+#define TRACE_TPI_NRZ      2U
+#define TRACE_PORTS_Msk    (((1UL << (TRACE_PORT_DTMF + 1U)) - 1U) & ~1UL) //ports 1 to TRACE_PORT_DTMF
+
+void TRACE_Init(void){
+	DBGMCU->CR |= DBGMCU_CR_TRACE_IOEN; //asynchronous trace: SWO on PB3
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	TPI->SPPR = TRACE_TPI_NRZ;
+	TPI->ACPR = HAL_RCC_GetHCLKFreq() / TRACE_SWO_BAUD - 1U;
+	TPI->FFCR = 0x100U; //formatter off, ITM packets go straight out
+	ITM->LAR = TRACE_ITM_UNLOCK;
+	ITM->TCR = (1UL << ITM_TCR_TraceBusID_Pos) | ITM_TCR_TSENA_Msk | ITM_TCR_SYNCENA_Msk | ITM_TCR_ITMENA_Msk;
+	ITM->TPR = 0; //ports usable without privilege
+	ITM->TER |= TRACE_PORTS_Msk;
+}
@@ -0,0 +1,434 @@
+/**
+ * uart_cmd.c
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+USART2 binary command channel
+----------------------------------------------------------------------
+ */
+#include "uart_cmd.h"
+#include "crc32.h"
+#include "scheduler.h"
+#include "isd1820.h"
+#include "telemetry.h"
+#include "logger.h"
+#include "metrics.h"
+#include "clips.h"
+#include "recorder.h"
+#include "vad.h"
+#include "playback.h"
+#include "stream.h"
+#include "offload.h"
+#include <string.h>
+
+#define UARTCMD_RX_MASK     (UARTCMD_RX_BUFFER_SIZE - 1U)
+#define UARTCMD_MAX_ENCODED (UARTCMD_MAX_FRAME + UARTCMD_MAX_FRAME / 254U + 1U) //COBS adds one byte per 254 data bytes
+#define UARTCMD_CRC_SIZE    4U
+#define UARTCMD_REPLY_SIZE  (2U + 4U + UARTCMD_CRC_SIZE)
+#define UARTCMD_PLAY_COMPLETE_TIME 100U
+
+#if (UARTCMD_RX_BUFFER_SIZE & UARTCMD_RX_MASK) != 0
+#error "UARTCMD_RX_BUFFER_SIZE must be a power of two"
+#endif
+#if UARTCMD_MAX_FRAME < 3U + 2U * STREAM_MAX_WRITE + UARTCMD_CRC_SIZE
+#error "UARTCMD_MAX_FRAME cannot hold a STREAM_MAX_WRITE PCM16 write"
+#endif
+#if 2U * UARTCMD_MAX_ENCODED > UARTCMD_RX_BUFFER_SIZE
+#error "UARTCMD_RX_BUFFER_SIZE must hold two frames: one being parsed, the next being received"
+#endif
+
+typedef __PACKED_STRUCT {
+	uint8_t cmd;
+	uint32_t duration;
+} UARTCMD_DurationTypeDef;
+
+typedef __PACKED_STRUCT {
+	uint8_t cmd;
+	uint8_t enable;
+} UARTCMD_EnableTypeDef;
+
+typedef __PACKED_STRUCT {
+	uint8_t cmd;
+	uint8_t histogram;
+	uint8_t reset;
+} UARTCMD_MetricsTypeDef;
+
+typedef __PACKED_STRUCT {
+	uint8_t cmd;
+	uint16_t id;
+	uint8_t route;
+} UARTCMD_ClipTypeDef;
+
+typedef __PACKED_STRUCT {
+	uint8_t cmd;
+	uint8_t op;
+	uint8_t format;
+} UARTCMD_FlashRecTypeDef;
+
+typedef __PACKED_STRUCT {
+	uint8_t cmd;
+	uint16_t id;
+	uint8_t stream;
+	uint16_t gain;
+	uint8_t route;
+} UARTCMD_MixTypeDef;
+
+typedef __PACKED_STRUCT {
+	uint8_t cmd;
+	uint32_t speed;
+} UARTCMD_SpeedTypeDef;
+
+typedef __PACKED_STRUCT {
+	uint8_t cmd;
+	uint8_t format;
+	uint8_t route;
+	uint8_t mode;
+} UARTCMD_StreamStartTypeDef;
+
+typedef __PACKED_STRUCT {
+	uint8_t cmd;
+	uint16_t seq;
+	uint8_t data[];
+} UARTCMD_StreamDataTypeDef;
+
+typedef __PACKED_STRUCT {
+	uint8_t cmd;
+	uint8_t op;
+	uint16_t id;
+} UARTCMD_OffloadTypeDef;
+
+typedef __PACKED_STRUCT {
+	uint8_t cmd;
+	uint16_t seq;
+	uint8_t resend;
+} UARTCMD_OffloadAckTypeDef;
+
+typedef __PACKED_STRUCT {
+	uint8_t cmd;
+	uint8_t result;
+	uint32_t status;
+	uint32_t crc;
+} UARTCMD_ReplyTypeDef;
+
+static UART_HandleTypeDef* _UARTCMD_huart;
+static uint8_t _UARTCMD_rxBuffer[UARTCMD_RX_BUFFER_SIZE];
+static uint8_t _UARTCMD_scratch[UARTCMD_MAX_ENCODED]; //frames wrapping around the end of the DMA buffer
+//Positions are byte counts since reception started, the buffer index is the count & UARTCMD_RX_MASK
+static volatile uint32_t _UARTCMD_received; //bytes written by DMA, updated by the RX event callback
+static uint32_t _UARTCMD_tail;              //first byte of the frame being received
+static uint32_t _UARTCMD_scan;              //next byte to check for a delimiter
+static uint8_t _UARTCMD_discard;            //frame is lost or grew past UARTCMD_MAX_ENCODED, skip to the next delimiter
+static volatile uint8_t _UARTCMD_pending;
+static volatile uint32_t _UARTCMD_errors;
+static uint32_t _UARTCMD_overruns;
+
+static const ISD1820_StepTypeDef _UARTCMD_playComplete[] = {
+	{ISD1820_OP_PLAY_COMPLETE, UARTCMD_PLAY_COMPLETE_TIME}
+};
+
+//Decodes {len} COBS bytes (without the delimiter) in place. Returns the decoded length, 0 if malformed.
+static uint16_t _UARTCMD_CobsDecode(uint8_t* frame, uint16_t len){
+	uint16_t read = 0, write = 0;
+	uint8_t code, i;
+	while(read < len){
+		code = frame[read++];
+		if(code == 0 || read + code - 1U > len) return 0;
+		for(i = 1; i < code; i++){
+			frame[write++] = frame[read++];
+		}
+		if(code != 0xFF && read < len) frame[write++] = 0;
+	}
+	return write;
+}
+
+static void _UARTCMD_ReplyStatus(uint8_t cmd, HAL_StatusTypeDef result, uint32_t status){
+	UARTCMD_ReplyTypeDef reply;
+	reply.cmd = cmd | UARTCMD_REPLY;
+	reply.result = (uint8_t)result;
+	reply.status = status;
+	reply.crc = CRC32_Compute(&reply, UARTCMD_REPLY_SIZE - UARTCMD_CRC_SIZE);
+	TELEM_Write((const uint8_t*)&reply, UARTCMD_REPLY_SIZE); //dropped with the telemetry if the line is saturated: the host polls with STATUS
+}
+
+static void _UARTCMD_Reply(uint8_t cmd, HAL_StatusTypeDef result){
+	_UARTCMD_ReplyStatus(cmd, result, ISD1820_GetStatus());
+}
+
+static HAL_StatusTypeDef _UARTCMD_FlashRec(uint8_t op, uint8_t format){
+	switch(op){
+		case UARTCMD_FLASHREC_STOP:
+			RECORDER_Stop();
+			return HAL_OK;
+		case UARTCMD_FLASHREC_START:
+			return RECORDER_Start((CODEC_FormatTypeDef)format);
+		case UARTCMD_FLASHREC_ERASE:
+			return RECORDER_Erase();
+		case UARTCMD_FLASHREC_PLAY:
+			return RECORDER_Play(PLAYBACK_ROUTE_DAC);
+		default:
+			return HAL_ERROR;
+	}
+}
+
+static HAL_StatusTypeDef _UARTCMD_Offload(uint8_t op, uint16_t id){
+	switch(op){
+		case UARTCMD_OFFLOAD_CANCEL:
+			OFFLOAD_Cancel();
+			return HAL_OK;
+		case UARTCMD_OFFLOAD_RECORDING:
+			return OFFLOAD_Start(OFFLOAD_SOURCE_RECORDING, id);
+		case UARTCMD_OFFLOAD_CLIP:
+			return OFFLOAD_Start(OFFLOAD_SOURCE_CLIP, id);
+		default:
+			return HAL_ERROR;
+	}
+}
+
+static void _UARTCMD_Execute(const uint8_t* frame, uint16_t len){
+	const UARTCMD_DurationTypeDef* duration = (const UARTCMD_DurationTypeDef*)frame;
+	const UARTCMD_EnableTypeDef* enable = (const UARTCMD_EnableTypeDef*)frame;
+	const UARTCMD_MetricsTypeDef* metrics = (const UARTCMD_MetricsTypeDef*)frame;
+	const UARTCMD_ClipTypeDef* clip = (const UARTCMD_ClipTypeDef*)frame;
+	const UARTCMD_FlashRecTypeDef* flashRec = (const UARTCMD_FlashRecTypeDef*)frame;
+	const UARTCMD_MixTypeDef* mix = (const UARTCMD_MixTypeDef*)frame;
+	const UARTCMD_SpeedTypeDef* speed = (const UARTCMD_SpeedTypeDef*)frame;
+	const UARTCMD_StreamStartTypeDef* streamStart = (const UARTCMD_StreamStartTypeDef*)frame;
+	const UARTCMD_StreamDataTypeDef* streamData = (const UARTCMD_StreamDataTypeDef*)frame;
+	const UARTCMD_OffloadTypeDef* offload = (const UARTCMD_OffloadTypeDef*)frame;
+	const UARTCMD_OffloadAckTypeDef* offloadAck = (const UARTCMD_OffloadAckTypeDef*)frame;
+	HAL_StatusTypeDef result = HAL_OK;
+	switch(frame[0]){
+		case UARTCMD_RECORD:
+			if(len != sizeof(UARTCMD_DurationTypeDef)) break;
+			METRICS_Mark();
+			result = ISD1820_RecordAsync(ISD1820_AsyncMsToCounts(duration->duration));
+			_UARTCMD_Reply(frame[0], result);
+			return;
+		case UARTCMD_PLAY:
+			if(len != sizeof(UARTCMD_DurationTypeDef)) break;
+			METRICS_Mark();
+			result = ISD1820_PlayAsync(ISD1820_AsyncMsToCounts(duration->duration));
+			_UARTCMD_Reply(frame[0], result);
+			return;
+		case UARTCMD_PLAY_COMPLETE:
+			if(len != 1U) break;
+			METRICS_Mark();
+			result = ISD1820_SequenceStart(_UARTCMD_playComplete, 1);
+			_UARTCMD_Reply(frame[0], result);
+			return;
+		case UARTCMD_CANCEL:
+			if(len != 1U) break;
+			ISD1820_Cancel();
+			_UARTCMD_Reply(frame[0], result);
+			return;
+		case UARTCMD_FEEDTHROUGH:
+			if(len != sizeof(UARTCMD_EnableTypeDef)) break;
+			if(enable->enable){
+				ISD1820_EnableFeedThrough();
+			}else{
+				ISD1820_DisableFeedThrough();
+			}
+			_UARTCMD_Reply(frame[0], result);
+			return;
+		case UARTCMD_STATUS:
+			if(len != 1U) break;
+			_UARTCMD_Reply(frame[0], result);
+			return;
+		case UARTCMD_METRICS:
+			if(len != sizeof(UARTCMD_MetricsTypeDef)) break;
+			result = METRICS_Dump((METRICS_HistogramTypeDef)metrics->histogram, metrics->reset);
+			_UARTCMD_Reply(frame[0], result);
+			return;
+		case UARTCMD_CAPTURE:
+			if(len != sizeof(UARTCMD_EnableTypeDef)) break;
+			result = RECORDER_Listen(enable->enable);
+			_UARTCMD_Reply(frame[0], result);
+			return;
+		case UARTCMD_CLIP:
+			if(len != sizeof(UARTCMD_ClipTypeDef)) break;
+			result = CLIPS_Play(clip->id, clip->route ? PLAYBACK_ROUTE_FEEDTHROUGH : PLAYBACK_ROUTE_DAC);
+			_UARTCMD_Reply(frame[0], result);
+			return;
+		case UARTCMD_FLASHREC:
+			if(len != sizeof(UARTCMD_FlashRecTypeDef)) break;
+			result = _UARTCMD_FlashRec(flashRec->op, flashRec->format);
+			_UARTCMD_Reply(frame[0], result);
+			return;
+		case UARTCMD_VAD:
+			if(len != sizeof(UARTCMD_DurationTypeDef)) break;
+			VAD_SetHangover(duration->duration);
+			_UARTCMD_Reply(frame[0], result);
+			return;
+		case UARTCMD_MIX:
+			if(len != sizeof(UARTCMD_MixTypeDef)) break;
+			result = CLIPS_Mix(mix->id, mix->stream, mix->gain, mix->route ? PLAYBACK_ROUTE_FEEDTHROUGH : PLAYBACK_ROUTE_DAC);
+			_UARTCMD_Reply(frame[0], result);
+			return;
+		case UARTCMD_SPEED:
+			if(len != sizeof(UARTCMD_SpeedTypeDef)) break;
+			result = PLAYBACK_SetSpeed(speed->speed);
+			_UARTCMD_Reply(frame[0], result);
+			return;
+		case UARTCMD_DTMF:
+			if(len != sizeof(UARTCMD_EnableTypeDef)) break;
+			result = RECORDER_ListenTones(enable->enable);
+			_UARTCMD_Reply(frame[0], result);
+			return;
+		case UARTCMD_STREAM_START:
+			if(len != sizeof(UARTCMD_StreamStartTypeDef)) break;
+			result = streamStart->route > PLAYBACK_ROUTE_RECORD ? HAL_ERROR :
+					STREAM_Start((CODEC_FormatTypeDef)streamStart->format, (PLAYBACK_RouteTypeDef)streamStart->route, (STREAM_ModeTypeDef)streamStart->mode);
+			_UARTCMD_Reply(frame[0], result);
+			return;
+		case UARTCMD_STREAM_DATA:
+			if(len <= sizeof(UARTCMD_StreamDataTypeDef)) break;
+			result = STREAM_Write(streamData->seq, streamData->data, len - sizeof(UARTCMD_StreamDataTypeDef));
+			_UARTCMD_ReplyStatus(frame[0], result, STREAM_GetAck());
+			return;
+		case UARTCMD_STREAM_END:
+			if(len != sizeof(UARTCMD_EnableTypeDef)) break;
+			result = STREAM_End(enable->enable);
+			_UARTCMD_Reply(frame[0], result);
+			return;
+		case UARTCMD_OFFLOAD:
+			if(len != sizeof(UARTCMD_OffloadTypeDef)) break;
+			result = _UARTCMD_Offload(offload->op, offload->id);
+			_UARTCMD_ReplyStatus(frame[0], result, OFFLOAD_GetAck());
+			return;
+		case UARTCMD_OFFLOAD_ACK:
+			if(len != sizeof(UARTCMD_OffloadAckTypeDef)) break;
+			result = OFFLOAD_Ack(offloadAck->seq, offloadAck->resend);
+			_UARTCMD_ReplyStatus(frame[0], result, OFFLOAD_GetAck());
+			return;
+		default:
+			break;
+	}
+	LOG("uart_cmd: bad command %02x, %u bytes", frame[0], len);
+	_UARTCMD_errors++; //unknown command or wrong payload size
+}
+
+//Handles the encoded frame in [start, end) of the DMA buffer.
+static void _UARTCMD_Frame(uint16_t start, uint16_t end){
+	uint16_t len = (end - start) & UARTCMD_RX_MASK, first;
+	uint32_t crc, expected;
+	uint8_t* frame;
+	if(_UARTCMD_discard){
+		_UARTCMD_discard = 0;
+		_UARTCMD_errors++;
+		return;
+	}
+	if(len == 0) return; //back to back delimiters
+	if(start + len <= UARTCMD_RX_BUFFER_SIZE){
+		frame = &_UARTCMD_rxBuffer[start]; //already received: DMA will not write here until it wraps
+	}else{
+		first = UARTCMD_RX_BUFFER_SIZE - start;
+		memcpy(_UARTCMD_scratch, &_UARTCMD_rxBuffer[start], first);
+		memcpy(&_UARTCMD_scratch[first], _UARTCMD_rxBuffer, len - first);
+		frame = _UARTCMD_scratch;
+	}
+	len = _UARTCMD_CobsDecode(frame, len);
+	if(len <= UARTCMD_CRC_SIZE){
+		_UARTCMD_errors++;
+		return;
+	}
+	len -= UARTCMD_CRC_SIZE;
+	memcpy(&crc, &frame[len], UARTCMD_CRC_SIZE);
+	expected = CRC32_Compute(frame, len);
+	if(expected != crc){
+		LOG("uart_cmd: bad crc %08lx, expected %08lx", crc, expected);
+		_UARTCMD_errors++;
+		return;
+	}
+	_UARTCMD_Execute(frame, len);
+}
+
+static void _UARTCMD_Process(uint32_t arg){
+	uint32_t received;
+	uint16_t scan;
+	UNUSED(arg);
+	_UARTCMD_pending = 0;
+	received = _UARTCMD_received;
+	while(_UARTCMD_scan != received){
+		if(_UARTCMD_received - _UARTCMD_tail > UARTCMD_RX_BUFFER_SIZE){
+			//DMA lapped the parser and wrote over the frame being received: drop it and
+			//resume at the next delimiter after what has arrived
+			LOG("uart_cmd: rx overrun, %lu bytes behind", _UARTCMD_received - _UARTCMD_scan);
+			_UARTCMD_overruns++;
+			received = _UARTCMD_received;
+			if(_UARTCMD_rxBuffer[(received - 1U) & UARTCMD_RX_MASK] == 0){
+				_UARTCMD_discard = 0; //what arrived ends with a delimiter: the next frame is whole
+				_UARTCMD_errors++;
+			}else{
+				_UARTCMD_discard = 1;
+			}
+			_UARTCMD_tail = received;
+			_UARTCMD_scan = received;
+			break;
+		}
+		scan = _UARTCMD_scan & UARTCMD_RX_MASK;
+		if(_UARTCMD_rxBuffer[scan] == 0){
+			_UARTCMD_Frame(_UARTCMD_tail & UARTCMD_RX_MASK, scan);
+			_UARTCMD_tail = _UARTCMD_scan + 1U;
+		}else if(_UARTCMD_scan - _UARTCMD_tail >= UARTCMD_MAX_ENCODED){
+			_UARTCMD_discard = 1;
+			_UARTCMD_tail = _UARTCMD_scan; //keep the oversized frame from growing past the buffer
+		}
+		_UARTCMD_scan++;
+	}
+}
+
+static void _UARTCMD_Start(uint32_t arg){
+	UNUSED(arg);
+	_UARTCMD_received = 0;
+	_UARTCMD_tail = 0;
+	_UARTCMD_scan = 0;
+	_UARTCMD_discard = 0;
+	if(HAL_UARTEx_ReceiveToIdle_DMA(_UARTCMD_huart, _UARTCMD_rxBuffer, UARTCMD_RX_BUFFER_SIZE) != HAL_OK){
+		_UARTCMD_errors++;
+	}
+}
+
+void UARTCMD_Init(UART_HandleTypeDef* huart){
+	_UARTCMD_huart = huart;
+	_UARTCMD_pending = 0;
+	_UARTCMD_errors = 0;
+	_UARTCMD_overruns = 0;
+	__HAL_RCC_CRC_CLK_ENABLE();
+	_UARTCMD_Start(0);
+}
+
+void UARTCMD_RxEventCallback(UART_HandleTypeDef* huart, uint16_t pos){
+	if(huart != _UARTCMD_huart) return;
+	//Events come at least every half buffer (half and full transfer), so the distance
+	//from the last position is the byte count. pos is the buffer size on a full transfer event.
+	_UARTCMD_received += (pos - _UARTCMD_received) & UARTCMD_RX_MASK;
+	if(_UARTCMD_pending) return;
+	if(SCHED_Post(SCHED_PRIO_NORMAL, _UARTCMD_Process, 0) == HAL_OK) _UARTCMD_pending = 1;
+}
+
+void UARTCMD_ErrorCallback(UART_HandleTypeDef* huart){
+	if(huart != _UARTCMD_huart) return;
+	_UARTCMD_errors++;
+	if(huart->RxState != HAL_UART_STATE_READY) return; //the HAL kept the DMA running
+	SCHED_Post(SCHED_PRIO_NORMAL, _UARTCMD_Start, 0); //indexes are reset from the scheduler, not under _UARTCMD_Process()
+}
+
+uint32_t UARTCMD_GetErrors(void){
+	return _UARTCMD_errors;
+}
+
+uint32_t UARTCMD_GetOverruns(void){
+	return _UARTCMD_overruns;
+}
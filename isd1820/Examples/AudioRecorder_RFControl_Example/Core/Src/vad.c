@@ -0,0 +1,118 @@
+/**
+ * vad.c
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+Voice activity detector
+----------------------------------------------------------------------
+ */
+#include "vad.h"
+#include "metrics.h"
+
+#define VAD_FLOOR_RISE_SHIFT  6U  //the noise floor rises by 1/64 of the gap per block
+#define VAD_FLOOR_TRACK_SHIFT 10U //and by 1/1024 during speech
+#define VAD_ZCR_MAX(count)   (((count) * 3U) / 8U)
+
+static uint32_t _VAD_sampleRate;
+static uint32_t _VAD_hangoverSamples;
+static uint32_t _VAD_noise;     //noise floor, mean square; 0 until the first block
+static uint32_t _VAD_onset;     //speech blocks in a row
+static uint32_t _VAD_remaining; //hangover samples left
+static uint8_t _VAD_active;
+
+//Mean square of {count} samples, up to 2^30.
+static uint32_t _VAD_Energy(const int16_t* block, uint32_t count){
+	const uint32_t* pairs = (const uint32_t*)block;
+	uint64_t sum = 0;
+	uint32_t i;
+	for(i = 0; i < count / 2U; i++){
+		sum = __SMLALD(pairs[i], pairs[i], sum);
+	}
+	return (uint32_t)(sum / count);
+}
+
+static uint32_t _VAD_ZeroCrossings(const int16_t* block, uint32_t count){
+	uint32_t crossings = 0, i;
+	for(i = 1; i < count; i++){
+		crossings += ((uint32_t)(block[i - 1U] ^ block[i])) >> 31; //sign change
+	}
+	return crossings;
+}
+
+void VAD_Init(uint32_t sampleRate){
+	_VAD_sampleRate = sampleRate;
+	VAD_SetHangover(VAD_HANGOVER_DEFAULT);
+	VAD_Reset();
+}
+
+void VAD_Reset(void){
+	_VAD_noise = 0;
+	_VAD_onset = 0;
+	_VAD_remaining = 0;
+	_VAD_active = 0;
+}
+
+void VAD_SetHangover(uint32_t ms){
+	_VAD_hangoverSamples = (uint32_t)(((uint64_t)ms * _VAD_sampleRate) / 1000U);
+}
+
+VAD_ResultTypeDef VAD_Process(const int16_t* block, uint32_t count){
+	uint32_t start = DWT->CYCCNT, energy, noise;
+	uint8_t speech;
+	if(count < 2U) return _VAD_active ? VAD_HANGOVER : VAD_SILENCE;
+	energy = _VAD_Energy(block, count);
+	noise = _VAD_noise ? _VAD_noise : energy;
+	speech = (energy >> 2) > noise && energy > VAD_MIN_ENERGY &&
+			((energy >> 4) > noise || _VAD_ZeroCrossings(block, count) < VAD_ZCR_MAX(count));
+	if(energy < noise){
+		noise = energy;
+	}else{
+		noise += ((energy - noise) >> (speech ? VAD_FLOOR_TRACK_SHIFT : VAD_FLOOR_RISE_SHIFT)) + 1U;
+	}
+	_VAD_noise = noise ? noise : 1U;
+	if(speech){
+		_VAD_onset++;
+		if(_VAD_active || _VAD_onset >= VAD_ONSET_BLOCKS) _VAD_remaining = _VAD_hangoverSamples;
+		if(!_VAD_active && _VAD_onset >= VAD_ONSET_BLOCKS){
+			_VAD_active = 1;
+			VAD_ChangeCallback(1);
+		}
+	}else{
+		_VAD_onset = 0;
+		if(_VAD_active){
+			if(_VAD_remaining > count){
+				_VAD_remaining -= count;
+			}else{
+				_VAD_remaining = 0;
+				_VAD_active = 0;
+				VAD_ChangeCallback(0);
+			}
+		}
+	}
+	METRICS_Record(METRICS_VAD_BLOCK, DWT->CYCCNT - start);
+	if(speech && _VAD_active) return VAD_SPEECH;
+	return _VAD_active ? VAD_HANGOVER : VAD_SILENCE;
+}
+
+uint8_t VAD_IsActive(void){
+	return _VAD_active;
+}
+
+__weak void VAD_ChangeCallback(uint8_t active){
+	UNUSED(active);
+	/* NOTE : This function should not be modified, when the callback is needed,
+	          the VAD_ChangeCallback could be implemented in the user file
+	 */
+}
@@ -0,0 +1,159 @@
+/**
+ * wsola.c
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+WSOLA time-scale modification
+----------------------------------------------------------------------
+ */
+#include "wsola.h"
+#include "metrics.h"
+#include <string.h>
+
+#define WSOLA_WINDOW (2U * (WSOLA_SEEK + WSOLA_HOP)) //input needed around a nominal position
+
+#if WSOLA_HOP != 160U
+#error "The fade table is for 160 samples"
+#endif
+#if WSOLA_BUFFER_SIZE < WSOLA_WINDOW + WSOLA_HOP
+#error "WSOLA_BUFFER_SIZE is too small for the search and a 2.0x step"
+#endif
+
+//sin^2(pi * (k + 0.5) / 320), Q15: the new segment fades in as the old one fades out, the gains sum to 1.
+static const int16_t _WSOLA_fade[WSOLA_HOP] = {
+	1, 7, 20, 39, 64, 95, 133, 177, 228, 284, 347, 416, 491, 572, 660, 753,
+	852, 958, 1069, 1186, 1309, 1438, 1573, 1713, 1859, 2011, 2168, 2331, 2499, 2672, 2851, 3035,
+	3224, 3418, 3618, 3822, 4031, 4244, 4463, 4686, 4913, 5145, 5381, 5622, 5866, 6115, 6368, 6624,
+	6884, 7148, 7416, 7687, 7961, 8238, 8519, 8803, 9089, 9379, 9671, 9966, 10263, 10563, 10864, 11168,
+	11474, 11782, 12092, 12403, 12716, 13030, 13346, 13662, 13980, 14299, 14618, 14938, 15259, 15580, 15902, 16223,
+	16545, 16866, 17188, 17509, 17830, 18150, 18469, 18788, 19106, 19422, 19738, 20052, 20365, 20676, 20986, 21294,
+	21600, 21904, 22205, 22505, 22802, 23097, 23389, 23679, 23965, 24249, 24530, 24807, 25081, 25352, 25620, 25884,
+	26144, 26400, 26653, 26902, 27146, 27387, 27623, 27855, 28082, 28305, 28524, 28737, 28946, 29150, 29350, 29544,
+	29733, 29917, 30096, 30269, 30437, 30600, 30757, 30909, 31055, 31195, 31330, 31459, 31582, 31699, 31810, 31916,
+	32015, 32108, 32196, 32277, 32352, 32421, 32484, 32540, 32591, 32635, 32673, 32704, 32729, 32748, 32761, 32767
+};
+
+//Cross-correlation of WSOLA_HOP samples of {x}, any alignment, with the tail.
+static int64_t _WSOLA_Correlate(const int16_t* x, const int16_t* tail){
+	const uint32_t* pairs = (const uint32_t*)tail;
+	uint64_t acc = 0;
+	uint32_t i;
+	for(i = 0; i < WSOLA_HOP / 2U; i++){
+		acc = __SMLALD(__UNALIGNED_UINT32_READ(&x[2U * i]), pairs[i], acc);
+	}
+	return (int64_t)acc;
+}
+
+//Returns the segment start within +/-WSOLA_SEEK of {nominal} that best continues the tail.
+static uint32_t _WSOLA_Search(const WSOLA_StateTypeDef* state, uint32_t nominal){
+	uint32_t first = nominal - WSOLA_SEEK, last = nominal + WSOLA_SEEK, best = first, start;
+	int64_t bestCorr = _WSOLA_Correlate(&state->buffer[first], state->tail), corr;
+	for(start = first + 2U; start <= last; start += 2U){ //every other lag
+		corr = _WSOLA_Correlate(&state->buffer[start], state->tail);
+		if(corr > bestCorr){
+			bestCorr = corr;
+			best = start;
+		}
+	}
+	start = best;
+	if(start > first && _WSOLA_Correlate(&state->buffer[start - 1U], state->tail) > bestCorr) best = start - 1U;
+	if(start < last && _WSOLA_Correlate(&state->buffer[start + 1U], state->tail) > bestCorr) best = start + 1U; //the lags between
+	return best;
+}
+
+//Makes sure the window around the nominal position is in the buffer. Returns HAL_ERROR at the end of the stream.
+static HAL_StatusTypeDef _WSOLA_Refill(WSOLA_StateTypeDef* state){
+	uint32_t drop = (state->nominal >> 16) - WSOLA_SEEK, n;
+	while((state->nominal >> 16) + WSOLA_SEEK + 2U * WSOLA_HOP > state->filled){
+		if(state->ended) return HAL_ERROR;
+		if(drop > state->natural) drop = state->natural;
+		memmove(state->buffer, &state->buffer[drop], (state->filled - drop) * sizeof(int16_t));
+		state->filled -= drop;
+		state->nominal -= drop << 16;
+		state->natural -= drop;
+		drop = 0;
+		n = state->input(&state->buffer[state->filled], WSOLA_BUFFER_SIZE - state->filled);
+		if(n == 0){ //flushes the last samples: enough zeros for a segment to start on the last one
+			n = WSOLA_SEEK + 2U * WSOLA_HOP;
+			if(n > WSOLA_BUFFER_SIZE - state->filled) n = WSOLA_BUFFER_SIZE - state->filled;
+			memset(&state->buffer[state->filled], 0, n * sizeof(int16_t));
+			state->ended = 1;
+		}
+		state->filled += n;
+	}
+	return HAL_OK;
+}
+
+static HAL_StatusTypeDef _WSOLA_Hop(WSOLA_StateTypeDef* state){
+	uint32_t start = DWT->CYCCNT, speed = state->speed, best, i;
+	const int16_t* segment;
+	if(speed == WSOLA_SPEED_MIN) state->nominal = state->natural << 16; //no search: the output is the input
+	if(_WSOLA_Refill(state) != HAL_OK) return HAL_ERROR;
+	best = state->nominal >> 16;
+	segment = &state->buffer[best];
+	if(!state->primed){
+		memcpy(state->out, segment, sizeof(state->out)); //nothing to fade from
+		state->primed = 1;
+	}else{
+		if(speed != WSOLA_SPEED_MIN){
+			best = _WSOLA_Search(state, best);
+			segment = &state->buffer[best];
+		}
+		for(i = 0; i < WSOLA_HOP; i++){
+			state->out[i] = (int16_t)(state->tail[i] + (((segment[i] - state->tail[i]) * _WSOLA_fade[i]) >> 15));
+		}
+	}
+	memcpy(state->tail, &segment[WSOLA_HOP], sizeof(state->tail));
+	state->natural = best + WSOLA_HOP;
+	state->nominal += speed * WSOLA_HOP;
+	METRICS_Record(METRICS_WSOLA_HOP, DWT->CYCCNT - start);
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef WSOLA_Init(WSOLA_StateTypeDef* state, WSOLA_InputTypeDef input, uint32_t speed){
+	if(speed < WSOLA_SPEED_MIN || speed > WSOLA_SPEED_MAX) return HAL_ERROR;
+	state->input = input;
+	state->speed = speed;
+	state->filled = WSOLA_SEEK; //zeros before the first sample, for the search
+	state->nominal = WSOLA_SEEK << 16;
+	state->natural = WSOLA_SEEK;
+	state->outPos = WSOLA_HOP;
+	state->primed = 0;
+	state->ended = 0;
+	memset(state->buffer, 0, WSOLA_SEEK * sizeof(int16_t));
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef WSOLA_SetSpeed(WSOLA_StateTypeDef* state, uint32_t speed){
+	if(speed < WSOLA_SPEED_MIN || speed > WSOLA_SPEED_MAX) return HAL_ERROR;
+	state->speed = speed;
+	return HAL_OK;
+}
+
+uint32_t WSOLA_Read(WSOLA_StateTypeDef* state, int16_t* out, uint32_t count){
+	uint32_t produced = 0, n;
+	while(produced < count){
+		if(state->outPos == WSOLA_HOP){
+			if(_WSOLA_Hop(state) != HAL_OK) break;
+			state->outPos = 0;
+		}
+		n = count - produced;
+		if(n > WSOLA_HOP - state->outPos) n = WSOLA_HOP - state->outPos;
+		memcpy(&out[produced], &state->out[state->outPos], n * sizeof(int16_t));
+		state->outPos += n;
+		produced += n;
+	}
+	return produced;
+}
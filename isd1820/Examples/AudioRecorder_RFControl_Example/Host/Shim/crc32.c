@@ -0,0 +1,51 @@
+/**
+ * crc32.c
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+Software CRC-32 of the host build
+----------------------------------------------------------------------
+Stands in for Core/Src/crc32.c: same result as the CRC unit, computed
+a word at a time, MSB first, the tail zero padded.
+----------------------------------------------------------------------
+ */
+#include "crc32.h"
+#include <string.h>
+
+static uint32_t _CRC32_Word(uint32_t crc, uint32_t word){
+	uint32_t i;
+	crc ^= word;
+	for(i = 0; i < 32U; i++){
+		crc = (crc & 0x80000000UL) ? (crc << 1) ^ 0x04C11DB7UL : crc << 1;
+	}
+	return crc;
+}
+
+uint32_t CRC32_Compute(const void* data, uint32_t len){
+	const uint8_t* bytes = (const uint8_t*)data;
+	uint32_t crc = 0xFFFFFFFFUL, word;
+	while(len >= 4U){
+		memcpy(&word, bytes, 4U);
+		crc = _CRC32_Word(crc, word);
+		bytes += 4U;
+		len -= 4U;
+	}
+	if(len){
+		word = 0;
+		memcpy(&word, bytes, len);
+		crc = _CRC32_Word(crc, word);
+	}
+	return crc;
+}
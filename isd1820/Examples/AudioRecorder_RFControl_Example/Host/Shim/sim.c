@@ -0,0 +1,527 @@
+/**
+ * sim.c
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+Host simulation of the HAL
+----------------------------------------------------------------------
+ */
+#include "sim.h"
+#include "trace.h"
+#include "trace_json.h"
+#include "elf_file.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define SIM_STACK_SIZE 4096U //fake stack of the telemetry watermark [bytes]
+#define SIM_STACK_MIN  2048U //_Min_Stack_Size
+#define SIM_NAMES      64U   //handler names kept, by address
+
+/* Linker script symbols, addresses under 4GB (-no-pie) */
+__asm__(
+	".data\n"
+	".balign 4\n"
+	".globl _sclips\n_sclips:\n.fill 0x8000, 4, 0xFFFFFFFF\n"
+	".globl _eclips\n_eclips:\n"
+	".globl _srecord\n_srecord:\n.fill 0x10000, 4, 0xFFFFFFFF\n"
+	".globl _erecord\n_erecord:\n"
+	".bss\n"
+	".balign 8\n"
+	"SIM_stack:\n.space 4096\n"
+	".globl _estack\n_estack:\n"
+	".globl _end\n_end:\n.space 8\n"
+	".globl _Min_Stack_Size\n.set _Min_Stack_Size, 2048\n"
+	".text\n"
+);
+extern uint8_t _end;
+extern uint8_t _estack;
+
+volatile uint32_t SIM_primask;
+uint32_t SIM_ge;
+__IO uint32_t uwTick;
+uint32_t SystemCoreClock = SIM_CPU_HZ;
+uint32_t SIM_tickStep;
+SIM_TickHookTypeDef SIM_tickHook;
+SIM_GpioHookTypeDef SIM_gpioHook;
+SIM_UartTxHookTypeDef SIM_uartTxHook;
+HAL_StatusTypeDef SIM_timStartResult;
+HAL_StatusTypeDef SIM_dmaStartResult;
+
+GPIO_TypeDef SIM_GPIO[3];
+TIM_TypeDef SIM_TIM[15];
+DMA_Stream_TypeDef SIM_DMA2_Stream0;
+USART_TypeDef SIM_USART2;
+ADC_TypeDef SIM_ADC1;
+ADC_Common_TypeDef SIM_ADC;
+DAC_TypeDef SIM_DAC1;
+FLASH_TypeDef SIM_FLASH;
+CRC_TypeDef SIM_CRC;
+RCC_TypeDef SIM_RCC;
+ITM_TypeDef SIM_ITM;
+TPI_TypeDef SIM_TPI;
+CoreDebug_Type SIM_CoreDebug;
+DBGMCU_TypeDef SIM_DBGMCU;
+
+static DWT_TypeDef _SIM_dwt;
+static uint8_t _SIM_timIT[15];           //started with interrupts
+static uint8_t _SIM_dmaM1[8];            //double buffer target, by stream
+static DMA_Stream_TypeDef _SIM_streams[8];
+static DMA_HandleTypeDef _SIM_uartDma[2];
+static uint32_t _SIM_eraseSector, _SIM_eraseLeft;
+static TRACEJSON_StateTypeDef _SIM_trace;
+static FILE* _SIM_traceFile;
+static uint8_t _SIM_traceChecked;
+static uint64_t _SIM_traceStart;
+static struct {
+	uint64_t addr;
+	const char* name;
+} _SIM_names[SIM_NAMES];
+
+static void _SIM_TraceEnd(void){
+	TRACEJSON_End(&_SIM_trace);
+	fclose(_SIM_traceFile);
+	_SIM_traceFile = NULL;
+}
+
+//ELF_Symbol() walks the whole symbol table: the few handlers a run posts are looked up once.
+static const char* _SIM_TraceName(uint64_t addr){
+	uint32_t slot = (uint32_t)(addr >> 4) % SIM_NAMES;
+	if(_SIM_names[slot].addr != addr){
+		_SIM_names[slot].addr = addr;
+		_SIM_names[slot].name = ELF_Symbol(addr);
+	}
+	return _SIM_names[slot].name;
+}
+
+//Opens the trace on first use, if SIM_TRACE names a file. Returns it with the time in CPU cycles, or NULL when not tracing.
+static TRACEJSON_StateTypeDef* _SIM_Tracing(uint64_t* cycles){
+	const char* path;
+	if(!_SIM_traceChecked){
+		_SIM_traceChecked = 1;
+		if((path = getenv("SIM_TRACE")) != NULL && (_SIM_traceFile = fopen(path, "w")) != NULL){
+			TRACEJSON_Begin(&_SIM_trace, _SIM_traceFile, ELF_Load("/proc/self/exe") ? _SIM_TraceName : NULL);
+			_SIM_traceStart = SIM_Nanoseconds();
+			atexit(_SIM_TraceEnd);
+		}
+	}
+	if(_SIM_traceFile == NULL) return NULL;
+	*cycles = (SIM_Nanoseconds() - _SIM_traceStart) * (SIM_CPU_HZ / 1000000UL) / 1000U;
+	return &_SIM_trace;
+}
+
+//Writes the edges of {port} since its output was {before}.
+static void _SIM_TraceGpio(GPIO_TypeDef* port, uint32_t before){
+	TRACEJSON_StateTypeDef* trace;
+	uint32_t changed = (before ^ port->ODR) & 0xFFFFU, pin;
+	uint64_t cycles;
+	char name[8];
+	if(changed == 0 || (trace = _SIM_Tracing(&cycles)) == NULL) return;
+	for(pin = 0; changed; pin++, changed >>= 1){
+		if(!(changed & 1U)) continue;
+		snprintf(name, sizeof(name), "P%c%u", 'A' + (int)(port - SIM_GPIO), pin);
+		TRACEJSON_Counter(trace, cycles, name, (port->ODR >> pin) & 1U);
+	}
+}
+
+static void _SIM_TraceTim(TIM_TypeDef* tim, uint8_t running){
+	TRACEJSON_StateTypeDef* trace;
+	uint64_t cycles;
+	char name[8];
+	if((trace = _SIM_Tracing(&cycles)) == NULL) return;
+	snprintf(name, sizeof(name), "TIM%u", (uint32_t)(tim - SIM_TIM));
+	TRACEJSON_Span(trace, cycles, name, running);
+}
+
+void SIM_Trace(uint32_t port, uint32_t value){
+	TRACEJSON_StateTypeDef* trace;
+	uint64_t cycles;
+	SIM_ITM.PORT[port].u32 = value;
+	if((trace = _SIM_Tracing(&cycles)) != NULL) TRACEJSON_Packet(trace, cycles, (uint8_t)port, value);
+}
+
+void SIM_Reset(void){
+	uint32_t before, i;
+	for(i = 0; i < sizeof(SIM_GPIO) / sizeof(SIM_GPIO[0]); i++){
+		before = SIM_GPIO[i].ODR;
+		SIM_GPIO[i].ODR = 0;
+		_SIM_TraceGpio(&SIM_GPIO[i], before);
+	}
+	for(i = 0; i < sizeof(SIM_TIM) / sizeof(SIM_TIM[0]); i++){
+		if(SIM_TIM[i].CR1 & TIM_CR1_CEN) _SIM_TraceTim(&SIM_TIM[i], 0);
+	}
+	memset(SIM_GPIO, 0, sizeof(SIM_GPIO));
+	memset(SIM_TIM, 0, sizeof(SIM_TIM));
+	memset(_SIM_timIT, 0, sizeof(_SIM_timIT));
+	memset(_SIM_dmaM1, 0, sizeof(_SIM_dmaM1));
+	memset(_SIM_streams, 0, sizeof(_SIM_streams));
+	memset(&SIM_DMA2_Stream0, 0, sizeof(SIM_DMA2_Stream0));
+	memset(&SIM_ADC1, 0, sizeof(SIM_ADC1));
+	memset(&SIM_DAC1, 0, sizeof(SIM_DAC1));
+	memset(&SIM_FLASH, 0, sizeof(SIM_FLASH));
+	memset(&SIM_ITM, 0, sizeof(SIM_ITM));
+	SIM_RCC.CFGR = RCC_CFGR_PPRE1_DIV2; //APB1 at 42MHz: its timers at 84MHz
+	SIM_primask = 0;
+	uwTick = 0;
+	SIM_tickStep = 0;
+	SIM_tickHook = NULL;
+	SIM_gpioHook = NULL;
+	SIM_uartTxHook = NULL;
+	SIM_timStartResult = HAL_OK;
+	SIM_dmaStartResult = HAL_OK;
+	_SIM_eraseLeft = 0;
+}
+
+uint64_t SIM_Nanoseconds(void){
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+DWT_TypeDef* SIM_Dwt(void){
+	_SIM_dwt.CYCCNT = (uint32_t)(SIM_Nanoseconds() * (SIM_CPU_HZ / 1000000UL) / 1000U);
+	return &_SIM_dwt;
+}
+
+uint32_t __get_MSP(void){
+	return (uint32_t)(uintptr_t)&_estack - SIM_STACK_SIZE / 4U; //a quarter of the fake stack in use
+}
+
+void* _sbrk(ptrdiff_t incr){
+	UNUSED(incr);
+	return &_end; //no heap
+}
+
+__weak void Error_Handler(void){
+	abort();
+}
+
+/* Core */
+uint32_t HAL_GetTick(void){
+	uint32_t tick = uwTick;
+	uwTick = tick + SIM_tickStep;
+	if(SIM_tickHook) SIM_tickHook(tick);
+	return tick;
+}
+
+void HAL_Delay(uint32_t delay){
+	uwTick += delay;
+}
+
+void HAL_NVIC_SetPriority(IRQn_Type irq, uint32_t preempt, uint32_t sub){
+	UNUSED(irq);
+	UNUSED(preempt);
+	UNUSED(sub);
+}
+
+void HAL_NVIC_EnableIRQ(IRQn_Type irq){
+	UNUSED(irq);
+}
+
+uint32_t HAL_RCC_GetHCLKFreq(void){
+	return SIM_CPU_HZ;
+}
+
+uint32_t HAL_RCC_GetPCLK1Freq(void){
+	return SIM_CPU_HZ / 2U;
+}
+
+uint32_t HAL_RCC_GetPCLK2Freq(void){
+	return SIM_CPU_HZ;
+}
+
+/* GPIO */
+void HAL_GPIO_Init(GPIO_TypeDef* port, GPIO_InitTypeDef* init){
+	UNUSED(port);
+	UNUSED(init);
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef* port, uint16_t pin, GPIO_PinState state){
+	uint32_t before = port->ODR;
+	if(state != GPIO_PIN_RESET){
+		port->ODR |= pin;
+	}else{
+		port->ODR &= ~(uint32_t)pin;
+	}
+	_SIM_TraceGpio(port, before);
+	if(SIM_gpioHook) SIM_gpioHook(port, pin, state);
+}
+
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef* port, uint16_t pin){
+	return ((port->ODR | port->IDR) & pin) ? GPIO_PIN_SET : GPIO_PIN_RESET;
+}
+
+/* TIM */
+static HAL_StatusTypeDef _SIM_TimStart(TIM_HandleTypeDef* htim, uint8_t it){
+	if(SIM_timStartResult != HAL_OK) return SIM_timStartResult;
+	if(htim->Instance->CR1 & TIM_CR1_CEN) return HAL_ERROR; //the HAL refuses a running timer
+	htim->Instance->CR1 |= TIM_CR1_CEN;
+	_SIM_timIT[htim->Instance - SIM_TIM] = it;
+	_SIM_TraceTim(htim->Instance, 1);
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_Start(TIM_HandleTypeDef* htim){
+	return _SIM_TimStart(htim, 0);
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_Start_IT(TIM_HandleTypeDef* htim){
+	return _SIM_TimStart(htim, 1);
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_Stop(TIM_HandleTypeDef* htim){
+	if(htim->Instance->CR1 & TIM_CR1_CEN) _SIM_TraceTim(htim->Instance, 0);
+	htim->Instance->CR1 &= ~TIM_CR1_CEN;
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_Stop_IT(TIM_HandleTypeDef* htim){
+	_SIM_timIT[htim->Instance - SIM_TIM] = 0;
+	return HAL_TIM_Base_Stop(htim);
+}
+
+void HAL_TIM_IRQHandler(TIM_HandleTypeDef* htim){
+	if(htim->Instance->SR & TIM_SR_UIF){
+		htim->Instance->SR = ~TIM_SR_UIF;
+		HAL_TIM_PeriodElapsedCallback(htim);
+	}
+}
+
+uint8_t SIM_TimRunning(TIM_HandleTypeDef* htim){
+	return (htim->Instance->CR1 & TIM_CR1_CEN) != 0;
+}
+
+uint32_t SIM_TimExpire(TIM_HandleTypeDef* htim){
+	if(!SIM_TimRunning(htim) || htim->Instance->ARR == 0) return 0; //ARR at 0 blocks the counter: no update event
+	htim->Instance->SR |= TIM_SR_UIF;
+	htim->Instance->CNT = 0;
+	if(!_SIM_timIT[htim->Instance - SIM_TIM]) return 0;
+	HAL_TIM_IRQHandler(htim);
+	return 1;
+}
+
+/* DMA */
+static uint32_t _SIM_Stream(DMA_HandleTypeDef* hdma){
+	return (hdma->Instance >= _SIM_streams && hdma->Instance < &_SIM_streams[8]) ? (uint32_t)(hdma->Instance - _SIM_streams) : 0;
+}
+
+//Interrupt of the stream of {hdma}: the ADC's, USART2's, or DMA1 Stream1, the DAC's, the one other stream of the example.
+static IRQn_Type _SIM_DmaIrq(DMA_HandleTypeDef* hdma){
+	if(hdma->Instance == DMA2_Stream0) return DMA2_Stream0_IRQn;
+	if(hdma == &_SIM_uartDma[0]) return DMA1_Stream6_IRQn;
+	if(hdma == &_SIM_uartDma[1]) return DMA1_Stream5_IRQn;
+	return DMA1_Stream1_IRQn;
+}
+
+HAL_StatusTypeDef HAL_DMA_Init(DMA_HandleTypeDef* hdma){
+	hdma->Instance->CR = hdma->Init.Mode;
+	hdma->State = HAL_DMA_STATE_READY;
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_DMA_Start_IT(DMA_HandleTypeDef* hdma, uint32_t src, uint32_t dst, uint32_t length){
+	if(SIM_dmaStartResult != HAL_OK) return SIM_dmaStartResult;
+	if(hdma->State != HAL_DMA_STATE_READY) return HAL_BUSY;
+	hdma->Instance->PAR = dst;
+	hdma->Instance->M0AR = src;
+	hdma->Instance->NDTR = length;
+	hdma->State = HAL_DMA_STATE_BUSY;
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_DMAEx_MultiBufferStart_IT(DMA_HandleTypeDef* hdma, uint32_t src, uint32_t dst, uint32_t second, uint32_t length){
+	if(SIM_dmaStartResult != HAL_OK) return SIM_dmaStartResult;
+	if(hdma->State != HAL_DMA_STATE_READY) return HAL_BUSY;
+	hdma->Instance->PAR = src;
+	hdma->Instance->M0AR = dst;
+	hdma->Instance->M1AR = second;
+	hdma->Instance->NDTR = length;
+	_SIM_dmaM1[_SIM_Stream(hdma)] = 0;
+	hdma->State = HAL_DMA_STATE_BUSY;
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_DMAEx_ChangeMemory(DMA_HandleTypeDef* hdma, uint32_t address, HAL_DMA_MemoryTypeDef memory){
+	if(memory == MEMORY0){
+		hdma->Instance->M0AR = address;
+	}else{
+		hdma->Instance->M1AR = address;
+	}
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_DMA_Abort(DMA_HandleTypeDef* hdma){
+	hdma->State = HAL_DMA_STATE_READY;
+	return HAL_OK;
+}
+
+uint32_t SIM_DmaComplete(DMA_HandleTypeDef* hdma, uint8_t half){
+	uint8_t* m1 = &_SIM_dmaM1[_SIM_Stream(hdma)];
+	void (*callback)(DMA_HandleTypeDef* hdma);
+	if(hdma->State != HAL_DMA_STATE_BUSY) return 0;
+	if(half){
+		callback = *m1 ? hdma->XferM1HalfCpltCallback : hdma->XferHalfCpltCallback;
+	}else if(hdma->XferM1CpltCallback){ //double buffer
+		callback = *m1 ? hdma->XferM1CpltCallback : hdma->XferCpltCallback;
+		*m1 ^= 1U;
+	}else{
+		callback = hdma->XferCpltCallback;
+		if(!(hdma->Instance->CR & DMA_SxCR_CIRC)) hdma->State = HAL_DMA_STATE_READY;
+	}
+	if(callback){
+		TRACE_ISR_ENTER(_SIM_DmaIrq(hdma));
+		callback(hdma);
+		TRACE_ISR_EXIT(_SIM_DmaIrq(hdma));
+	}
+	return callback != NULL;
+}
+
+uint32_t SIM_DmaError(DMA_HandleTypeDef* hdma){
+	if(hdma->State != HAL_DMA_STATE_BUSY) return 0;
+	hdma->State = HAL_DMA_STATE_READY; //the HAL disables the stream before the callback
+	if(hdma->XferErrorCallback == NULL) return 0;
+	TRACE_ISR_ENTER(_SIM_DmaIrq(hdma));
+	hdma->XferErrorCallback(hdma);
+	TRACE_ISR_EXIT(_SIM_DmaIrq(hdma));
+	return 1;
+}
+
+uint32_t SIM_DmaReceive(DMA_HandleTypeDef* hdma, const void* data, uint32_t size){
+	uint32_t target;
+	if(hdma->State != HAL_DMA_STATE_BUSY) return 0;
+	target = _SIM_dmaM1[_SIM_Stream(hdma)] ? hdma->Instance->M1AR : hdma->Instance->M0AR;
+	memcpy((void*)(uintptr_t)target, data, size);
+	return SIM_DmaComplete(hdma, 0);
+}
+
+/* UART */
+void SIM_UartInit(UART_HandleTypeDef* huart){
+	memset(huart, 0, sizeof(*huart));
+	memset(_SIM_uartDma, 0, sizeof(_SIM_uartDma));
+	huart->Instance = USART2;
+	huart->gState = HAL_UART_STATE_READY;
+	huart->RxState = HAL_UART_STATE_READY;
+	_SIM_uartDma[0].Instance = &_SIM_streams[6];
+	_SIM_uartDma[1].Instance = &_SIM_streams[5];
+	_SIM_uartDma[0].Parent = huart;
+	_SIM_uartDma[1].Parent = huart;
+	huart->hdmatx = &_SIM_uartDma[0];
+	huart->hdmarx = &_SIM_uartDma[1];
+}
+
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef* huart, const uint8_t* data, uint16_t size){
+	if(huart->gState != HAL_UART_STATE_READY) return HAL_BUSY;
+	if(data == NULL || size == 0) return HAL_ERROR;
+	huart->gState = HAL_UART_STATE_BUSY_TX;
+	if(SIM_uartTxHook) SIM_uartTxHook(huart, data, size);
+	return HAL_OK;
+}
+
+void SIM_UartTxComplete(UART_HandleTypeDef* huart){
+	if(huart->gState != HAL_UART_STATE_BUSY_TX) return;
+	huart->gState = HAL_UART_STATE_READY;
+	TRACE_ISR_ENTER(USART2_IRQn); //transmission complete
+	HAL_UART_TxCpltCallback(huart);
+	TRACE_ISR_EXIT(USART2_IRQn);
+}
+
+HAL_StatusTypeDef HAL_UARTEx_ReceiveToIdle_DMA(UART_HandleTypeDef* huart, uint8_t* data, uint16_t size){
+	if(huart->RxState != HAL_UART_STATE_READY) return HAL_BUSY;
+	huart->RxState = HAL_UART_STATE_BUSY_RX;
+	huart->pRxBuffPtr = data;
+	huart->RxXferSize = size;
+	huart->hdmarx->Instance->NDTR = size;
+	return HAL_OK;
+}
+
+void SIM_UartReceive(UART_HandleTypeDef* huart, const uint8_t* data, uint16_t len, uint8_t idle){
+	DMA_Stream_TypeDef* stream = huart->hdmarx->Instance;
+	uint16_t size = huart->RxXferSize, pos;
+	if(huart->RxState != HAL_UART_STATE_BUSY_RX) return; //bytes lost
+	while(len--){
+		pos = size - (uint16_t)stream->NDTR;
+		huart->pRxBuffPtr[pos++] = *data++;
+		stream->NDTR = (pos == size) ? size : (uint32_t)(size - pos); //circular: reloads
+		if(pos == size / 2U || pos == size){ //half and full transfer
+			TRACE_ISR_ENTER(DMA1_Stream5_IRQn);
+			HAL_UARTEx_RxEventCallback(huart, pos);
+			TRACE_ISR_EXIT(DMA1_Stream5_IRQn);
+		}
+	}
+	if(idle && stream->NDTR != size){
+		TRACE_ISR_ENTER(USART2_IRQn);
+		HAL_UARTEx_RxEventCallback(huart, size - (uint16_t)stream->NDTR);
+		TRACE_ISR_EXIT(USART2_IRQn);
+	}
+}
+
+/* FLASH */
+HAL_StatusTypeDef HAL_FLASH_Unlock(void){
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASH_Lock(void){
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASHEx_Erase_IT(FLASH_EraseInitTypeDef* erase){
+	if(_SIM_eraseLeft) return HAL_BUSY;
+	if(erase->Sector < FLASH_SECTOR_5 || erase->Sector + erase->NbSectors > FLASH_SECTOR_7 + 1U) return HAL_ERROR; //only CLIPS and RECORD are simulated
+	_SIM_eraseSector = erase->Sector;
+	_SIM_eraseLeft = erase->NbSectors;
+	SIM_FLASH.SR |= FLASH_SR_BSY;
+	return HAL_OK;
+}
+
+uint32_t SIM_FlashEraseStep(void){
+	uint8_t* sector;
+	if(!_SIM_eraseLeft) return 0;
+	sector = (_SIM_eraseSector == FLASH_SECTOR_5) ? _sclips : (uint8_t*)_srecord + (_SIM_eraseSector - FLASH_SECTOR_6) * SIM_SECTOR_SIZE;
+	memset(sector, 0xFF, SIM_SECTOR_SIZE);
+	if(--_SIM_eraseLeft){
+		HAL_FLASH_EndOfOperationCallback(_SIM_eraseSector++);
+	}else{
+		SIM_FLASH.SR &= ~FLASH_SR_BSY;
+		HAL_FLASH_EndOfOperationCallback(0xFFFFFFFFUL);
+	}
+	return _SIM_eraseLeft;
+}
+
+/* Callbacks the application may implement */
+__weak void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef* htim){
+	UNUSED(htim);
+}
+
+__weak void HAL_UART_TxCpltCallback(UART_HandleTypeDef* huart){
+	UNUSED(huart);
+}
+
+__weak void HAL_UART_ErrorCallback(UART_HandleTypeDef* huart){
+	UNUSED(huart);
+}
+
+__weak void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef* huart, uint16_t size){
+	UNUSED(huart);
+	UNUSED(size);
+}
+
+__weak void HAL_FLASH_EndOfOperationCallback(uint32_t value){
+	UNUSED(value);
+}
+
+__weak void HAL_FLASH_OperationErrorCallback(uint32_t value){
+	UNUSED(value);
+}
@@ -0,0 +1,150 @@
+/**
+ * sim.h
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+Host simulation controls
+----------------------------------------------------------------------
+What the tests use to drive the HAL stand-in (see stm32f4xx_hal.h):
+time, the interrupts the HAL calls lead to, and hooks on the outputs.
+Everything runs on the test thread: an "interrupt" is a SIM_ call made
+between two calls into the Core, never inside one.
+
+The tests link with -no-pie, so statics sit below 4GB and survive the
+(uint32_t) casts of addresses the Core does for DMA and the linker
+symbols. The linker symbols are defined here, with the sizes of
+STM32F446RETX_FLASH.ld: the CLIPS region (sector 5) and the RECORD
+region (sectors 6 and 7) start erased.
+
+With SIM_TRACE set to a file name in the environment, a run writes
+its trace there as Chrome trace-event JSON, an event at a time (see
+Tools/trace_json.h), ts on the host clock from the first event:
+	- every TRACE() of the Core, with the mapping of trace.h, and the
+	  handlers named from the symbols of the program itself;
+	- around the callbacks of SIM_DmaComplete(), SIM_DmaError(),
+	  SIM_UartReceive() and SIM_UartTxComplete(), TRACE_ISR_ENTER and
+	  EXIT of the interrupt they stand for: DMA2 Stream0 for the ADC
+	  stream, DMA1 Stream5 and 6 for USART2 RX and TX, DMA1 Stream1
+	  for any other (the DAC stream of the example), and USART2 for
+	  the idle line and the end of a transmission;
+	- a counter for every GPIO output edge, "PB5" for instance;
+	- a span from HAL_TIM_Base_Start(_IT)() to the stop of the timer,
+	  "TIM6" for instance, on a track of its own.
+SIM_Reset() ends the spans and takes the outputs to 0. The array is
+closed when the program exits.
+----------------------------------------------------------------------
+ */
+#ifndef SIM_H
+#define SIM_H
+
+/* C++ detection */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stm32f4xx_hal.h"
+
+#define SIM_CLIPS_SIZE  0x20000UL //bytes
+#define SIM_RECORD_SIZE 0x40000UL //bytes
+#define SIM_SECTOR_SIZE 0x20000UL //sectors 5 to 7 [bytes]
+
+typedef void (*SIM_GpioHookTypeDef)(GPIO_TypeDef* port, uint16_t pin, GPIO_PinState state);
+typedef void (*SIM_TickHookTypeDef)(uint32_t tick);
+typedef void (*SIM_UartTxHookTypeDef)(UART_HandleTypeDef* huart, const uint8_t* data, uint16_t size);
+
+extern uint32_t SIM_tickStep;                 //ms added by every HAL_GetTick() call, for busy-waits
+extern SIM_TickHookTypeDef SIM_tickHook;      //called on every HAL_GetTick(), as an interrupt during busy-waits
+extern SIM_GpioHookTypeDef SIM_gpioHook;      //called on every HAL_GPIO_WritePin()
+extern SIM_UartTxHookTypeDef SIM_uartTxHook;  //called on every accepted HAL_UART_Transmit_DMA()
+extern HAL_StatusTypeDef SIM_timStartResult;  //returned by HAL_TIM_Base_Start(_IT)()
+extern HAL_StatusTypeDef SIM_dmaStartResult;  //returned by HAL_DMA_Start_IT() and HAL_DMAEx_MultiBufferStart_IT()
+extern uint8_t _sclips[];
+extern uint32_t _srecord[];
+
+void SIM_Reset(void);
+/**
+ * @brief  Clears the peripherals, the hooks and the results, and sets uwTick to 0. Flash is left as it is.
+ * @retval None
+ */
+
+uint64_t SIM_Nanoseconds(void);
+/**
+ * @brief  Returns the host monotonic clock [ns].
+ */
+
+uint8_t SIM_TimRunning(TIM_HandleTypeDef* htim);
+/**
+ * @brief  Tells whether {htim} was started and not stopped since.
+ */
+
+uint32_t SIM_TimExpire(TIM_HandleTypeDef* htim);
+/**
+ * @brief  Raises the update event of {htim}: sets UIF and, if started with interrupts, calls HAL_TIM_PeriodElapsedCallback().
+ * @retval 1 if the interrupt ran, 0 if the timer is stopped, started without interrupts, or blocked by ARR at 0.
+ */
+
+void SIM_UartInit(UART_HandleTypeDef* huart);
+/**
+ * @brief  Makes {huart} a ready USART2 handle, with DMA handles for both directions.
+ * @retval None
+ */
+
+void SIM_UartTxComplete(UART_HandleTypeDef* huart);
+/**
+ * @brief  Ends the running HAL_UART_Transmit_DMA(): the handle is ready again and HAL_UART_TxCpltCallback() runs.
+ * @retval None
+ */
+
+void SIM_UartReceive(UART_HandleTypeDef* huart, const uint8_t* data, uint16_t len, uint8_t idle);
+/**
+ * @brief  Has the circular RX DMA write {len} bytes, raising the half and full transfer events on the way,
+ *         and the idle event at the end if {idle} is 1, like HAL_UARTEx_ReceiveToIdle_DMA(): each calls
+ *         HAL_UARTEx_RxEventCallback() with the DMA position (the buffer size for a full transfer).
+ * @retval None
+ */
+
+uint32_t SIM_DmaComplete(DMA_HandleTypeDef* hdma, uint8_t half);
+/**
+ * @brief  Ends a transfer (or its first half if {half} is 1) of {hdma}, calling the callback the HAL would.
+ *         A double buffer transfer alternates between the XferCplt and XferM1Cplt callbacks.
+ * @retval 1 if a callback ran, 0 if {hdma} is stopped.
+ */
+
+uint32_t SIM_DmaError(DMA_HandleTypeDef* hdma);
+/**
+ * @brief  Fails the transfer of {hdma} with a transfer error: the stream stops and the XferError callback runs.
+ * @retval Same as SIM_DmaComplete().
+ */
+
+uint32_t SIM_DmaReceive(DMA_HandleTypeDef* hdma, const void* data, uint32_t size);
+/**
+ * @brief  Has {hdma}, a peripheral to memory transfer, write {size} bytes of {data} to the memory it targets
+ *         (M1AR for the second buffer of a double buffer transfer), then ends the transfer with SIM_DmaComplete().
+ * @retval Same as SIM_DmaComplete().
+ */
+
+uint32_t SIM_FlashEraseStep(void);
+/**
+ * @brief  Ends the erase of the next sector asked from HAL_FLASHEx_Erase_IT(): erases its memory and calls
+ *         HAL_FLASH_EndOfOperationCallback() with the sector, or 0xFFFFFFFF for the last one.
+ * @retval Sectors left, 0 when done or with no erase running.
+ */
+
+/* C++ detection */
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,498 @@
+/**
+ * stm32f4xx_hal.h
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+Host stand-in for the STM32F4 HAL and CMSIS
+----------------------------------------------------------------------
+Lets the Core sources build and run on the host, unchanged: it comes
+first on the include path of the host build (see Host/CMakeLists.txt),
+in place of the HAL. It only has what the Core modules use, other than
+main.c and the interrupt vectors:
+	- peripherals are plain structs in RAM, so register writes land
+	  there and tests read them back (GPIO output levels, timer state).
+	  DWT->CYCCNT reads the host clock, scaled to SIM_CPU_HZ.
+	- CMSIS intrinsics are portable C, the SIMD ones with the GE flags
+	  of the instructions that set them, for __SEL. PRIMASK is a flag.
+	- HAL calls record what they were asked (sim.h); the interrupts they
+	  lead to are raised by the tests with the SIM_ functions.
+	- TRACE() of trace.h calls SIM_Trace(): the ITM store, and the trace
+	  file of the run if there is one (see sim.h).
+The CRC unit is the one peripheral computed in software, in crc32.c of
+the host build, since a plain register cannot compute: crc32.c of the
+Core is left out.
+----------------------------------------------------------------------
+ */
+#ifndef STM32F4XX_HAL_H
+#define STM32F4XX_HAL_H
+
+/* C++ detection */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define SIM_CPU_HZ 84000000UL //HCLK of the example
+
+/* Compiler */
+#define __IO volatile
+#define __I  volatile const
+#define __O  volatile
+#define __weak              __attribute__((weak))
+#define __ALIGNED(x)        __attribute__((aligned(x)))
+#define __PACKED_STRUCT     struct __attribute__((packed))
+#define __NOINLINE          __attribute__((noinline))
+#define __RAM_FUNC          //no RAM functions on the host
+#define __STATIC_INLINE     static inline
+#define __UNALIGNED_UINT32_READ(addr) (*(const uint32_t*)(addr))
+#define UNUSED(x)           ((void)(x))
+#define SET_BIT(reg, bit)   ((reg) |= (bit))
+#define CLEAR_BIT(reg, bit) ((reg) &= ~(bit))
+#define READ_BIT(reg, bit)  ((reg) & (bit))
+
+/* Core */
+extern volatile uint32_t SIM_primask;
+extern uint32_t SIM_ge; //GE[3:0] of the last SIMD add or subtract
+
+static inline uint32_t __get_PRIMASK(void){ return SIM_primask; }
+static inline void __set_PRIMASK(uint32_t primask){ SIM_primask = primask; }
+static inline void __disable_irq(void){ SIM_primask = 1U; }
+static inline void __enable_irq(void){ SIM_primask = 0; }
+static inline void __DMB(void){ __atomic_thread_fence(__ATOMIC_SEQ_CST); }
+static inline void __DSB(void){ __atomic_thread_fence(__ATOMIC_SEQ_CST); }
+static inline void __WFI(void){}
+static inline uint32_t __LDREXW(volatile uint32_t* addr){ return *addr; }
+static inline uint32_t __STREXW(uint32_t value, volatile uint32_t* addr){ *addr = value; return 0; } //one thread: never fails
+static inline void __CLREX(void){}
+uint32_t __get_MSP(void); //a fake stack in the sim (see sim.h), for the telemetry watermark
+static inline uint8_t __CLZ(uint32_t value){ return value ? (uint8_t)__builtin_clz(value) : 32U; }
+
+static inline int32_t __SSAT(int32_t value, uint32_t bits){
+	int32_t max = (int32_t)((1UL << (bits - 1U)) - 1U);
+	return (value > max) ? max : (value < -max - 1) ? -max - 1 : value;
+}
+
+static inline uint32_t __USAT(int32_t value, uint32_t bits){
+	int32_t max = (int32_t)((1UL << bits) - 1U);
+	return (value > max) ? (uint32_t)max : (value < 0) ? 0 : (uint32_t)value;
+}
+
+#define SIM_LO(x) ((int32_t)(int16_t)(x))
+#define SIM_HI(x) ((int32_t)(int16_t)((x) >> 16))
+#define SIM_PACK(lo, hi) (((uint32_t)(lo) & 0xFFFFU) | ((uint32_t)(hi) << 16))
+
+static inline uint32_t __QADD16(uint32_t a, uint32_t b){
+	return SIM_PACK(__SSAT(SIM_LO(a) + SIM_LO(b), 16), __SSAT(SIM_HI(a) + SIM_HI(b), 16));
+}
+
+static inline uint32_t __SHADD16(uint32_t a, uint32_t b){
+	return SIM_PACK((SIM_LO(a) + SIM_LO(b)) >> 1, (SIM_HI(a) + SIM_HI(b)) >> 1);
+}
+
+static inline uint32_t __UADD16(uint32_t a, uint32_t b){
+	uint32_t lo = (a & 0xFFFFU) + (b & 0xFFFFU), hi = (a >> 16) + (b >> 16);
+	SIM_ge = ((lo >> 16) ? 0x3U : 0) | ((hi >> 16) ? 0xCU : 0); //carry out
+	return SIM_PACK(lo, hi);
+}
+
+static inline uint32_t __USUB16(uint32_t a, uint32_t b){
+	int32_t lo = (int32_t)(a & 0xFFFFU) - (int32_t)(b & 0xFFFFU), hi = (int32_t)(a >> 16) - (int32_t)(b >> 16);
+	SIM_ge = ((lo >= 0) ? 0x3U : 0) | ((hi >= 0) ? 0xCU : 0); //no borrow
+	return SIM_PACK(lo, hi);
+}
+
+static inline uint32_t __SSUB16(uint32_t a, uint32_t b){
+	int32_t lo = SIM_LO(a) - SIM_LO(b), hi = SIM_HI(a) - SIM_HI(b);
+	SIM_ge = ((lo >= 0) ? 0x3U : 0) | ((hi >= 0) ? 0xCU : 0);
+	return SIM_PACK(lo, hi);
+}
+
+static inline uint32_t __SEL(uint32_t a, uint32_t b){
+	uint32_t result = 0, i;
+	for(i = 0; i < 4U; i++){
+		result |= (((SIM_ge >> i) & 1U) ? a : b) & (0xFFU << (8U * i));
+	}
+	return result;
+}
+
+static inline uint32_t __SMUAD(uint32_t a, uint32_t b){
+	return (uint32_t)(SIM_LO(a) * SIM_LO(b) + SIM_HI(a) * SIM_HI(b));
+}
+
+static inline uint32_t __SMUADX(uint32_t a, uint32_t b){
+	return (uint32_t)(SIM_LO(a) * SIM_HI(b) + SIM_HI(a) * SIM_LO(b));
+}
+
+static inline uint32_t __SMLAD(uint32_t a, uint32_t b, uint32_t acc){
+	return __SMUAD(a, b) + acc;
+}
+
+static inline uint64_t __SMLALD(uint32_t a, uint32_t b, uint64_t acc){
+	return acc + (uint64_t)((int64_t)SIM_LO(a) * SIM_LO(b) + (int64_t)SIM_HI(a) * SIM_HI(b));
+}
+
+#define __PKHBT(a, b, shift) (((uint32_t)(a) & 0xFFFFU) | (((uint32_t)(b) << (shift)) & 0xFFFF0000U))
+
+/* HAL */
+typedef enum {
+	HAL_OK      = 0x00U,
+	HAL_ERROR   = 0x01U,
+	HAL_BUSY    = 0x02U,
+	HAL_TIMEOUT = 0x03U
+} HAL_StatusTypeDef;
+
+typedef enum {
+	RESET = 0U,
+	SET = !RESET
+} FlagStatus;
+
+typedef enum {
+	DMA2_Stream0_IRQn = 56,
+	DMA1_Stream1_IRQn = 12,
+	DMA1_Stream5_IRQn = 16,
+	DMA1_Stream6_IRQn = 17,
+	USART2_IRQn       = 38,
+	TIM5_IRQn         = 50
+} IRQn_Type;
+
+extern __IO uint32_t uwTick; //HAL_GetTick() [ms]
+extern uint32_t SystemCoreClock;
+uint32_t HAL_GetTick(void);
+void HAL_Delay(uint32_t delay);
+void HAL_NVIC_SetPriority(IRQn_Type irq, uint32_t preempt, uint32_t sub);
+void HAL_NVIC_EnableIRQ(IRQn_Type irq);
+
+/* RCC */
+typedef struct {
+	__IO uint32_t CR, PLLCFGR, CFGR, CIR;
+} RCC_TypeDef;
+
+#define RCC_CFGR_PPRE1          0x00001C00U
+#define RCC_CFGR_PPRE1_DIV1     0x00000000U
+#define RCC_CFGR_PPRE1_DIV2     0x00001000U
+#define RCC_CFGR_PPRE2          0x0000E000U
+#define RCC_CFGR_PPRE2_DIV1     0x00000000U
+#define __HAL_RCC_GPIOA_CLK_ENABLE() ((void)0)
+#define __HAL_RCC_ADC1_CLK_ENABLE()  ((void)0)
+#define __HAL_RCC_DMA2_CLK_ENABLE()  ((void)0)
+#define __HAL_RCC_DAC_CLK_ENABLE()   ((void)0)
+#define __HAL_RCC_CRC_CLK_ENABLE()   ((void)0)
+
+uint32_t HAL_RCC_GetHCLKFreq(void);
+uint32_t HAL_RCC_GetPCLK1Freq(void);
+uint32_t HAL_RCC_GetPCLK2Freq(void);
+
+/* GPIO */
+typedef struct {
+	__IO uint32_t MODER, OTYPER, OSPEEDR, PUPDR, IDR, ODR, BSRR, LCKR, AFR[2];
+} GPIO_TypeDef;
+
+typedef enum {
+	GPIO_PIN_RESET = 0,
+	GPIO_PIN_SET
+} GPIO_PinState;
+
+typedef struct {
+	uint32_t Pin, Mode, Pull, Speed, Alternate;
+} GPIO_InitTypeDef;
+
+#define GPIO_PIN_0  0x0001U
+#define GPIO_PIN_1  0x0002U
+#define GPIO_PIN_2  0x0004U
+#define GPIO_PIN_3  0x0008U
+#define GPIO_PIN_4  0x0010U
+#define GPIO_PIN_5  0x0020U
+#define GPIO_PIN_6  0x0040U
+#define GPIO_PIN_7  0x0080U
+#define GPIO_PIN_8  0x0100U
+#define GPIO_PIN_10 0x0400U
+#define GPIO_PIN_13 0x2000U
+#define GPIO_PIN_14 0x4000U
+#define GPIO_MODE_ANALOG 0x00000003U
+#define GPIO_NOPULL      0x00000000U
+
+void HAL_GPIO_Init(GPIO_TypeDef* port, GPIO_InitTypeDef* init);
+void HAL_GPIO_WritePin(GPIO_TypeDef* port, uint16_t pin, GPIO_PinState state);
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef* port, uint16_t pin);
+
+/* DMA */
+typedef struct {
+	__IO uint32_t CR, NDTR, PAR, M0AR, M1AR, FCR;
+} DMA_Stream_TypeDef;
+
+typedef enum {
+	HAL_DMA_STATE_RESET = 0,
+	HAL_DMA_STATE_READY,
+	HAL_DMA_STATE_BUSY
+} HAL_DMA_StateTypeDef;
+
+typedef enum {
+	MEMORY0 = 0,
+	MEMORY1
+} HAL_DMA_MemoryTypeDef;
+
+typedef struct {
+	uint32_t Channel, Direction, PeriphInc, MemInc, PeriphDataAlignment, MemDataAlignment, Mode, Priority, FIFOMode;
+} DMA_InitTypeDef;
+
+typedef struct __DMA_HandleTypeDef {
+	DMA_Stream_TypeDef* Instance;
+	DMA_InitTypeDef Init;
+	__IO HAL_DMA_StateTypeDef State;
+	void* Parent;
+	void (*XferCpltCallback)(struct __DMA_HandleTypeDef* hdma);
+	void (*XferHalfCpltCallback)(struct __DMA_HandleTypeDef* hdma);
+	void (*XferM1CpltCallback)(struct __DMA_HandleTypeDef* hdma);
+	void (*XferM1HalfCpltCallback)(struct __DMA_HandleTypeDef* hdma);
+	void (*XferErrorCallback)(struct __DMA_HandleTypeDef* hdma);
+	void (*XferAbortCallback)(struct __DMA_HandleTypeDef* hdma);
+} DMA_HandleTypeDef;
+
+#define DMA_SxCR_CIRC           0x00000100U
+#define DMA_CHANNEL_0           0x00000000U
+#define DMA_PERIPH_TO_MEMORY    0x00000000U
+#define DMA_PINC_DISABLE        0x00000000U
+#define DMA_MINC_ENABLE         0x00000400U
+#define DMA_PDATAALIGN_HALFWORD 0x00000800U
+#define DMA_MDATAALIGN_HALFWORD 0x00002000U
+#define DMA_CIRCULAR            0x00000100U
+#define DMA_PRIORITY_HIGH       0x00020000U
+#define DMA_FIFOMODE_DISABLE    0x00000000U
+
+HAL_StatusTypeDef HAL_DMA_Init(DMA_HandleTypeDef* hdma);
+HAL_StatusTypeDef HAL_DMA_Start_IT(DMA_HandleTypeDef* hdma, uint32_t src, uint32_t dst, uint32_t length);
+HAL_StatusTypeDef HAL_DMA_Abort(DMA_HandleTypeDef* hdma);
+HAL_StatusTypeDef HAL_DMAEx_MultiBufferStart_IT(DMA_HandleTypeDef* hdma, uint32_t src, uint32_t dst, uint32_t second, uint32_t length);
+HAL_StatusTypeDef HAL_DMAEx_ChangeMemory(DMA_HandleTypeDef* hdma, uint32_t address, HAL_DMA_MemoryTypeDef memory);
+
+/* TIM */
+typedef struct {
+	__IO uint32_t CR1, CR2, SMCR, DIER, SR, EGR, CCMR1, CCMR2, CCER, CNT, PSC, ARR;
+} TIM_TypeDef;
+
+typedef struct {
+	uint32_t Prescaler, CounterMode, Period, ClockDivision, RepetitionCounter, AutoReloadPreload;
+} TIM_Base_InitTypeDef;
+
+typedef struct {
+	TIM_TypeDef* Instance;
+	TIM_Base_InitTypeDef Init;
+	DMA_HandleTypeDef* hdma[7];
+} TIM_HandleTypeDef;
+
+#define TIM_CR1_CEN        0x0001U
+#define TIM_SR_UIF         0x0001U
+#define TIM_DIER_UIE       0x0001U
+#define TIM_DMA_UPDATE     0x0100U
+#define TIM_DMA_ID_UPDATE  0U
+
+#define __HAL_TIM_SET_AUTORELOAD(h, v) do{ (h)->Instance->ARR = (v); (h)->Init.Period = (v); }while(0)
+#define __HAL_TIM_SET_COUNTER(h, v)    ((h)->Instance->CNT = (v))
+#define __HAL_TIM_CLEAR_FLAG(h, flag)  ((h)->Instance->SR = ~(flag))
+#define __HAL_TIM_ENABLE_DMA(h, dma)   ((h)->Instance->DIER |= (dma))
+#define __HAL_TIM_DISABLE_DMA(h, dma)  ((h)->Instance->DIER &= ~(dma))
+
+HAL_StatusTypeDef HAL_TIM_Base_Start(TIM_HandleTypeDef* htim);
+HAL_StatusTypeDef HAL_TIM_Base_Stop(TIM_HandleTypeDef* htim);
+HAL_StatusTypeDef HAL_TIM_Base_Start_IT(TIM_HandleTypeDef* htim);
+HAL_StatusTypeDef HAL_TIM_Base_Stop_IT(TIM_HandleTypeDef* htim);
+void HAL_TIM_IRQHandler(TIM_HandleTypeDef* htim);
+void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef* htim);
+
+/* UART */
+typedef struct {
+	__IO uint32_t SR, DR, BRR, CR1, CR2, CR3, GTPR;
+} USART_TypeDef;
+
+typedef enum {
+	HAL_UART_STATE_RESET   = 0x00U,
+	HAL_UART_STATE_READY   = 0x20U,
+	HAL_UART_STATE_BUSY_TX = 0x21U,
+	HAL_UART_STATE_BUSY_RX = 0x22U
+} HAL_UART_StateTypeDef;
+
+typedef struct {
+	USART_TypeDef* Instance;
+	uint8_t* pRxBuffPtr;
+	uint16_t RxXferSize;
+	DMA_HandleTypeDef* hdmatx;
+	DMA_HandleTypeDef* hdmarx;
+	__IO HAL_UART_StateTypeDef gState;
+	__IO HAL_UART_StateTypeDef RxState;
+	__IO uint32_t ErrorCode;
+} UART_HandleTypeDef;
+
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef* huart, const uint8_t* data, uint16_t size);
+HAL_StatusTypeDef HAL_UARTEx_ReceiveToIdle_DMA(UART_HandleTypeDef* huart, uint8_t* data, uint16_t size);
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef* huart);
+void HAL_UART_ErrorCallback(UART_HandleTypeDef* huart);
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef* huart, uint16_t size);
+
+/* ADC */
+typedef struct {
+	__IO uint32_t SR, CR1, CR2, SMPR1, SMPR2, JOFR[4], HTR, LTR, SQR1, SQR2, SQR3, JSQR, JDR[4], DR;
+} ADC_TypeDef;
+
+typedef struct {
+	__IO uint32_t CSR, CCR, CDR;
+} ADC_Common_TypeDef;
+
+#define ADC_CR2_ADON        0x00000001U
+#define ADC_CR2_DMA         0x00000100U
+#define ADC_CR2_DDS         0x00000200U
+#define ADC_CR2_ALIGN       0x00000800U
+#define ADC_CR2_EXTSEL_1    0x02000000U
+#define ADC_CR2_EXTSEL_2    0x04000000U
+#define ADC_CR2_EXTEN_0     0x10000000U
+#define ADC_SMPR2_SMP1_2    0x00000020U
+#define ADC_CCR_ADCPRE      0x00030000U
+#define ADC_CCR_ADCPRE_0    0x00010000U
+
+/* DAC */
+typedef struct {
+	__IO uint32_t CR, SWTRIGR, DHR12R1, DHR12L1, DHR8R1, DHR12R2, DHR12L2, DHR8R2, DHR12RD, DHR12LD, DHR8RD, DOR1, DOR2, SR;
+} DAC_TypeDef;
+
+#define DAC_CR_EN1 0x00000001U
+
+/* FLASH */
+typedef struct {
+	__IO uint32_t ACR, KEYR, OPTKEYR, SR, CR, OPTCR;
+} FLASH_TypeDef;
+
+typedef struct {
+	uint32_t TypeErase, Banks, Sector, NbSectors, VoltageRange;
+} FLASH_EraseInitTypeDef;
+
+#define FLASH_SR_BSY            0x00010000U
+#define FLASH_FLAG_OPERR        0x00000000U //write 1 to clear, which a plain SR cannot do: 0, programming never fails
+#define FLASH_FLAG_WRPERR       0x00000000U
+#define FLASH_FLAG_PGAERR       0x00000000U
+#define FLASH_FLAG_PGPERR       0x00000000U
+#define FLASH_FLAG_PGSERR       0x00000000U
+#define FLASH_FLAG_RDERR        0x00000000U
+#define FLASH_CR_PG             0x00000001U
+#define FLASH_CR_PSIZE          0x00000300U
+#define FLASH_PSIZE_WORD        0x00000200U
+#define FLASH_TYPEERASE_SECTORS 0x00000000U
+#define FLASH_VOLTAGE_RANGE_3   0x00000002U
+#define FLASH_SECTOR_5          5U
+#define FLASH_SECTOR_6          6U
+#define FLASH_SECTOR_7          7U
+#define __HAL_FLASH_DATA_CACHE_DISABLE() ((void)0)
+#define __HAL_FLASH_DATA_CACHE_RESET()   ((void)0)
+#define __HAL_FLASH_DATA_CACHE_ENABLE()  ((void)0)
+
+HAL_StatusTypeDef HAL_FLASH_Unlock(void);
+HAL_StatusTypeDef HAL_FLASH_Lock(void);
+HAL_StatusTypeDef HAL_FLASHEx_Erase_IT(FLASH_EraseInitTypeDef* erase);
+void HAL_FLASH_EndOfOperationCallback(uint32_t value);
+void HAL_FLASH_OperationErrorCallback(uint32_t value);
+
+/* CRC: computed by the host crc32.c, never read */
+typedef struct {
+	__IO uint32_t DR, IDR, CR;
+} CRC_TypeDef;
+
+#define CRC_CR_RESET 0x00000001U
+
+/* Debug */
+typedef struct {
+	__O union {
+		__O uint8_t u8;
+		__O uint16_t u16;
+		__O uint32_t u32;
+	} PORT[32];
+	__IO uint32_t TER, TPR, TCR, LAR;
+} ITM_TypeDef;
+
+void SIM_Trace(uint32_t port, uint32_t value);
+#define TRACE(port, value) SIM_Trace((port), (uint32_t)(value)) //in place of the one of trace.h
+
+typedef struct {
+	__IO uint32_t CTRL, CYCCNT;
+} DWT_TypeDef;
+
+typedef struct {
+	__IO uint32_t SSPSR, CSPSR, ACPR, SPPR, FFSR, FFCR;
+} TPI_TypeDef;
+
+typedef struct {
+	__IO uint32_t DHCSR, DCRSR, DCRDR, DEMCR;
+} CoreDebug_Type;
+
+typedef struct {
+	__IO uint32_t IDCODE, CR, APB1FZ, APB2FZ;
+} DBGMCU_TypeDef;
+
+#define ITM_TCR_ITMENA_Msk          0x00000001U
+#define ITM_TCR_TSENA_Msk           0x00000002U
+#define ITM_TCR_SYNCENA_Msk         0x00000004U
+#define ITM_TCR_TraceBusID_Pos      16U
+#define DWT_CTRL_CYCCNTENA_Msk      0x00000001U
+#define CoreDebug_DEMCR_TRCENA_Msk  0x01000000U
+#define DBGMCU_CR_TRACE_IOEN        0x00000020U
+
+/* Instances */
+extern GPIO_TypeDef SIM_GPIO[3];
+extern TIM_TypeDef SIM_TIM[15];
+extern DMA_Stream_TypeDef SIM_DMA2_Stream0;
+extern USART_TypeDef SIM_USART2;
+extern ADC_TypeDef SIM_ADC1;
+extern ADC_Common_TypeDef SIM_ADC;
+extern DAC_TypeDef SIM_DAC1;
+extern FLASH_TypeDef SIM_FLASH;
+extern CRC_TypeDef SIM_CRC;
+extern RCC_TypeDef SIM_RCC;
+extern ITM_TypeDef SIM_ITM;
+extern TPI_TypeDef SIM_TPI;
+extern CoreDebug_Type SIM_CoreDebug;
+extern DBGMCU_TypeDef SIM_DBGMCU;
+DWT_TypeDef* SIM_Dwt(void);
+
+#define GPIOA        (&SIM_GPIO[0])
+#define GPIOB        (&SIM_GPIO[1])
+#define GPIOC        (&SIM_GPIO[2])
+#define TIM1         (&SIM_TIM[1])
+#define TIM2         (&SIM_TIM[2])
+#define TIM5         (&SIM_TIM[5])
+#define TIM6         (&SIM_TIM[6])
+#define TIM8         (&SIM_TIM[8])
+#define TIM9         (&SIM_TIM[9])
+#define TIM10        (&SIM_TIM[10])
+#define TIM11        (&SIM_TIM[11])
+#define DMA2_Stream0 (&SIM_DMA2_Stream0)
+#define USART2       (&SIM_USART2)
+#define ADC1         (&SIM_ADC1)
+#define ADC          (&SIM_ADC)
+#define DAC1         (&SIM_DAC1)
+#define DAC          (&SIM_DAC1)
+#define FLASH        (&SIM_FLASH)
+#define CRC          (&SIM_CRC)
+#define RCC          (&SIM_RCC)
+#define ITM          (&SIM_ITM)
+#define TPI          (&SIM_TPI)
+#define CoreDebug    (&SIM_CoreDebug)
+#define DBGMCU       (&SIM_DBGMCU)
+#define DWT          (SIM_Dwt()) //CYCCNT is the host clock, writes to it are lost
+
+/* C++ detection */
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,196 @@
+/**
+ * capture_sim.c
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+Capture to flash, fed from a WAV file
+----------------------------------------------------------------------
+Usage: capture_sim [-f pcm16|ulaw|adpcm] [-s blocks] input.wav
+Plays the WAV file into the ADC, one DMA block at a time, and records
+it to flash in the given format (pcm16 by default) as the board does:
+every block goes through RECORDER_Process(), voice detection and DTMF
+included, then the scheduler runs until idle, which programs the
+flash. Samples are taken as they are, at CAPTURE_SAMPLE_RATE, whatever
+the rate of the file.
+	-s  the main loop stalls for {blocks} blocks halfway through the
+	    input: no RECORDER_Process(), no scheduler. The ring backs up,
+	    and past CAPTURE_BLOCKS - 2 blocks DMA goes to the scratch
+	    block until the consumer catches up.
+
+Prints what the pipeline did, then bench lines (see Tests/test.h): the
+main loop time per block, average and worst, and the share of real
+time it takes (a block lasts CAPTURE_BLOCK_SIZE / CAPTURE_SAMPLE_RATE).
+Times are the host's: they compare formats and inputs, the target
+figures are in the METRICS_ histograms.
+Every block DMA completes into the ring is kept, in order; in pcm16 the
+recording is checked against the input blocks kept, the held ones
+after a stall included:
+	kept: n blocks, d dropped
+	recording: n blocks, intact (or: block i is not input block m)
+The exit status is 2 for a bad argument or file, 1 if recording does
+not start.
+----------------------------------------------------------------------
+ */
+#include "sim.h"
+#include "scheduler.h"
+#include "capture.h"
+#include "recorder.h"
+#include "flash_writer.h"
+#include "vad.h"
+#include "wav_file.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+extern DMA_HandleTypeDef hdma_adc1;
+
+static const char* const _SIM_formats[] = {
+	[CODEC_FORMAT_PCM16] = "pcm16",
+	[CODEC_FORMAT_ULAW]  = "ulaw",
+	[CODEC_FORMAT_IMA_ADPCM] = "adpcm",
+};
+
+static TIM_HandleTypeDef _SIM_htim2;
+static uint32_t _SIM_voiceChanges;
+static char _SIM_keys[64];
+static uint32_t _SIM_keyCount;
+
+void VAD_ChangeCallback(uint8_t active){
+	UNUSED(active);
+	_SIM_voiceChanges++;
+}
+
+void DTMF_KeyCallback(char key){
+	if(_SIM_keyCount < sizeof(_SIM_keys) - 1U) _SIM_keys[_SIM_keyCount++] = key;
+}
+
+void HAL_FLASH_EndOfOperationCallback(uint32_t value){
+	FLASHWR_EndOfOperationCallback(value);
+}
+
+static void _SIM_Drain(void){
+	while(SCHED_RunOnce());
+}
+
+//Compares the pcm16 recording with the last input blocks kept, in order. Prints the first that differs.
+static void _SIM_CheckRecording(const int16_t* samples, const uint32_t* kept, uint32_t keptCount, const int16_t* recorded, uint32_t length){
+	uint32_t blocks = length / (CAPTURE_BLOCK_SIZE * sizeof(int16_t)), i, j, input;
+	if(blocks > keptCount){
+		printf("recording: %u blocks, over the %u kept\n", blocks, keptCount);
+		return;
+	}
+	for(i = 0; i < blocks; i++){
+		input = kept[keptCount - blocks + i];
+		for(j = 0; j < CAPTURE_BLOCK_SIZE; j++){
+			if(recorded[i * CAPTURE_BLOCK_SIZE + j] != (int16_t)((uint16_t)samples[input * CAPTURE_BLOCK_SIZE + j] & 0xFFF0U)){
+				printf("recording: block %u is not input block %u\n", i, input);
+				return;
+			}
+		}
+	}
+	printf("recording: %u blocks, intact\n", blocks);
+}
+
+int main(int argc, char** argv){
+	uint16_t block[CAPTURE_BLOCK_SIZE];
+	CODEC_FormatTypeDef format = CODEC_FORMAT_PCM16;
+	uint32_t rate, count, blocks, stall = 0, keptCount = 0, backlog, i, j;
+	uint64_t start, time, busy = 0, worst = 0, measured = 0;
+	const void* data;
+	uint32_t tag, length;
+	uint32_t* kept;
+	int16_t* samples;
+	int option;
+	uint8_t bad = 0;
+	while((option = getopt(argc, argv, "f:s:")) != -1){
+		switch(option){
+			case 'f':
+				for(i = 0; i < sizeof(_SIM_formats) / sizeof(_SIM_formats[0]); i++){
+					if(_SIM_formats[i] && strcmp(optarg, _SIM_formats[i]) == 0) break;
+				}
+				format = (CODEC_FormatTypeDef)i;
+				break;
+			case 's':
+				stall = (uint32_t)atoi(optarg);
+				break;
+			default:
+				bad = 1;
+				break;
+		}
+	}
+	if(bad || argc - optind != 1 || format >= sizeof(_SIM_formats) / sizeof(_SIM_formats[0])){
+		fprintf(stderr, "usage: capture_sim [-f pcm16|ulaw|adpcm] [-s blocks] input.wav\n");
+		return 2;
+	}
+	if((samples = WAV_Read(argv[optind], &rate, &count)) == NULL){
+		fprintf(stderr, "%s: no PCM WAV file\n", argv[optind]);
+		return 2;
+	}
+	blocks = count / CAPTURE_BLOCK_SIZE;
+	if((kept = malloc((blocks + 1U) * sizeof(uint32_t))) == NULL) return 2;
+
+	SIM_Reset();
+	SCHED_Init();
+	_SIM_htim2.Instance = TIM2;
+	CAPTURE_Init(&_SIM_htim2);
+	VAD_Init(CAPTURE_SAMPLE_RATE);
+	FLASHWR_Init();
+	if(RECORDER_Erase() != HAL_OK) return 1;
+	while(SIM_FlashEraseStep());
+	_SIM_Drain();
+	if(RECORDER_Start(format) != HAL_OK){
+		fprintf(stderr, "recording does not start\n");
+		return 1;
+	}
+
+	for(i = 0; i < blocks; i++){
+		for(j = 0; j < CAPTURE_BLOCK_SIZE; j++){
+			block[j] = ((uint16_t)samples[i * CAPTURE_BLOCK_SIZE + j] ^ 0x8000U) & 0xFFF0U; //12 bits, left-aligned offset binary
+		}
+		backlog = CAPTURE_GetBacklog();
+		SIM_DmaReceive(&hdma_adc1, block, sizeof(block));
+		if(CAPTURE_GetBacklog() != backlog) kept[keptCount++] = i; //in the ring, not the scratch block
+		if(i >= blocks / 2U && i < blocks / 2U + stall) continue; //the main loop is held up
+		measured++;
+		start = SIM_Nanoseconds();
+		RECORDER_Process();
+		_SIM_Drain();
+		time = SIM_Nanoseconds() - start;
+		busy += time;
+		if(time > worst) worst = time;
+	}
+	RECORDER_Stop();
+	_SIM_Drain();
+	length = FLASHWR_GetRecording(&data, &tag);
+
+	printf("input: %u samples at %u Hz, %u blocks\n", count, rate, blocks);
+	if(rate != CAPTURE_SAMPLE_RATE) printf("warning: captured as %u Hz\n", CAPTURE_SAMPLE_RATE);
+	printf("overruns: %u\n", CAPTURE_GetOverruns());
+	printf("kept: %u blocks, %u dropped\n", keptCount, blocks - keptCount);
+	printf("voice changes: %u\n", _SIM_voiceChanges);
+	printf("dtmf keys: %s\n", _SIM_keys);
+	printf("recorded: %u bytes, %s\n", length, _SIM_formats[format]);
+	if(format == CODEC_FORMAT_PCM16) _SIM_CheckRecording(samples, kept, keptCount, data, length);
+	if(measured){
+		printf("bench capture %s, mean over every block: %.3f ns\n", _SIM_formats[format], (double)busy / measured);
+		printf("bench capture %s, worst block: %.3f ns\n", _SIM_formats[format], (double)worst);
+		printf("bench capture %s, share of real time: %.3f %%\n", _SIM_formats[format],
+				busy / 1e9 / measured * CAPTURE_SAMPLE_RATE / CAPTURE_BLOCK_SIZE * 100.0);
+	}
+	free(kept);
+	free(samples);
+	return 0;
+}
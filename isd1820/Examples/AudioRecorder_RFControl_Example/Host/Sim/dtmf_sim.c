@@ -0,0 +1,101 @@
+/**
+ * dtmf_sim.c
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+DTMF keys in a WAV file
+----------------------------------------------------------------------
+Usage: dtmf_sim input.wav
+Plays the WAV file into the ADC, one DMA block at a time, with the
+recorder listening for tones (RECORDER_ListenTones()) as the board
+does between recordings, and prints every key DTMF_KeyCallback()
+reports, with the time of the end of the block it came in:
+	key K at T ms
+then the key count. Samples are taken as they are, at
+CAPTURE_SAMPLE_RATE, whatever the rate of the file.
+
+Bench lines (see Tests/test.h) give the main loop time per block,
+average and worst. Latency and false triggers depend on what the file
+holds: Tests/test_dtmf.c works them out from the key times.
+----------------------------------------------------------------------
+ */
+#include "sim.h"
+#include "capture.h"
+#include "recorder.h"
+#include "flash_writer.h"
+#include "dtmf.h"
+#include "vad.h"
+#include "wav_file.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+extern DMA_HandleTypeDef hdma_adc1;
+
+static TIM_HandleTypeDef _SIM_htim2;
+static uint32_t _SIM_block;   //blocks played, the current one included
+static uint32_t _SIM_keys;
+
+void DTMF_KeyCallback(char key){
+	printf("key %c at %u ms\n", key, _SIM_block * CAPTURE_BLOCK_SIZE * 1000U / CAPTURE_SAMPLE_RATE);
+	_SIM_keys++;
+}
+
+int main(int argc, char** argv){
+	uint16_t block[CAPTURE_BLOCK_SIZE];
+	uint32_t rate, count, blocks, i, j;
+	uint64_t start, time, busy = 0, worst = 0;
+	int16_t* samples;
+	if(argc != 2){
+		fprintf(stderr, "usage: dtmf_sim input.wav\n");
+		return 2;
+	}
+	if((samples = WAV_Read(argv[1], &rate, &count)) == NULL){
+		fprintf(stderr, "%s: no PCM WAV file\n", argv[1]);
+		return 2;
+	}
+
+	SIM_Reset();
+	_SIM_htim2.Instance = TIM2;
+	CAPTURE_Init(&_SIM_htim2);
+	VAD_Init(CAPTURE_SAMPLE_RATE);
+	FLASHWR_Init();
+	if(RECORDER_ListenTones(1) != HAL_OK){
+		fprintf(stderr, "capture does not start\n");
+		return 1;
+	}
+
+	blocks = count / CAPTURE_BLOCK_SIZE;
+	for(i = 0; i < blocks; i++){
+		for(j = 0; j < CAPTURE_BLOCK_SIZE; j++){
+			block[j] = ((uint16_t)samples[i * CAPTURE_BLOCK_SIZE + j] ^ 0x8000U) & 0xFFF0U; //12 bits, left-aligned offset binary
+		}
+		SIM_DmaReceive(&hdma_adc1, block, sizeof(block));
+		_SIM_block = i + 1U;
+		start = SIM_Nanoseconds();
+		RECORDER_Process();
+		time = SIM_Nanoseconds() - start;
+		busy += time;
+		if(time > worst) worst = time;
+	}
+	RECORDER_ListenTones(0);
+
+	printf("keys: %u\n", _SIM_keys);
+	if(blocks){
+		printf("bench dtmf listening, mean over every block: %.3f ns\n", (double)busy / blocks);
+		printf("bench dtmf listening, worst block: %.3f ns\n", (double)worst);
+	}
+	free(samples);
+	return 0;
+}
@@ -0,0 +1,219 @@
+/**
+ * offload_sim.c
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+Audio offload of a clip, board and receiver in one loop, on a timed
+line
+----------------------------------------------------------------------
+Usage: offload_sim [-b baud] [-r ms] [-x %] clips.bin id output.wav
+Loads the clip library image (see Tools/clips_pack) and offloads clip
+{id} with the receiver of offload_recv (Tools/offload_receiver.h), over
+the simulated USART2, to output.wav. Every transfer the board starts
+holds the line for its time at the baud rate (2000000 by default, 10
+bits a byte), and its bytes reach the receiver when it ends:
+	-r  round trip from the end of a frame to its acknowledgement
+	    reaching the board [ms], the host and USB-serial latency, 1 by
+	    default;
+	-x  share of data frames hit by a bit error on the line [%].
+The board runs from its scheduler as in main.c: OFFLOAD_Poll() every
+10ms and on each TX complete.
+
+Prints what the receiver did, the file size, and how busy the line was
+from the offload command to the last frame: with the window covering
+the round trip it stays near 100%, frames back to back. Bench lines
+give the file throughput, and its speed against real time.
+The exit status is 2 for a bad argument or file, 1 if the transfer
+does not end.
+----------------------------------------------------------------------
+ */
+#include "link.h"
+#include "clips.h"
+#include "offload_receiver.h"
+#include "stream_sender.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define SIM_TIMER   4U     //OFFLOAD_TIMER of main.c
+#define SIM_ACKS    64U    //acknowledgements on their way to the board
+#define SIM_GIVE_UP (2U * OFFLOAD_RETRIES * OFFLOAD_TIMEOUT * 1000U) //us without a frame taken
+
+static const char* const _SIM_formats[] = {
+	[CLIPS_FORMAT_DAC]       = "dac",
+	[CLIPS_FORMAT_PCM16]     = "pcm16",
+	[CLIPS_FORMAT_ULAW]      = "ulaw",
+	[CLIPS_FORMAT_IMA_ADPCM] = "adpcm",
+};
+
+typedef struct {
+	uint64_t at;          //[us]
+	uint8_t bytes[SENDER_MAX_ENCODED];
+	uint16_t len;
+} SIM_AckTypeDef;
+
+static RECEIVER_StateTypeDef _SIM_receiver;
+static SIM_AckTypeDef _SIM_acks[SIM_ACKS];
+static uint32_t _SIM_ackHead, _SIM_ackTail;
+static uint8_t _SIM_tx[4096];          //the transfer on the line
+static uint16_t _SIM_txLen;
+static uint8_t _SIM_txStarted;
+static uint32_t _SIM_loss;
+static uint32_t _SIM_corrupted;
+static uint32_t _SIM_lcg = 1;
+
+static uint32_t _SIM_Random(uint32_t range){
+	_SIM_lcg = _SIM_lcg * 1103515245U + 12345U;
+	return (_SIM_lcg >> 8) % range;
+}
+
+//Takes the transfer HAL_UART_Transmit_DMA() starts. Data frames may take a bit error, keeping the COBS framing.
+static void _SIM_TxHook(UART_HandleTypeDef* huart, const uint8_t* data, uint16_t size){
+	uint16_t at;
+	UNUSED(huart);
+	_SIM_txLen = size < sizeof(_SIM_tx) ? size : sizeof(_SIM_tx);
+	memcpy(_SIM_tx, data, _SIM_txLen);
+	_SIM_txStarted = 1;
+	if(_SIM_loss && _SIM_txLen > RECEIVER_MAX_FRAME / 2U && _SIM_Random(100U) < _SIM_loss){
+		at = (uint16_t)(1U + _SIM_Random(_SIM_txLen - 2U));
+		_SIM_tx[at] ^= (_SIM_tx[at] == 0x10U) ? 0x20U : 0x10U;
+		_SIM_corrupted++;
+	}
+}
+
+//Runs the board until it waits for an interrupt.
+static void _SIM_Run(void){
+	while(SCHED_RunOnce());
+	TELEM_Flush(0);
+}
+
+static void _SIM_Send(uint8_t cmd, const void* payload, uint16_t len){
+	uint8_t frame[SENDER_MAX_ENCODED];
+	SIM_UartReceive(&LINK_huart, frame, SENDER_Command(cmd, payload, len, frame), 1);
+	_SIM_Run();
+}
+
+//Loads the library image at {path}. Returns 0 if it cannot be read.
+static uint8_t _SIM_Load(const char* path){
+	FILE* image = fopen(path, "rb");
+	size_t size;
+	if(image == NULL) return 0;
+	memset(_sclips, 0xFF, SIM_CLIPS_SIZE);
+	size = fread(_sclips, 1, SIM_CLIPS_SIZE, image);
+	fclose(image);
+	return size > 0 && CLIPS_Init() == HAL_OK;
+}
+
+int main(int argc, char** argv){
+	uint8_t request[3] = {UARTCMD_OFFLOAD_CLIP, 0, 0};
+	const CLIPS_EntryTypeDef* clip;
+	uint32_t baud = 2000000U, rtt = 1000U, id, taken = 0;
+	uint64_t now = 0, txEnd = 0, txBusy = 0, busy = 0, end = 0, progress = 0, next;
+	SIM_AckTypeDef* ack;
+	FILE* output;
+	int option;
+	while((option = getopt(argc, argv, "b:r:x:")) != -1){
+		switch(option){
+			case 'b':
+				baud = (uint32_t)atoi(optarg);
+				break;
+			case 'r':
+				rtt = (uint32_t)(atof(optarg) * 1000.0);
+				break;
+			case 'x':
+				_SIM_loss = (uint32_t)atoi(optarg);
+				break;
+			default:
+				baud = 0;
+				break;
+		}
+	}
+	if(argc - optind != 3 || baud == 0 || _SIM_loss >= 100U){
+		fprintf(stderr, "usage: offload_sim [-b baud] [-r ms] [-x %%] clips.bin id output.wav\n");
+		return 2;
+	}
+	LINK_Open(NULL);
+	SIM_uartTxHook = _SIM_TxHook;
+	if(!_SIM_Load(argv[optind])){
+		fprintf(stderr, "%s: no clip library image\n", argv[optind]);
+		return 2;
+	}
+	id = (uint32_t)atoi(argv[optind + 1]);
+	if((clip = CLIPS_Find((uint16_t)id)) == NULL){
+		fprintf(stderr, "%s: no clip %u\n", argv[optind], id);
+		return 2;
+	}
+	RECEIVER_Init(&_SIM_receiver);
+	SCHED_TimerStart(SIM_TIMER, 10, 10, OFFLOAD_Poll, 0);
+	request[1] = (uint8_t)id;
+	request[2] = (uint8_t)(id >> 8);
+	_SIM_Send(UARTCMD_OFFLOAD, request, sizeof(request));
+
+	for(;;){ //one event at a time: a transfer ends, an acknowledgement arrives, or the next ms tick
+		if(_SIM_txStarted){
+			_SIM_txStarted = 0;
+			txBusy = (uint64_t)_SIM_txLen * 10U * 1000000U / baud;
+			txEnd = now + txBusy;
+		}
+		next = (now / 1000U + 1U) * 1000U;
+		if(LINK_huart.gState != HAL_UART_STATE_READY && txEnd < next) next = txEnd;
+		if(_SIM_ackHead != _SIM_ackTail && _SIM_acks[_SIM_ackTail % SIM_ACKS].at < next) next = _SIM_acks[_SIM_ackTail % SIM_ACKS].at;
+		now = next;
+		uwTick = (uint32_t)(now / 1000U);
+		if(LINK_huart.gState != HAL_UART_STATE_READY && now == txEnd){
+			if(!RECEIVER_Done(&_SIM_receiver)) busy += txBusy;
+			RECEIVER_Input(&_SIM_receiver, _SIM_tx, _SIM_txLen);
+			SIM_UartTxComplete(&LINK_huart);
+			if(_SIM_ackHead - _SIM_ackTail < SIM_ACKS){
+				ack = &_SIM_acks[_SIM_ackHead % SIM_ACKS];
+				if((ack->len = RECEIVER_Ack(&_SIM_receiver, ack->bytes)) != 0){
+					ack->at = now + rtt + (uint64_t)ack->len * 10U * 1000000U / baud;
+					_SIM_ackHead++;
+				}
+			}
+		}
+		while(_SIM_ackHead != _SIM_ackTail && _SIM_acks[_SIM_ackTail % SIM_ACKS].at <= now){
+			ack = &_SIM_acks[_SIM_ackTail++ % SIM_ACKS];
+			SIM_UartReceive(&LINK_huart, ack->bytes, ack->len, 1);
+		}
+		_SIM_Run();
+		if(_SIM_receiver.taken != taken){
+			taken = _SIM_receiver.taken;
+			progress = now;
+		}
+		if(!end && RECEIVER_Done(&_SIM_receiver)) end = now;
+		if(end && OFFLOAD_GetAck() == 0 && LINK_huart.gState == HAL_UART_STATE_READY && _SIM_ackHead == _SIM_ackTail) break;
+		if(now - progress > SIM_GIVE_UP){
+			fprintf(stderr, "the transfer does not end: %u of %u frames taken\n", _SIM_receiver.next, _SIM_receiver.frames);
+			return 1;
+		}
+	}
+
+	printf("frames: %u taken, %u dropped, %u bad, %u resends asked\n", _SIM_receiver.taken, _SIM_receiver.dropped, _SIM_receiver.bad, _SIM_receiver.requests);
+	printf("file: %u bytes\n", _SIM_receiver.length);
+	printf("line: %.1f%% busy\n", end ? busy * 100.0 / end : 0.0);
+	if(end){
+		printf("bench offload %s throughput: %.1f KB/s\n", _SIM_formats[clip->format], _SIM_receiver.length * 1000.0 / end);
+		printf("bench offload %s speed: %.2f x real time\n", _SIM_formats[clip->format], clip->length * 1e6 / clip->sampleRate / end);
+	}
+	output = fopen(argv[optind + 2], "wb");
+	if(output == NULL || fwrite(_SIM_receiver.file, 1, _SIM_receiver.length, output) != _SIM_receiver.length){
+		fprintf(stderr, "%s: cannot write\n", argv[optind + 2]);
+		return 2;
+	}
+	fclose(output);
+	RECEIVER_Free(&_SIM_receiver);
+	return 0;
+}
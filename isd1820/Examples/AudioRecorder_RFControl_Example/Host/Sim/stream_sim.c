@@ -0,0 +1,242 @@
+/**
+ * stream_sim.c
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+Host stream to the DAC, sender and board in one loop
+----------------------------------------------------------------------
+Usage: stream_sim [-f pcm16|ulaw|adpcm] [-l] [-r dac|feedthrough|record]
+                  [-d ppm] [-j ms] [-x %] input.wav [output.wav]
+Streams the WAV file, at PLAYBACK_SAMPLE_RATE, with the sender of
+stream_send (Tools/stream_sender.h) to the firmware over the simulated
+USART2, and plays it on the DAC, whose samples go to output.wav. Time
+runs on the DAC clock, one playback half at a time:
+	-l  live mode: frames go when their last sample is due on the host
+	    clock, rather than as fast as the board takes them;
+	-r  playback route of playback.h, dac by default;
+	-d  host clock ahead of the DAC timer [ppm], negative for behind;
+	-j  each frame up to that late, at random, in order [ms];
+	-x  share of data frames lost on the line [%].
+Frames arrive whole as they are sent: at 2Mbaud a PCM16 frame takes
+2.6ms of a 16ms period. Without a reply for 100ms, the sender goes
+back (SENDER_Timeout()).
+
+Prints the frames sent, sent again and lost, the underruns and the
+final target fill (see stream.h), and in live mode how far the fill
+was from the target, on average, over the last 10s of the stream:
+the drift the rate converter left uncorrected. Bench lines give the
+latency from the jitter buffer to the DAC, mean and worst, as
+METRICS_STREAM_LATENCY counts it; a live host adds its frame, 16ms.
+The exit status is 2 for a bad argument or file, 1 if the stream does
+not end.
+----------------------------------------------------------------------
+ */
+#include "link.h"
+#include "stream.h"
+#include "playback.h"
+#include "stream_sender.h"
+#include "wav_file.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define SIM_TIMEOUT  (100U * PLAYBACK_SAMPLE_RATE / 1000U) //samples without a reply before going back
+#define SIM_TRACKING (10U * PLAYBACK_SAMPLE_RATE / PLAYBACK_HALF_SIZE) //refills in the tracking mean, 10s
+#define SIM_TAIL     (5U * PLAYBACK_SAMPLE_RATE) //samples past the end of the input before giving up
+
+static const char* const _SIM_formats[] = {
+	[CODEC_FORMAT_PCM16] = "pcm16",
+	[CODEC_FORMAT_ULAW]  = "ulaw",
+	[CODEC_FORMAT_IMA_ADPCM] = "adpcm",
+};
+
+static const char* const _SIM_routes[] = {
+	[PLAYBACK_ROUTE_DAC]         = "dac",
+	[PLAYBACK_ROUTE_FEEDTHROUGH] = "feedthrough",
+	[PLAYBACK_ROUTE_RECORD]      = "record",
+};
+
+static TIM_HandleTypeDef _SIM_htim6;
+static DMA_HandleTypeDef _SIM_hdma;
+static DMA_Stream_TypeDef _SIM_stream;
+static SENDER_StateTypeDef _SIM_sender;
+static int32_t _SIM_errors[SIM_TRACKING]; //fill off the target, last refills
+static uint32_t _SIM_lcg = 1;
+
+static void _SIM_TxHook(UART_HandleTypeDef* huart, const uint8_t* data, uint16_t size){
+	UNUSED(huart);
+	SENDER_Input(&_SIM_sender, data, size);
+}
+
+static uint32_t _SIM_Random(uint32_t range){
+	_SIM_lcg = _SIM_lcg * 1103515245U + 12345U;
+	return (_SIM_lcg >> 8) % range;
+}
+
+static void _SIM_Send(uint8_t cmd, const void* payload, uint16_t len){
+	uint8_t frame[SENDER_MAX_ENCODED];
+	SIM_UartReceive(&LINK_huart, frame, SENDER_Command(cmd, payload, len, frame), 1);
+	LINK_Pump();
+}
+
+static void _SIM_Init(void){
+	LINK_Open(NULL);
+	SIM_uartTxHook = _SIM_TxHook;
+	memset(&_SIM_stream, 0, sizeof(_SIM_stream));
+	_SIM_hdma.Instance = &_SIM_stream;
+	_SIM_hdma.Init.Mode = DMA_CIRCULAR;
+	HAL_DMA_Init(&_SIM_hdma);
+	_SIM_htim6.Instance = TIM6;
+	_SIM_htim6.Init.Period = 5249U; //16kHz at 84MHz
+	_SIM_htim6.hdma[TIM_DMA_ID_UPDATE] = &_SIM_hdma;
+	PLAYBACK_Init(&_SIM_htim6);
+}
+
+int main(int argc, char** argv){
+	uint8_t start[3] = {CODEC_FORMAT_PCM16, PLAYBACK_ROUTE_DAC, STREAM_MODE_BUFFERED}, end = 0;
+	uint8_t frame[SENDER_MAX_ENCODED];
+	CODEC_FormatTypeDef format = CODEC_FORMAT_PCM16;
+	double ppm = 0, latency = 0, worst = 0, tracking = 0;
+	uint32_t jitter = 0, loss = 0, rate, count, now = 0, due = 0, dueAt = STREAM_MAX_WRITE, progress = 0, acked = 0;
+	uint32_t lost = 0, refills = 0, tracked = 0, played = 0, halves = 0, route = PLAYBACK_ROUTE_DAC, fill, half, i;
+	const uint16_t* buffer;
+	uint16_t len;
+	uint8_t ended = 0;
+	int16_t* samples;
+	int16_t* output;
+	int option;
+	while((option = getopt(argc, argv, "f:lr:d:j:x:")) != -1){
+		switch(option){
+			case 'f':
+				for(i = CODEC_FORMAT_PCM16; i < sizeof(_SIM_formats) / sizeof(_SIM_formats[0]); i++){
+					if(strcmp(optarg, _SIM_formats[i]) == 0) break;
+				}
+				format = (CODEC_FormatTypeDef)i;
+				break;
+			case 'l':
+				start[2] = STREAM_MODE_LIVE;
+				break;
+			case 'r':
+				for(route = 0; route < sizeof(_SIM_routes) / sizeof(_SIM_routes[0]); route++){
+					if(strcmp(optarg, _SIM_routes[route]) == 0) break;
+				}
+				break;
+			case 'd':
+				ppm = atof(optarg);
+				break;
+			case 'j':
+				jitter = (uint32_t)atoi(optarg) * PLAYBACK_SAMPLE_RATE / 1000U;
+				break;
+			case 'x':
+				loss = (uint32_t)atoi(optarg);
+				break;
+			default:
+				format = 0;
+				break;
+		}
+	}
+	if(argc - optind < 1 || argc - optind > 2 || format >= sizeof(_SIM_formats) / sizeof(_SIM_formats[0]) || format == 0 || loss >= 100U
+			|| route >= sizeof(_SIM_routes) / sizeof(_SIM_routes[0])){
+		fprintf(stderr, "usage: stream_sim [-f pcm16|ulaw|adpcm] [-l] [-r dac|feedthrough|record] [-d ppm] [-j ms] [-x %%] input.wav [output.wav]\n");
+		return 2;
+	}
+	if((samples = WAV_Read(argv[optind], &rate, &count)) == NULL){
+		fprintf(stderr, "%s: no PCM WAV file\n", argv[optind]);
+		return 2;
+	}
+	if(rate != PLAYBACK_SAMPLE_RATE){
+		fprintf(stderr, "%s: %u Hz, the stream is %u Hz\n", argv[optind], rate, PLAYBACK_SAMPLE_RATE);
+		return 2;
+	}
+	output = calloc(count + SIM_TAIL, sizeof(int16_t));
+	if(output == NULL || !SENDER_Init(&_SIM_sender, format, samples, count)) return 2;
+
+	_SIM_Init();
+	start[0] = (uint8_t)format;
+	start[1] = (uint8_t)route;
+	_SIM_Send(UARTCMD_STREAM_START, start, sizeof(start));
+	for(;;){
+		if(start[2] == STREAM_MODE_LIVE){ //frames the host clock has reached, each up to {jitter} late
+			while(due < _SIM_sender.frames && now * (1.0 + ppm * 1e-6) >= dueAt){
+				due++;
+				i = (due + 1U) * STREAM_MAX_WRITE + (jitter ? _SIM_Random(jitter + 1U) : 0);
+				if(i > dueAt) dueAt = i;
+			}
+		}else{
+			due = 0xFFFFFFFFU;
+		}
+		while((len = SENDER_Next(&_SIM_sender, due, frame)) != 0){
+			if(loss && _SIM_Random(100U) < loss){
+				lost++;
+				continue;
+			}
+			SIM_UartReceive(&LINK_huart, frame, len, 1);
+			LINK_Pump();
+		}
+		if(_SIM_sender.acked != acked || SENDER_Done(&_SIM_sender) || (_SIM_sender.next == _SIM_sender.acked && _SIM_sender.next >= due)){
+			acked = _SIM_sender.acked; //progress, or nothing to send yet
+			progress = now;
+		}else if(now - progress >= SIM_TIMEOUT){
+			SENDER_Timeout(&_SIM_sender);
+			progress = now;
+		}
+		if(!ended && SENDER_Done(&_SIM_sender)){
+			_SIM_Send(UARTCMD_STREAM_END, &end, 1);
+			ended = 1;
+		}
+		if(PLAYBACK_IsPlaying()){ //the DAC takes the half DMA leaves, then it is refilled
+			half = halves++ & 1U; //first half out, then the second
+			buffer = (const uint16_t*)(uintptr_t)_SIM_stream.M0AR + half * PLAYBACK_HALF_SIZE;
+			for(i = 0; i < PLAYBACK_HALF_SIZE && played < count + SIM_TAIL; i++) output[played++] = (int16_t)(buffer[i] ^ 0x8000U);
+			if(!ended){
+				fill = STREAM_BUFFER_SIZE - (STREAM_GetAck() >> 16);
+				latency += fill + PLAYBACK_HALF_SIZE;
+				if(fill + PLAYBACK_HALF_SIZE > worst) worst = fill + PLAYBACK_HALF_SIZE;
+				_SIM_errors[refills++ % SIM_TRACKING] = (int32_t)fill - (int32_t)STREAM_GetTarget();
+			}
+			SIM_DmaComplete(&_SIM_hdma, half == 0);
+			LINK_Pump();
+		}else if(ended){
+			break;
+		}
+		now += PLAYBACK_HALF_SIZE;
+		SENDER_Elapse(&_SIM_sender, PLAYBACK_HALF_SIZE);
+		if(now > 2U * count + SIM_TAIL){
+			fprintf(stderr, "the stream does not end: %u of %u frames taken\n", _SIM_sender.acked, _SIM_sender.frames);
+			return 1;
+		}
+	}
+
+	printf("frames: %u sent, %u sent again, %u lost\n", _SIM_sender.sent, _SIM_sender.resent, lost);
+	printf("underruns: %u\n", STREAM_GetUnderruns());
+	printf("target: %u samples\n", STREAM_GetTarget());
+	if(start[2] == STREAM_MODE_LIVE){
+		tracked = refills < SIM_TRACKING ? refills : SIM_TRACKING;
+		for(i = 0; i < tracked; i++) tracking += _SIM_errors[i];
+		printf("tracking: %.1f samples off the target\n", tracked ? tracking / tracked : 0.0);
+	}
+	if(refills){
+		printf("bench stream %s latency, mean: %.3f ms\n", _SIM_formats[format], latency / refills * 1000.0 / PLAYBACK_SAMPLE_RATE);
+		printf("bench stream %s latency, worst: %.3f ms\n", _SIM_formats[format], worst * 1000.0 / PLAYBACK_SAMPLE_RATE);
+	}
+	if(argc - optind == 2 && !WAV_Write(argv[optind + 1], output, played, PLAYBACK_SAMPLE_RATE)){
+		fprintf(stderr, "%s: cannot write\n", argv[optind + 1]);
+		return 2;
+	}
+	SENDER_Free(&_SIM_sender);
+	free(samples);
+	free(output);
+	return 0;
+}
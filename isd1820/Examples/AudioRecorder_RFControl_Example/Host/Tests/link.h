@@ -0,0 +1,156 @@
+/**
+ * link.h
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+Host side of the USART2 link, for the tests
+----------------------------------------------------------------------
+Builds command frames as the host sends them (see uart_cmd.h) and
+splits what the device sends into decoded frames. LINK_Open() links
+USART2 to the telemetry stream and the command parser, with the HAL
+callbacks of main.c; LINK_Pump() then runs the scheduler and moves DMA
+transfers along until nothing is left to do.
+----------------------------------------------------------------------
+ */
+#ifndef LINK_H
+#define LINK_H
+
+#include "sim.h"
+#include "crc32.h"
+#include "scheduler.h"
+#include "telemetry.h"
+#include "uart_cmd.h"
+#include "offload.h"
+#include <string.h>
+
+#define LINK_MAX_FRAME 1100U //decoded bytes, an offload frame with its header
+
+typedef void (*LINK_FrameHookTypeDef)(const uint8_t* frame, uint16_t len);
+
+static UART_HandleTypeDef LINK_huart;
+static LINK_FrameHookTypeDef LINK_frameHook; //called with every frame the device sends, decoded
+static uint8_t _LINK_rx[LINK_MAX_FRAME + 8U];
+static uint16_t _LINK_rxLen;
+
+//COBS-encodes {len} bytes of {data} to {out}, with the 0x00 delimiter. Returns the encoded size.
+static inline uint16_t LINK_Cobs(const uint8_t* data, uint16_t len, uint8_t* out){
+	uint16_t code = 0, n = 1, i;
+	for(i = 0; i < len; i++){
+		if(data[i] == 0){
+			out[code] = (uint8_t)(n - code);
+			code = n++;
+			continue;
+		}
+		out[n++] = data[i];
+		if(n - code == 0xFFU){
+			out[code] = 0xFFU;
+			code = n++;
+		}
+	}
+	out[code] = (uint8_t)(n - code);
+	out[n++] = 0;
+	return n;
+}
+
+//Builds the encoded frame for {cmd} and {payload} in {out}. Returns its size.
+static inline uint16_t LINK_Frame(uint8_t cmd, const void* payload, uint16_t len, uint8_t* out){
+	uint8_t frame[LINK_MAX_FRAME];
+	uint32_t crc;
+	frame[0] = cmd;
+	if(len) memcpy(&frame[1], payload, len);
+	crc = CRC32_Compute(frame, len + 1U);
+	memcpy(&frame[len + 1U], &crc, 4U);
+	return LINK_Cobs(frame, len + 5U, out);
+}
+
+//Reads the varints of telemetry record {frame}, tick first, into {values}. Returns how many.
+static inline uint32_t LINK_Values(const uint8_t* frame, uint16_t len, uint32_t* values, uint32_t max){
+	uint32_t count = 0, shift = 0;
+	uint16_t i;
+	for(i = 1; i < len && count < max; i++){
+		if(shift == 0) values[count] = 0;
+		values[count] |= (uint32_t)(frame[i] & 0x7FU) << shift;
+		shift += 7U;
+		if((frame[i] & 0x80U) == 0){
+			count++;
+			shift = 0;
+		}
+	}
+	return count;
+}
+
+//Decodes the frame collected in _LINK_rx, in place, and hands it over.
+static inline void _LINK_Deliver(void){
+	uint16_t in = 0, out = 0, code, i;
+	while(in < _LINK_rxLen){
+		code = _LINK_rx[in++];
+		for(i = 1; i < code && in < _LINK_rxLen; i++) _LINK_rx[out++] = _LINK_rx[in++];
+		if(code != 0xFFU && in < _LINK_rxLen) _LINK_rx[out++] = 0;
+	}
+	if(out && LINK_frameHook) LINK_frameHook(_LINK_rx, out);
+}
+
+static inline void _LINK_TxHook(UART_HandleTypeDef* huart, const uint8_t* data, uint16_t size){
+	UNUSED(huart);
+	while(size--){
+		if(*data == 0){
+			_LINK_Deliver();
+			_LINK_rxLen = 0;
+		}else if(_LINK_rxLen < sizeof(_LINK_rx)){
+			_LINK_rx[_LINK_rxLen++] = *data;
+		}
+		data++;
+	}
+}
+
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef* huart, uint16_t pos){
+	UARTCMD_RxEventCallback(huart, pos);
+}
+
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef* huart){
+	TELEM_TxCpltCallback(huart);
+	OFFLOAD_TxCpltCallback(huart);
+}
+
+//Resets the simulation and opens the link. Frames sent by the device go to {hook}.
+static inline void LINK_Open(LINK_FrameHookTypeDef hook){
+	SIM_Reset();
+	SCHED_Init();
+	SIM_UartInit(&LINK_huart);
+	SIM_uartTxHook = _LINK_TxHook;
+	LINK_frameHook = hook;
+	_LINK_rxLen = 0;
+	TELEM_Init(&LINK_huart);
+	OFFLOAD_Init(&LINK_huart);
+	UARTCMD_Init(&LINK_huart);
+}
+
+//Runs the scheduler, the telemetry flush and the transfers until all is idle.
+static inline void LINK_Pump(void){
+	for(;;){
+		while(SCHED_RunOnce());
+		TELEM_Flush(0);
+		if(LINK_huart.gState == HAL_UART_STATE_READY) return;
+		SIM_UartTxComplete(&LINK_huart);
+	}
+}
+
+//Sends the command frame for {cmd} and {payload}, with the idle line after it.
+static inline void LINK_Send(uint8_t cmd, const void* payload, uint16_t len){
+	uint8_t out[LINK_MAX_FRAME + 8U];
+	SIM_UartReceive(&LINK_huart, out, LINK_Frame(cmd, payload, len, out), 1);
+}
+
+#endif
@@ -0,0 +1,82 @@
+/**
+ * test.h
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+Host test helpers
+----------------------------------------------------------------------
+Each test is one program: CHECK() reports a failure with its line and
+goes on, TEST_END() makes the exit status. Benchmarks print one line
+per measure, "bench <name>: <value> <unit>", for whoever tracks them;
+they only fail on bounds loose enough to hold on a loaded machine.
+Timings come from the host clock: they rank the code paths, the cycle
+counts of the target are in the METRICS_ histograms of the board.
+Tests of the host tools and sims run them with TEST_Tool() and check
+what they print, line by line; their bench lines are passed through.
+----------------------------------------------------------------------
+ */
+#ifndef TEST_H
+#define TEST_H
+
+#include "sim.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int _TEST_failures;
+
+#define CHECK(cond) do{ \
+	if(!(cond)){ \
+		printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+		_TEST_failures++; \
+	} \
+}while(0)
+
+#define CHECK_EQ(a, b) do{ \
+	long long _a = (long long)(a), _b = (long long)(b); \
+	if(_a != _b){ \
+		printf("%s:%d: CHECK_EQ(%s, %s) failed: %lld != %lld\n", __FILE__, __LINE__, #a, #b, _a, _b); \
+		_TEST_failures++; \
+	} \
+}while(0)
+
+#define BENCH(name, value, unit) printf("bench %s: %.3f %s\n", (name), (double)(value), (unit))
+
+//Runs {command} and checks its output against {expected}, one line each, and its exit status. Bench lines are printed instead.
+static inline void TEST_Tool(const char* command, const char* const* expected, uint32_t count, int status){
+	char line[512];
+	uint32_t n = 0;
+	FILE* out = popen(command, "r");
+	CHECK(out != NULL);
+	if(out == NULL) return;
+	while(fgets(line, sizeof(line), out)){
+		if(strncmp(line, "bench ", 6) == 0){
+			fputs(line, stdout);
+			continue;
+		}
+		line[strcspn(line, "\n")] = 0;
+		if(n < count && strcmp(line, expected[n]) != 0){
+			printf("%s: line %u: \"%s\", expected \"%s\"\n", command, n, line, expected[n]);
+			_TEST_failures++;
+		}
+		n++;
+	}
+	CHECK_EQ(n, count);
+	CHECK_EQ(WEXITSTATUS(pclose(out)), status);
+}
+
+#define TEST_END() (printf("%s: %d failure(s)\n", __FILE__, _TEST_failures), _TEST_failures != 0)
+
+#endif
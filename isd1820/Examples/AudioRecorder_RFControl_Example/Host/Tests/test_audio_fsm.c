@@ -0,0 +1,177 @@
+/**
+ * test_audio_fsm.c
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+Audio state machine: every transition and its dispatch cost
+----------------------------------------------------------------------
+ */
+#include "test.h"
+#include "audio_fsm.h"
+#include "isd1820.h"
+#include "capture.h"
+#include "recorder.h"
+#include "main.h"
+
+#define COST_RUNS     200U
+#define COST_BOUND_NS 20000U //no action may wait on the driver
+
+static TIM_HandleTypeDef htim2, htim5;
+
+//Expected next state of each (state, event), from the table of audio_fsm.h. Completion events come once the
+//operation ended, ABORTED with the driver still busy (the leftover of a preemption).
+static const uint8_t _expected[FSM_STATE_COUNT][FSM_EVENT_COUNT] = {
+	/*                       A                   B                  C                    D                    REC_DONE           PLAY_DONE          ABORTED              VOICE_START          VOICE_END */
+	[FSM_STATE_IDLE]        = {FSM_STATE_QUEUED, FSM_STATE_PLAYING, FSM_STATE_LISTENING, FSM_STATE_FEEDTHROUGH, FSM_STATE_IDLE,    FSM_STATE_IDLE,    FSM_STATE_IDLE,      FSM_STATE_IDLE,      FSM_STATE_IDLE},
+	[FSM_STATE_RECORDING]   = {FSM_STATE_RECORDING, FSM_STATE_QUEUED, FSM_STATE_IDLE,    FSM_STATE_RECORDING, FSM_STATE_IDLE,    FSM_STATE_RECORDING, FSM_STATE_RECORDING, FSM_STATE_RECORDING, FSM_STATE_RECORDING},
+	[FSM_STATE_QUEUED]      = {FSM_STATE_QUEUED, FSM_STATE_QUEUED,  FSM_STATE_IDLE,      FSM_STATE_QUEUED,    FSM_STATE_PLAYING, FSM_STATE_QUEUED,  FSM_STATE_QUEUED,    FSM_STATE_QUEUED,    FSM_STATE_QUEUED},
+	[FSM_STATE_PLAYING]     = {FSM_STATE_PLAYING, FSM_STATE_PLAYING, FSM_STATE_RECORDING, FSM_STATE_PLAYING,  FSM_STATE_PLAYING, FSM_STATE_IDLE,    FSM_STATE_PLAYING,   FSM_STATE_PLAYING,   FSM_STATE_PLAYING},
+	[FSM_STATE_FEEDTHROUGH] = {FSM_STATE_FEEDTHROUGH, FSM_STATE_FEEDTHROUGH, FSM_STATE_FEEDTHROUGH, FSM_STATE_IDLE, FSM_STATE_FEEDTHROUGH, FSM_STATE_FEEDTHROUGH, FSM_STATE_FEEDTHROUGH, FSM_STATE_FEEDTHROUGH, FSM_STATE_FEEDTHROUGH},
+	[FSM_STATE_LISTENING]   = {FSM_STATE_LISTENING, FSM_STATE_LISTENING, FSM_STATE_IDLE, FSM_STATE_LISTENING, FSM_STATE_LISTENING, FSM_STATE_LISTENING, FSM_STATE_LISTENING, FSM_STATE_VOICE, FSM_STATE_LISTENING},
+	[FSM_STATE_VOICE]       = {FSM_STATE_VOICE,  FSM_STATE_VOICE,   FSM_STATE_IDLE,      FSM_STATE_VOICE,     FSM_STATE_IDLE,    FSM_STATE_VOICE,   FSM_STATE_VOICE,     FSM_STATE_VOICE,     FSM_STATE_VOICE},
+};
+
+static const char* const _stateNames[FSM_STATE_COUNT] = {"IDLE", "ACTIVE", "RECORDING", "QUEUED", "PLAYING", "FEEDTHROUGH", "LISTENING", "VOICE"};
+static const char* const _eventNames[FSM_EVENT_COUNT] = {"A", "B", "C", "D", "RECORD_DONE", "PLAY_DONE", "ABORTED", "VOICE_START", "VOICE_END"};
+
+void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef* htim){
+	if(htim == &htim5) ISD1820_AsyncTimHandler();
+}
+
+static uint8_t _Pin(GPIO_TypeDef* port, uint16_t pin){
+	return HAL_GPIO_ReadPin(port, pin) == GPIO_PIN_SET;
+}
+
+//Drives the machine into {state} the way the buttons would, from a clean IDLE.
+static void _Reach(FSM_StateTypeDef state){
+	ISD1820_ResetPins();
+	RECORDER_Listen(0);
+	FSM_Init();
+	switch(state){
+		case FSM_STATE_QUEUED:
+			FSM_Dispatch(FSM_EVENT_BUTTON_A);
+			break;
+		case FSM_STATE_PLAYING:
+			FSM_Dispatch(FSM_EVENT_BUTTON_B);
+			break;
+		case FSM_STATE_RECORDING:
+			FSM_Dispatch(FSM_EVENT_BUTTON_B);
+			FSM_Dispatch(FSM_EVENT_BUTTON_C);
+			break;
+		case FSM_STATE_FEEDTHROUGH:
+			FSM_Dispatch(FSM_EVENT_BUTTON_D);
+			break;
+		case FSM_STATE_LISTENING:
+			FSM_Dispatch(FSM_EVENT_BUTTON_C);
+			break;
+		case FSM_STATE_VOICE:
+			FSM_Dispatch(FSM_EVENT_BUTTON_C);
+			FSM_Dispatch(FSM_EVENT_VOICE_START);
+			break;
+		default:
+			break;
+	}
+}
+
+static void _Setup(void){
+	SIM_Reset();
+	htim2.Instance = TIM2;
+	htim5.Instance = TIM5;
+	TIM5->PSC = 8399U; //10kHz
+	CAPTURE_Init(&htim2);
+	ISD1820_AsyncInit(&htim5);
+	SIM_tickStep = 1U; //a busy-wait shows as ticks going by
+}
+
+static void _TestTransitions(void){
+	uint64_t start, cost, worst = 0, total = 0;
+	uint32_t state, event, run, tick, count = 0;
+	FSM_StateTypeDef next;
+	_Setup();
+	for(state = 0; state < FSM_STATE_COUNT; state++){
+		if(state == FSM_STATE_ACTIVE) continue; //never current
+		for(event = 0; event < FSM_EVENT_COUNT; event++){
+			cost = UINT64_MAX;
+			for(run = 0; run < COST_RUNS; run++){
+				_Reach((FSM_StateTypeDef)state);
+				CHECK_EQ(FSM_GetState(), state);
+				if(event == FSM_EVENT_RECORD_DONE || event == FSM_EVENT_PLAY_DONE){
+					ISD1820_StopRecording();
+					ISD1820_StopPlaying();
+				}
+				tick = uwTick;
+				start = SIM_Nanoseconds();
+				next = FSM_Dispatch((FSM_EventTypeDef)event);
+				start = SIM_Nanoseconds() - start;
+				if(start < cost) cost = start;
+				if(run) continue;
+				if(next != _expected[state][event]){
+					printf("%s + %s -> %s, expected %s\n", _stateNames[state], _eventNames[event], _stateNames[next], _stateNames[_expected[state][event]]);
+				}
+				CHECK_EQ(next, _expected[state][event]);
+				CHECK(uwTick - tick <= 1U); //the action read the tick at most once: it did not wait
+			}
+			CHECK(cost < COST_BOUND_NS);
+			if(cost > worst) worst = cost;
+			total += cost;
+			count++;
+		}
+	}
+	BENCH("fsm dispatch, mean over every transition", (double)total / count, "ns");
+	BENCH("fsm dispatch, worst transition", worst, "ns");
+}
+
+static void _TestActions(void){
+	_Setup();
+	_Reach(FSM_STATE_PLAYING); //PLAYING + D: the PE pulse replaces the play, and dispatch returns at once
+	CHECK_EQ(FSM_Dispatch(FSM_EVENT_BUTTON_D), FSM_STATE_PLAYING);
+	CHECK(_Pin(PE_GPIO_Port, PE_Pin));
+	CHECK(!_Pin(PL_GPIO_Port, PL_Pin));
+	CHECK_EQ(ISD1820_STATUS_OP(ISD1820_GetStatus()), ISD1820_OP_PLAY_COMPLETE);
+	CHECK_EQ(FSM_EventFromStatus(ISD1820_GetStatus()), FSM_EVENT_PLAY_DONE);
+	CHECK(SIM_TimExpire(&htim5)); //end of the pulse
+	CHECK(!_Pin(PE_GPIO_Port, PE_Pin));
+	CHECK_EQ(FSM_Dispatch(FSM_EVENT_PLAY_DONE), FSM_STATE_IDLE);
+
+	_Reach(FSM_STATE_QUEUED); //the queued play starts after the record, as a sequence
+	CHECK(_Pin(REC_GPIO_Port, REC_Pin));
+	ISD1820_StopRecording();
+	CHECK_EQ(FSM_Dispatch(FSM_EVENT_RECORD_DONE), FSM_STATE_PLAYING);
+	CHECK(ISD1820_SequenceActive());
+
+	_Reach(FSM_STATE_PLAYING); //aborted with the driver idle: back to IDLE
+	ISD1820_Cancel();
+	CHECK_EQ(FSM_Dispatch(FSM_EVENT_ABORTED), FSM_STATE_IDLE);
+
+	_Reach(FSM_STATE_FEEDTHROUGH);
+	CHECK(_Pin(FT_GPIO_Port, FT_Pin));
+	CHECK_EQ(FSM_Dispatch(FSM_EVENT_BUTTON_D), FSM_STATE_IDLE);
+	CHECK(!_Pin(FT_GPIO_Port, FT_Pin));
+
+	_Reach(FSM_STATE_VOICE); //voice end stops the recording, record done leaves
+	CHECK(_Pin(REC_GPIO_Port, REC_Pin));
+	CHECK_EQ(FSM_Dispatch(FSM_EVENT_VOICE_END), FSM_STATE_VOICE);
+	CHECK(!_Pin(REC_GPIO_Port, REC_Pin));
+	CHECK_EQ(FSM_Dispatch(FSM_EVENT_RECORD_DONE), FSM_STATE_IDLE);
+	CHECK(!SIM_TimRunning(&htim2)); //capture stopped with the listening
+
+	CHECK_EQ(FSM_Dispatch(FSM_EVENT_COUNT), FSM_STATE_IDLE); //out of range: ignored
+}
+
+int main(void){
+	_TestTransitions();
+	_TestActions();
+	return TEST_END();
+}
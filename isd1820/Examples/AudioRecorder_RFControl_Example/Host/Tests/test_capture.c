@@ -0,0 +1,83 @@
+/**
+ * test_capture.c
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+Capture to flash from a WAV file, by Sim/capture_sim, in every format,
+and with the main loop stalled
+----------------------------------------------------------------------
+Usage: test_capture <capture_sim>
+A stall of s blocks leaves s + 1 blocks waiting when it ends, the
+block completing then included: past CAPTURE_BLOCKS - 2 each one is
+an overrun, its audio dropped, and the blocks held in the ring must
+reach the recording intact and in order.
+----------------------------------------------------------------------
+ */
+#include "test.h"
+#include "capture.h"
+#include "wav_file.h"
+#include <math.h>
+
+#define INPUT   "test_capture.wav"
+#define SECONDS 2U
+
+//Half a second of silence, then a DTMF '1' (697 and 1209 Hz): one voice change, one key.
+static void _WriteInput(void){
+	static int16_t samples[SECONDS * CAPTURE_SAMPLE_RATE];
+	uint32_t i;
+	for(i = CAPTURE_SAMPLE_RATE / 2U; i < SECONDS * CAPTURE_SAMPLE_RATE; i++){
+		samples[i] = (int16_t)(8000.0 * (sin(2.0 * M_PI * 697.0 * i / CAPTURE_SAMPLE_RATE)
+				+ sin(2.0 * M_PI * 1209.0 * i / CAPTURE_SAMPLE_RATE)));
+	}
+	CHECK(WAV_Write(INPUT, samples, SECONDS * CAPTURE_SAMPLE_RATE, CAPTURE_SAMPLE_RATE));
+}
+
+//{recording} is the pcm16 check line, NULL for the other formats.
+static void _Run(const char* tool, const char* options, const char* overruns, const char* kept, const char* recorded, const char* recording){
+	char command[512];
+	const char* const expected[] = {
+		"input: 32000 samples at 16000 Hz, 125 blocks",
+		overruns,
+		kept,
+		"voice changes: 1",
+		"dtmf keys: 1",
+		recorded,
+		recording,
+	};
+	snprintf(command, sizeof(command), "%s %s " INPUT " 2>/dev/null", tool, options);
+	TEST_Tool(command, expected, sizeof(expected) / sizeof(expected[0]) - (recording == NULL), 0);
+}
+
+int main(int argc, char** argv){
+	char command[512];
+	if(argc != 2){
+		printf("usage: %s <capture_sim>\n", argv[0]);
+		return 2;
+	}
+	_WriteInput();
+	_Run(argv[1], "-f pcm16", "overruns: 0", "kept: 125 blocks, 0 dropped", //the silence before the preroll left out: 95 blocks
+			"recorded: 48640 bytes, pcm16", "recording: 95 blocks, intact");
+	_Run(argv[1], "-f ulaw", "overruns: 0", "kept: 125 blocks, 0 dropped", "recorded: 24320 bytes, ulaw", NULL);
+	_Run(argv[1], "-f adpcm", "overruns: 0", "kept: 125 blocks, 0 dropped", "recorded: 12540 bytes, adpcm", NULL);
+	_Run(argv[1], "-s 5", "overruns: 0", "kept: 125 blocks, 0 dropped", //6 blocks waiting: the ring is full, not over
+			"recorded: 48640 bytes, pcm16", "recording: 95 blocks, intact");
+	_Run(argv[1], "-s 10", "overruns: 5", "kept: 120 blocks, 5 dropped",
+			"recorded: 46080 bytes, pcm16", "recording: 90 blocks, intact");
+	snprintf(command, sizeof(command), "%s -f mp3 " INPUT " 2>/dev/null", argv[1]);
+	TEST_Tool(command, NULL, 0, 2);
+	snprintf(command, sizeof(command), "%s %s 2>/dev/null", argv[1], argv[0]); //no WAV file
+	TEST_Tool(command, NULL, 0, 2);
+	return TEST_END();
+}
@@ -0,0 +1,178 @@
+/**
+ * test_clips.c
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+Clip library: images built by Tools/clips_pack, crc checks, and the
+lookup and start latencies
+----------------------------------------------------------------------
+Usage: test_clips <clips_pack>
+----------------------------------------------------------------------
+ */
+#include "test.h"
+#include "link.h"
+#include "clips.h"
+#include "mixer.h"
+#include "wav_file.h"
+
+#define INPUT       "test_clips.wav"
+#define INPUT_8K    "test_clips_8k.wav"
+#define INPUT_SHORT "test_clips_short.wav" //BENCH_CLIPS of them fit the region
+#define IMAGE       "test_clips.bin"
+#define SAMPLES     1000U
+#define BENCH_CLIPS 512U
+#define BENCH_RUNS  100U
+
+static TIM_HandleTypeDef _htim6;
+static DMA_HandleTypeDef _hdma;
+static DMA_Stream_TypeDef _stream;
+
+static void _WriteInputs(void){
+	static int16_t samples[SAMPLES];
+	uint32_t i;
+	for(i = 0; i < SAMPLES; i++) samples[i] = (int16_t)(i * 31U);
+	CHECK(WAV_Write(INPUT, samples, SAMPLES, 16000));
+	CHECK(WAV_Write(INPUT_8K, samples, SAMPLES, 8000));
+	CHECK(WAV_Write(INPUT_SHORT, samples, SAMPLES / 10U, 16000));
+}
+
+static void _Init(void){
+	LINK_Open(NULL);
+	memset(&_stream, 0, sizeof(_stream));
+	_hdma.Instance = &_stream;
+	_hdma.Init.Mode = DMA_CIRCULAR;
+	HAL_DMA_Init(&_hdma);
+	_htim6.Instance = TIM6;
+	_htim6.Init.Period = 5249;
+	_htim6.hdma[TIM_DMA_ID_UPDATE] = &_hdma;
+	PLAYBACK_Init(&_htim6);
+}
+
+//Runs the packer and loads the image it wrote into the CLIPS region. Without {expected}, its output is not checked.
+static void _Pack(const char* tool, const char* clips, const char* const* expected, uint32_t count){
+	char command[16384];
+	FILE* image;
+	snprintf(command, sizeof(command), "%s -o " IMAGE " %s %s", tool, clips, expected ? "2>/dev/null" : ">/dev/null");
+	TEST_Tool(command, expected, count, 0);
+	memset(_sclips, 0xFF, SIM_CLIPS_SIZE);
+	image = fopen(IMAGE, "rb");
+	CHECK(image != NULL);
+	if(image == NULL) return;
+	CHECK(fread(_sclips, 1, SIM_CLIPS_SIZE, image) > 0U);
+	fclose(image);
+}
+
+static void _TestPack(const char* tool){
+	static const char* const expected[] = {
+		"clip 1: pcm16, 16000 Hz, 1000 samples, 2000 bytes",
+		"clip 2: dac, 8000 Hz, 1000 samples, 2000 bytes",
+		"clip 7: ulaw, 16000 Hz, 1000 samples, 1000 bytes",
+		"clip 9: adpcm, 8000 Hz, 1000 samples, 516 bytes",
+		"image: 4 clips, 5612 bytes",
+	};
+	const CLIPS_EntryTypeDef* clip;
+	char command[1024];
+	_Init();
+	_Pack(tool, "9:adpcm:" INPUT_8K " 7:ulaw:" INPUT " 1:pcm16:" INPUT " 2:dac:" INPUT_8K, expected, 5);
+	CHECK_EQ(CLIPS_Init(), HAL_OK);
+	CHECK_EQ(CLIPS_GetCount(), 4U);
+	clip = CLIPS_Find(2);
+	CHECK(clip != NULL);
+	if(clip){
+		CHECK_EQ(clip->sampleRate, 8000U);
+		CHECK_EQ(((const uint16_t*)CLIPS_GetData(clip))[1], 31U ^ 0x8000U);
+	}
+	CHECK(CLIPS_Find(3) == NULL);
+	CHECK_EQ(CLIPS_Play(9, PLAYBACK_ROUTE_DAC), HAL_OK);
+	PLAYBACK_Stop();
+	snprintf(command, sizeof(command), "%s -o " IMAGE " 1:pcm16:" INPUT " 1:ulaw:" INPUT " 2>/dev/null", tool);
+	TEST_Tool(command, NULL, 0, 2); //id twice
+	snprintf(command, sizeof(command), "%s -o " IMAGE " 1:mp3:" INPUT " 2>/dev/null", tool);
+	TEST_Tool(command, NULL, 0, 2);
+}
+
+//A clip whose data fail their crc can neither play, mix nor be sent; the others are left alone.
+static void _TestCorrupt(const char* tool){
+	static const char* const expected[] = {
+		"clip 1: pcm16, 16000 Hz, 1000 samples, 2000 bytes",
+		"clip 2: pcm16, 16000 Hz, 1000 samples, 2000 bytes",
+		"image: 2 clips, 4056 bytes",
+	};
+	const CLIPS_EntryTypeDef* clip;
+	_Init();
+	_Pack(tool, "1:pcm16:" INPUT " 2:pcm16:" INPUT, expected, 3);
+	CHECK_EQ(CLIPS_Init(), HAL_OK);
+	clip = CLIPS_Find(2);
+	CHECK(clip != NULL);
+	if(clip == NULL) return;
+	_sclips[clip->offset + 100U] ^= 0x01U;
+	CHECK_EQ(CLIPS_Init(), HAL_OK);
+	CHECK_EQ(CLIPS_GetCount(), 2U);
+	CHECK(CLIPS_Find(2) == NULL);
+	CHECK_EQ(CLIPS_Play(2, PLAYBACK_ROUTE_DAC), HAL_ERROR);
+	CHECK_EQ(CLIPS_Mix(2, 0, MIXER_GAIN_UNITY, PLAYBACK_ROUTE_DAC), HAL_ERROR);
+	CHECK_EQ(OFFLOAD_Start(OFFLOAD_SOURCE_CLIP, 2), HAL_ERROR);
+	CHECK(!PLAYBACK_IsPlaying());
+	CHECK_EQ(CLIPS_Play(1, PLAYBACK_ROUTE_DAC), HAL_OK);
+	PLAYBACK_Stop();
+}
+
+//Mean CLIPS_Find() and CLIPS_Play() times over a full index, and the check of CLIPS_Init().
+static void _BenchLatency(const char* tool){
+	static char clips[BENCH_CLIPS * 32U];
+	uint32_t len = 0, i, run;
+	uint64_t start, lookup = 0, play[2] = {0, 0};
+	const char* formats[2] = {"dac", "adpcm"};
+	for(i = 0; i < BENCH_CLIPS; i++){
+		len += (uint32_t)snprintf(&clips[len], sizeof(clips) - len, "%u:%s:" INPUT_SHORT " ", 2U * i + 1U, formats[i & 1U]);
+	}
+	_Init();
+	_Pack(tool, clips, NULL, 0);
+	CHECK_EQ(CLIPS_Init(), HAL_OK);
+	CHECK_EQ(CLIPS_GetCount(), BENCH_CLIPS);
+	start = SIM_Nanoseconds();
+	for(run = 0; run < BENCH_RUNS; run++) CLIPS_Init();
+	BENCH("clips init, crc of every clip", (double)(SIM_Nanoseconds() - start) / BENCH_RUNS, "ns");
+	for(run = 0; run < BENCH_RUNS; run++){
+		for(i = 0; i < BENCH_CLIPS; i++){
+			start = SIM_Nanoseconds();
+			CHECK(CLIPS_Find((uint16_t)(2U * i + 1U)) != NULL);
+			lookup += SIM_Nanoseconds() - start;
+		}
+	}
+	BENCH("clips lookup, mean over the index", (double)lookup / (BENCH_RUNS * BENCH_CLIPS), "ns");
+	for(run = 0; run < BENCH_RUNS; run++){
+		for(i = 0; i < 2U; i++){
+			start = SIM_Nanoseconds();
+			CHECK_EQ(CLIPS_Play((uint16_t)(2U * (run * 2U + i) + 1U), PLAYBACK_ROUTE_DAC), HAL_OK);
+			play[i] += SIM_Nanoseconds() - start;
+			PLAYBACK_Stop();
+		}
+	}
+	BENCH("clips start, dac (direct)", (double)play[0] / BENCH_RUNS, "ns");
+	BENCH("clips start, adpcm (decoded)", (double)play[1] / BENCH_RUNS, "ns");
+}
+
+int main(int argc, char** argv){
+	if(argc != 2){
+		printf("usage: %s <clips_pack>\n", argv[0]);
+		return 2;
+	}
+	_WriteInputs();
+	_TestPack(argv[1]);
+	_TestCorrupt(argv[1]);
+	_BenchLatency(argv[1]);
+	return TEST_END();
+}
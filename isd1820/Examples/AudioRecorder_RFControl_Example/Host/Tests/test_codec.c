@@ -0,0 +1,230 @@
+/**
+ * test_codec.c
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+Codecs: bit-exact with the reference coders, odd blocks, and the
+cycles per sample
+----------------------------------------------------------------------
+The references are the plain C of the Sun g711.c (linear2ulaw(),
+ulaw2linear()) and of the Intel/DVI adpcm.c coder, packed low nibble
+first as in WAV files. Cycles are host time counted at SIM_CPU_HZ by
+DWT->CYCCNT: a sample lasts 5250 of them at 16kHz.
+----------------------------------------------------------------------
+ */
+#include "test.h"
+#include "codec.h"
+
+#define SIGNAL_SIZE  4096U
+#define BENCH_RUNS   2000U
+
+static const int16_t _REF_ulawEnd[8] = {0x3F, 0x7F, 0xFF, 0x1FF, 0x3FF, 0x7FF, 0xFFF, 0x1FFF};
+
+static const int16_t _REF_steps[89] = {
+	7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+	50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230,
+	253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963,
+	1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327,
+	3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442,
+	11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794,
+	32767
+};
+
+static const int _REF_indexes[16] = {-1, -1, -1, -1, 2, 4, 6, 8, -1, -1, -1, -1, 2, 4, 6, 8};
+
+static int16_t _signal[SIGNAL_SIZE];
+
+static uint8_t _RefLinear2Ulaw(int16_t pcm){
+	int value = pcm >> 2, mask, segment;
+	if(value < 0){
+		value = -value;
+		mask = 0x7F;
+	}else{
+		mask = 0xFF;
+	}
+	if(value > 8159) value = 8159;
+	value += 0x84 >> 2;
+	for(segment = 0; segment < 8 && value > _REF_ulawEnd[segment]; segment++);
+	if(segment >= 8) return (uint8_t)(0x7F ^ mask);
+	return (uint8_t)(((segment << 4) | ((value >> (segment + 1)) & 0xF)) ^ mask);
+}
+
+static int16_t _RefUlaw2Linear(uint8_t code){
+	int t;
+	code = (uint8_t)~code;
+	t = ((code & 0x0F) << 3) + 0x84;
+	t <<= (code & 0x70) >> 4;
+	return (int16_t)((code & 0x80) ? 0x84 - t : t - 0x84);
+}
+
+static void _RefAdpcmCoder(int* predictor, int* index, const int16_t* in, uint8_t* out, uint32_t count){
+	int step = _REF_steps[*index], diff, sign, delta, vpdiff;
+	uint32_t i;
+	for(i = 0; i < count; i++){
+		diff = in[i] - *predictor;
+		sign = (diff < 0) ? 8 : 0;
+		if(sign) diff = -diff;
+		delta = 0;
+		vpdiff = step >> 3;
+		if(diff >= step){ delta = 4; diff -= step; vpdiff += step; }
+		step >>= 1;
+		if(diff >= step){ delta |= 2; diff -= step; vpdiff += step; }
+		step >>= 1;
+		if(diff >= step){ delta |= 1; vpdiff += step; }
+		*predictor += sign ? -vpdiff : vpdiff;
+		if(*predictor > 32767) *predictor = 32767;
+		else if(*predictor < -32768) *predictor = -32768;
+		delta |= sign;
+		*index += _REF_indexes[delta];
+		if(*index < 0) *index = 0;
+		if(*index > 88) *index = 88;
+		step = _REF_steps[*index];
+		if(i & 1U) out[i / 2U] |= (uint8_t)(delta << 4);
+		else out[i / 2U] = (uint8_t)delta;
+	}
+}
+
+static void _RefAdpcmDecoder(int* predictor, int* index, const uint8_t* in, int16_t* out, uint32_t count){
+	int step = _REF_steps[*index], delta, vpdiff;
+	uint32_t i;
+	for(i = 0; i < count; i++){
+		delta = (i & 1U) ? in[i / 2U] >> 4 : in[i / 2U] & 0x0F;
+		*index += _REF_indexes[delta];
+		if(*index < 0) *index = 0;
+		if(*index > 88) *index = 88;
+		vpdiff = step >> 3;
+		if(delta & 4) vpdiff += step;
+		if(delta & 2) vpdiff += step >> 1;
+		if(delta & 1) vpdiff += step >> 2;
+		*predictor += (delta & 8) ? -vpdiff : vpdiff;
+		if(*predictor > 32767) *predictor = 32767;
+		else if(*predictor < -32768) *predictor = -32768;
+		step = _REF_steps[*index];
+		out[i] = (int16_t)*predictor;
+	}
+}
+
+//Speech-like sweeps with full-scale steps and clipping, so every ADPCM step size and both clamps are reached.
+static void _MakeSignal(void){
+	uint32_t lcg = 1, i;
+	int32_t value;
+	for(i = 0; i < SIGNAL_SIZE; i++){
+		lcg = lcg * 1103515245U + 12345U;
+		value = (int32_t)((lcg >> 16) & 0xFFFFU) - 32768;
+		if((i / 512U) & 1U) value >>= (i / 256U) % 12U; //quiet stretches
+		if(i % 1024U > 1000U) value = (i & 1U) ? 32767 : -32768;
+		_signal[i] = (int16_t)value;
+	}
+}
+
+static void _TestUlaw(void){
+	static int16_t in[65536] __ALIGNED(4), out[256] __ALIGNED(4);
+	static uint8_t codes[65536];
+	uint32_t i, errors = 0;
+	for(i = 0; i < 65536U; i++) in[i] = (int16_t)(i - 32768U);
+	CODEC_UlawEncode(in, codes, 65536U);
+	for(i = 0; i < 65536U; i++) errors += (codes[i] != _RefLinear2Ulaw(in[i]));
+	CHECK_EQ(errors, 0U);
+	for(i = 0; i < 256U; i++) codes[i] = (uint8_t)i;
+	CODEC_UlawDecode(codes, out, 256U);
+	for(i = 0; i < 256U; i++) errors += (out[i] != _RefUlaw2Linear((uint8_t)i));
+	CHECK_EQ(errors, 0U);
+}
+
+static void _TestAdpcm(void){
+	static uint8_t codes[SIGNAL_SIZE / 2U], expected[SIGNAL_SIZE / 2U];
+	static int16_t out[SIGNAL_SIZE] __ALIGNED(4), reference[SIGNAL_SIZE];
+	CODEC_AdpcmStateTypeDef state = {0, 0};
+	int predictor = 0, index = 0;
+	uint32_t i, errors = 0;
+	_RefAdpcmCoder(&predictor, &index, _signal, expected, SIGNAL_SIZE);
+	CODEC_AdpcmEncode(&state, _signal, codes, SIGNAL_SIZE);
+	CHECK_EQ(memcmp(codes, expected, sizeof(codes)), 0);
+	CHECK_EQ(state.predictor, predictor);
+	CHECK_EQ(state.index, index);
+	predictor = index = 0;
+	state.predictor = 0;
+	state.index = 0;
+	_RefAdpcmDecoder(&predictor, &index, expected, reference, SIGNAL_SIZE);
+	CODEC_AdpcmDecode(&state, expected, out, SIGNAL_SIZE);
+	for(i = 0; i < SIGNAL_SIZE; i++) errors += (out[i] != reference[i]);
+	CHECK_EQ(errors, 0U);
+	CHECK_EQ(state.predictor, predictor);
+	CHECK_EQ(state.index, index);
+}
+
+//An odd count is encoded whole, in CODEC_BlockSize() bytes, and decodes back to the same samples.
+static void _TestOddBlock(void){
+	static const int16_t in[5] = {1000, -2000, 3000, -4000, 5000};
+	uint8_t block[CODEC_MAX_BLOCK_SIZE] __ALIGNED(4);
+	int16_t out[CODEC_BLOCK_SAMPLES] __ALIGNED(4);
+	CODEC_AdpcmStateTypeDef state = {0, 0};
+	int predictor = 0, index = 0;
+	uint8_t expected[3];
+	int16_t reference[5];
+	uint32_t i, errors = 0;
+	CHECK_EQ(CODEC_EncodeBlock(CODEC_FORMAT_ULAW, &state, in, 5, block), 5U);
+	CHECK_EQ(CODEC_BlockSize(CODEC_FORMAT_ULAW, 5), 5U);
+	CHECK_EQ(block[4], _RefLinear2Ulaw(5000));
+	CHECK_EQ(CODEC_DecodeBlock(CODEC_FORMAT_ULAW, block, 5, out), 5U);
+	CHECK_EQ(out[4], _RefUlaw2Linear(block[4]));
+	CHECK_EQ(CODEC_EncodeBlock(CODEC_FORMAT_IMA_ADPCM, &state, in, 5, block), CODEC_ADPCM_HEADER_SIZE + 3U);
+	CHECK_EQ(CODEC_BlockSize(CODEC_FORMAT_IMA_ADPCM, 5), CODEC_ADPCM_HEADER_SIZE + 3U);
+	_RefAdpcmCoder(&predictor, &index, in, expected, 5);
+	CHECK_EQ(memcmp(&block[CODEC_ADPCM_HEADER_SIZE], expected, 3), 0);
+	CHECK_EQ(block[CODEC_ADPCM_HEADER_SIZE + 2U] >> 4, 0);
+	CHECK_EQ(state.predictor, predictor);
+	CHECK_EQ(CODEC_DecodeBlock(CODEC_FORMAT_IMA_ADPCM, block, CODEC_ADPCM_HEADER_SIZE + 3U, out), 6U); //the pad nibble too
+	predictor = index = 0;
+	_RefAdpcmDecoder(&predictor, &index, expected, reference, 5);
+	for(i = 0; i < 5U; i++) errors += (out[i] != reference[i]);
+	CHECK_EQ(errors, 0U);
+}
+
+//Cycles per sample of a full block, each format, both ways.
+static void _BenchBlocks(void){
+	static const CODEC_FormatTypeDef formats[3] = {CODEC_FORMAT_PCM16, CODEC_FORMAT_ULAW, CODEC_FORMAT_IMA_ADPCM};
+	static const char* const names[3] = {"pcm16", "ulaw", "adpcm"};
+	uint8_t block[CODEC_MAX_BLOCK_SIZE] __ALIGNED(4);
+	int16_t out[CODEC_BLOCK_SAMPLES] __ALIGNED(4);
+	CODEC_AdpcmStateTypeDef state = {0, 0};
+	uint32_t f, run, size = 0, start, encode, decode;
+	char name[64];
+	for(f = 0; f < 3U; f++){
+		encode = decode = 0;
+		for(run = 0; run < BENCH_RUNS; run++){
+			const int16_t* in = &_signal[(run * CODEC_BLOCK_SAMPLES) % SIGNAL_SIZE];
+			start = DWT->CYCCNT;
+			size = CODEC_EncodeBlock(formats[f], &state, in, CODEC_BLOCK_SAMPLES, block);
+			encode += DWT->CYCCNT - start;
+			start = DWT->CYCCNT;
+			CHECK_EQ(CODEC_DecodeBlock(formats[f], block, size, out), CODEC_BLOCK_SAMPLES);
+			decode += DWT->CYCCNT - start;
+		}
+		snprintf(name, sizeof(name), "codec %s encode, per sample", names[f]);
+		BENCH(name, (double)encode / (BENCH_RUNS * CODEC_BLOCK_SAMPLES), "cycles");
+		snprintf(name, sizeof(name), "codec %s decode, per sample", names[f]);
+		BENCH(name, (double)decode / (BENCH_RUNS * CODEC_BLOCK_SAMPLES), "cycles");
+	}
+}
+
+int main(void){
+	_MakeSignal();
+	_TestUlaw();
+	_TestAdpcm();
+	_TestOddBlock();
+	_BenchBlocks();
+	return TEST_END();
+}
@@ -0,0 +1,224 @@
+/**
+ * test_dtmf.c
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+DTMF: keys in WAV files by Sim/dtmf_sim, clean and noisy, false
+triggers, and tones still heard after an erase
+----------------------------------------------------------------------
+Usage: test_dtmf <dtmf_sim>
+----------------------------------------------------------------------
+The key sequence is every key, 100ms tones 100ms apart, each tone
+peaking at -13dBFS, alone and under white noise 10dB below the tones.
+The latency of a key is from its tone's start to the end of the block
+that reports it. False triggers are counted over a minute of noise, and of
+vowel-like harmonics, with no key in them.
+----------------------------------------------------------------------
+ */
+#include "test.h"
+#include "capture.h"
+#include "recorder.h"
+#include "flash_writer.h"
+#include "dtmf.h"
+#include "wav_file.h"
+#include <math.h>
+
+#define RATE       CAPTURE_SAMPLE_RATE
+#define KEYS       "123A456B789C*0#D"
+#define TONE_MS    100U
+#define GAP_MS     100U
+#define LEAD_MS    300U   //before the first key
+#define FALSE_S    60U    //seconds of input without keys
+#define INPUT      "test_dtmf.wav"
+#define MAX_LENGTH (FALSE_S * RATE)
+#define BLOCK_MS   (CAPTURE_BLOCK_SIZE * 1000U / RATE)
+
+typedef struct {
+	char key;
+	uint32_t ms;
+} KeyTypeDef;
+
+static const double _rows[4] = {697.0, 770.0, 852.0, 941.0};
+static const double _columns[4] = {1209.0, 1336.0, 1477.0, 1633.0};
+static const char _keypad[4][5] = {"123A", "456B", "789C", "*0#D"};
+
+static int16_t _samples[MAX_LENGTH];
+static uint32_t _lcg = 1;
+static char _key;
+
+extern DMA_HandleTypeDef hdma_adc1;
+
+void DTMF_KeyCallback(char key){
+	_key = key;
+}
+
+void HAL_FLASH_EndOfOperationCallback(uint32_t value){
+	FLASHWR_EndOfOperationCallback(value);
+}
+
+//Uniform white noise, {rms} full scale.
+static double _Noise(double rms){
+	_lcg = _lcg * 1103515245U + 12345U;
+	return ((double)((_lcg >> 8) & 0xFFFFU) / 32768.0 - 1.0) * rms * sqrt(3.0);
+}
+
+static void _Tone(char key, double* frame, uint32_t count, uint32_t offset){
+	uint32_t r, c, i;
+	for(r = 0; r < 4U; r++){
+		for(c = 0; c < 4U; c++){
+			if(_keypad[r][c] != key) continue;
+			for(i = 0; i < count; i++){
+				frame[i] += 0.22 * (sin(2.0 * M_PI * _rows[r] * (offset + i) / RATE) + sin(2.0 * M_PI * _columns[c] * (offset + i) / RATE));
+			}
+		}
+	}
+}
+
+//Writes the key sequence, under noise of {noise} rms, and returns its length.
+static uint32_t _WriteKeys(double noise){
+	static double frame[MAX_LENGTH];
+	uint32_t length = (LEAD_MS + (TONE_MS + GAP_MS) * (sizeof(KEYS) - 1U)) * (RATE / 1000U), k, i, start;
+	memset(frame, 0, length * sizeof(double));
+	for(k = 0; k < sizeof(KEYS) - 1U; k++){
+		start = (LEAD_MS + (TONE_MS + GAP_MS) * k) * (RATE / 1000U);
+		_Tone(KEYS[k], &frame[start], TONE_MS * (RATE / 1000U), start);
+	}
+	for(i = 0; i < length; i++) _samples[i] = (int16_t)((frame[i] + _Noise(noise)) * 32767.0);
+	CHECK(WAV_Write(INPUT, _samples, length, RATE));
+	return length;
+}
+
+//Runs the sim on INPUT. Returns the key count and fills {keys}.
+static uint32_t _Run(const char* tool, KeyTypeDef* keys, uint32_t max){
+	char command[512], line[256], key;
+	uint32_t n = 0, total = 0;
+	unsigned ms, count;
+	FILE* out;
+	snprintf(command, sizeof(command), "%s " INPUT " 2>/dev/null", tool);
+	out = popen(command, "r");
+	CHECK(out != NULL);
+	if(out == NULL) return 0;
+	while(fgets(line, sizeof(line), out)){
+		if(sscanf(line, "key %c at %u ms", &key, &ms) == 2){
+			if(n < max){
+				keys[n].key = key;
+				keys[n].ms = ms;
+			}
+			n++;
+		}else if(sscanf(line, "keys: %u", &count) == 1){
+			total = count;
+		}else if(strncmp(line, "bench ", 6) == 0){
+			fputs(line, stdout);
+		}
+	}
+	CHECK_EQ(WEXITSTATUS(pclose(out)), 0);
+	CHECK_EQ(total, n);
+	return n;
+}
+
+//Every key once, in order, DTMF_ON_BLOCKS blocks after its tone starts, give or take the block it starts in. Returns the mean latency.
+static double _CheckKeys(const char* tool){
+	KeyTypeDef keys[64];
+	uint32_t n = _Run(tool, keys, 64), k, latency, total = 0;
+	CHECK_EQ(n, sizeof(KEYS) - 1U);
+	if(n != sizeof(KEYS) - 1U) return 0;
+	for(k = 0; k < n; k++){
+		CHECK_EQ(keys[k].key, KEYS[k]);
+		latency = keys[k].ms - (LEAD_MS + (TONE_MS + GAP_MS) * k);
+		CHECK(latency >= (DTMF_ON_BLOCKS - 1U) * BLOCK_MS && latency <= (DTMF_ON_BLOCKS + 1U) * BLOCK_MS);
+		total += latency;
+	}
+	return (double)total / n;
+}
+
+static void _TestKeys(const char* tool){
+	_WriteKeys(0);
+	BENCH("dtmf latency, clean, mean", _CheckKeys(tool), "ms");
+	_WriteKeys(0.22 / 3.16); //each tone 0.22 peak, 0.156 rms: the pair at 0.22 rms, 10dB over the noise
+	BENCH("dtmf latency, 10dB SNR, mean", _CheckKeys(tool), "ms");
+}
+
+//Vowel-like: a 120Hz voice with harmonics falling 6dB per octave, its pitch drifting, under a little noise.
+static void _WriteVowels(void){
+	uint32_t i, h;
+	double phase = 0, pitch, v;
+	for(i = 0; i < MAX_LENGTH; i++){
+		pitch = 120.0 + 30.0 * sin(2.0 * M_PI * 0.7 * i / RATE);
+		phase += 2.0 * M_PI * pitch / RATE;
+		v = 0;
+		for(h = 1; h <= 25U; h++) v += 0.3 / h * sin(h * phase);
+		_samples[i] = (int16_t)((v + _Noise(0.01)) * 32767.0);
+	}
+	CHECK(WAV_Write(INPUT, _samples, MAX_LENGTH, RATE));
+}
+
+static void _TestFalseTriggers(const char* tool){
+	KeyTypeDef keys[64];
+	uint32_t i, n;
+	for(i = 0; i < MAX_LENGTH; i++) _samples[i] = (int16_t)(_Noise(0.2) * 32767.0);
+	CHECK(WAV_Write(INPUT, _samples, MAX_LENGTH, RATE));
+	n = _Run(tool, keys, 64);
+	CHECK_EQ(n, 0U);
+	BENCH("dtmf false triggers, white noise at -14dBFS", (double)n * 60U / FALSE_S, "per minute");
+	_WriteVowels();
+	n = _Run(tool, keys, 64);
+	CHECK(n <= 1U);
+	BENCH("dtmf false triggers, vowels", (double)n * 60U / FALSE_S, "per minute");
+}
+
+//Listening for tones, stopped by an erase, is back once the erase ends.
+static void _TestErase(void){
+	static TIM_HandleTypeDef htim2;
+	uint16_t block[CAPTURE_BLOCK_SIZE];
+	double frame[CAPTURE_BLOCK_SIZE];
+	uint32_t b, i;
+	SIM_Reset();
+	htim2.Instance = TIM2;
+	CAPTURE_Init(&htim2);
+	FLASHWR_Init();
+	CHECK_EQ(RECORDER_ListenTones(1), HAL_OK);
+	CHECK_EQ(RECORDER_Erase(), HAL_OK);
+	CHECK_EQ(SIM_DmaReceive(&hdma_adc1, block, sizeof(block)), 0U); //capture stopped for the erase
+	while(SIM_FlashEraseStep());
+	RECORDER_Process(); //from HAL_FLASH_EndOfOperationCallback(), on the board
+	_key = 0;
+	for(b = 0; b < 4U; b++){
+		memset(frame, 0, sizeof(frame));
+		_Tone('5', frame, CAPTURE_BLOCK_SIZE, b * CAPTURE_BLOCK_SIZE);
+		for(i = 0; i < CAPTURE_BLOCK_SIZE; i++) block[i] = ((uint16_t)(int16_t)(frame[i] * 32767.0) ^ 0x8000U) & 0xFFF0U;
+		CHECK_EQ(SIM_DmaReceive(&hdma_adc1, block, sizeof(block)), 1U);
+		RECORDER_Process();
+	}
+	CHECK_EQ(_key, '5');
+	RECORDER_ListenTones(0);
+	CHECK_EQ(RECORDER_Erase(), HAL_OK); //no listening to restore
+	while(SIM_FlashEraseStep());
+	RECORDER_Process();
+	CHECK_EQ(SIM_DmaReceive(&hdma_adc1, block, sizeof(block)), 0U);
+}
+
+int main(int argc, char** argv){
+	char command[512];
+	if(argc != 2){
+		printf("usage: %s <dtmf_sim>\n", argv[0]);
+		return 2;
+	}
+	_TestKeys(argv[1]);
+	_TestFalseTriggers(argv[1]);
+	_TestErase();
+	snprintf(command, sizeof(command), "%s %s 2>/dev/null", argv[1], argv[0]); //no WAV file
+	TEST_Tool(command, NULL, 0, 2);
+	return TEST_END();
+}
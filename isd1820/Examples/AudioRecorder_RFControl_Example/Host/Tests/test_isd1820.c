@@ -0,0 +1,251 @@
+/**
+ * test_isd1820.c
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+ISD1820 driver: preemption, cancellation and their latency, and the
+cost of sequences
+----------------------------------------------------------------------
+ */
+#include "test.h"
+#include "isd1820.h"
+#include "main.h"
+
+#define LATENCY_ROUNDS   50U
+#define LATENCY_REQUESTS 1000U  //short rounds: most see no host interrupt
+#define LATENCY_BOUND_NS 10000U //best round: a few us on the target, a few hundred ns here
+#define RESUME_STEPS     250U   //steps of the resume bench sequence
+
+static TIM_HandleTypeDef htim5;
+static uint32_t _completed, _aborted;
+static uint32_t _cancelAt;
+static uint64_t _releasedAt;
+static uint16_t _watchPin;
+
+void ISD1820_OperationCpltCallback(uint32_t status){
+	_completed = status;
+}
+
+void ISD1820_OperationAbortCallback(uint32_t status){
+	_aborted = status;
+}
+
+void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef* htim){
+	if(htim == &htim5) ISD1820_AsyncTimHandler();
+}
+
+static void _GpioHook(GPIO_TypeDef* port, uint16_t pin, GPIO_PinState state){
+	UNUSED(port);
+	if(pin == _watchPin && state == GPIO_PIN_RESET && !_releasedAt) _releasedAt = SIM_Nanoseconds();
+}
+
+static void _TickHook(uint32_t tick){
+	if(_cancelAt && tick >= _cancelAt){ //"interrupt" in the middle of the busy-wait
+		_cancelAt = 0;
+		ISD1820_Cancel();
+	}
+}
+
+static uint8_t _Pin(GPIO_TypeDef* port, uint16_t pin){
+	return HAL_GPIO_ReadPin(port, pin) == GPIO_PIN_SET;
+}
+
+static void _Setup(void){
+	SIM_Reset();
+	htim5.Instance = TIM5;
+	TIM5->PSC = 8399U; //10kHz
+	ISD1820_SetPolicy(ISD1820_POLICY_RECORD_PREEMPTS_PLAY);
+	ISD1820_AsyncInit(&htim5);
+	_completed = 0;
+	_aborted = 0;
+}
+
+static void _TestPolicies(void){
+	uint32_t play;
+	_Setup();
+	CHECK_EQ(ISD1820_PlayAsync(ISD1820_AsyncMsToCounts(1000)), HAL_OK);
+	play = ISD1820_GetStatus();
+	CHECK(_Pin(PL_GPIO_Port, PL_Pin));
+	CHECK_EQ(ISD1820_PlayAsync(ISD1820_AsyncMsToCounts(1000)), HAL_BUSY); //play does not replace play
+	CHECK_EQ(ISD1820_RecordAsync(ISD1820_AsyncMsToCounts(1000)), HAL_OK); //record preempts play
+	CHECK_EQ(_aborted, play);
+	CHECK(!_Pin(PL_GPIO_Port, PL_Pin));
+	CHECK(_Pin(REC_GPIO_Port, REC_Pin));
+	CHECK_EQ(ISD1820_PlayAsync(ISD1820_AsyncMsToCounts(1000)), HAL_BUSY); //nothing preempts record
+
+	ISD1820_SetPolicy(ISD1820_POLICY_REJECT_IF_BUSY);
+	CHECK_EQ(ISD1820_RecordAsync(ISD1820_AsyncMsToCounts(1000)), HAL_BUSY);
+	ISD1820_Cancel();
+	CHECK(!_Pin(REC_GPIO_Port, REC_Pin));
+	CHECK(!SIM_TimRunning(&htim5));
+
+	ISD1820_SetPolicy(ISD1820_POLICY_PLAY_REPLACES_PLAY);
+	CHECK_EQ(ISD1820_PlayAsync(ISD1820_AsyncMsToCounts(1000)), HAL_OK);
+	play = ISD1820_GetStatus();
+	_aborted = 0;
+	CHECK_EQ(ISD1820_PlayAsync(ISD1820_AsyncMsToCounts(1000)), HAL_OK);
+	CHECK_EQ(_aborted, play);
+	CHECK(ISD1820_STATUS_GEN(ISD1820_GetStatus()) != ISD1820_STATUS_GEN(play)); //same op, same deadline: a new operation all the same
+	ISD1820_Cancel();
+}
+
+static void _TestAsync(void){
+	static const ISD1820_StepTypeDef steps[] = {{ISD1820_OP_PLAY, 500}, {ISD1820_OP_IDLE, 100}, {ISD1820_OP_PLAY, 500}};
+	static const ISD1820_StepTypeDef pauses[] = {{ISD1820_OP_PLAY, 500}, {ISD1820_OP_IDLE, 0}, {ISD1820_OP_PLAY, 500}};
+	uint32_t status;
+	_Setup();
+	CHECK_EQ(ISD1820_RecordAsync(ISD1820_AsyncMsToCounts(1000)), HAL_OK);
+	status = ISD1820_GetStatus();
+	CHECK_EQ(TIM5->ARR, 9999U);
+	CHECK(SIM_TimExpire(&htim5));
+	CHECK_EQ(_completed, status);
+	CHECK(!_Pin(REC_GPIO_Port, REC_Pin));
+	CHECK(!(ISD1820_GetStatus() & ISD1820_STATUS_BUSY));
+
+	//ended early: the timer must not end the next operation, nor run the rest of the sequence
+	CHECK_EQ(ISD1820_SequenceStart(steps, 3), HAL_OK);
+	ISD1820_StopPlaying();
+	CHECK(!_Pin(PL_GPIO_Port, PL_Pin));
+	CHECK(!SIM_TimRunning(&htim5));
+	CHECK(!ISD1820_SequenceActive());
+	CHECK_EQ(ISD1820_StartRecording(), HAL_OK);
+	status = ISD1820_GetStatus();
+	ISD1820_AsyncTimHandler(); //stale update event
+	CHECK_EQ(ISD1820_GetStatus(), status);
+	CHECK(_Pin(REC_GPIO_Port, REC_Pin));
+	ISD1820_StopRecording();
+
+	//sequence to the end
+	CHECK_EQ(ISD1820_SequenceStart(steps, 3), HAL_OK);
+	CHECK(SIM_TimExpire(&htim5));
+	CHECK(!_Pin(PL_GPIO_Port, PL_Pin));
+	CHECK(SIM_TimExpire(&htim5));
+	CHECK(_Pin(PL_GPIO_Port, PL_Pin));
+	CHECK(SIM_TimExpire(&htim5));
+	CHECK(!ISD1820_SequenceActive());
+	CHECK(!SIM_TimRunning(&htim5));
+
+	//0ms and sub-tick steps still count: ARR at 0 would never raise the update event
+	CHECK_EQ(ISD1820_AsyncMsToCounts(0), 1U);
+	CHECK_EQ(ISD1820_PlayAsync(0), HAL_ERROR);
+	CHECK(!(ISD1820_GetStatus() & ISD1820_STATUS_BUSY));
+	CHECK_EQ(ISD1820_SequenceStart(pauses, 3), HAL_OK);
+	CHECK(SIM_TimExpire(&htim5));
+	CHECK_EQ(TIM5->ARR, 1U);
+	CHECK(SIM_TimExpire(&htim5));
+	CHECK(_Pin(PL_GPIO_Port, PL_Pin));
+	CHECK(SIM_TimExpire(&htim5));
+	CHECK(!ISD1820_SequenceActive());
+	CHECK(!(ISD1820_GetStatus() & ISD1820_STATUS_BUSY));
+
+	//the timer fails to start: nothing is left claimed
+	SIM_timStartResult = HAL_ERROR;
+	CHECK_EQ(ISD1820_RecordAsync(ISD1820_AsyncMsToCounts(1000)), HAL_ERROR);
+	CHECK(!(ISD1820_GetStatus() & ISD1820_STATUS_BUSY));
+	CHECK(!_Pin(REC_GPIO_Port, REC_Pin));
+	CHECK_EQ(ISD1820_SequenceStart(steps, 3), HAL_ERROR);
+	CHECK(!ISD1820_SequenceActive());
+	SIM_timStartResult = HAL_OK;
+	CHECK_EQ(ISD1820_RecordAsync(ISD1820_AsyncMsToCounts(1000)), HAL_OK);
+	ISD1820_Cancel();
+}
+
+static void _TestBlocking(void){
+	uint32_t start;
+	_Setup();
+	SIM_tickStep = 1U;
+	SIM_tickHook = _TickHook;
+	_cancelAt = 50U;
+	start = uwTick;
+	CHECK_EQ(ISD1820_Play(1000), HAL_ERROR); //cancelled from an "interrupt"
+	CHECK(uwTick - start < 55U); //returns on the next poll, not at the end of the 1s
+	CHECK(_aborted & ISD1820_STATUS_BUSY);
+	CHECK(!_Pin(PL_GPIO_Port, PL_Pin));
+	CHECK_EQ(ISD1820_Record(100), HAL_OK);
+	CHECK(!_Pin(REC_GPIO_Port, REC_Pin));
+}
+
+//Time from the request to the pin release, worst case of each round, best round kept: the host scheduler only adds.
+static uint64_t _Latency(uint8_t preempt){
+	uint64_t best = UINT64_MAX, worst, start, elapsed;
+	uint32_t round, i;
+	for(round = 0; round < LATENCY_ROUNDS; round++){
+		worst = 0;
+		for(i = 0; i < LATENCY_REQUESTS; i++){
+			ISD1820_PlayAsync(ISD1820_AsyncMsToCounts(1000));
+			_releasedAt = 0;
+			start = SIM_Nanoseconds();
+			if(preempt){
+				ISD1820_RecordAsync(ISD1820_AsyncMsToCounts(1000));
+			}else{
+				ISD1820_Cancel();
+			}
+			elapsed = _releasedAt - start;
+			if(elapsed > worst) worst = elapsed;
+			ISD1820_Cancel();
+		}
+		if(worst < best) best = worst;
+	}
+	return best;
+}
+
+static void _TestLatency(void){
+	uint64_t cancel, preempt;
+	_Setup();
+	_watchPin = PL_Pin;
+	SIM_gpioHook = _GpioHook;
+	cancel = _Latency(0);
+	preempt = _Latency(1);
+	BENCH("isd1820 cancel to PL low, worst", cancel, "ns");
+	BENCH("isd1820 record preempting play to PL low, worst", preempt, "ns");
+	CHECK(cancel < LATENCY_BOUND_NS);
+	CHECK(preempt < LATENCY_BOUND_NS);
+}
+
+//Time from the update event of one step to the next step running, from ISD1820_AsyncTimHandler(), best round mean.
+static void _TestResume(void){
+	static ISD1820_StepTypeDef steps[RESUME_STEPS];
+	uint64_t best = UINT64_MAX, start, total;
+	uint32_t round, i;
+	_Setup();
+	for(i = 0; i < RESUME_STEPS; i++){
+		steps[i].op = (i & 1U) ? ISD1820_OP_IDLE : ISD1820_OP_PLAY;
+		steps[i].duration = 100U;
+	}
+	for(round = 0; round < LATENCY_ROUNDS; round++){
+		CHECK_EQ(ISD1820_SequenceStart(steps, RESUME_STEPS), HAL_OK);
+		total = 0;
+		for(i = 1; i < RESUME_STEPS; i++){
+			start = SIM_Nanoseconds();
+			ISD1820_AsyncTimHandler();
+			total += SIM_Nanoseconds() - start;
+		}
+		CHECK(ISD1820_SequenceActive()); //on the last step
+		ISD1820_AsyncTimHandler();
+		CHECK(!ISD1820_SequenceActive());
+		if(total < best) best = total;
+	}
+	BENCH("isd1820 sequence step to step, from the timer interrupt", (double)best / (RESUME_STEPS - 1U), "ns");
+	BENCH("isd1820 sequence state", sizeof(ISD1820_SequenceTypeDef), "bytes"); //8 on the target, its pointers 4 bytes, whatever the step count: the table stays in flash
+}
+
+int main(void){
+	_TestPolicies();
+	_TestAsync();
+	_TestBlocking();
+	_TestLatency();
+	_TestResume();
+	return TEST_END();
+}
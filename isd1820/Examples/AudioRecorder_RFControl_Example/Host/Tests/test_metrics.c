@@ -0,0 +1,86 @@
+/**
+ * test_metrics.c
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+Histograms: buckets, and dumps through a full telemetry stream
+----------------------------------------------------------------------
+ */
+#include "test.h"
+#include "link.h"
+#include "metrics.h"
+
+#define HISTOGRAM METRICS_CLIP_LOOKUP
+
+static uint32_t _received[METRICS_BUCKETS];
+static uint32_t _records;
+
+static void _Histogram(const uint8_t* frame, uint16_t len){
+	uint32_t values[TELEM_MAX_VALUES + 1U], count, i;
+	if(frame[0] != TELEM_REC_HISTOGRAM) return;
+	count = LINK_Values(frame, len, values, TELEM_MAX_VALUES + 1U);
+	CHECK(count >= 4U); //tick, histogram, first bucket, a count
+	CHECK_EQ(values[1], HISTOGRAM);
+	for(i = 3; i < count && values[2] + i - 3U < METRICS_BUCKETS; i++){
+		_received[values[2] + i - 3U] += values[i];
+		CHECK(values[i] != 0); //runs of empty buckets are skipped
+	}
+	_records++;
+}
+
+static void _TestBuckets(void){
+	CHECK_EQ(METRICS_Bucket(7), 7U);
+	CHECK_EQ(METRICS_Bucket(8), 8U);
+	CHECK_EQ(METRICS_Bucket(15), 15U);
+	CHECK_EQ(METRICS_Bucket(16), 16U);
+	CHECK_EQ(METRICS_Bucket(17), 16U); //2 per bucket from 16
+	CHECK_EQ(METRICS_Bucket(18), 17U);
+	CHECK_EQ(METRICS_Bucket((1UL << METRICS_RANGE_BITS) - 1U), METRICS_BUCKETS - 1U);
+	CHECK_EQ(METRICS_Bucket(0xFFFFFFFFU), METRICS_BUCKETS - 1U);
+}
+
+static void _TestDump(void){
+	uint32_t expected[METRICS_BUCKETS], bucket, polls;
+	LINK_Open(_Histogram);
+	memset(_received, 0, sizeof(_received));
+	_records = 0;
+	METRICS_Reset(HISTOGRAM);
+	for(bucket = 0; bucket < METRICS_BUCKETS; bucket++){
+		expected[bucket] = bucket % 7U; //runs of 6 buckets: records of 6 counts
+		_METRICS_histograms[HISTOGRAM][bucket] = expected[bucket];
+	}
+	while(TELEM_Record(TELEM_REC_DRIVER, (const uint32_t[]){0}, 1) == HAL_OK); //stream full
+	CHECK_EQ(METRICS_Dump(HISTOGRAM, 1), HAL_OK);
+	CHECK_EQ(METRICS_Dump(HISTOGRAM, 0), HAL_BUSY);
+	CHECK_EQ(METRICS_Dump(METRICS_COUNT, 0), HAL_ERROR);
+	for(polls = 0; polls < 100U && _records < METRICS_BUCKETS / 7U + 1U; polls++){
+		LINK_Pump();
+		if(polls == 0) METRICS_Record(HISTOGRAM, 3); //recorded during the dump
+		METRICS_DumpPoll(0);
+	}
+	LINK_Pump();
+	CHECK(polls > 1U); //the stream was full: the dump had to be resumed
+	for(bucket = 0; bucket < METRICS_BUCKETS; bucket++){
+		CHECK(_received[bucket] >= expected[bucket]); //nothing lost
+		CHECK_EQ(_METRICS_histograms[HISTOGRAM][bucket] + _received[bucket], expected[bucket] + (bucket == 3U)); //reset takes off what was sent only
+	}
+	CHECK_EQ(METRICS_Dump(HISTOGRAM, 0), HAL_OK); //done: a new dump starts
+}
+
+int main(void){
+	_TestBuckets();
+	_TestDump();
+	return TEST_END();
+}
@@ -0,0 +1,149 @@
+/**
+ * test_mixer.c
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+Mixer: the SIMD kernel against a scalar reference, streams joining and
+ending, and the refill time
+----------------------------------------------------------------------
+The reference mixes one sample at a time, as the kernel is specified:
+out = sat16(out + (in * gain >> 15)), in * gain an arithmetic shift.
+The SIMD intrinsics are portable C on the host (see Shim/), so the
+kernel does not beat the reference here: the benches track each of
+them over time, the target gain shows in METRICS_MIX_BLOCK.
+----------------------------------------------------------------------
+ */
+#include "test.h"
+#include "mixer.h"
+
+#define SIGNAL_SIZE 1024U
+#define BENCH_RUNS  2000U
+
+static int16_t _signal[4][SIGNAL_SIZE] __ALIGNED(4);
+
+static void _RefMix(int16_t* out, const int16_t* in, uint32_t count, uint16_t gain){
+	int32_t sample;
+	uint32_t i;
+	for(i = 0; i < count; i++){
+		sample = out[i] + ((gain >= MIXER_GAIN_UNITY) ? in[i] : ((int32_t)in[i] * gain) >> 15);
+		out[i] = (int16_t)((sample > 32767) ? 32767 : (sample < -32768) ? -32768 : sample);
+	}
+}
+
+//Loud noise, so the sums clip often, with the extremes in every stream.
+static void _MakeSignals(void){
+	uint32_t lcg = 7, s, i;
+	for(s = 0; s < 4U; s++){
+		for(i = 0; i < SIGNAL_SIZE; i++){
+			lcg = lcg * 1103515245U + 12345U;
+			_signal[s][i] = (int16_t)((lcg >> 16) & 0xFFFFU);
+		}
+		_signal[s][s] = 32767;
+		_signal[s][s + 4U] = -32768;
+	}
+}
+
+static void _TestKernel(void){
+	static const uint16_t gains[] = {0, 1, 0x2000, 0x4000, 0x7FFF, MIXER_GAIN_UNITY, 0xFFFF};
+	static const uint32_t counts[] = {0, 1, 2, 3, 255, SIGNAL_SIZE};
+	static int16_t out[SIGNAL_SIZE] __ALIGNED(4), reference[SIGNAL_SIZE];
+	uint32_t g, c, i, errors = 0;
+	for(g = 0; g < sizeof(gains) / sizeof(gains[0]); g++){
+		for(c = 0; c < sizeof(counts) / sizeof(counts[0]); c++){
+			memcpy(out, _signal[1], sizeof(out));
+			memcpy(reference, _signal[1], sizeof(reference));
+			MIXER_Mix(out, _signal[0], counts[c], gains[g]);
+			_RefMix(reference, _signal[0], counts[c], gains[g]);
+			for(i = 0; i < SIGNAL_SIZE; i++) errors += (out[i] != reference[i]); //and nothing past {count}
+		}
+	}
+	CHECK_EQ(errors, 0U);
+}
+
+static uint32_t _sourceLeft;
+
+static uint32_t _Source(int16_t* buffer, uint32_t count){
+	uint32_t n = (count > _sourceLeft) ? _sourceLeft : count;
+	memcpy(buffer, _signal[3], n * sizeof(int16_t));
+	_sourceLeft -= n;
+	return n;
+}
+
+//Three clips of different lengths and a source, against the reference sum, until the last one ends.
+static void _TestStreams(void){
+	static const uint16_t gains[4] = {MIXER_GAIN_UNITY, 0x6000, 0x1234, 0x4000};
+	static const uint32_t lengths[4] = {PLAYBACK_HALF_SIZE + 3U, 2U * PLAYBACK_HALF_SIZE, 5U, PLAYBACK_HALF_SIZE / 2U};
+	static int16_t out[PLAYBACK_HALF_SIZE] __ALIGNED(4), reference[PLAYBACK_HALF_SIZE];
+	uint32_t block, s, n, offset, errors = 0, i;
+	_sourceLeft = lengths[3];
+	for(s = 0; s < 3U; s++) CHECK_EQ(MIXER_AddClip((uint8_t)s, _signal[s], lengths[s], gains[s]), HAL_OK);
+	CHECK_EQ(MIXER_AddSource(3, _Source, gains[3]), HAL_OK);
+	CHECK_EQ(MIXER_AddClip(0, _signal[0], 1, MIXER_GAIN_UNITY), HAL_BUSY);
+	CHECK_EQ(MIXER_AddClip(MIXER_STREAMS, _signal[0], 1, MIXER_GAIN_UNITY), HAL_ERROR);
+	for(block = 0; block < 2U; block++){
+		CHECK_EQ(MIXER_Source(out, PLAYBACK_HALF_SIZE), PLAYBACK_HALF_SIZE);
+		memset(reference, 0, sizeof(reference));
+		offset = block * PLAYBACK_HALF_SIZE;
+		for(s = 0; s < 4U; s++){
+			n = (lengths[s] > offset) ? lengths[s] - offset : 0;
+			if(n > PLAYBACK_HALF_SIZE) n = PLAYBACK_HALF_SIZE;
+			_RefMix(reference, &_signal[s][(s == 3U) ? 0 : offset], n, gains[s]);
+		}
+		for(i = 0; i < PLAYBACK_HALF_SIZE; i++) errors += (out[i] != reference[i]);
+	}
+	CHECK_EQ(errors, 0U);
+	CHECK_EQ(MIXER_Source(out, PLAYBACK_HALF_SIZE), 0U); //every stream ran out in the second block
+	CHECK_EQ(MIXER_AddClip(0, _signal[0], 1, MIXER_GAIN_UNITY), HAL_OK); //free again
+	MIXER_Remove(0);
+	CHECK_EQ(MIXER_Source(out, PLAYBACK_HALF_SIZE), 0U);
+}
+
+//Kernel against the reference, per sample, and a refill of every stream.
+static void _Bench(void){
+	static int16_t out[SIGNAL_SIZE] __ALIGNED(4);
+	static const uint16_t gains[2] = {0x4000, MIXER_GAIN_UNITY};
+	static const char* const names[2][2] = {
+		{"mixer kernel, gain 0.5, per sample", "mixer reference, gain 0.5, per sample"},
+		{"mixer kernel, unity gain, per sample", "mixer reference, unity gain, per sample"},
+	};
+	uint64_t start, time;
+	uint32_t g, run, s;
+	for(g = 0; g < 2U; g++){
+		memset(out, 0, sizeof(out));
+		start = SIM_Nanoseconds();
+		for(run = 0; run < BENCH_RUNS; run++) MIXER_Mix(out, _signal[run & 3U], SIGNAL_SIZE, gains[g]);
+		time = SIM_Nanoseconds() - start;
+		BENCH(names[g][0], (double)time / (BENCH_RUNS * SIGNAL_SIZE), "ns");
+		start = SIM_Nanoseconds();
+		for(run = 0; run < BENCH_RUNS; run++) _RefMix(out, _signal[run & 3U], SIGNAL_SIZE, gains[g]);
+		time = SIM_Nanoseconds() - start;
+		BENCH(names[g][1], (double)time / (BENCH_RUNS * SIGNAL_SIZE), "ns");
+	}
+	start = SIM_Nanoseconds();
+	for(run = 0; run < BENCH_RUNS; run++){
+		for(s = 0; s < MIXER_STREAMS; s++) MIXER_AddClip((uint8_t)s, _signal[s], PLAYBACK_HALF_SIZE, 0x4000);
+		MIXER_Source(out, PLAYBACK_HALF_SIZE);
+		for(s = 0; s < MIXER_STREAMS; s++) MIXER_Remove((uint8_t)s);
+	}
+	BENCH("mixer refill, 4 clip streams, per half", (double)(SIM_Nanoseconds() - start) / BENCH_RUNS, "ns");
+}
+
+int main(void){
+	_MakeSignals();
+	_TestKernel();
+	_TestStreams();
+	_Bench();
+	return TEST_END();
+}
@@ -0,0 +1,154 @@
+/**
+ * test_offload.c
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+Audio offload: clips of a library built by Tools/clips_pack, pulled
+off the board by Sim/offload_sim as WAV files, with bit errors, and how
+busy the line stays
+----------------------------------------------------------------------
+Usage: test_offload <clips_pack> <offload_sim>
+----------------------------------------------------------------------
+The file must be the clip as the board plays it: the samples given for
+PCM16 and DAC clips, the Core decoder's for ADPCM, at the clip rate.
+The line must stay busy, over 95% of the transfer, while the window
+covers the round trip to the host, and the sim must show it when it
+does not.
+----------------------------------------------------------------------
+ */
+#include "test.h"
+#include "codec.h"
+#include "offload.h"
+#include "wav_file.h"
+#include <math.h>
+
+#define INPUT    "test_offload.wav"
+#define INPUT_8K "test_offload_8k.wav"
+#define IMAGE    "test_offload.bin"
+#define OUTPUT   "test_offload_out.wav"
+#define SAMPLES  32000U //2s at 16kHz, 4s at 8kHz
+
+typedef struct {
+	unsigned taken, dropped, bad, requests, size;
+	double busy;
+} SimTypeDef;
+
+static int16_t _samples[SAMPLES];
+
+//Runs the sim with {options} on clip {id} of IMAGE, to OUTPUT. Returns its exit status and fills {sim}.
+static int _Run(const char* tool, const char* options, uint32_t id, SimTypeDef* sim){
+	char command[512], line[256];
+	FILE* out;
+	memset(sim, 0, sizeof(*sim));
+	snprintf(command, sizeof(command), "%s %s " IMAGE " %u " OUTPUT " 2>/dev/null", tool, options, id);
+	out = popen(command, "r");
+	CHECK(out != NULL);
+	if(out == NULL) return -1;
+	while(fgets(line, sizeof(line), out)){
+		if(sscanf(line, "frames: %u taken, %u dropped, %u bad, %u resends asked", &sim->taken, &sim->dropped, &sim->bad, &sim->requests) == 4) continue;
+		if(sscanf(line, "file: %u bytes", &sim->size) == 1) continue;
+		if(sscanf(line, "line: %lf%% busy", &sim->busy) == 1) continue;
+		if(strncmp(line, "bench ", 6) == 0) fputs(line, stdout);
+	}
+	return WEXITSTATUS(pclose(out));
+}
+
+//Checks OUTPUT against {count} {expected} samples at {rate} Hz.
+static void _CheckOutput(const int16_t* expected, uint32_t count, uint32_t rate){
+	uint32_t outRate, outCount;
+	int16_t* output = WAV_Read(OUTPUT, &outRate, &outCount);
+	CHECK(output != NULL);
+	if(output == NULL) return;
+	CHECK_EQ(outRate, rate);
+	CHECK_EQ(outCount, count);
+	if(outCount == count) CHECK_EQ(memcmp(output, expected, count * sizeof(int16_t)), 0);
+	free(output);
+}
+
+static void _Pack(const char* tool){
+	char command[512];
+	uint32_t i;
+	for(i = 0; i < SAMPLES; i++) _samples[i] = (int16_t)(20000.0 * sin(i * 0.05) + (int32_t)(i * 7919U % 2001U) - 1000);
+	CHECK(WAV_Write(INPUT, _samples, SAMPLES, 16000));
+	CHECK(WAV_Write(INPUT_8K, _samples, SAMPLES / 2U, 8000));
+	snprintf(command, sizeof(command), "%s -o " IMAGE " 1:pcm16:" INPUT " 2:adpcm:" INPUT " 3:dac:" INPUT_8K " >/dev/null", tool);
+	TEST_Tool(command, NULL, 0, 0);
+}
+
+//Every format comes off as the board plays it, at its rate, the line busy from the command to the last frame.
+static void _TestFormats(const char* tool){
+	static int16_t decoded[SAMPLES];
+	uint8_t adpcm[CODEC_MAX_BLOCK_SIZE];
+	CODEC_AdpcmStateTypeDef state = {0, 0};
+	uint32_t i, n;
+	SimTypeDef sim;
+	CHECK_EQ(_Run(tool, "", 1, &sim), 0);
+	_CheckOutput(_samples, SAMPLES, 16000);
+	CHECK_EQ(sim.taken, 1U + SAMPLES / OFFLOAD_FRAME_SAMPLES + (SAMPLES % OFFLOAD_FRAME_SAMPLES != 0));
+	CHECK_EQ(sim.size, 44U + SAMPLES * 2U);
+	CHECK_EQ(sim.dropped + sim.bad + sim.requests, 0U);
+	CHECK(sim.busy >= 95.0);
+	for(i = 0; i < SAMPLES; i += n){ //as clips_pack encodes and offload.c decodes, a block at a time
+		n = SAMPLES - i;
+		if(n > CODEC_BLOCK_SAMPLES) n = CODEC_BLOCK_SAMPLES;
+		CODEC_DecodeBlock(CODEC_FORMAT_IMA_ADPCM, adpcm, CODEC_EncodeBlock(CODEC_FORMAT_IMA_ADPCM, &state, &_samples[i], n, adpcm), &decoded[i]);
+	}
+	CHECK_EQ(_Run(tool, "", 2, &sim), 0);
+	_CheckOutput(decoded, SAMPLES, 16000);
+	CHECK_EQ(_Run(tool, "", 3, &sim), 0);
+	_CheckOutput(_samples, SAMPLES / 2U, 8000);
+}
+
+//The window covers a 30ms round trip with the line still saturated, not a 60ms one.
+static void _TestSaturation(const char* tool){
+	SimTypeDef sim;
+	CHECK_EQ(_Run(tool, "-r 30", 1, &sim), 0);
+	CHECK(sim.busy >= 95.0);
+	BENCH("offload line use, 30ms round trip", sim.busy, "%");
+	CHECK_EQ(_Run(tool, "-r 60", 1, &sim), 0);
+	CHECK(sim.busy < 90.0);
+	BENCH("offload line use, 60ms round trip", sim.busy, "%");
+	CHECK_EQ(_Run(tool, "-b 921600", 1, &sim), 0);
+	CHECK(sim.busy >= 95.0);
+}
+
+//Frames failing their crc are asked again: the file still comes off whole.
+static void _TestErrors(const char* tool){
+	SimTypeDef sim;
+	CHECK_EQ(_Run(tool, "-x 5", 1, &sim), 0);
+	_CheckOutput(_samples, SAMPLES, 16000);
+	CHECK(sim.bad > 0U);
+	CHECK(sim.requests > 0U);
+	CHECK_EQ(_Run(tool, "-x 20 -r 10", 1, &sim), 0);
+	_CheckOutput(_samples, SAMPLES, 16000);
+	BENCH("offload line use, 20% of frames hit", sim.busy, "%");
+}
+
+int main(int argc, char** argv){
+	char command[512];
+	SimTypeDef sim;
+	if(argc != 3){
+		printf("usage: %s <clips_pack> <offload_sim>\n", argv[0]);
+		return 2;
+	}
+	_Pack(argv[1]);
+	_TestFormats(argv[2]);
+	_TestSaturation(argv[2]);
+	_TestErrors(argv[2]);
+	CHECK_EQ(_Run(argv[2], "", 9, &sim), 2); //no such clip
+	snprintf(command, sizeof(command), "%s " IMAGE " 2>/dev/null", argv[2]);
+	TEST_Tool(command, NULL, 0, 2);
+	return TEST_END();
+}
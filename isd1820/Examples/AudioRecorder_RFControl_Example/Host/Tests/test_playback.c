@@ -0,0 +1,233 @@
+/**
+ * test_playback.c
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+Playback: TIM6 rates, underruns of a source fed late, DMA errors,
+and no erase while playing
+----------------------------------------------------------------------
+The underrun harness runs the DMA refills on a sample clock while a
+producer, as the main loop would, adds chunks to a ring the source
+reads, each up to {jitter} late, {prefill} ahead of the DAC. It
+checks every underrun is counted and the DAC gets every sample, in
+order, with silence only where the ring ran dry.
+----------------------------------------------------------------------
+ */
+#include "test.h"
+#include "playback.h"
+#include "recorder.h"
+#include "capture.h"
+#include "flash_writer.h"
+#include "main.h"
+
+#define TICKS        5250U //TIM6 ticks per sample at 16kHz, 84MHz
+#define RING_SIZE    4096U
+#define CHUNK        64U   //samples per producer chunk
+#define CHUNKS       2000U
+#define REFILL_RUNS  1000U
+#define BUFFERED     (2U * PLAYBACK_HALF_SIZE) //samples PLAYBACK_Start() takes
+
+static TIM_HandleTypeDef _htim6, _htim2;
+static DMA_HandleTypeDef _hdma;
+static DMA_Stream_TypeDef _stream;
+static uint32_t _completions;
+
+static int16_t _ring[RING_SIZE];
+static uint32_t _written;  //samples produced
+static uint32_t _read;     //samples taken by the source
+static uint8_t _ended;     //the producer is done
+static uint32_t _starved;  //refills the ring could not serve in full
+
+void PLAYBACK_CompleteCallback(void){
+	_completions++;
+}
+
+void HAL_FLASH_EndOfOperationCallback(uint32_t value){
+	FLASHWR_EndOfOperationCallback(value);
+}
+
+//Never 0, so the silence of an underrun stands out.
+static int16_t _Sample(uint32_t n){
+	return (int16_t)(1U + n % 30000U);
+}
+
+//Reads the ring. A dry ring gives one sample of silence, as a live source would, rather than 0, which ends playback.
+static uint32_t _RingSource(int16_t* buffer, uint32_t count){
+	uint32_t n = _written - _read, i;
+	if(n < count && !_ended) _starved++;
+	if(n == 0){
+		if(_ended) return 0;
+		buffer[0] = 0;
+		return 1;
+	}
+	if(n > count) n = count;
+	for(i = 0; i < n; i++) buffer[i] = _ring[(_read + i) % RING_SIZE];
+	_read += n;
+	if(!_ended) return n;
+	memset(&buffer[n], 0, (count - n) * sizeof(int16_t)); //end of the stream, not an underrun
+	return count;
+}
+
+static void _Init(void){
+	SIM_Reset();
+	memset(&_stream, 0, sizeof(_stream));
+	_hdma.Instance = &_stream;
+	_hdma.Init.Mode = DMA_CIRCULAR;
+	HAL_DMA_Init(&_hdma);
+	_htim6.Instance = TIM6;
+	_htim6.Init.Period = TICKS - 1U;
+	_htim6.hdma[TIM_DMA_ID_UPDATE] = &_hdma;
+	PLAYBACK_Init(&_htim6);
+	_completions = 0;
+}
+
+static void _TestRate(void){
+	static const uint16_t samples[4] = {0x8000, 0x8000, 0x8000, 0x8000};
+	_Init();
+	CHECK_EQ(PLAYBACK_StartDirect(samples, 4, 8000, PLAYBACK_ROUTE_DAC), HAL_OK);
+	CHECK_EQ(TIM6->ARR, 2U * TICKS - 1U);
+	PLAYBACK_Stop();
+	CHECK_EQ(PLAYBACK_StartClip((const int16_t*)samples, 4, PLAYBACK_ROUTE_DAC), HAL_OK);
+	CHECK_EQ(TIM6->ARR, TICKS - 1U); //back to 16kHz, not kept at 8kHz
+	PLAYBACK_Stop();
+	CHECK_EQ(PLAYBACK_StartDirect(samples, 4, 1300, PLAYBACK_ROUTE_DAC), HAL_OK);
+	CHECK_EQ(TIM6->ARR, TICKS * 16000U / 1300U - 1U);
+	PLAYBACK_Stop();
+	CHECK_EQ(PLAYBACK_StartDirect(samples, 4, 1200, PLAYBACK_ROUTE_DAC), HAL_ERROR); //over 65536 ticks
+	CHECK_EQ(PLAYBACK_StartDirect(samples, 4, TICKS * 16000U + 1U, PLAYBACK_ROUTE_DAC), HAL_ERROR); //under 1 tick
+	CHECK_EQ(PLAYBACK_StartDirect(samples, 4, 0, PLAYBACK_ROUTE_DAC), HAL_ERROR);
+	CHECK(!PLAYBACK_IsPlaying());
+}
+
+//Checks the half of the DMA buffer just refilled against the stream produced, silence aside.
+static void _CheckHalf(const uint16_t* half, uint32_t* next){
+	uint32_t i;
+	int16_t sample;
+	for(i = 0; i < PLAYBACK_HALF_SIZE; i++){
+		sample = (int16_t)(half[i] ^ 0x8000U);
+		if(sample != 0 && sample != _Sample((*next)++)){
+			CHECK_EQ(sample, _Sample(*next - 1U));
+			return;
+		}
+	}
+}
+
+//Plays CHUNKS chunks, chunk k due at sample k * CHUNK - prefill, up to {jitter} samples late. Returns the underruns.
+static uint32_t _RunUnderrun(uint32_t jitter, uint32_t prefill){
+	uint32_t chunk = 0, now = 0, next = 0, due = 0, lcg = 12345, underruns, i;
+	const uint16_t* buffer = NULL;
+	_Init();
+	underruns = PLAYBACK_GetUnderruns();
+	_written = _read = _starved = 0;
+	_ended = 0;
+	while(!_completions){
+		while(chunk < CHUNKS && due <= now + prefill){ //the main loop, between two refills
+			for(i = 0; i < CHUNK; i++) _ring[(_written + i) % RING_SIZE] = _Sample(_written + i);
+			_written += CHUNK;
+			chunk++;
+			lcg = lcg * 1103515245U + 12345U;
+			i = chunk * CHUNK + (lcg >> 16) % (jitter + 1U);
+			if(i > due) due = i; //in order: a late chunk delays the next
+		}
+		_ended = (chunk == CHUNKS);
+		if(now == 0){
+			CHECK_EQ(PLAYBACK_Start(_RingSource, PLAYBACK_ROUTE_DAC), HAL_OK);
+			buffer = (const uint16_t*)(uintptr_t)_stream.M0AR;
+			_CheckHalf(buffer, &next);
+			_CheckHalf(buffer + PLAYBACK_HALF_SIZE, &next);
+		}else{
+			SIM_DmaComplete(&_hdma, (now / PLAYBACK_HALF_SIZE) & 1U); //first half out, then the second
+			if(!_completions) _CheckHalf(buffer + ((now / PLAYBACK_HALF_SIZE) & 1U ? 0 : PLAYBACK_HALF_SIZE), &next);
+		}
+		now += PLAYBACK_HALF_SIZE;
+	}
+	CHECK_EQ(next, CHUNKS * CHUNK); //every sample played
+	CHECK_EQ(PLAYBACK_GetUnderruns() - underruns, _starved);
+	CHECK(!PLAYBACK_IsPlaying());
+	CHECK_EQ(_completions, 1U);
+	return _starved;
+}
+
+static void _TestUnderrun(void){
+	CHECK_EQ(_RunUnderrun(0, BUFFERED), 0U);                             //on time: the DMA buffer is enough
+	CHECK(_RunUnderrun(BUFFERED, BUFFERED) > 0U);                        //16ms late, no margin
+	CHECK_EQ(_RunUnderrun(BUFFERED, 2U * BUFFERED), 0U);                 //16ms late, 16ms ahead
+	BENCH("playback underruns, 8ms jitter, no margin", _RunUnderrun(PLAYBACK_HALF_SIZE, BUFFERED), "refills");
+	BENCH("playback underruns, 32ms jitter, 16ms margin", _RunUnderrun(2U * BUFFERED, 2U * BUFFERED), "refills");
+}
+
+static uint32_t _SilenceSource(int16_t* buffer, uint32_t count){
+	memset(buffer, 0, count * sizeof(int16_t));
+	return count;
+}
+
+//A transfer error stops the stream: playback ends, feed-through is released, and the next start runs.
+static void _TestError(void){
+	static const uint16_t samples[4] = {0x8000, 0x8000, 0x8000, 0x8000};
+	uint32_t errors;
+	_Init();
+	errors = PLAYBACK_GetErrors();
+	CHECK_EQ(PLAYBACK_Start(_SilenceSource, PLAYBACK_ROUTE_FEEDTHROUGH), HAL_OK);
+	CHECK_EQ(HAL_GPIO_ReadPin(FT_GPIO_Port, FT_Pin), GPIO_PIN_SET);
+	CHECK_EQ(SIM_DmaError(&_hdma), 1U);
+	CHECK(!PLAYBACK_IsPlaying());
+	CHECK_EQ(HAL_GPIO_ReadPin(FT_GPIO_Port, FT_Pin), GPIO_PIN_RESET);
+	CHECK_EQ(_completions, 1U);
+	CHECK_EQ(PLAYBACK_GetErrors() - errors, 1U);
+	CHECK_EQ(PLAYBACK_StartDirect(samples, 4, PLAYBACK_SAMPLE_RATE, PLAYBACK_ROUTE_DAC), HAL_OK);
+	CHECK_EQ(SIM_DmaError(&_hdma), 1U);
+	CHECK(!PLAYBACK_IsPlaying());
+	CHECK_EQ(_completions, 2U);
+	CHECK_EQ(PLAYBACK_GetErrors() - errors, 2U);
+	CHECK_EQ(PLAYBACK_Start(_SilenceSource, PLAYBACK_ROUTE_DAC), HAL_OK);
+	PLAYBACK_Stop();
+}
+
+//The erase stalls the CPU for seconds: refused while the DAC plays.
+static void _TestErase(void){
+	static const int16_t samples[4] = {1, 2, 3, 4};
+	_Init();
+	_htim2.Instance = TIM2;
+	CAPTURE_Init(&_htim2);
+	FLASHWR_Init();
+	CHECK_EQ(PLAYBACK_StartClip(samples, 4, PLAYBACK_ROUTE_DAC), HAL_OK);
+	CHECK_EQ(RECORDER_Erase(), HAL_BUSY);
+	CHECK_EQ(FLASHWR_GetState(), FLASHWR_STATE_ERASED);
+	PLAYBACK_Stop();
+	CHECK_EQ(RECORDER_Erase(), HAL_OK);
+	CHECK_EQ(FLASHWR_GetState(), FLASHWR_STATE_ERASING);
+	while(SIM_FlashEraseStep());
+	CHECK_EQ(FLASHWR_GetState(), FLASHWR_STATE_ERASED);
+}
+
+static void _BenchRefill(void){
+	uint64_t start;
+	uint32_t i;
+	_Init();
+	CHECK_EQ(PLAYBACK_Start(_SilenceSource, PLAYBACK_ROUTE_DAC), HAL_OK);
+	start = SIM_Nanoseconds();
+	for(i = 0; i < REFILL_RUNS; i++) SIM_DmaComplete(&_hdma, i & 1U);
+	BENCH("playback refill from memory, per half", (double)(SIM_Nanoseconds() - start) / REFILL_RUNS, "ns");
+	PLAYBACK_Stop();
+}
+
+int main(void){
+	_TestRate();
+	_TestUnderrun();
+	_TestError();
+	_TestErase();
+	_BenchRefill();
+	return TEST_END();
+}
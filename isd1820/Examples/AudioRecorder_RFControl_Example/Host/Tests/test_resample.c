@@ -0,0 +1,129 @@
+/**
+ * test_resample.c
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+Resampler: lengths, passband and aliasing of each table, and the
+throughput
+----------------------------------------------------------------------
+Each input rate converts tones to 16kHz: 1kHz must come out at full
+level, 10kHz, above the output Nyquist, must not alias back.
+Levels are RMS, past the filter's start up.
+----------------------------------------------------------------------
+ */
+#include "test.h"
+#include "resample.h"
+#include <math.h>
+
+#define OUT_RATE    16000U
+#define SECONDS     1U
+#define ALIAS_HZ    10000U //over the output Nyquist, under the input one from 22.05kHz on
+#define SETTLE      100U   //output samples left out of the levels
+#define BENCH_RUNS  20U
+
+static int16_t _input[48000U * SECONDS];
+static uint32_t _inputLength, _inputPos;
+static int16_t _output[2U * OUT_RATE * SECONDS];
+
+static uint32_t _Input(int16_t* buffer, uint32_t count){
+	uint32_t n = _inputLength - _inputPos;
+	if(n > count) n = count;
+	memcpy(buffer, &_input[_inputPos], n * sizeof(int16_t));
+	_inputPos += n;
+	return n;
+}
+
+static void _Tone(uint32_t rate, double hz){
+	uint32_t i;
+	_inputLength = rate * SECONDS;
+	for(i = 0; i < _inputLength; i++) _input[i] = (int16_t)(16384.0 * sin(2.0 * M_PI * hz * i / rate));
+}
+
+//Converts the whole input, RESAMPLE_BLOCK_SIZE outputs at a time as a playback source would. Returns the output count.
+static uint32_t _Convert(uint32_t inRate){
+	static RESAMPLE_StateTypeDef state;
+	uint32_t produced = 0, n;
+	_inputPos = 0;
+	CHECK_EQ(RESAMPLE_Init(&state, _Input, inRate, OUT_RATE), HAL_OK);
+	do{
+		n = RESAMPLE_Read(&state, &_output[produced], RESAMPLE_BLOCK_SIZE);
+		produced += n;
+	}while(n == RESAMPLE_BLOCK_SIZE && produced + RESAMPLE_BLOCK_SIZE <= sizeof(_output) / sizeof(_output[0]));
+	return produced;
+}
+
+//Output level relative to the 16384 peak of the input tone.
+static double _Level(uint32_t count){
+	double sum = 0;
+	uint32_t i;
+	for(i = SETTLE; i + SETTLE < count; i++) sum += (double)_output[i] * _output[i];
+	return sqrt(sum / (count - 2U * SETTLE)) * sqrt(2.0) / 16384.0;
+}
+
+static void _TestRates(void){
+	static const uint32_t rates[] = {6400, 16000, 16500, 22050, 32000, 44100, 48000};
+	uint32_t r, count, expected;
+	double level;
+	for(r = 0; r < sizeof(rates) / sizeof(rates[0]); r++){
+		_Tone(rates[r], 1000.0);
+		count = _Convert(rates[r]);
+		expected = (uint32_t)((uint64_t)_inputLength * OUT_RATE / rates[r]);
+		CHECK(count + 2U >= expected && count <= expected + 2U);
+		level = _Level(count);
+		if(level < 0.97 || level > 1.03) printf("%u Hz: 1kHz at %.3f\n", rates[r], level);
+		CHECK(level > 0.97 && level < 1.03);
+		if(rates[r] < 2U * ALIAS_HZ) continue;
+		_Tone(rates[r], ALIAS_HZ);
+		level = _Level(_Convert(rates[r]));
+		if(level > 0.01) printf("%u Hz: alias at %.4f\n", rates[r], level);
+		CHECK(level < 0.01); //40dB down
+	}
+}
+
+static void _TestLimits(void){
+	static RESAMPLE_StateTypeDef state;
+	CHECK_EQ(RESAMPLE_Init(&state, _Input, 48000, 16000), HAL_OK);
+	CHECK_EQ(RESAMPLE_Init(&state, _Input, 48001, 16000), HAL_ERROR);
+	CHECK_EQ(RESAMPLE_Init(&state, _Input, 0, 16000), HAL_ERROR);
+	CHECK_EQ(RESAMPLE_Init(&state, _Input, 16000, 16000), HAL_OK);
+	CHECK_EQ(RESAMPLE_SetStep(&state, 0x10400), HAL_OK);  //drift
+	CHECK_EQ(RESAMPLE_SetStep(&state, 0x18000), HAL_ERROR); //past the table picked
+	CHECK_EQ(RESAMPLE_SetStep(&state, 0), HAL_ERROR);
+}
+
+//Host time per output sample, and the share of real time at the output rate.
+static void _Bench(void){
+	static const uint32_t rates[] = {8000, 16000, 32000, 48000};
+	uint64_t start, time;
+	uint32_t r, run, count = 0;
+	char name[64];
+	for(r = 0; r < sizeof(rates) / sizeof(rates[0]); r++){
+		_Tone(rates[r], 1000.0);
+		start = SIM_Nanoseconds();
+		for(run = 0; run < BENCH_RUNS; run++) count = _Convert(rates[r]);
+		time = SIM_Nanoseconds() - start;
+		snprintf(name, sizeof(name), "resample %u to 16000 Hz, per output sample", rates[r]);
+		BENCH(name, (double)time / (BENCH_RUNS * count), "ns");
+		snprintf(name, sizeof(name), "resample %u to 16000 Hz, share of real time", rates[r]);
+		BENCH(name, time / 1e9 / BENCH_RUNS / SECONDS * 100.0, "%");
+	}
+}
+
+int main(void){
+	_TestRates();
+	_TestLimits();
+	_Bench();
+	return TEST_END();
+}
@@ -0,0 +1,143 @@
+/**
+ * test_scheduler.c
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+Scheduler: ordering, timers and event throughput
+----------------------------------------------------------------------
+ */
+#include "test.h"
+#include "scheduler.h"
+
+#define BENCH_EVENTS 2000000UL
+
+static uint32_t _log[64];
+static uint32_t _logCount;
+static volatile uint32_t _sink;
+
+static void _Log(uint32_t arg){
+	if(_logCount < 64U) _log[_logCount++] = arg;
+}
+
+static void _PostHigh(uint32_t arg){ //a handler posting, as an interrupt would
+	_Log(arg);
+	SCHED_Post(SCHED_PRIO_HIGH, _Log, arg + 1U);
+}
+
+static void _Nop(uint32_t arg){
+	_sink += arg;
+}
+
+static void _Drain(void){
+	while(SCHED_RunOnce());
+}
+
+static void _TestOrder(void){
+	uint32_t i;
+	SIM_Reset();
+	SCHED_Init();
+	_logCount = 0;
+	SCHED_Post(SCHED_PRIO_LOW, _Log, 30);
+	SCHED_Post(SCHED_PRIO_NORMAL, _Log, 20);
+	SCHED_Post(SCHED_PRIO_NORMAL, _PostHigh, 21);
+	SCHED_Post(SCHED_PRIO_HIGH, _Log, 10);
+	SCHED_Post(SCHED_PRIO_NORMAL, _Log, 23);
+	_Drain();
+	CHECK_EQ(_logCount, 6U);
+	CHECK_EQ(_log[0], 10U);
+	CHECK_EQ(_log[1], 20U);
+	CHECK_EQ(_log[2], 21U);
+	CHECK_EQ(_log[3], 22U); //high priority posted from a handler runs before the older normal one
+	CHECK_EQ(_log[4], 23U);
+	CHECK_EQ(_log[5], 30U);
+
+	for(i = 0; i < SCHED_QUEUE_SIZE - 1U; i++){
+		CHECK_EQ(SCHED_Post(SCHED_PRIO_LOW, _Nop, i), HAL_OK);
+	}
+	CHECK_EQ(SCHED_Post(SCHED_PRIO_LOW, _Nop, i), HAL_BUSY);
+	CHECK_EQ(SCHED_GetDropped(), 1U);
+	CHECK_EQ(SCHED_Post(SCHED_PRIO_HIGH, _Nop, i), HAL_OK); //queues are independent
+	_Drain();
+}
+
+static void _TestTimers(void){
+	SIM_Reset();
+	SCHED_Init();
+	_logCount = 0;
+	CHECK_EQ(SCHED_TimerStart(0, 10, 0, _Log, 1), HAL_OK);
+	CHECK_EQ(SCHED_TimerStart(1, 5, 20, _Log, 2), HAL_OK);
+	CHECK_EQ(SCHED_TimerStart(SCHED_TIMERS, 5, 0, _Log, 3), HAL_ERROR);
+	uwTick = 4;
+	_Drain();
+	CHECK_EQ(_logCount, 0U);
+	uwTick = 10;
+	_Drain();
+	CHECK_EQ(_logCount, 2U);
+	uwTick = 100; //late: a periodic timer catches up, one period per run (25, 45, 65, 85)
+	CHECK(SCHED_RunOnce());
+	CHECK_EQ(_logCount, 3U);
+	_Drain();
+	CHECK_EQ(_logCount, 6U);
+	CHECK_EQ(_log[5], 2U);
+	SCHED_TimerStop(1);
+	uwTick = 1000;
+	_Drain();
+	CHECK_EQ(_logCount, 6U);
+}
+
+static void _TestThroughput(void){
+	uint64_t start, elapsed;
+	uint32_t i, j;
+	SIM_Reset();
+	SCHED_Init();
+	start = SIM_Nanoseconds();
+	for(i = 0; i < BENCH_EVENTS; i++){
+		SCHED_Post(SCHED_PRIO_NORMAL, _Nop, i);
+		SCHED_RunOnce();
+	}
+	elapsed = SIM_Nanoseconds() - start;
+	BENCH("sched post + run, one at a time", (double)elapsed / BENCH_EVENTS, "ns/event");
+	BENCH("sched throughput, one at a time", BENCH_EVENTS * 1e3 / (double)elapsed, "Mevents/s");
+	CHECK((double)elapsed / BENCH_EVENTS < 1000.0);
+
+	start = SIM_Nanoseconds();
+	for(i = 0; i < BENCH_EVENTS; i += SCHED_QUEUE_SIZE - 1U){
+		for(j = 0; j < SCHED_QUEUE_SIZE - 1U; j++){
+			SCHED_Post((SCHED_PriorityTypeDef)(j % SCHED_PRIO_COUNT), _Nop, j);
+		}
+		_Drain();
+	}
+	elapsed = SIM_Nanoseconds() - start;
+	BENCH("sched throughput, bursts over 3 queues", BENCH_EVENTS * 1e3 / (double)elapsed, "Mevents/s");
+	CHECK_EQ(SCHED_GetDropped(), 0U);
+
+	for(i = 0; i < SCHED_TIMERS; i++){ //every timer armed: the cost of the timer pass on each run
+		SCHED_TimerStart((uint8_t)i, 1000000U, 0, _Nop, 0);
+	}
+	start = SIM_Nanoseconds();
+	for(i = 0; i < BENCH_EVENTS; i++){
+		SCHED_Post(SCHED_PRIO_NORMAL, _Nop, i);
+		SCHED_RunOnce();
+	}
+	elapsed = SIM_Nanoseconds() - start;
+	BENCH("sched post + run, all timers armed", (double)elapsed / BENCH_EVENTS, "ns/event");
+}
+
+int main(void){
+	_TestOrder();
+	_TestTimers();
+	_TestThroughput();
+	return TEST_END();
+}
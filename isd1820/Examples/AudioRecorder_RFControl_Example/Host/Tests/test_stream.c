@@ -0,0 +1,301 @@
+/**
+ * test_stream.c
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+Host stream: sequence numbers and acknowledges over USART2, an
+ISD1820 programmed end to end from frames, and the host sender against
+the firmware in Sim/stream_sim: lost frames, clock drift and jitter
+----------------------------------------------------------------------
+Usage: test_stream <stream_sim>
+----------------------------------------------------------------------
+Every frame goes through the command parser (see link.h) and every
+sample the DAC takes is read off the playback DMA buffer as each half
+completes, so the programming test checks the path the board runs:
+frames to the jitter buffer, to the DAC, with REC around the samples.
+The sim tests stream a minute of signal: lost frames must be sent again
+until the output is the input, and the rate converter must hold the
+fill on its target with the host clock 500ppm off the DAC timer.
+----------------------------------------------------------------------
+ */
+#include "test.h"
+#include "link.h"
+#include "stream.h"
+#include "playback.h"
+#include "isd1820.h"
+#include "main.h"
+#include "wav_file.h"
+
+#define CLIP_LENGTH 16000U //samples, 1s
+#define FRAME_SIZE  STREAM_MAX_WRITE
+#define SIM_LENGTH  (60U * PLAYBACK_SAMPLE_RATE) //samples, 1min
+#define INPUT       "test_stream.wav"
+#define OUTPUT      "test_stream_out.wav"
+
+typedef __PACKED_STRUCT {
+	uint16_t seq;
+	int16_t samples[FRAME_SIZE];
+} DataTypeDef;
+
+static TIM_HandleTypeDef _htim5, _htim6;
+static DMA_HandleTypeDef _hdma;
+static DMA_Stream_TypeDef _stream;
+
+typedef struct {
+	unsigned sent, resent, lost, underruns, target;
+	double tracking;
+} SimTypeDef;
+
+static int16_t _clip[CLIP_LENGTH];
+static int16_t _played[CLIP_LENGTH + 4U * PLAYBACK_HALF_SIZE];
+static uint32_t _out;        //samples the DAC took
+static uint32_t _recRise, _recFall;
+static uint32_t _completions;
+static uint8_t _result;      //of the last STREAM_DATA reply
+static uint32_t _ack;
+static uint32_t _replies;
+
+void PLAYBACK_CompleteCallback(void){
+	_completions++;
+}
+
+static void _Reply(const uint8_t* frame, uint16_t len){
+	if(frame[0] != (UARTCMD_STREAM_DATA | UARTCMD_REPLY) || len != 10U) return;
+	_result = frame[1];
+	memcpy(&_ack, &frame[2], 4U);
+	_replies++;
+}
+
+static void _GpioHook(GPIO_TypeDef* port, uint16_t pin, GPIO_PinState state){
+	if(port != REC_GPIO_Port || pin != REC_Pin) return;
+	if(state == GPIO_PIN_SET) _recRise = _out;
+	else _recFall = _out;
+}
+
+//Never 0, so silence stands out.
+static int16_t _Sample(uint32_t n){
+	return (int16_t)((int32_t)((n * 7919U) % 60000U) - 30000) | 1;
+}
+
+static void _Init(void){
+	uint32_t i;
+	LINK_Open(_Reply);
+	memset(&_stream, 0, sizeof(_stream));
+	_hdma.Instance = &_stream;
+	_hdma.Init.Mode = DMA_CIRCULAR;
+	HAL_DMA_Init(&_hdma);
+	_htim6.Instance = TIM6;
+	_htim6.Init.Period = 5249U;
+	_htim6.hdma[TIM_DMA_ID_UPDATE] = &_hdma;
+	PLAYBACK_Init(&_htim6);
+	_htim5.Instance = TIM5;
+	TIM5->PSC = 8399U;
+	ISD1820_SetPolicy(ISD1820_POLICY_REJECT_IF_BUSY);
+	ISD1820_AsyncInit(&_htim5);
+	SIM_gpioHook = _GpioHook;
+	for(i = 0; i < CLIP_LENGTH; i++) _clip[i] = _Sample(i);
+	_out = _completions = _replies = 0;
+	_recRise = _recFall = 0xFFFFFFFFU;
+}
+
+static void _Start(PLAYBACK_RouteTypeDef route){
+	uint8_t start[3] = {CODEC_FORMAT_PCM16, (uint8_t)route, STREAM_MODE_BUFFERED};
+	LINK_Send(UARTCMD_STREAM_START, start, sizeof(start));
+	LINK_Pump();
+}
+
+//Sends samples [first, first + count) of the clip as frame {seq}. Returns the result in the reply.
+static uint8_t _Send(uint16_t seq, uint32_t first, uint32_t count){
+	DataTypeDef data;
+	uint32_t replies = _replies;
+	data.seq = seq;
+	memcpy(data.samples, &_clip[first], count * sizeof(int16_t));
+	LINK_Send(UARTCMD_STREAM_DATA, &data, (uint16_t)(2U + count * sizeof(int16_t)));
+	LINK_Pump();
+	CHECK_EQ(_replies, replies + 1U);
+	return _result;
+}
+
+//The DAC takes the half DMA is leaving, then it is refilled. Returns 0 once playback is over.
+static uint32_t _Refill(void){
+	const uint16_t* buffer = (const uint16_t*)(uintptr_t)_stream.M0AR;
+	uint32_t half = (_out / PLAYBACK_HALF_SIZE) & 1U, i;
+	if(!PLAYBACK_IsPlaying()) return 0;
+	for(i = 0; i < PLAYBACK_HALF_SIZE && _out < sizeof(_played) / sizeof(_played[0]); i++){
+		_played[_out++] = (int16_t)(buffer[half * PLAYBACK_HALF_SIZE + i] ^ 0x8000U);
+	}
+	SIM_DmaComplete(&_hdma, half == 0);
+	LINK_Pump();
+	return 1;
+}
+
+//Numbering: out of sequence refused, repeats taken once, no room refused until the DAC makes some.
+static void _TestSequence(void){
+	uint16_t seq;
+	_Init();
+	_Start(PLAYBACK_ROUTE_DAC);
+	CHECK_EQ(_Send(1, 0, FRAME_SIZE), HAL_ERROR); //0 expected
+	CHECK_EQ(_ack & 0xFFFFU, 0U);
+	CHECK_EQ(_ack >> 16, STREAM_BUFFER_SIZE);
+	CHECK_EQ(_Send(0, 0, FRAME_SIZE), HAL_OK); //a full frame of PCM16 fits UARTCMD_MAX_FRAME
+	CHECK_EQ(_ack & 0xFFFFU, 1U);
+	CHECK_EQ(_ack >> 16, STREAM_BUFFER_SIZE - FRAME_SIZE);
+	CHECK_EQ(_Send(0, 0, FRAME_SIZE), HAL_OK); //the reply was lost: not written twice
+	CHECK_EQ(_ack, ((STREAM_BUFFER_SIZE - FRAME_SIZE) << 16) | 1U);
+	CHECK_EQ(_Send(3, 0, FRAME_SIZE), HAL_ERROR); //2 was lost: the host goes back to 1
+	CHECK_EQ(_ack & 0xFFFFU, 1U);
+	CHECK_EQ(_Send(1, FRAME_SIZE, 2U), HAL_OK); //any even count up to STREAM_MAX_WRITE
+	CHECK_EQ(STREAM_Write(2, (const uint8_t*)_clip, 6), HAL_ERROR); //3 samples, odd
+	CHECK_EQ(STREAM_Write(2, (const uint8_t*)_clip, 2U * FRAME_SIZE + 4U), HAL_ERROR); //over STREAM_MAX_WRITE
+	CHECK_EQ(UARTCMD_GetErrors(), 0U);
+
+	STREAM_End(1);
+	_Start(PLAYBACK_ROUTE_DAC);
+	_ack = STREAM_BUFFER_SIZE << 16;
+	for(seq = 0; (_ack >> 16) >= FRAME_SIZE; seq++){ //the host fills the room the acks show
+		CHECK_EQ(_Send(seq, 0, FRAME_SIZE), HAL_OK);
+	}
+	CHECK(PLAYBACK_IsPlaying()); //from STREAM_PREFILL on, taking both DMA halves
+	CHECK_EQ(_ack >> 16, 0U);
+	CHECK_EQ(_Send(seq, 0, FRAME_SIZE), HAL_BUSY);
+	CHECK_EQ(_ack & 0xFFFFU, seq); //not taken: the host sends it again
+	CHECK_EQ(_Refill(), 1U); //taken by the DMA refill: room for half a frame
+	CHECK_EQ(_Send((uint16_t)(_ack & 0xFFFFU), 0, FRAME_SIZE), HAL_BUSY);
+	CHECK_EQ(_Refill(), 1U);
+	CHECK_EQ(_Send((uint16_t)(_ack & 0xFFFFU), 0, FRAME_SIZE), HAL_OK);
+	CHECK_EQ(STREAM_End(1), HAL_OK);
+	CHECK(!PLAYBACK_IsPlaying());
+	CHECK_EQ(STREAM_End(1), HAL_ERROR);
+}
+
+//A clip streamed to PLAYBACK_ROUTE_RECORD: every sample reaches the DAC, in order, inside REC.
+static void _TestProgramming(void){
+	uint32_t sent = 0, count, i;
+	uint16_t seq = 0;
+	_Init();
+	_Start(PLAYBACK_ROUTE_RECORD);
+	while(sent < CLIP_LENGTH){ //the host runs ahead while there is room, the DAC drains a half per refill
+		count = CLIP_LENGTH - sent;
+		if(count > FRAME_SIZE) count = FRAME_SIZE;
+		if(_Send(seq, sent, count) == HAL_OK){
+			sent += count;
+			seq++;
+		}else{
+			CHECK_EQ(_result, HAL_BUSY);
+			CHECK_EQ(_Refill(), 1U);
+		}
+	}
+	CHECK_EQ(_recFall, 0xFFFFFFFFU);
+	LINK_Send(UARTCMD_STREAM_END, "\0", 1);
+	LINK_Pump();
+	while(_Refill());
+
+	CHECK_EQ(_completions, 1U);
+	CHECK_EQ(_recRise, 0U); //before the first sample
+	CHECK(_recFall >= CLIP_LENGTH && _recFall <= CLIP_LENGTH + 2U * PLAYBACK_HALF_SIZE); //after the last, once its half is out
+	CHECK(_out >= CLIP_LENGTH);
+	CHECK_EQ(memcmp(_played, _clip, CLIP_LENGTH * sizeof(int16_t)), 0);
+	for(i = CLIP_LENGTH; i < _out; i++) CHECK_EQ(_played[i], 0);
+	CHECK_EQ(STREAM_GetUnderruns(), 0U);
+	CHECK(!HAL_GPIO_ReadPin(REC_GPIO_Port, REC_Pin));
+	CHECK_EQ(UARTCMD_GetErrors(), 0U);
+	BENCH("stream programming, 1s clip, REC held", _recFall * 1000.0 / PLAYBACK_SAMPLE_RATE, "ms");
+}
+
+//Runs the sim with {options} on INPUT, to OUTPUT. Returns its exit status and fills {sim}.
+static int _Run(const char* tool, const char* options, SimTypeDef* sim){
+	char command[512], line[256];
+	FILE* out;
+	memset(sim, 0, sizeof(*sim));
+	sim->tracking = 1e9;
+	snprintf(command, sizeof(command), "%s %s " INPUT " " OUTPUT " 2>/dev/null", tool, options);
+	out = popen(command, "r");
+	CHECK(out != NULL);
+	if(out == NULL) return -1;
+	while(fgets(line, sizeof(line), out)){
+		if(sscanf(line, "frames: %u sent, %u sent again, %u lost", &sim->sent, &sim->resent, &sim->lost) == 3) continue;
+		if(sscanf(line, "underruns: %u", &sim->underruns) == 1) continue;
+		if(sscanf(line, "target: %u", &sim->target) == 1) continue;
+		if(sscanf(line, "tracking: %lf", &sim->tracking) == 1) continue;
+		if(strncmp(line, "bench ", 6) == 0) fputs(line, stdout);
+	}
+	return WEXITSTATUS(pclose(out));
+}
+
+//Frames lost on the line are sent again: the DAC plays the input, sample for sample, in every format.
+static void _TestLoss(const char* tool){
+	static int16_t samples[SIM_LENGTH];
+	int16_t* output;
+	uint32_t rate, count, i;
+	SimTypeDef sim;
+	for(i = 0; i < SIM_LENGTH; i++) samples[i] = _Sample(i);
+	CHECK(WAV_Write(INPUT, samples, SIM_LENGTH, PLAYBACK_SAMPLE_RATE));
+	CHECK_EQ(_Run(tool, "-x 10", &sim), 0);
+	CHECK(sim.lost > 0U);
+	CHECK(sim.resent >= sim.lost);
+	CHECK_EQ(sim.underruns, 0U);
+	output = WAV_Read(OUTPUT, &rate, &count);
+	CHECK(output != NULL && count >= SIM_LENGTH);
+	if(output != NULL && count >= SIM_LENGTH) CHECK_EQ(memcmp(output, samples, sizeof(samples)), 0);
+	free(output);
+	BENCH("stream pcm16, 10% lost, frames sent again", sim.resent, "frames");
+	CHECK_EQ(_Run(tool, "-f ulaw -x 5", &sim), 0);
+	CHECK_EQ(sim.underruns, 0U);
+	CHECK_EQ(_Run(tool, "-f adpcm -x 5", &sim), 0);
+	CHECK_EQ(sim.underruns, 0U);
+}
+
+//A live host 500ppm fast, then slow: the rate converter takes the drift, the fill stays on its target.
+static void _TestDrift(const char* tool){
+	SimTypeDef sim;
+	CHECK_EQ(_Run(tool, "-l -d 500", &sim), 0);
+	CHECK_EQ(sim.underruns, 0U);
+	CHECK(sim.tracking > -16.0 && sim.tracking < 16.0);
+	BENCH("stream live, host 500ppm fast, fill off the target", sim.tracking, "samples");
+	CHECK_EQ(_Run(tool, "-l -d -500", &sim), 0);
+	CHECK_EQ(sim.underruns, 0U);
+	CHECK(sim.tracking > -16.0 && sim.tracking < 16.0);
+	BENCH("stream live, host 500ppm slow, fill off the target", sim.tracking, "samples");
+}
+
+//Frames up to 40ms late: the target settles where it covers them, with no underrun.
+static void _TestJitter(const char* tool){
+	SimTypeDef sim;
+	uint32_t steady;
+	CHECK_EQ(_Run(tool, "-l", &sim), 0);
+	steady = sim.target;
+	CHECK(steady < STREAM_LIVE_TARGET); //steady arrivals shrink it
+	CHECK_EQ(_Run(tool, "-l -j 40", &sim), 0);
+	CHECK(sim.target > steady);
+	CHECK(sim.target >= 40U * PLAYBACK_SAMPLE_RATE / 1000U);
+	CHECK_EQ(sim.underruns, 0U);
+	BENCH("stream live, 40ms jitter, target", sim.target * 1000.0 / PLAYBACK_SAMPLE_RATE, "ms");
+}
+
+int main(int argc, char** argv){
+	char command[512];
+	if(argc != 2){
+		printf("usage: %s <stream_sim>\n", argv[0]);
+		return 2;
+	}
+	_TestSequence();
+	_TestProgramming();
+	_TestLoss(argv[1]);
+	_TestDrift(argv[1]);
+	_TestJitter(argv[1]);
+	snprintf(command, sizeof(command), "%s -f alaw " INPUT " 2>/dev/null", argv[1]); //no such format
+	TEST_Tool(command, NULL, 0, 2);
+	return TEST_END();
+}
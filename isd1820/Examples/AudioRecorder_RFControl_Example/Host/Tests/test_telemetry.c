@@ -0,0 +1,123 @@
+/**
+ * test_telemetry.c
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+Telemetry stream, decoded by Tools/telem_decode
+----------------------------------------------------------------------
+Usage: test_telemetry <telem_decode>
+----------------------------------------------------------------------
+ */
+#include "test.h"
+#include "link.h"
+#include "logger.h"
+#include <unistd.h>
+
+#define CAPTURE "test_telemetry.bin"
+
+extern int _write(int file, char* ptr, int len);
+
+static FILE* _capture;
+
+static void _Capture(UART_HandleTypeDef* huart, const uint8_t* data, uint16_t size){
+	UNUSED(huart);
+	fwrite(data, 1, size, _capture);
+}
+
+//Runs the decoder on the capture and checks its output against {expected}, one line each.
+static void _Decode(const char* tool, const char* options, const char* const* expected, uint32_t count, int status){
+	char command[512];
+	snprintf(command, sizeof(command), "%s %s " CAPTURE " 2>/dev/null", tool, options);
+	TEST_Tool(command, expected, count, status);
+}
+
+static void _TestRecords(const char* tool){
+	static const char* const expected[] = {
+		"1234,histogram,1,16,0,7,128",
+		"1234,driver,5",
+		"1234,fsm,3,300",
+		"1234,timing,0,4294967295",
+		"1235,log,64,1234,42",
+		",text,\"say \"\"hi\"\"\\n\"",
+		",reply,6,0,0",
+	};
+	uint32_t values[5] = {1, 16, 0, 7, 128};
+	char text[] = "say \"hi\"\n";
+	_capture = fopen(CAPTURE, "wb");
+	LINK_Open(NULL);
+	SIM_uartTxHook = _Capture;
+	uwTick = 1234;
+	TELEM_Record(TELEM_REC_HISTOGRAM, values, 5);
+	TELEM_Record(TELEM_REC_DRIVER, (const uint32_t[]){5}, 1);
+	TELEM_Record(TELEM_REC_FSM, (const uint32_t[]){3, 300}, 2);
+	TELEM_Record(TELEM_REC_TIMING, (const uint32_t[]){TELEM_TIMING_FSM_DISPATCH, 0xFFFFFFFFU}, 2); //longest varint
+	LOG_Write(64, 1, (const uint32_t[]){42});
+	uwTick = 1235;
+	LOG_Drain(0);
+	_write(1, text, (int)strlen(text));
+	LINK_Send(UARTCMD_STATUS, NULL, 0);
+	LINK_Pump();
+	fclose(_capture);
+	_Decode(tool, "", expected, sizeof(expected) / sizeof(expected[0]), 0);
+}
+
+static void _TestErrors(const char* tool){
+	static const char* const expected[] = {
+		"7,driver,0,1",
+	};
+	static const uint8_t bytes[] = {
+		0x03, TELEM_REC_DRIVER, 0x07, 0x02, 0x01, 0x00, //record with a 0 value: 10 07 00 01
+		0x05, TELEM_REC_DRIVER, 0x00,                   //cut by a lost byte
+		0x03, TELEM_REC_FSM, 0x87, 0x00,                //varint runs past the end
+	};
+	_capture = fopen(CAPTURE, "wb");
+	fwrite(bytes, 1, sizeof(bytes), _capture);
+	fclose(_capture);
+	_Decode(tool, "", expected, 1, 1);
+}
+
+//Messages rebuilt from the .log_fmt section of this very program.
+static void _TestLog(const char* tool){
+	static const char* const expected[] = {
+		"10,log,10,\"level -3, state 5, flags 0x00ab 100% ?\"",
+		"10,log,10,\"1 2 3 4\"",
+	};
+	char options[300] = "-e ";
+	ssize_t len = readlink("/proc/self/exe", &options[3], sizeof(options) - 4U);
+	CHECK(len > 0);
+	options[3 + (len > 0 ? len : 0)] = 0;
+	_capture = fopen(CAPTURE, "wb");
+	LINK_Open(NULL);
+	SIM_uartTxHook = _Capture;
+	uwTick = 10;
+	LOG("level %d, state %lu, flags 0x%04x 100%% %s", -3, 5U, 0xABU, 0);
+	LOG_Write(LOG_ID("%u %u %u %u"), 6, (const uint32_t[]){1, 2, 3, 4, 5, 6}); //the arguments past LOG_MAX_ARGS are dropped
+	LOG_Drain(0);
+	LINK_Pump();
+	fclose(_capture);
+	_Decode(tool, options, expected, 2, 0);
+	CHECK_EQ(LOG_GetDropped(), 0U);
+}
+
+int main(int argc, char** argv){
+	if(argc != 2){
+		printf("usage: %s <telem_decode>\n", argv[0]);
+		return 2;
+	}
+	_TestRecords(argv[1]);
+	_TestErrors(argv[1]);
+	_TestLog(argv[1]);
+	return TEST_END();
+}
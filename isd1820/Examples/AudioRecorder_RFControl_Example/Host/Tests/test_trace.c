@@ -0,0 +1,269 @@
+/**
+ * test_trace.c
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+ITM setup and SWO streams, decoded by Tools/swo_decode to CSV and JSON,
+and the trace of a simulated run
+----------------------------------------------------------------------
+Usage: test_trace <swo_decode> <stream_sim>
+The run streams a clip to the ISD1820 (PLAYBACK_ROUTE_RECORD) with
+SIM_TRACE set. Its JSON must be one event per line, in time order,
+with every span closed on its track, and hold what the run did: the
+command and the REC edges, the TIM6 span, the DAC stream and USART2
+interrupts, and the UART command handler posted, by name.
+----------------------------------------------------------------------
+ */
+#include "test.h"
+#include "trace.h"
+#include "isd1820.h"
+#include "playback.h"
+#include "wav_file.h"
+#include <unistd.h>
+
+#define CAPTURE    "test_trace.bin"
+#define SIM_INPUT  "test_trace.wav"
+#define SIM_OUTPUT "test_trace.json"
+#define SIM_TRACKS 8U
+
+static uint8_t _swo[256];
+static uint32_t _swoLen;
+
+static void _Bytes(const uint8_t* bytes, uint32_t len){
+	while(len--) _swo[_swoLen++] = *bytes++;
+}
+
+//Software packet of {size} bytes on {port}, as the ITM sends it.
+static void _Packet(uint8_t port, uint32_t value, uint8_t size){
+	uint8_t i;
+	_swo[_swoLen++] = (uint8_t)(port << 3) | (size == 4U ? 3U : size);
+	for(i = 0; i < size; i++) _swo[_swoLen++] = (uint8_t)(value >> (8U * i));
+}
+
+//Local timestamp packet for {delta} cycles.
+static void _Timestamp(uint32_t delta){
+	if(delta && delta < 7U){
+		_swo[_swoLen++] = (uint8_t)(delta << 4);
+		return;
+	}
+	_swo[_swoLen++] = 0xC0U;
+	while(delta >= 0x80U){
+		_swo[_swoLen++] = (uint8_t)(delta | 0x80U);
+		delta >>= 7;
+	}
+	_swo[_swoLen++] = (uint8_t)delta;
+}
+
+static void _Decode(const char* tool, const char* options, const char* const* expected, uint32_t count, int status){
+	char command[1024];
+	FILE* capture = fopen(CAPTURE, "wb");
+	fwrite(_swo, 1, _swoLen, capture);
+	fclose(capture);
+	snprintf(command, sizeof(command), "%s %s " CAPTURE " 2>/dev/null", tool, options);
+	TEST_Tool(command, expected, count, status);
+}
+
+void TEST_Handler(uint32_t arg){ //named from the symbols of this program
+	UNUSED(arg);
+}
+
+static void _TestInit(void){
+	SIM_Reset();
+	TRACE_Init();
+	CHECK_EQ(TPI->ACPR, SystemCoreClock / TRACE_SWO_BAUD - 1U);
+	CHECK_EQ(ITM->TER, 0x7FEU); //ports 1 to 10
+	CHECK(ITM->TCR & ITM_TCR_TSENA_Msk);
+	TRACE(TRACE_PORT_RF, 3);
+	CHECK_EQ(ITM->PORT[TRACE_PORT_RF].u32, 3U);
+}
+
+static void _TestStream(const char* tool){
+	static const uint8_t sync[] = {0, 0, 0, 0, 0, 0x80};
+	static const uint8_t skipped[] = {
+		0x05, 0x01,       //hardware source, 1 byte
+		0x94, 0x81, 0x01, //global timestamp
+		0x08,             //extension
+	};
+	static const char* const expected[] = {
+		"100,1,305419896",
+		"103,2,5",
+		"303,7,769",
+		"303,9,0",
+		"2097455,10,1",
+	};
+	_swoLen = 0;
+	_Bytes(sync, sizeof(sync));
+	_Packet(TRACE_PORT_COMMAND, 0x12345678U, 4);
+	_Timestamp(100);
+	_Packet(TRACE_PORT_PIN, 5, 1);
+	_Timestamp(3);
+	_Packet(TRACE_PORT_ISR, 0x301, 2); //two packets dated by one timestamp
+	_Packet(TRACE_PORT_RUN, 0, 4);
+	_Timestamp(200);
+	_Bytes(skipped, sizeof(skipped));
+	_Bytes(sync, sizeof(sync));
+	_Packet(TRACE_PORT_DTMF, 1, 1);
+	_Timestamp(0x200000U);
+	_Decode(tool, "", expected, 5, 0);
+}
+
+static void _TestOverflow(const char* tool){
+	static const char* const expected[] = {
+		"10,6,2",
+	};
+	_swoLen = 0;
+	_swo[_swoLen++] = 0x70; //overflow: events were lost
+	_Packet(TRACE_PORT_RF, 2, 4);
+	_Timestamp(10);
+	_Packet(TRACE_PORT_RF, 3, 4); //cut
+	_swoLen -= 2U;
+	_Decode(tool, "", expected, 1, 1);
+}
+
+static void _TestJson(const char* tool){
+	static const char* const expected[] = {
+		"[",
+		"{\"name\":\"IRQ 28\",\"ph\":\"B\",\"ts\":1.000,\"pid\":1,\"tid\":\"isr\"},",
+		"{\"name\":\"post\",\"ph\":\"i\",\"ts\":1.000,\"pid\":1,\"tid\":\"main\",\"s\":\"t\",\"args\":{\"handler\":\"TEST_Handler\"}},",
+		"{\"name\":\"IRQ 28\",\"ph\":\"E\",\"ts\":1.500,\"pid\":1,\"tid\":\"isr\"},",
+		"{\"name\":\"TEST_Handler\",\"ph\":\"B\",\"ts\":2.000,\"pid\":1,\"tid\":\"main\"},",
+		"{\"name\":\"pins\",\"ph\":\"C\",\"ts\":2.000,\"pid\":1,\"tid\":\"main\",\"args\":{\"REC\":0,\"PL\":1,\"PE\":0}},",
+		"{\"name\":\"\",\"ph\":\"E\",\"ts\":3.000,\"pid\":1,\"tid\":\"main\"},",
+		"{\"name\":\"async timer\",\"ph\":\"B\",\"ts\":10.000,\"pid\":1,\"tid\":\"isr\"},",
+		"{\"name\":\"pins\",\"ph\":\"C\",\"ts\":10.000,\"pid\":1,\"tid\":\"main\",\"args\":{\"REC\":0,\"PL\":0,\"PE\":0}},",
+		"{\"name\":\"timer\",\"ph\":\"i\",\"ts\":10.000,\"pid\":1,\"tid\":\"main\",\"s\":\"t\",\"args\":{\"value\":9}},",
+		"{\"name\":\"async timer\",\"ph\":\"E\",\"ts\":10.000,\"pid\":1,\"tid\":\"isr\"},",
+		"{\"name\":\"FT\",\"ph\":\"C\",\"ts\":20.000,\"pid\":1,\"tid\":\"main\",\"args\":{\"FT\":1}}",
+		"]",
+	};
+	char options[300] = "-j -e ";
+	ssize_t len = readlink("/proc/self/exe", &options[6], sizeof(options) - 7U);
+	CHECK(len > 0);
+	options[6 + (len > 0 ? len : 0)] = 0;
+	_swoLen = 0;
+	_Packet(TRACE_PORT_ISR, (28U << 1) | 1U, 1); //TIM2
+	_Packet(TRACE_PORT_POST, (uint32_t)TEST_Handler, 4);
+	_Timestamp(84);
+	_Packet(TRACE_PORT_ISR, 28U << 1, 1);
+	_Timestamp(42);
+	_Packet(TRACE_PORT_RUN, (uint32_t)TEST_Handler, 4);
+	_Packet(TRACE_PORT_PIN, (ISD1820_OP_PLAY << 1) | 1U, 1);
+	_Timestamp(42);
+	_Packet(TRACE_PORT_RUN, 0, 4);
+	_Timestamp(84);
+	_Packet(TRACE_PORT_TIM_IRQ, 1, 1);
+	_Packet(TRACE_PORT_PIN, ISD1820_OP_IDLE << 1, 1);
+	_Packet(TRACE_PORT_TIMER, 9, 4);
+	_Packet(TRACE_PORT_TIM_IRQ, 0, 1);
+	_Timestamp(588);
+	_Packet(TRACE_PORT_FT, 1, 1);
+	_Timestamp(840);
+	_Decode(tool, options, expected, sizeof(expected) / sizeof(expected[0]), 0);
+}
+
+//Counts the events of the sim trace matching {name} and {ph}, and {args} if not NULL.
+typedef struct {
+	const char* name;
+	char ph;
+	const char* args;
+	uint32_t count;
+} SimEventTypeDef;
+
+static void _TestSim(const char* tool){
+	static SimEventTypeDef events[] = {
+		{"\"command\"", 'i', NULL, 0},
+		{"\"pins\"", 'C', "\"REC\":1", 0},
+		{"\"pins\"", 'C', "\"REC\":0", 0},
+		{"\"PB5\"", 'C', "\"PB5\":1", 0}, //REC
+		{"\"PB5\"", 'C', "\"PB5\":0", 0},
+		{"\"TIM6\"", 'B', NULL, 0},
+		{"\"TIM6\"", 'E', NULL, 0},
+		{"\"IRQ 12\"", 'B', NULL, 0},  //DMA1 Stream1, the DAC
+		{"\"IRQ 38\"", 'B', NULL, 0},  //USART2
+		{"\"post\"", 'i', "\"handler\":\"_UARTCMD_Process\"", 0},
+	};
+	static int16_t samples[PLAYBACK_SAMPLE_RATE / 2U];
+	char command[1024], line[512], tracks[SIM_TRACKS][16];
+	int32_t depths[SIM_TRACKS] = {0};
+	uint32_t trackCount = 0, i, t;
+	double ts, last = 0;
+	const char* field;
+	char ph;
+	FILE* trace;
+	for(i = 0; i < sizeof(samples) / sizeof(samples[0]); i++) samples[i] = (int16_t)((i * 97U) % 4000U);
+	CHECK(WAV_Write(SIM_INPUT, samples, sizeof(samples) / sizeof(samples[0]), PLAYBACK_SAMPLE_RATE));
+	unlink(SIM_OUTPUT);
+	snprintf(command, sizeof(command), "%s -r record " SIM_INPUT " >/dev/null 2>&1", tool);
+	CHECK_EQ(system(command), 0);
+	CHECK(access(SIM_OUTPUT, F_OK) != 0); //no trace unless asked
+	snprintf(command, sizeof(command), "SIM_TRACE=" SIM_OUTPUT " %s -r record " SIM_INPUT " >/dev/null 2>&1", tool);
+	CHECK_EQ(system(command), 0);
+	if((trace = fopen(SIM_OUTPUT, "r")) == NULL){
+		CHECK(trace != NULL);
+		return;
+	}
+	CHECK(fgets(line, sizeof(line), trace) != NULL && strcmp(line, "[\n") == 0);
+	while(fgets(line, sizeof(line), trace) != NULL && line[0] == '{'){
+		field = strstr(line, "\"ph\":\"");
+		ph = field ? field[6] : 0;
+		field = strstr(line, "\"ts\":");
+		ts = field ? atof(&field[5]) : -1.0;
+		if(ts < last){
+			CHECK(ts >= last);
+			break;
+		}
+		last = ts;
+		for(i = 0; i < sizeof(events) / sizeof(events[0]); i++){
+			if(strncmp(&line[8], events[i].name, strlen(events[i].name)) == 0 && ph == events[i].ph
+					&& (events[i].args == NULL || strstr(line, events[i].args) != NULL)) events[i].count++;
+		}
+		if(ph != 'B' && ph != 'E') continue;
+		field = strstr(line, "\"tid\":\"");
+		CHECK(field != NULL);
+		if(field == NULL) break;
+		field += 7;
+		for(t = 0; t < trackCount && strncmp(tracks[t], field, strcspn(field, "\"")) != 0; t++);
+		if(t == trackCount && trackCount < SIM_TRACKS){
+			snprintf(tracks[trackCount++], sizeof(tracks[0]), "%.*s", (int)strcspn(field, "\""), field);
+		}
+		depths[t] += (ph == 'B') ? 1 : -1;
+		if(depths[t] < 0){
+			CHECK(depths[t] >= 0); //an end with no begin
+			break;
+		}
+	}
+	CHECK_EQ(strcmp(line, "]\n"), 0);
+	fclose(trace);
+	for(t = 0; t < trackCount; t++) CHECK_EQ(depths[t], 0);
+	for(i = 0; i < sizeof(events) / sizeof(events[0]); i++){
+		if(events[i].count == 0) printf("no %s %c %s in " SIM_OUTPUT "\n", events[i].name, events[i].ph, events[i].args ? events[i].args : "");
+		CHECK(events[i].count > 0);
+	}
+	CHECK_EQ(events[0].count, 1U); //one command: REC
+	CHECK_EQ(events[5].count, 1U); //one run of TIM6
+}
+
+int main(int argc, char** argv){
+	if(argc != 3){
+		printf("usage: %s <swo_decode> <stream_sim>\n", argv[0]);
+		return 2;
+	}
+	_TestInit();
+	_TestStream(argv[1]);
+	_TestOverflow(argv[1]);
+	_TestJson(argv[1]);
+	_TestSim(argv[2]);
+	return TEST_END();
+}
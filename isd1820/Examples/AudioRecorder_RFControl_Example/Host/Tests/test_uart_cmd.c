@@ -0,0 +1,96 @@
+/**
+ * test_uart_cmd.c
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+Command parser: frames, wrap around the DMA buffer and overruns
+----------------------------------------------------------------------
+ */
+#include "test.h"
+#include "link.h"
+
+static uint32_t _replies;
+
+static void _Count(const uint8_t* frame, uint16_t len){
+	if(frame[0] == (UARTCMD_STATUS | UARTCMD_REPLY) && len == 10U) _replies++; //cmd, result, status, crc
+}
+
+//Appends {count} STATUS frames to {out}. Returns the size.
+static uint16_t _Status(uint8_t* out, uint16_t count){
+	uint16_t len = 0;
+	while(count--) len += LINK_Frame(UARTCMD_STATUS, NULL, 0, &out[len]);
+	return len;
+}
+
+static void _TestFrames(void){
+	uint8_t bytes[256];
+	uint8_t bad[] = {0x02, 0x06, 0x00};
+	LINK_Open(_Count);
+	_replies = 0;
+	SIM_UartReceive(&LINK_huart, bytes, _Status(bytes, 10), 1);
+	LINK_Pump();
+	CHECK_EQ(_replies, 10U);
+	SIM_UartReceive(&LINK_huart, bad, sizeof(bad), 1); //no crc
+	LINK_Pump();
+	CHECK_EQ(_replies, 10U);
+	CHECK_EQ(UARTCMD_GetErrors(), 1U);
+	CHECK_EQ(UARTCMD_GetOverruns(), 0U);
+}
+
+static void _TestWrap(void){
+	uint8_t bytes[256];
+	uint16_t len = _Status(bytes, 20), i; //7 bytes a frame: one of them straddles the end of the buffer
+	LINK_Open(_Count);
+	_replies = 0;
+	for(i = 0; i < 10U; i++){
+		SIM_UartReceive(&LINK_huart, bytes, len, 1);
+		LINK_Pump();
+	}
+	CHECK_EQ(_replies, 200U);
+	CHECK_EQ(UARTCMD_GetErrors(), 0U);
+	CHECK_EQ(UARTCMD_GetOverruns(), 0U);
+}
+
+static void _TestOverrun(void){
+	uint8_t bytes[4096];
+	uint16_t len = _Status(bytes, 400); //2800 bytes before the parser runs
+	LINK_Open(_Count);
+	_replies = 0;
+	SIM_UartReceive(&LINK_huart, bytes, len, 1);
+	LINK_Pump();
+	CHECK_EQ(_replies, 0U); //the whole backlog is dropped, not parsed half overwritten
+	CHECK_EQ(UARTCMD_GetOverruns(), 1U);
+	SIM_UartReceive(&LINK_huart, bytes, _Status(bytes, 3), 1); //ended on a delimiter: next frames are whole
+	LINK_Pump();
+	CHECK_EQ(_replies, 3U);
+
+	len = _Status(bytes, 400);
+	_Status(&bytes[len], 1);
+	SIM_UartReceive(&LINK_huart, bytes, len + 3U, 1); //and half a frame
+	LINK_Pump();
+	CHECK_EQ(UARTCMD_GetOverruns(), 2U);
+	SIM_UartReceive(&LINK_huart, &bytes[len + 3U], 4U, 0); //rest of the half frame, dropped
+	SIM_UartReceive(&LINK_huart, bytes, _Status(bytes, 2), 1);
+	LINK_Pump();
+	CHECK_EQ(_replies, 5U);
+	CHECK_EQ(UARTCMD_GetErrors(), 2U); //one per overrun
+}
+
+int main(void){
+	_TestFrames();
+	_TestWrap();
+	_TestOverrun();
+	return TEST_END();
+}
@@ -0,0 +1,141 @@
+/**
+ * test_vad.c
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+Voice activity: speech over quiet noise, long speech, and loud
+backgrounds setting in
+----------------------------------------------------------------------
+Signals are synthetic, 16kHz blocks of 256 samples: hiss is white
+noise, a hum a 100Hz tone, and speech a 200Hz tone under syllables of
+a 4Hz envelope that falls to the background between them.
+----------------------------------------------------------------------
+ */
+#include "test.h"
+#include "vad.h"
+#include <math.h>
+
+#define RATE       16000U
+#define BLOCK      256U
+#define BLOCKS(ms) ((ms) * (RATE / 1000U) / BLOCK)
+
+typedef enum {
+	QUIET = 0, //hiss at -60dBFS
+	HISS,      //hiss at -20dBFS
+	HUM,       //-20dBFS
+	SPEECH     //up to -12dBFS, over QUIET
+} SignalTypeDef;
+
+static uint32_t _changes, _lastActive;
+static uint32_t _lcg = 1, _time;
+
+void VAD_ChangeCallback(uint8_t active){
+	_changes++;
+	_lastActive = active;
+}
+
+static double _Noise(void){
+	_lcg = _lcg * 1103515245U + 12345U;
+	return (double)((int32_t)(_lcg >> 8) & 0xFFFF) / 32768.0 - 1.0;
+}
+
+static void _Block(SignalTypeDef signal, int16_t* block){
+	double t, v;
+	uint32_t i;
+	for(i = 0; i < BLOCK; i++, _time++){
+		t = (double)_time / RATE;
+		v = 0.001 * _Noise();
+		if(signal == HISS) v = 0.1 * 1.73 * _Noise();
+		if(signal == HUM) v = 0.1 * 1.41 * sin(2.0 * M_PI * 100.0 * t);
+		if(signal == SPEECH) v += 0.25 * fabs(sin(2.0 * M_PI * 2.0 * t)) * sin(2.0 * M_PI * 200.0 * t); //|sin 2Hz|: 4 syllables/s
+		block[i] = (int16_t)(v * 32767.0);
+	}
+}
+
+//Runs {blocks} blocks of {signal}. Returns the block, from 1, at which voice last changed, 0 if it did not.
+static uint32_t _Run(SignalTypeDef signal, uint32_t blocks){
+	int16_t block[BLOCK] __ALIGNED(4);
+	uint32_t changes = _changes, at = 0, i;
+	for(i = 0; i < blocks; i++){
+		_Block(signal, block);
+		VAD_Process(block, BLOCK);
+		if(_changes != changes){
+			changes = _changes;
+			at = i + 1U;
+		}
+	}
+	return at;
+}
+
+static void _Init(void){
+	VAD_Init(RATE);
+	_changes = 0;
+	_time = 0;
+}
+
+//Short speech over quiet noise: on within the onset, off after the hangover.
+static void _TestSpeech(void){
+	uint32_t at;
+	_Init();
+	CHECK_EQ(_Run(QUIET, BLOCKS(1000)), 0U);
+	CHECK(!VAD_IsActive());
+	at = _Run(SPEECH, BLOCKS(2000));
+	CHECK_EQ(_changes, 1U);
+	CHECK(at > 0 && at <= BLOCKS(250)); //the first syllable
+	CHECK(VAD_IsActive());
+	at = _Run(QUIET, BLOCKS(1000));
+	CHECK_EQ(_changes, 2U);
+	CHECK(at >= BLOCKS(VAD_HANGOVER_DEFAULT) && at <= BLOCKS(VAD_HANGOVER_DEFAULT) + 2U);
+	CHECK(!VAD_IsActive());
+}
+
+//A minute of talk, never a break: voice stays on throughout.
+static void _TestLongSpeech(void){
+	_Init();
+	_Run(QUIET, BLOCKS(1000));
+	_Run(SPEECH, BLOCKS(60000));
+	CHECK_EQ(_changes, 1U);
+	CHECK(VAD_IsActive());
+}
+
+//A loud background setting in during speech ends voice, rather than holding it. Returns the block voice ended at.
+static uint32_t _RunBackground(SignalTypeDef background){
+	uint32_t at;
+	_Init();
+	_Run(QUIET, BLOCKS(1000));
+	_Run(SPEECH, BLOCKS(1000));
+	CHECK(VAD_IsActive());
+	at = _Run(background, BLOCKS(20000));
+	CHECK(!VAD_IsActive());
+	CHECK_EQ(_lastActive, 0U);
+	return at;
+}
+
+static void _TestBackground(void){
+	uint32_t at;
+	at = _RunBackground(HISS);
+	CHECK(at > 0 && at <= BLOCKS(2000));
+	BENCH("vad release, hiss setting in at -20dBFS", at * BLOCK * 1000.0 / RATE, "ms");
+	at = _RunBackground(HUM);
+	CHECK(at > 0 && at <= BLOCKS(7000));
+	BENCH("vad release, hum setting in at -20dBFS", at * BLOCK * 1000.0 / RATE, "ms");
+}
+
+int main(void){
+	_TestSpeech();
+	_TestLongSpeech();
+	_TestBackground();
+	return TEST_END();
+}
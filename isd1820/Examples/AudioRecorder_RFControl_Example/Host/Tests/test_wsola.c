@@ -0,0 +1,124 @@
+/**
+ * test_wsola.c
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+Time-stretch: 1.0x bit for bit, output lengths and the end of the
+stream at each speed, and the CPU headroom per hop
+----------------------------------------------------------------------
+The headroom bench times every hop of a second of input at each speed
+and prints the mean and worst against the hop period, WSOLA_HOP
+samples at 16kHz, as a share: what is left of it is the headroom of
+the refill interrupt. Host times, so the shares compare speeds; the
+target's hop cycles are in METRICS_WSOLA_HOP.
+----------------------------------------------------------------------
+ */
+#include "test.h"
+#include "wsola.h"
+#include <math.h>
+
+#define RATE      16000U
+#define LENGTH    RATE //samples of input
+#define READ_SIZE 128U //samples per read, a playback half
+
+static const uint32_t _speeds[] = {0x10000, 0x14000, 0x18000, 0x1C000, 0x20000};
+
+static int16_t _input[LENGTH];
+static int16_t _output[LENGTH + WSOLA_BUFFER_SIZE];
+static uint32_t _inputPos;
+static WSOLA_StateTypeDef _state;
+
+static uint32_t _Input(int16_t* buffer, uint32_t count){
+	uint32_t n = LENGTH - _inputPos;
+	if(n > count) n = count;
+	memcpy(buffer, &_input[_inputPos], n * sizeof(int16_t));
+	_inputPos += n;
+	return n;
+}
+
+//Voiced speech, roughly: a 150Hz pulse train with two formants, never 0.
+static void _MakeInput(void){
+	uint32_t i;
+	double t;
+	for(i = 0; i < LENGTH; i++){
+		t = (double)i / RATE;
+		_input[i] = (int16_t)(8000.0 * sin(2.0 * M_PI * 150.0 * t) + 4000.0 * sin(2.0 * M_PI * 700.0 * t)
+				+ 2000.0 * sin(2.0 * M_PI * 1200.0 * t) + 100.0);
+	}
+}
+
+//Plays the whole input at {speed}, READ_SIZE samples at a time. Returns the output count.
+static uint32_t _Play(uint32_t speed){
+	uint32_t produced = 0, n;
+	_inputPos = 0;
+	CHECK_EQ(WSOLA_Init(&_state, _Input, speed), HAL_OK);
+	do{
+		n = WSOLA_Read(&_state, &_output[produced], READ_SIZE);
+		produced += n;
+	}while(n == READ_SIZE && produced + READ_SIZE <= sizeof(_output) / sizeof(_output[0]));
+	return produced;
+}
+
+static void _TestIdentity(void){
+	uint32_t count = _Play(WSOLA_SPEED_MIN);
+	CHECK(count >= LENGTH && count <= LENGTH + WSOLA_HOP); //at most a hop of silence after the end
+	CHECK_EQ(memcmp(_output, _input, LENGTH * sizeof(int16_t)), 0);
+}
+
+//The output lasts the input over the speed, give or take the search range, and ends on at most a hop of silence.
+static void _TestLengths(void){
+	uint32_t s, count, expected, silence;
+	for(s = 0; s < sizeof(_speeds) / sizeof(_speeds[0]); s++){
+		count = _Play(_speeds[s]);
+		expected = (uint32_t)(((uint64_t)LENGTH << 16) / _speeds[s]);
+		CHECK(count + WSOLA_HOP >= expected && count <= expected + WSOLA_SEEK + WSOLA_HOP);
+		for(silence = 0; silence < count && _output[count - 1U - silence] == 0; silence++);
+		CHECK(silence <= WSOLA_HOP);
+	}
+	CHECK_EQ(WSOLA_Init(&_state, _Input, WSOLA_SPEED_MAX + 1U), HAL_ERROR);
+	CHECK_EQ(WSOLA_SetSpeed(&_state, WSOLA_SPEED_MIN - 1U), HAL_ERROR);
+}
+
+//Mean and worst hop at each speed, as a share of the hop period.
+static void _BenchHeadroom(void){
+	int16_t out[WSOLA_HOP];
+	uint64_t start, time, total, worst;
+	uint32_t s, hops;
+	char name[64];
+	for(s = 0; s < sizeof(_speeds) / sizeof(_speeds[0]); s++){
+		_inputPos = 0;
+		WSOLA_Init(&_state, _Input, _speeds[s]);
+		total = worst = 0;
+		for(hops = 0; ; hops++){
+			start = SIM_Nanoseconds();
+			if(WSOLA_Read(&_state, out, WSOLA_HOP) != WSOLA_HOP) break; //one hop per read
+			time = SIM_Nanoseconds() - start;
+			total += time;
+			if(time > worst) worst = time;
+		}
+		snprintf(name, sizeof(name), "wsola %.2fx, mean hop", _speeds[s] / 65536.0);
+		BENCH(name, (double)total / hops, "ns");
+		snprintf(name, sizeof(name), "wsola %.2fx, worst hop, share of its period", _speeds[s] / 65536.0);
+		BENCH(name, worst / 1e9 * RATE / WSOLA_HOP * 100.0, "%");
+	}
+}
+
+int main(void){
+	_MakeInput();
+	_TestIdentity();
+	_TestLengths();
+	_BenchHeadroom();
+	return TEST_END();
+}
@@ -0,0 +1,161 @@
+/**
+ * clips_pack.c
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+WAV files to clip library image
+----------------------------------------------------------------------
+Usage: clips_pack -o clips.bin id:format:file.wav...
+Builds the image of clips.h from WAV files, one clip each, in any
+order: format is dac, pcm16, ulaw or adpcm. Clips keep the sample rate
+of their file (playback converts it). The codec formats are encoded by
+the Core codec itself, so the image matches what the board decodes.
+Prints one line per clip, by id, then the image size:
+	clip id: format, rate Hz, samples samples, bytes bytes
+	image: count clips, size bytes
+The exit status is 2 for a bad argument or file, 1 if the image does
+not fit the CLIPS region. Program it with
+	st-flash write clips.bin 0x08020000
+----------------------------------------------------------------------
+ */
+#include "clips.h"
+#include "crc32.h"
+#include "sim.h"
+#include "wav_file.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char* const _PACK_formats[] = {
+	[CLIPS_FORMAT_DAC]       = "dac",
+	[CLIPS_FORMAT_PCM16]     = "pcm16",
+	[CLIPS_FORMAT_ULAW]      = "ulaw",
+	[CLIPS_FORMAT_IMA_ADPCM] = "adpcm",
+};
+
+typedef struct {
+	CLIPS_EntryTypeDef entry;
+	const char* path;
+} PACK_ClipTypeDef;
+
+static uint8_t _PACK_image[SIM_CLIPS_SIZE + CODEC_MAX_BLOCK_SIZE]; //room for the clip that does not fit
+
+static int _PACK_Compare(const void* a, const void* b){
+	return (int)((const PACK_ClipTypeDef*)a)->entry.id - (int)((const PACK_ClipTypeDef*)b)->entry.id;
+}
+
+//Parses "id:format:file.wav". Returns 0 if it is not one.
+static uint8_t _PACK_Parse(const char* arg, PACK_ClipTypeDef* clip){
+	char format[8];
+	unsigned id;
+	int used = 0;
+	uint32_t i;
+	if(sscanf(arg, "%u:%7[a-z0-9]:%n", &id, format, &used) != 2 || used == 0 || id > 0xFFFFU) return 0;
+	for(i = 0; i < sizeof(_PACK_formats) / sizeof(_PACK_formats[0]); i++){
+		if(_PACK_formats[i] && strcmp(format, _PACK_formats[i]) == 0) break;
+	}
+	if(i == sizeof(_PACK_formats) / sizeof(_PACK_formats[0])) return 0;
+	memset(clip, 0, sizeof(*clip));
+	clip->entry.id = (uint16_t)id;
+	clip->entry.format = (uint8_t)i;
+	clip->path = &arg[used];
+	return 1;
+}
+
+//Writes the data of {clip} at {offset}. Returns its size [bytes], or 0 if it does not fit.
+static uint32_t _PACK_Data(const CLIPS_EntryTypeDef* clip, const int16_t* samples, uint32_t offset){
+	CODEC_AdpcmStateTypeDef state = {0};
+	uint32_t size = 0, n, i;
+	uint16_t dac;
+	if(clip->format == CLIPS_FORMAT_DAC){
+		if(offset + clip->length * sizeof(uint16_t) > SIM_CLIPS_SIZE) return 0;
+		for(i = 0; i < clip->length; i++){
+			dac = (uint16_t)samples[i] ^ 0x8000U;
+			memcpy(&_PACK_image[offset + i * sizeof(uint16_t)], &dac, sizeof(dac));
+		}
+		return clip->length * sizeof(uint16_t);
+	}
+	for(i = 0; i < clip->length; i += n){
+		n = clip->length - i;
+		if(n > CODEC_BLOCK_SAMPLES) n = CODEC_BLOCK_SAMPLES;
+		if(offset + size > SIM_CLIPS_SIZE) return 0;
+		size += CODEC_EncodeBlock((CODEC_FormatTypeDef)clip->format, &state, &samples[i], n, &_PACK_image[offset + size]);
+	}
+	return (offset + size > SIM_CLIPS_SIZE) ? 0 : size;
+}
+
+int main(int argc, char** argv){
+	CLIPS_HeaderTypeDef header = {CLIPS_MAGIC, CLIPS_VERSION, 0, 0, 0};
+	PACK_ClipTypeDef* clips;
+	const char* output = NULL;
+	uint32_t offset, size, rate, i;
+	int16_t* samples;
+	FILE* file;
+	if(argc > 2 && strcmp(argv[1], "-o") == 0){
+		output = argv[2];
+		argc -= 2;
+		argv += 2;
+	}
+	if(output == NULL || argc < 2 || argc - 1 > (int)CLIPS_MAX_COUNT){
+		fprintf(stderr, "usage: clips_pack -o clips.bin id:format:file.wav...\n");
+		return 2;
+	}
+	header.count = (uint16_t)(argc - 1);
+	clips = calloc(header.count, sizeof(PACK_ClipTypeDef));
+	for(i = 0; i < header.count; i++){
+		if(!_PACK_Parse(argv[i + 1U], &clips[i])){
+			fprintf(stderr, "%s: not id:dac|pcm16|ulaw|adpcm:file.wav\n", argv[i + 1U]);
+			return 2;
+		}
+	}
+	qsort(clips, header.count, sizeof(PACK_ClipTypeDef), _PACK_Compare);
+	for(i = 1; i < header.count; i++){
+		if(clips[i].entry.id == clips[i - 1U].entry.id){
+			fprintf(stderr, "clip %u: given twice\n", clips[i].entry.id);
+			return 2;
+		}
+	}
+	offset = sizeof(header) + header.count * sizeof(CLIPS_EntryTypeDef);
+	for(i = 0; i < header.count; i++){
+		if((samples = WAV_Read(clips[i].path, &rate, &clips[i].entry.length)) == NULL || clips[i].entry.length == 0){
+			fprintf(stderr, "%s: no PCM WAV file\n", clips[i].path);
+			return 2;
+		}
+		clips[i].entry.sampleRate = rate;
+		clips[i].entry.offset = offset;
+		if(offset > SIM_CLIPS_SIZE || (size = _PACK_Data(&clips[i].entry, samples, offset)) == 0){
+			fprintf(stderr, "clip %u: the image is over %lu bytes\n", clips[i].entry.id, SIM_CLIPS_SIZE);
+			return 1;
+		}
+		clips[i].entry.crc = CRC32_Compute(&_PACK_image[offset], size);
+		printf("clip %u: %s, %u Hz, %u samples, %u bytes\n", clips[i].entry.id, _PACK_formats[clips[i].entry.format],
+				rate, clips[i].entry.length, size);
+		offset = (offset + size + 3U) & ~3U; //word aligned
+		free(samples);
+	}
+	header.size = offset;
+	for(i = 0; i < header.count; i++){
+		memcpy(&_PACK_image[sizeof(header) + i * sizeof(CLIPS_EntryTypeDef)], &clips[i].entry, sizeof(CLIPS_EntryTypeDef));
+	}
+	header.crc = CRC32_Compute(&_PACK_image[sizeof(header)], header.count * sizeof(CLIPS_EntryTypeDef));
+	memcpy(_PACK_image, &header, sizeof(header));
+	if((file = fopen(output, "wb")) == NULL || fwrite(_PACK_image, 1, header.size, file) != header.size || fclose(file) != 0){
+		perror(output);
+		return 2;
+	}
+	printf("image: %u clips, %u bytes\n", header.count, header.size);
+	free(clips);
+	return 0;
+}
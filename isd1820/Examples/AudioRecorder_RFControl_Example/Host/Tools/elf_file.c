@@ -0,0 +1,121 @@
+/**
+ * elf_file.c
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+Sections and symbols of the firmware .elf, for the host tools
+----------------------------------------------------------------------
+ */
+#include "elf_file.h"
+#include <elf.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Field of the 32 or 64-bit header at {offset} */
+#define ELF_FIELD(type, offset, field) (_ELF_is64 ? \
+		((const Elf64_##type*)(_ELF_data + (offset)))->field : \
+		((const Elf32_##type*)(_ELF_data + (offset)))->field)
+
+static uint8_t* _ELF_data;
+static uint64_t _ELF_size;
+static uint8_t _ELF_is64;
+
+//Offset of the header of section {index}, 0 if out of the file.
+static uint64_t _ELF_SectionHeader(uint32_t index){
+	uint64_t offset = ELF_FIELD(Ehdr, 0, e_shoff);
+	uint64_t size = _ELF_is64 ? sizeof(Elf64_Shdr) : sizeof(Elf32_Shdr);
+	if(index >= ELF_FIELD(Ehdr, 0, e_shnum)) return 0;
+	offset += index * size;
+	return (offset + size <= _ELF_size) ? offset : 0;
+}
+
+//Contents of section {index}, NULL if out of the file.
+static const char* _ELF_Contents(uint32_t index, uint64_t* size){
+	uint64_t header = _ELF_SectionHeader(index), offset;
+	if(header == 0) return NULL;
+	offset = ELF_FIELD(Shdr, header, sh_offset);
+	*size = ELF_FIELD(Shdr, header, sh_size);
+	if(offset + *size > _ELF_size) return NULL;
+	return (const char*)_ELF_data + offset;
+}
+
+uint8_t ELF_Load(const char* path){
+	FILE* file = fopen(path, "rb");
+	long size;
+	if(file == NULL) return 0;
+	fseek(file, 0, SEEK_END);
+	size = ftell(file);
+	rewind(file);
+	free(_ELF_data);
+	_ELF_data = malloc(size > 0 ? (size_t)size : 1U);
+	_ELF_size = (uint64_t)size;
+	if(_ELF_data == NULL || size < (long)sizeof(Elf64_Ehdr) || fread(_ELF_data, 1, (size_t)size, file) != (size_t)size
+			|| memcmp(_ELF_data, ELFMAG, SELFMAG) != 0 || _ELF_data[EI_DATA] != ELFDATA2LSB){
+		fclose(file);
+		free(_ELF_data);
+		_ELF_data = NULL;
+		return 0;
+	}
+	fclose(file);
+	_ELF_is64 = (_ELF_data[EI_CLASS] == ELFCLASS64);
+	return 1;
+}
+
+const char* ELF_Section(const char* name, uint64_t* addr, uint64_t* size){
+	uint64_t header, namesSize;
+	uint32_t count, i, offset;
+	const char* names;
+	if(_ELF_data == NULL) return NULL;
+	names = _ELF_Contents(ELF_FIELD(Ehdr, 0, e_shstrndx), &namesSize);
+	if(names == NULL) return NULL;
+	count = ELF_FIELD(Ehdr, 0, e_shnum);
+	for(i = 0; i < count; i++){
+		header = _ELF_SectionHeader(i);
+		offset = ELF_FIELD(Shdr, header, sh_name);
+		if(header == 0 || offset >= namesSize || strncmp(&names[offset], name, namesSize - offset) != 0) continue;
+		*addr = ELF_FIELD(Shdr, header, sh_addr);
+		return _ELF_Contents(i, size);
+	}
+	return NULL;
+}
+
+const char* ELF_Symbol(uint64_t addr){
+	uint64_t header, size, namesSize, entry, value;
+	uint32_t count, i, name;
+	const char* symbols;
+	const char* names;
+	if(_ELF_data == NULL) return NULL;
+	count = ELF_FIELD(Ehdr, 0, e_shnum);
+	for(i = 0; i < count; i++){
+		header = _ELF_SectionHeader(i);
+		if(header && ELF_FIELD(Shdr, header, sh_type) == SHT_SYMTAB) break;
+	}
+	if(i == count) return NULL;
+	symbols = _ELF_Contents(i, &size);
+	names = _ELF_Contents(ELF_FIELD(Shdr, header, sh_link), &namesSize);
+	if(symbols == NULL || names == NULL) return NULL;
+	entry = _ELF_is64 ? sizeof(Elf64_Sym) : sizeof(Elf32_Sym);
+	addr &= ~1ULL;
+	for(i = 0; (i + 1U) * entry <= size; i++){
+		header = (uint64_t)(symbols - (const char*)_ELF_data) + i * entry;
+		if((_ELF_is64 ? ELF64_ST_TYPE(ELF_FIELD(Sym, header, st_info)) : ELF32_ST_TYPE(ELF_FIELD(Sym, header, st_info))) != STT_FUNC) continue;
+		value = ELF_FIELD(Sym, header, st_value) & ~1ULL;
+		name = ELF_FIELD(Sym, header, st_name);
+		if(name >= namesSize) continue;
+		if(addr == value || (addr > value && addr < value + ELF_FIELD(Sym, header, st_size))) return &names[name];
+	}
+	return NULL;
+}
@@ -0,0 +1,49 @@
+/**
+ * elf_file.h
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+Sections and symbols of the firmware .elf, for the host tools
+----------------------------------------------------------------------
+Reads 32-bit (the target) and 64-bit (the host tests) little-endian
+ELF files.
+----------------------------------------------------------------------
+ */
+#ifndef ELF_FILE_H
+#define ELF_FILE_H
+
+#include <stdint.h>
+
+uint8_t ELF_Load(const char* path);
+/**
+ * @brief  Reads the whole file {path}.
+ * @retval 1, or 0 if it cannot be read or is no little-endian ELF.
+ */
+
+const char* ELF_Section(const char* name, uint64_t* addr, uint64_t* size);
+/**
+ * @brief  Finds section {name} of the loaded file.
+ * @param  addr: Address of the section.
+ * @param  size: Size of the section [bytes].
+ * @retval Contents of the section, or NULL if there is none.
+ */
+
+const char* ELF_Symbol(uint64_t addr);
+/**
+ * @brief  Finds the function at {addr}, in the symbol table of the loaded file. The Thumb bit is ignored.
+ * @retval Function name, or NULL if no function holds {addr}.
+ */
+
+#endif
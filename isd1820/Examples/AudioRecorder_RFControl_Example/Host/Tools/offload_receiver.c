@@ -0,0 +1,141 @@
+/**
+ * offload_receiver.c
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+Host side of the audio offload, for offload_recv and offload_sim
+----------------------------------------------------------------------
+ */
+#include "offload_receiver.h"
+#include "stream_sender.h"
+#include "crc32.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define RECEIVER_CRC_SIZE   4U
+#define RECEIVER_REPLY_SIZE 10U //cmd, result, status, crc
+
+void RECEIVER_Init(RECEIVER_StateTypeDef* state){
+	memset(state, 0, sizeof(*state));
+}
+
+void RECEIVER_Free(RECEIVER_StateTypeDef* state){
+	free(state->file);
+	state->file = NULL;
+}
+
+//Asks for frame {next} again.
+static void _RECEIVER_Resend(RECEIVER_StateTypeDef* state){
+	state->requests++;
+	state->resending = 1;
+	state->ackDue = 1;
+	state->resendDue = 1;
+}
+
+//Takes frame 0: the header gives the file size and the frame count. Returns 0 if it is no WAV header.
+static uint8_t _RECEIVER_Header(RECEIVER_StateTypeDef* state, const uint8_t* bytes, uint32_t len){
+	uint32_t dataSize;
+	if(len != RECEIVER_HEADER_SIZE || memcmp(bytes, "RIFF", 4U) != 0 || memcmp(&bytes[8], "WAVE", 4U) != 0) return 0;
+	memcpy(&dataSize, &bytes[40], 4U);
+	state->file = malloc(RECEIVER_HEADER_SIZE + dataSize);
+	if(state->file == NULL) return 0;
+	state->size = RECEIVER_HEADER_SIZE + dataSize;
+	state->frames = 1U + (dataSize / 2U + OFFLOAD_FRAME_SAMPLES - 1U) / OFFLOAD_FRAME_SAMPLES;
+	return 1;
+}
+
+//Takes a decoded frame from the device.
+static void _RECEIVER_Frame(RECEIVER_StateTypeDef* state, const uint8_t* frame, uint32_t len){
+	uint32_t crc, seq;
+	if(len < 1U + RECEIVER_CRC_SIZE) return;
+	memcpy(&crc, &frame[len - RECEIVER_CRC_SIZE], RECEIVER_CRC_SIZE);
+	if(frame[0] == (UARTCMD_OFFLOAD_DATA | UARTCMD_REPLY)){
+		if(len < 3U + RECEIVER_CRC_SIZE || crc != CRC32_Compute(frame, len - RECEIVER_CRC_SIZE)){
+			state->bad++;
+			if(!state->resending && !RECEIVER_Done(state)) _RECEIVER_Resend(state);
+			return;
+		}
+		seq = frame[1] | (uint32_t)frame[2] << 8; //a file is far under 65536 frames: no wrap
+		len -= 3U + RECEIVER_CRC_SIZE;
+		if(seq != state->next){
+			state->dropped++;
+			if(seq < state->next) state->ackDue = 1; //seen already: the acknowledgement was lost
+			else if(!state->resending || seq <= state->last) _RECEIVER_Resend(state); //first gap, or the device went back and missed it again
+			state->last = seq;
+			return;
+		}
+		if(seq == 0){
+			if(!_RECEIVER_Header(state, &frame[3], len)){
+				state->bad++;
+				return;
+			}
+		}else if(state->length + len > state->size || (len < OFFLOAD_FRAME_SAMPLES * 2U && seq + 1U != state->frames)){
+			state->bad++; //not the size the header gave
+			return;
+		}
+		memcpy(&state->file[state->length], &frame[3], len);
+		state->length += len;
+		state->next++;
+		state->taken++;
+		state->last = seq;
+		state->resending = 0;
+		state->ackDue = 1;
+		state->resendDue = 0;
+		return;
+	}
+	if(len != RECEIVER_REPLY_SIZE || (frame[0] & UARTCMD_REPLY) == 0) return;
+	if(crc != CRC32_Compute(frame, len - RECEIVER_CRC_SIZE)) return;
+	state->reply = frame[0];
+	state->result = frame[1];
+	memcpy(&state->status, &frame[2], 4U);
+}
+
+void RECEIVER_Input(RECEIVER_StateTypeDef* state, const uint8_t* bytes, uint32_t count){
+	uint8_t frame[RECEIVER_MAX_ENCODED];
+	uint32_t in, out, code, i;
+	while(count--){
+		if(*bytes != 0){
+			if(state->rxLen < sizeof(state->rx)) state->rx[state->rxLen] = *bytes;
+			state->rxLen++;
+			bytes++;
+			continue;
+		}
+		bytes++;
+		if(state->rxLen <= sizeof(state->rx)){ //COBS, longer frames are not ours
+			for(in = 0, out = 0; in < state->rxLen; ){
+				code = state->rx[in++];
+				for(i = 1; i < code && in < state->rxLen; i++) frame[out++] = state->rx[in++];
+				if(code != 0xFFU && in < state->rxLen) frame[out++] = 0;
+			}
+			_RECEIVER_Frame(state, frame, out);
+		}
+		state->rxLen = 0;
+	}
+}
+
+uint16_t RECEIVER_Ack(RECEIVER_StateTypeDef* state, uint8_t* out){
+	uint8_t payload[3];
+	if(!state->ackDue) return 0;
+	payload[0] = (uint8_t)state->next;
+	payload[1] = (uint8_t)(state->next >> 8);
+	payload[2] = state->resendDue;
+	state->ackDue = 0;
+	state->resendDue = 0;
+	return SENDER_Command(UARTCMD_OFFLOAD_ACK, payload, sizeof(payload), out);
+}
+
+uint8_t RECEIVER_Done(const RECEIVER_StateTypeDef* state){
+	return state->frames && state->next >= state->frames;
+}
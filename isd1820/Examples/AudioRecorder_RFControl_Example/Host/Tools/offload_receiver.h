@@ -0,0 +1,97 @@
+/**
+ * offload_receiver.h
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+Host side of the audio offload, for offload_recv and offload_sim
+----------------------------------------------------------------------
+Takes the UARTCMD_OFFLOAD_DATA frames of offload.h and builds the
+UARTCMD_OFFLOAD_ACK frames that answer them, with no I/O of its own:
+the caller moves the bytes, on a serial port or through the simulated
+USART2.
+
+Frames are kept in order, the file growing from the WAV header of
+frame 0, which also gives the frame count. Each frame taken is
+acknowledged (RECEIVER_Ack(), one acknowledgement for every frame
+taken since the last). A frame after a missing one, or one failing
+its crc, asks for the missing one again, once: the frames the device
+had in flight behind it, numbered up from the last one received, are
+dropped without asking again. A frame numbered at or below the last
+one, but still ahead, shows the device went back and lost the frame
+again, and asks again. Anything else is left to the device timeout.
+----------------------------------------------------------------------
+ */
+#ifndef OFFLOAD_RECEIVER_H
+#define OFFLOAD_RECEIVER_H
+
+#include "offload.h"
+#include "uart_cmd.h"
+
+#define RECEIVER_MAX_FRAME   (3U + OFFLOAD_FRAME_SAMPLES * 2U + 4U) //cmd, seq, samples, crc
+#define RECEIVER_MAX_ENCODED (RECEIVER_MAX_FRAME + RECEIVER_MAX_FRAME / 254U + 2U) //COBS and the delimiter
+#define RECEIVER_HEADER_SIZE 44U //the WAV header of frame 0
+
+typedef struct {
+	uint8_t* file;        //the WAV file, NULL before frame 0
+	uint32_t size;        //its size, from the header [bytes]
+	uint32_t length;      //bytes received, in order
+	uint32_t frames;      //frame count, 0 before frame 0
+	uint32_t next;        //next frame expected
+	uint32_t last;        //number of the last frame received
+	uint8_t resending;    //a resend was asked, and its frame did not come yet
+	uint8_t ackDue;       //an acknowledgement is to go
+	uint8_t resendDue;    //with the resend flag
+	uint32_t taken;       //frames taken
+	uint32_t dropped;     //frames dropped, out of order or seen already
+	uint32_t bad;         //frames failing their crc
+	uint32_t requests;    //resends asked
+	uint8_t reply;        //command of the last reply that is not data, UARTCMD_REPLY set, 0 before any
+	uint8_t result;       //its result, a HAL_StatusTypeDef
+	uint32_t status;      //its status word, OFFLOAD_GetAck()
+	uint8_t rx[RECEIVER_MAX_ENCODED]; //frame being received
+	uint32_t rxLen;
+} RECEIVER_StateTypeDef;
+
+void RECEIVER_Init(RECEIVER_StateTypeDef* state);
+/**
+ * @brief  Expects a new file, from frame 0.
+ * @retval None
+ */
+
+void RECEIVER_Free(RECEIVER_StateTypeDef* state);
+/**
+ * @brief  Frees the file.
+ * @retval None
+ */
+
+void RECEIVER_Input(RECEIVER_StateTypeDef* state, const uint8_t* bytes, uint32_t count);
+/**
+ * @brief  Takes {count} bytes received from the device: data frames, replies, and telemetry, left out.
+ * @retval None
+ */
+
+uint16_t RECEIVER_Ack(RECEIVER_StateTypeDef* state, uint8_t* out);
+/**
+ * @brief  Builds the UARTCMD_OFFLOAD_ACK frame due, if any.
+ * @param  out: Room for SENDER_MAX_ENCODED bytes (see stream_sender.h).
+ * @retval Size of the frame [bytes], or 0 if none is due.
+ */
+
+uint8_t RECEIVER_Done(const RECEIVER_StateTypeDef* state);
+/**
+ * @brief  Tells whether every frame of the file was taken.
+ */
+
+#endif
@@ -0,0 +1,151 @@
+/**
+ * offload_recv.c
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+Recording or clip off the board, to a WAV file over its serial port
+----------------------------------------------------------------------
+Usage: offload_recv [-c id] [-b baud] device output.wav
+Asks the board on the serial port {device} (USART2, 2000000 baud by
+default) for the flash recording, or clip {id} of the library with -c,
+and writes the WAV file it sends to output.wav as it comes: 16-bit PCM
+mono at the rate it was recorded at (see offload.h). Frames are
+acknowledged and asked again by Tools/offload_receiver.h. Offload_sim
+runs the same receiver against the firmware, with no board.
+Prints what the receiver did, the file size, and the throughput against
+what the line carries at the baud rate, 10 bits a byte:
+	frames: taken taken, dropped dropped, bad bad, requests resends asked
+	file: size bytes
+	throughput: rate KB/s, share% of the line
+The exit status is 2 for a bad argument or file, 1 if the board does
+not answer, has no such recording or clip, or stops sending for
+OFFLOAD_RETRIES timeouts.
+----------------------------------------------------------------------
+ */
+#include "offload_receiver.h"
+#include "stream_sender.h"
+#include "serial_port.h"
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#define RECV_REPLY   500U //ms to wait for the reply to the offload command
+#define RECV_GIVE_UP (OFFLOAD_RETRIES * OFFLOAD_TIMEOUT) //ms without a frame taken
+
+static RECEIVER_StateTypeDef _RECV_receiver;
+
+//Monotonic time [ms].
+static double _RECV_Now(void){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+//Reads what the board sent, waiting up to {ms}, and acknowledges it. Returns 0 if the port fails.
+static uint8_t _RECV_Read(int fd, int ms){
+	struct pollfd pfd = {fd, POLLIN, 0};
+	uint8_t bytes[4096], ack[SENDER_MAX_ENCODED];
+	uint16_t len;
+	ssize_t n;
+	if(poll(&pfd, 1, ms) <= 0) return 1;
+	while((n = read(fd, bytes, sizeof(bytes))) > 0){
+		RECEIVER_Input(&_RECV_receiver, bytes, (uint32_t)n);
+		if((len = RECEIVER_Ack(&_RECV_receiver, ack)) != 0 && !SERIAL_Write(fd, ack, len)) return 0;
+	}
+	return 1;
+}
+
+int main(int argc, char** argv){
+	uint8_t request[3] = {UARTCMD_OFFLOAD_RECORDING, 0, 0}, cancel[3] = {UARTCMD_OFFLOAD_CANCEL, 0, 0};
+	uint8_t frame[SENDER_MAX_ENCODED];
+	uint32_t baud = 2000000U, id = 0, taken = 0;
+	double begin, progress, took;
+	FILE* output;
+	int option, fd;
+	while((option = getopt(argc, argv, "c:b:")) != -1){
+		switch(option){
+			case 'c':
+				request[0] = UARTCMD_OFFLOAD_CLIP;
+				id = (uint32_t)atoi(optarg);
+				break;
+			case 'b':
+				baud = (uint32_t)atoi(optarg);
+				break;
+			default:
+				baud = 0;
+				break;
+		}
+	}
+	if(argc - optind != 2 || baud == 0 || id > 0xFFFFU){
+		fprintf(stderr, "usage: offload_recv [-c id] [-b baud] device output.wav\n");
+		return 2;
+	}
+	if((fd = SERIAL_Open(argv[optind], baud)) < 0){
+		fprintf(stderr, "%s: cannot open at %u baud\n", argv[optind], baud);
+		return 2;
+	}
+	if((output = fopen(argv[optind + 1], "wb")) == NULL){
+		fprintf(stderr, "%s: cannot write\n", argv[optind + 1]);
+		return 2;
+	}
+
+	RECEIVER_Init(&_RECV_receiver);
+	request[1] = (uint8_t)id;
+	request[2] = (uint8_t)(id >> 8);
+	begin = progress = _RECV_Now();
+	if(!SERIAL_Write(fd, frame, SENDER_Command(UARTCMD_OFFLOAD, request, sizeof(request), frame))){
+		fprintf(stderr, "%s: write failed\n", argv[optind]);
+		return 1;
+	}
+	while(_RECV_receiver.reply != (UARTCMD_OFFLOAD | UARTCMD_REPLY) && _RECV_Now() - begin < RECV_REPLY){
+		if(!_RECV_Read(fd, 10)) break;
+	}
+	if(_RECV_receiver.reply != (UARTCMD_OFFLOAD | UARTCMD_REPLY)){
+		fprintf(stderr, "no reply to the offload command\n");
+		return 1;
+	}
+	if(_RECV_receiver.result != HAL_OK){
+		fprintf(stderr, _RECV_receiver.result == HAL_BUSY ? "an offload runs already\n" : "no such recording or clip\n");
+		return 1;
+	}
+	while(!RECEIVER_Done(&_RECV_receiver)){
+		if(!_RECV_Read(fd, 10)){
+			fprintf(stderr, "%s: write failed\n", argv[optind]);
+			return 1;
+		}
+		if(_RECV_receiver.taken != taken){
+			taken = _RECV_receiver.taken;
+			progress = _RECV_Now();
+		}else if(_RECV_Now() - progress > RECV_GIVE_UP){
+			SERIAL_Write(fd, frame, SENDER_Command(UARTCMD_OFFLOAD, cancel, sizeof(cancel), frame));
+			fprintf(stderr, "the board stopped sending: %u of %u frames taken\n", _RECV_receiver.next, _RECV_receiver.frames);
+			return 1;
+		}
+	}
+	took = (_RECV_Now() - begin) / 1000.0;
+	if(fwrite(_RECV_receiver.file, 1, _RECV_receiver.length, output) != _RECV_receiver.length || fclose(output) != 0){
+		fprintf(stderr, "%s: cannot write\n", argv[optind + 1]);
+		return 2;
+	}
+
+	printf("frames: %u taken, %u dropped, %u bad, %u resends asked\n", _RECV_receiver.taken, _RECV_receiver.dropped, _RECV_receiver.bad, _RECV_receiver.requests);
+	printf("file: %u bytes\n", _RECV_receiver.length);
+	printf("throughput: %.1f KB/s, %.1f%% of the line\n", _RECV_receiver.length / took / 1000.0, _RECV_receiver.length * 10.0 / baud / took * 100.0);
+	close(fd);
+	RECEIVER_Free(&_RECV_receiver);
+	return 0;
+}
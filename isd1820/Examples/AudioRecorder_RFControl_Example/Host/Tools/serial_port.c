@@ -0,0 +1,70 @@
+/**
+ * serial_port.c
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+Serial port to the board, for stream_send and offload_recv
+----------------------------------------------------------------------
+ */
+#include "serial_port.h"
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+
+static const struct {
+	uint32_t baud;
+	speed_t speed;
+} _SERIAL_speeds[] = {
+	{115200U, B115200}, {230400U, B230400}, {460800U, B460800}, {921600U, B921600},
+	{1000000U, B1000000}, {2000000U, B2000000},
+};
+
+int SERIAL_Open(const char* device, uint32_t baud){
+	struct termios tio;
+	uint32_t i;
+	int fd;
+	for(i = 0; i < sizeof(_SERIAL_speeds) / sizeof(_SERIAL_speeds[0]); i++){
+		if(_SERIAL_speeds[i].baud == baud) break;
+	}
+	if(i == sizeof(_SERIAL_speeds) / sizeof(_SERIAL_speeds[0])) return -1;
+	fd = open(device, O_RDWR | O_NOCTTY);
+	if(fd < 0) return -1;
+	if(tcgetattr(fd, &tio) != 0){
+		close(fd);
+		return -1;
+	}
+	cfmakeraw(&tio);
+	cfsetispeed(&tio, _SERIAL_speeds[i].speed);
+	cfsetospeed(&tio, _SERIAL_speeds[i].speed);
+	tio.c_cc[VMIN] = 0;
+	tio.c_cc[VTIME] = 0;
+	if(tcsetattr(fd, TCSANOW, &tio) != 0){
+		close(fd);
+		return -1;
+	}
+	tcflush(fd, TCIOFLUSH);
+	return fd;
+}
+
+uint8_t SERIAL_Write(int fd, const uint8_t* bytes, uint32_t count){
+	ssize_t n;
+	while(count){
+		n = write(fd, bytes, count);
+		if(n <= 0) return 0;
+		bytes += n;
+		count -= (uint32_t)n;
+	}
+	return 1;
+}
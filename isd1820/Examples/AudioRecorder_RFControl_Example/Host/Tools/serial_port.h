@@ -0,0 +1,42 @@
+/**
+ * serial_port.h
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+Serial port to the board, for stream_send and offload_recv
+----------------------------------------------------------------------
+Opens a tty raw, 8N1 with no flow control, at one of the rates the
+USB-serial adapters and USART2 share, and writes whole buffers.
+----------------------------------------------------------------------
+ */
+#ifndef SERIAL_PORT_H
+#define SERIAL_PORT_H
+
+#include <stdint.h>
+
+int SERIAL_Open(const char* device, uint32_t baud);
+/**
+ * @brief  Opens {device} raw at {baud}, with reads that do not block, and drops what is pending.
+ * @param  baud: 115200, 230400, 460800, 921600, 1000000 or 2000000.
+ * @retval The file descriptor, or -1 for another rate or if the port cannot be set.
+ */
+
+uint8_t SERIAL_Write(int fd, const uint8_t* bytes, uint32_t count);
+/**
+ * @brief  Writes {count} bytes, waiting as long as it takes.
+ * @retval 1, or 0 on an error.
+ */
+
+#endif
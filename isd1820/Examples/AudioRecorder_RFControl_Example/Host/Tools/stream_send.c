@@ -0,0 +1,203 @@
+/**
+ * stream_send.c
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+WAV file to the board, as an audio stream over its serial port
+----------------------------------------------------------------------
+Usage: stream_send [-f pcm16|ulaw|adpcm] [-l] [-r dac|feedthrough|record]
+                   [-b baud] device input.wav
+Streams the WAV file, at PLAYBACK_SAMPLE_RATE, to the board on the
+serial port {device} (USART2, 2000000 baud by default) with the
+UARTCMD_STREAM_ commands of uart_cmd.h, the window kept by
+Tools/stream_sender.h:
+	-f  format on the line, pcm16 by default;
+	-l  live mode: each frame goes when its last sample is due on the
+	    host clock, as a live source would send it;
+	-r  playback route of playback.h, dac by default; record programs
+	    the ISD1820 with the clip.
+Without a reply for 100ms, the sender goes back to the oldest frame
+the board did not take. Stream_sim runs the same sender against the
+firmware, with no board.
+Prints the frames sent and sent again, then the time taken:
+	frames: sent sent, resent sent again
+	time: seconds s, ratio x real time
+The exit status is 2 for a bad argument or file, 1 if the board does
+not answer or refuses the stream.
+----------------------------------------------------------------------
+ */
+#include "stream_sender.h"
+#include "playback.h"
+#include "serial_port.h"
+#include "wav_file.h"
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define SEND_TIMEOUT 100U //ms without a reply before going back
+#define SEND_RETRIES 20U  //timeouts in a row before giving up
+
+static const char* const _SEND_formats[] = {
+	[CODEC_FORMAT_PCM16] = "pcm16",
+	[CODEC_FORMAT_ULAW]  = "ulaw",
+	[CODEC_FORMAT_IMA_ADPCM] = "adpcm",
+};
+
+static const char* const _SEND_routes[] = {
+	[PLAYBACK_ROUTE_DAC]         = "dac",
+	[PLAYBACK_ROUTE_FEEDTHROUGH] = "feedthrough",
+	[PLAYBACK_ROUTE_RECORD]      = "record",
+};
+
+static SENDER_StateTypeDef _SEND_sender;
+
+//Index of {name} in {names}, or {count} if it is none.
+static uint32_t _SEND_Find(const char* const* names, uint32_t count, const char* name){
+	uint32_t i;
+	for(i = 0; i < count; i++){
+		if(names[i] != NULL && strcmp(name, names[i]) == 0) break;
+	}
+	return i;
+}
+
+//Monotonic time [ms].
+static double _SEND_Now(void){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+//Reads what the board sent, waiting up to {ms}.
+static void _SEND_Read(int fd, int ms){
+	struct pollfd pfd = {fd, POLLIN, 0};
+	uint8_t bytes[256];
+	ssize_t n;
+	if(poll(&pfd, 1, ms) <= 0) return;
+	while((n = read(fd, bytes, sizeof(bytes))) > 0) SENDER_Input(&_SEND_sender, bytes, (uint32_t)n);
+}
+
+//Sends {cmd} and waits for its reply. Returns its result, or 0xFF without one.
+static uint8_t _SEND_Command(int fd, uint8_t cmd, const void* payload, uint16_t len){
+	uint8_t frame[SENDER_MAX_ENCODED];
+	uint32_t retry;
+	double start;
+	for(retry = 0; retry < 3U; retry++){
+		_SEND_sender.reply = 0;
+		if(!SERIAL_Write(fd, frame, SENDER_Command(cmd, payload, len, frame))) return 0xFFU;
+		for(start = _SEND_Now(); _SEND_Now() - start < SEND_TIMEOUT; ){
+			_SEND_Read(fd, 10);
+			if(_SEND_sender.reply == (cmd | UARTCMD_REPLY)) return _SEND_sender.result;
+		}
+	}
+	return 0xFFU;
+}
+
+int main(int argc, char** argv){
+	uint8_t start[3] = {CODEC_FORMAT_PCM16, PLAYBACK_ROUTE_DAC, STREAM_MODE_BUFFERED}, end = 0;
+	uint8_t frame[SENDER_MAX_ENCODED];
+	uint32_t baud = 2000000U, format = CODEC_FORMAT_PCM16, route = PLAYBACK_ROUTE_DAC, rate, count, due, acked = 0, retries = 0;
+	double begin, last, now, progress, elapsed = 0, took;
+	uint16_t len;
+	uint8_t result, bad = 0;
+	int16_t* samples;
+	int option, fd;
+	while((option = getopt(argc, argv, "f:lr:b:")) != -1){
+		switch(option){
+			case 'f':
+				format = _SEND_Find(_SEND_formats, sizeof(_SEND_formats) / sizeof(_SEND_formats[0]), optarg);
+				break;
+			case 'l':
+				start[2] = STREAM_MODE_LIVE;
+				break;
+			case 'r':
+				route = _SEND_Find(_SEND_routes, sizeof(_SEND_routes) / sizeof(_SEND_routes[0]), optarg);
+				break;
+			case 'b':
+				baud = (uint32_t)atoi(optarg);
+				break;
+			default:
+				bad = 1;
+				break;
+		}
+	}
+	if(bad || argc - optind != 2 || format == 0 || format >= sizeof(_SEND_formats) / sizeof(_SEND_formats[0])
+			|| route >= sizeof(_SEND_routes) / sizeof(_SEND_routes[0])){
+		fprintf(stderr, "usage: stream_send [-f pcm16|ulaw|adpcm] [-l] [-r dac|feedthrough|record] [-b baud] device input.wav\n");
+		return 2;
+	}
+	if((samples = WAV_Read(argv[optind + 1], &rate, &count)) == NULL){
+		fprintf(stderr, "%s: no PCM WAV file\n", argv[optind + 1]);
+		return 2;
+	}
+	if(rate != PLAYBACK_SAMPLE_RATE){
+		fprintf(stderr, "%s: %u Hz, the stream is %u Hz\n", argv[optind + 1], rate, PLAYBACK_SAMPLE_RATE);
+		return 2;
+	}
+	if(!SENDER_Init(&_SEND_sender, (CODEC_FormatTypeDef)format, samples, count)) return 2;
+	if((fd = SERIAL_Open(argv[optind], baud)) < 0){
+		fprintf(stderr, "%s: cannot open at %u baud\n", argv[optind], baud);
+		return 2;
+	}
+
+	start[0] = (uint8_t)format;
+	start[1] = (uint8_t)route;
+	if((result = _SEND_Command(fd, UARTCMD_STREAM_START, start, sizeof(start))) != HAL_OK){
+		if(result == 0xFFU) fprintf(stderr, "no reply to the stream start\n");
+		else fprintf(stderr, "stream refused: %u\n", result);
+		return 1;
+	}
+	begin = last = progress = _SEND_Now();
+	while(!SENDER_Done(&_SEND_sender)){
+		now = _SEND_Now();
+		elapsed += (now - last) * PLAYBACK_SAMPLE_RATE / 1000.0;
+		if(elapsed >= 1.0){ //whole samples played since
+			SENDER_Elapse(&_SEND_sender, (uint32_t)elapsed);
+			elapsed -= (uint32_t)elapsed;
+		}
+		last = now;
+		due = start[2] == STREAM_MODE_LIVE ? (uint32_t)((now - begin) * PLAYBACK_SAMPLE_RATE / 1000.0 / STREAM_MAX_WRITE) : 0xFFFFFFFFU;
+		while((len = SENDER_Next(&_SEND_sender, due, frame)) != 0){
+			if(!SERIAL_Write(fd, frame, len)){
+				fprintf(stderr, "%s: write failed\n", argv[optind]);
+				return 1;
+			}
+		}
+		_SEND_Read(fd, 2);
+		if(_SEND_sender.acked != acked || (_SEND_sender.next == _SEND_sender.acked && _SEND_sender.next >= due)){
+			acked = _SEND_sender.acked; //progress, or nothing to send yet
+			progress = now;
+			retries = 0;
+		}else if(now - progress >= SEND_TIMEOUT){
+			if(++retries > SEND_RETRIES){
+				fprintf(stderr, "no reply: %u of %u frames taken\n", _SEND_sender.acked, _SEND_sender.frames);
+				return 1;
+			}
+			SENDER_Timeout(&_SEND_sender);
+			progress = now;
+		}
+	}
+	took = (_SEND_Now() - begin) / 1000.0;
+	if(_SEND_Command(fd, UARTCMD_STREAM_END, &end, 1) != HAL_OK) fprintf(stderr, "no reply to the stream end\n");
+
+	printf("frames: %u sent, %u sent again\n", _SEND_sender.sent, _SEND_sender.resent);
+	printf("time: %.2f s, %.2f x real time\n", took, count ? took * PLAYBACK_SAMPLE_RATE / count : 0.0);
+	close(fd);
+	SENDER_Free(&_SEND_sender);
+	free(samples);
+	return 0;
+}
@@ -0,0 +1,187 @@
+/**
+ * stream_sender.c
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+Host side of the audio stream, for stream_send and stream_sim
+----------------------------------------------------------------------
+ */
+#include "stream_sender.h"
+#include "crc32.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define SENDER_CRC_SIZE   4U
+#define SENDER_REPLY_SIZE 10U //cmd, result, ack, crc
+
+//Encoded size of a data frame of {bytes} stream bytes, an upper bound.
+static uint32_t _SENDER_Encoded(uint32_t bytes){
+	bytes += 3U + SENDER_CRC_SIZE;
+	return bytes + bytes / 254U + 2U;
+}
+
+uint8_t SENDER_Init(SENDER_StateTypeDef* state, CODEC_FormatTypeDef format, const int16_t* samples, uint32_t count){
+	CODEC_AdpcmStateTypeDef adpcm = {0, 0};
+	memset(state, 0, sizeof(*state));
+	state->format = format;
+	count &= ~1U; //the device takes even sample counts
+	switch(format){
+		case CODEC_FORMAT_PCM16:
+			state->size = count * 2U;
+			state->frameBytes = STREAM_MAX_WRITE * 2U;
+			break;
+		case CODEC_FORMAT_ULAW:
+			state->size = count;
+			state->frameBytes = STREAM_MAX_WRITE;
+			break;
+		case CODEC_FORMAT_IMA_ADPCM:
+			state->size = count / 2U;
+			state->frameBytes = STREAM_MAX_WRITE / 2U;
+			break;
+		default:
+			return 0;
+	}
+	state->data = malloc(state->size ? state->size : 1U);
+	if(state->data == NULL) return 0;
+	if(format == CODEC_FORMAT_PCM16) memcpy(state->data, samples, state->size);
+	else if(format == CODEC_FORMAT_ULAW) CODEC_UlawEncode(samples, state->data, count);
+	else CODEC_AdpcmEncode(&adpcm, samples, state->data, count); //one coder state throughout, as STREAM_Write() decodes
+	state->frames = (state->size + state->frameBytes - 1U) / state->frameBytes;
+	state->room = STREAM_BUFFER_SIZE;
+	return 1;
+}
+
+void SENDER_Free(SENDER_StateTypeDef* state){
+	free(state->data);
+	state->data = NULL;
+}
+
+uint16_t SENDER_Command(uint8_t cmd, const void* payload, uint16_t len, uint8_t* out){
+	uint8_t frame[UARTCMD_MAX_FRAME];
+	uint32_t crc;
+	uint16_t code = 0, n = 1, i;
+	frame[0] = cmd;
+	memcpy(&frame[1], payload, len);
+	crc = CRC32_Compute(frame, len + 1U);
+	memcpy(&frame[len + 1U], &crc, SENDER_CRC_SIZE);
+	len += 1U + SENDER_CRC_SIZE;
+	for(i = 0; i < len; i++){ //COBS
+		if(frame[i] == 0){
+			out[code] = (uint8_t)(n - code);
+			code = n++;
+			continue;
+		}
+		out[n++] = frame[i];
+		if(n - code == 0xFFU){
+			out[code] = 0xFFU;
+			code = n++;
+		}
+	}
+	out[code] = (uint8_t)(n - code);
+	out[n++] = 0;
+	return n;
+}
+
+uint16_t SENDER_Next(SENDER_StateTypeDef* state, uint32_t due, uint8_t* out){
+	uint8_t payload[2U + STREAM_MAX_WRITE * 2U];
+	uint32_t offset, bytes, flight;
+	uint16_t seq;
+	if(state->next >= state->frames || state->next >= due) return 0;
+	offset = state->next * state->frameBytes;
+	bytes = state->size - offset;
+	if(bytes > state->frameBytes) bytes = state->frameBytes;
+	flight = state->next - state->acked;
+	if(!state->probe){
+		if((flight + 1U) * STREAM_MAX_WRITE > state->room) return 0;
+		if((flight + 1U) * _SENDER_Encoded(state->frameBytes) > UARTCMD_RX_BUFFER_SIZE) return 0;
+	}
+	state->probe = 0;
+	seq = (uint16_t)state->next;
+	memcpy(payload, &seq, 2U);
+	memcpy(&payload[2], &state->data[offset], bytes);
+	state->next++;
+	state->sent++;
+	return SENDER_Command(UARTCMD_STREAM_DATA, payload, (uint16_t)(2U + bytes), out);
+}
+
+//Goes back to the frame the device expects.
+static void _SENDER_Rewind(SENDER_StateTypeDef* state){
+	state->resent += state->next - state->acked;
+	state->next = state->acked;
+	state->rewound = state->acked;
+	state->rewinding = 1;
+}
+
+//Takes a decoded frame from the device.
+static void _SENDER_Frame(SENDER_StateTypeDef* state, const uint8_t* frame, uint32_t len){
+	uint32_t crc, ack;
+	uint16_t seq;
+	if(len != SENDER_REPLY_SIZE || (frame[0] & UARTCMD_REPLY) == 0) return;
+	memcpy(&crc, &frame[len - SENDER_CRC_SIZE], SENDER_CRC_SIZE);
+	if(crc != CRC32_Compute(frame, len - SENDER_CRC_SIZE)) return;
+	state->reply = frame[0];
+	state->result = frame[1];
+	if(frame[0] != (UARTCMD_STREAM_DATA | UARTCMD_REPLY)) return;
+	memcpy(&ack, &frame[2], 4U);
+	seq = (uint16_t)ack;
+	state->acked += (uint16_t)(seq - (uint16_t)state->acked); //numbers wrap at 16 bits, frame counts do not
+	if(state->acked > state->next) state->next = state->acked; //a late reply to frames sent again
+	state->room = ack >> 16;
+	if(STREAM_BUFFER_SIZE - state->room >= STREAM_PREFILL) state->draining = 1; //playback started, if it had not
+	if(state->acked > state->rewound) state->rewinding = 0;
+	if(frame[1] != HAL_OK){
+		state->refused++;
+		if(!state->rewinding) _SENDER_Rewind(state); //else a refusal of a frame sent before going back: the timeout covers the frame sent again being lost
+	}
+}
+
+void SENDER_Elapse(SENDER_StateTypeDef* state, uint32_t samples){
+	if(!state->draining) return;
+	state->room += samples;
+	if(state->room > STREAM_BUFFER_SIZE) state->room = STREAM_BUFFER_SIZE;
+}
+
+void SENDER_Input(SENDER_StateTypeDef* state, const uint8_t* bytes, uint32_t count){
+	uint8_t frame[SENDER_MAX_ENCODED];
+	uint32_t in, out, code, i;
+	while(count--){
+		if(*bytes != 0){
+			if(state->rxLen < sizeof(state->rx)) state->rx[state->rxLen] = *bytes;
+			state->rxLen++;
+			bytes++;
+			continue;
+		}
+		bytes++;
+		if(state->rxLen <= sizeof(state->rx)){ //COBS, longer frames are telemetry or offload: not ours
+			for(in = 0, out = 0; in < state->rxLen; ){
+				code = state->rx[in++];
+				for(i = 1; i < code && in < state->rxLen; i++) frame[out++] = state->rx[in++];
+				if(code != 0xFFU && in < state->rxLen) frame[out++] = 0;
+			}
+			_SENDER_Frame(state, frame, out);
+		}
+		state->rxLen = 0;
+	}
+}
+
+void SENDER_Timeout(SENDER_StateTypeDef* state){
+	_SENDER_Rewind(state);
+	state->rewinding = 0;
+	state->probe = 1;
+}
+
+uint8_t SENDER_Done(const SENDER_StateTypeDef* state){
+	return state->acked >= state->frames;
+}
@@ -0,0 +1,123 @@
+/**
+ * stream_sender.h
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+Host side of the audio stream, for stream_send and stream_sim
+----------------------------------------------------------------------
+Builds the UARTCMD_STREAM_ frames of uart_cmd.h and follows the
+replies, with no I/O of its own: the caller moves the bytes, on a
+serial port or through the simulated USART2.
+
+The clip is encoded whole by the Core codec at SENDER_Init(), so a
+frame sent again is the same bytes, ADPCM coder state included. Frames
+hold STREAM_MAX_WRITE samples. A frame is sent while:
+	- the room of the last reply, plus what the device played since
+	  (SENDER_Elapse()) once it plays, holds it and every frame in
+	  flight;
+	- the frames in flight fit UARTCMD_RX_BUFFER_SIZE encoded, so the
+	  device parser cannot be lapped by the frames it has not read;
+	- in live mode, its last sample is due on the host clock.
+A reply refusing a frame (HAL_ERROR: one before it was lost; HAL_BUSY:
+no room) sends again from the number it expects; the refusals of the
+frames that were in flight behind it are then expected, and ignored
+until the device takes a frame again. SENDER_Timeout(), called when
+replies stop, does the same and sends one frame whatever the room, so
+a full buffer is polled rather than waited on forever.
+----------------------------------------------------------------------
+ */
+#ifndef STREAM_SENDER_H
+#define STREAM_SENDER_H
+
+#include "codec.h"
+#include "stream.h"
+#include "uart_cmd.h"
+
+#define SENDER_MAX_ENCODED (UARTCMD_MAX_FRAME + UARTCMD_MAX_FRAME / 254U + 2U) //COBS and the delimiter
+
+typedef struct {
+	CODEC_FormatTypeDef format;
+	uint8_t* data;        //the encoded clip
+	uint32_t frames;      //frame count
+	uint32_t frameBytes;  //bytes per frame, the last one may be shorter
+	uint32_t size;        //bytes in {data}
+	uint32_t acked;       //frames the device took
+	uint32_t next;        //next frame to send
+	uint32_t room;        //free room in the device buffer, from the last reply on [samples]
+	uint8_t draining;     //the device plays: the room grows between replies
+	uint8_t probe;        //one frame may go whatever the room
+	uint32_t rewound;     //frame sending went back to
+	uint8_t rewinding;    //refusals of the frames sent before going back are due
+	uint32_t sent;        //frames sent, again or not
+	uint32_t resent;      //frames sent again
+	uint32_t refused;     //replies refusing a frame
+	uint8_t reply;        //command of the last reply, UARTCMD_REPLY set, 0 before any
+	uint8_t result;       //its result, a HAL_StatusTypeDef
+	uint8_t rx[SENDER_MAX_ENCODED]; //reply being received
+	uint32_t rxLen;
+} SENDER_StateTypeDef;
+
+uint8_t SENDER_Init(SENDER_StateTypeDef* state, CODEC_FormatTypeDef format, const int16_t* samples, uint32_t count);
+/**
+ * @brief  Encodes {count} samples at PLAYBACK_SAMPLE_RATE in {format}, to send from frame 0.
+ * @retval 1, or 0 for an unknown format or no memory.
+ */
+
+void SENDER_Free(SENDER_StateTypeDef* state);
+/**
+ * @brief  Frees the encoded clip.
+ * @retval None
+ */
+
+uint16_t SENDER_Command(uint8_t cmd, const void* payload, uint16_t len, uint8_t* out);
+/**
+ * @brief  Builds the frame of {cmd} with {len} bytes of {payload}: crc, COBS and delimiter.
+ * @param  out: Room for SENDER_MAX_ENCODED bytes.
+ * @retval Size of the frame [bytes].
+ */
+
+uint16_t SENDER_Next(SENDER_StateTypeDef* state, uint32_t due, uint8_t* out);
+/**
+ * @brief  Builds the next data frame, if one may go now.
+ * @param  due: Frames the host clock has reached (live mode), or 0xFFFFFFFF to send as fast as the device takes them.
+ * @param  out: Room for SENDER_MAX_ENCODED bytes.
+ * @retval Size of the frame [bytes], or 0 if none may go.
+ */
+
+void SENDER_Elapse(SENDER_StateTypeDef* state, uint32_t samples);
+/**
+ * @brief  Counts {samples} periods of PLAYBACK_SAMPLE_RATE on the host clock: once the buffer was filled
+ *         to STREAM_PREFILL, as many samples were played, and their room is free.
+ * @retval None
+ */
+
+void SENDER_Input(SENDER_StateTypeDef* state, const uint8_t* bytes, uint32_t count);
+/**
+ * @brief  Takes {count} bytes received from the device. Replies are kept (reply, result), those to data frames move the window. Other frames are left out.
+ * @retval None
+ */
+
+void SENDER_Timeout(SENDER_StateTypeDef* state);
+/**
+ * @brief  No reply came for a while: sends again from the oldest frame not taken, one of them whatever the room.
+ * @retval None
+ */
+
+uint8_t SENDER_Done(const SENDER_StateTypeDef* state);
+/**
+ * @brief  Tells whether the device took every frame.
+ */
+
+#endif
@@ -0,0 +1,158 @@
+/**
+ * swo_decode.c
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+SWO stream to timeline
+----------------------------------------------------------------------
+Usage: swo_decode [-j] [-e firmware.elf] [capture]
+Reads the ITM packets captured from SWO (the file, or stdin) and writes
+one CSV line per software packet to stdout (see trace.h):
+	cycles,port,value
+With -j, it writes Chrome trace-event JSON instead, to open in Perfetto
+or chrome://tracing, with the mapping of trace.h (Tools/trace_json.h,
+which the simulation shares). Each event is written as its packet is
+decoded, so memory does not grow with the capture.
+The handlers of TRACE_PORT_POST and TRACE_PORT_RUN are named from the
+symbols of the .elf, if given.
+cycles adds up the local timestamps. A timestamp comes after the
+packets it dates, so packets are held until it arrives. Synchronisation,
+global timestamp, extension and hardware (DWT) packets are skipped.
+Overflow packets, where the ITM lost events, and bytes that are no
+packet are counted on stderr; the exit status is 1 if there were any.
+----------------------------------------------------------------------
+ */
+#include "trace_json.h"
+#include "elf_file.h"
+#include <stdio.h>
+#include <string.h>
+
+#define SWO_PENDING 64U //packets waiting for their timestamp
+
+typedef struct {
+	uint8_t port;
+	uint32_t value;
+} SWO_PacketTypeDef;
+
+static FILE* _SWO_in;
+static uint64_t _SWO_cycles;
+static SWO_PacketTypeDef _SWO_pending[SWO_PENDING];
+static uint32_t _SWO_pendingCount;
+static uint32_t _SWO_overflows;
+static uint32_t _SWO_errors;
+static uint8_t _SWO_json;
+static uint8_t _SWO_elf;
+static TRACEJSON_StateTypeDef _SWO_trace;
+
+static void _SWO_Flush(void){
+	uint32_t i;
+	for(i = 0; i < _SWO_pendingCount; i++){
+		if(_SWO_json) TRACEJSON_Packet(&_SWO_trace, _SWO_cycles, _SWO_pending[i].port, _SWO_pending[i].value);
+		else printf("%llu,%u,%u\n", (unsigned long long)_SWO_cycles, _SWO_pending[i].port, _SWO_pending[i].value);
+	}
+	_SWO_pendingCount = 0;
+}
+
+//Reads the payload bytes of a packet with continuation bits, up to {max}. Returns the 7-bit groups.
+static uint32_t _SWO_Continued(uint8_t max){
+	uint32_t value = 0;
+	uint8_t i;
+	int c;
+	for(i = 0; i < max; i++){
+		if((c = fgetc(_SWO_in)) == EOF) break;
+		value |= (uint32_t)(c & 0x7F) << (7U * i);
+		if((c & 0x80) == 0) break;
+	}
+	return value;
+}
+
+static void _SWO_Source(uint8_t header){
+	static const uint8_t sizes[4] = {0, 1, 2, 4};
+	uint32_t value = 0;
+	uint8_t i;
+	int c;
+	for(i = 0; i < sizes[header & 0x03U]; i++){
+		if((c = fgetc(_SWO_in)) == EOF){
+			_SWO_errors++; //cut at the end of the capture
+			return;
+		}
+		value |= (uint32_t)c << (8U * i);
+	}
+	if(header & 0x04U) return; //hardware source: DWT packets
+	if(_SWO_pendingCount == SWO_PENDING) _SWO_Flush(); //timestamps are off: dated with the last one
+	_SWO_pending[_SWO_pendingCount].port = header >> 3;
+	_SWO_pending[_SWO_pendingCount++].value = value;
+}
+
+int main(int argc, char** argv){
+	uint32_t zeros = 0;
+	int c;
+	_SWO_in = stdin;
+	for(; argc > 1 && argv[1][0] == '-'; argc--, argv++){
+		if(strcmp(argv[1], "-j") == 0){
+			_SWO_json = 1;
+		}else if(strcmp(argv[1], "-e") == 0 && argc > 2 && ELF_Load(argv[2])){
+			_SWO_elf = 1;
+			argc--;
+			argv++;
+		}else{
+			argc = 3; //usage
+			break;
+		}
+	}
+	if(argc > 2){
+		fprintf(stderr, "usage: swo_decode [-j] [-e firmware.elf] [capture]\n");
+		return 2;
+	}
+	if(argc == 2 && (_SWO_in = fopen(argv[1], "rb")) == NULL){
+		perror(argv[1]);
+		return 2;
+	}
+	TRACEJSON_Begin(&_SWO_trace, stdout, _SWO_elf ? ELF_Symbol : NULL);
+	while((c = fgetc(_SWO_in)) != EOF){
+		if(c == 0){ //synchronisation: zeros, then 0x80
+			zeros++;
+			continue;
+		}
+		if(zeros){
+			if(c != 0x80 || zeros < 5U) _SWO_errors++;
+			zeros = 0;
+			if(c == 0x80) continue;
+		}
+		if(c & 0x03){
+			_SWO_Source((uint8_t)c);
+		}else if(c == 0x70){
+			_SWO_overflows++;
+		}else if((c & 0xCF) == 0xC0){ //local timestamp, with payload
+			_SWO_cycles += _SWO_Continued(4);
+			_SWO_Flush();
+		}else if((c & 0x8F) == 0){ //local timestamp in the header, 1 to 6
+			_SWO_cycles += (uint32_t)c >> 4;
+			_SWO_Flush();
+		}else if(c == 0x94 || c == 0xB4){ //global timestamp
+			_SWO_Continued(5);
+		}else if((c & 0x0B) == 0x08){ //extension
+			if(c & 0x80) _SWO_Continued(4);
+		}else{
+			_SWO_errors++;
+		}
+	}
+	_SWO_Flush();
+	if(_SWO_json) TRACEJSON_End(&_SWO_trace);
+	if(_SWO_in != stdin) fclose(_SWO_in);
+	if(_SWO_overflows) fprintf(stderr, "%u overflow(s): the ITM lost events\n", _SWO_overflows);
+	if(_SWO_errors) fprintf(stderr, "%u byte(s) were no packet\n", _SWO_errors);
+	return (_SWO_overflows || _SWO_errors) != 0;
+}
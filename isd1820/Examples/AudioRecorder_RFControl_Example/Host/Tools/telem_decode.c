@@ -0,0 +1,253 @@
+/**
+ * telem_decode.c
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+USART2 stream to CSV
+----------------------------------------------------------------------
+Usage: telem_decode [-e firmware.elf] [capture]
+Reads the bytes captured from USART2 (the file, or stdin) and writes
+one CSV line per frame to stdout (see telemetry.h):
+	tick,type,value0,value1,...
+With the .elf the capture came from, LOG() messages are rebuilt from
+the format strings of its .log_fmt section (see logger.h):
+	tick,log,tick at LOG(),"message"
+type is the record name (driver, fsm, timing, watermark, log,
+histogram), or the type byte in hex for unknown records. Frames with
+no tick leave the first column empty:
+	,text,"printf() output"
+	,reply,cmd,result,status,...   command replies (see uart_cmd.h)
+	,offload,seq,bytes             offload frames, without their bytes
+Frames that do not decode are counted on stderr, and the exit status
+is 1 if there were any.
+----------------------------------------------------------------------
+ */
+#include "telemetry.h"
+#include "uart_cmd.h"
+#include "elf_file.h"
+#include <stdio.h>
+#include <string.h>
+
+#define DECODE_MAX_FRAME   2048U
+#define DECODE_MAX_MESSAGE 512U
+
+static const char* const _DECODE_names[] = {
+	[TELEM_REC_DRIVER - TELEM_REC_DRIVER]    = "driver",
+	[TELEM_REC_FSM - TELEM_REC_DRIVER]       = "fsm",
+	[TELEM_REC_TIMING - TELEM_REC_DRIVER]    = "timing",
+	[TELEM_REC_WATERMARK - TELEM_REC_DRIVER] = "watermark",
+	[TELEM_REC_LOG - TELEM_REC_DRIVER]       = "log",
+	[TELEM_REC_TEXT - TELEM_REC_DRIVER]      = "text",
+	[TELEM_REC_HISTOGRAM - TELEM_REC_DRIVER] = "histogram",
+};
+
+static uint32_t _DECODE_errors;
+static const char* _DECODE_formats; //.log_fmt section of the .elf, NULL without one
+static uint64_t _DECODE_formatsAddr;
+static uint64_t _DECODE_formatsSize;
+
+//Loads the .log_fmt section of the .elf at {path}. Returns 0 on failure.
+static uint8_t _DECODE_LoadElf(const char* path){
+	if(!ELF_Load(path)) return 0;
+	_DECODE_formats = ELF_Section(".log_fmt", &_DECODE_formatsAddr, &_DECODE_formatsSize);
+	return _DECODE_formats != NULL;
+}
+
+//Formats {fmt} as printf() on the target would with the 32-bit {args}. Arguments it cannot show are "?".
+static void _DECODE_Format(char* out, uint32_t size, const char* fmt, const uint32_t* args, uint32_t count){
+	char spec[32];
+	uint32_t n = 0, arg = 0, len, value;
+	while(*fmt && n + 1U < size){
+		if(*fmt != '%'){
+			out[n++] = *fmt++;
+			continue;
+		}
+		if(fmt[1] == '%'){
+			out[n++] = '%';
+			fmt += 2;
+			continue;
+		}
+		len = 0;
+		spec[len++] = *fmt++;
+		while(*fmt && strchr("-+ #0123456789.*", *fmt) && len < sizeof(spec) - 16U){
+			if(*fmt == '*'){ //width or precision from the arguments
+				len += (uint32_t)snprintf(&spec[len], sizeof(spec) - len, "%d", arg < count ? (int32_t)args[arg] : 0);
+				arg++;
+				fmt++;
+				continue;
+			}
+			spec[len++] = *fmt++;
+		}
+		while(*fmt && strchr("hlLqjzt", *fmt)) fmt++; //every argument is 32 bits
+		if(*fmt == 0) break;
+		value = (arg < count) ? args[arg] : 0;
+		spec[len++] = *fmt;
+		spec[len] = 0;
+		if(arg++ >= count || !strchr("diuoxXcp", *fmt)){
+			len = (uint32_t)snprintf(&out[n], size - n, "?"); //%s, %f, or an argument missing
+		}else if(*fmt == 'd' || *fmt == 'i'){
+			len = (uint32_t)snprintf(&out[n], size - n, spec, (int32_t)value);
+		}else if(*fmt == 'c'){
+			len = (uint32_t)snprintf(&out[n], size - n, spec, (int)value);
+		}else if(*fmt == 'p'){
+			len = (uint32_t)snprintf(&out[n], size - n, "0x%08x", value);
+		}else{
+			len = (uint32_t)snprintf(&out[n], size - n, spec, value);
+		}
+		n = (n + len < size) ? n + len : size - 1U;
+		fmt++;
+	}
+	out[n] = 0;
+}
+
+//Decodes the COBS frame in place. Returns its size, or 0 if it is malformed.
+static uint32_t _DECODE_Cobs(uint8_t* frame, uint32_t len){
+	uint32_t read = 0, write = 0, code, i;
+	while(read < len){
+		code = frame[read++];
+		if(read + code - 1U > len) return 0;
+		for(i = 1; i < code; i++) frame[write++] = frame[read++];
+		if(code != 0xFFU && read < len) frame[write++] = 0;
+	}
+	return write;
+}
+
+//Reads the varint at {*pos}. Returns 0 if it runs past {len}.
+static uint8_t _DECODE_Varint(const uint8_t* frame, uint32_t len, uint32_t* pos, uint32_t* value){
+	uint32_t shift = 0;
+	*value = 0;
+	while(*pos < len && shift < 35U){
+		*value |= (uint32_t)(frame[*pos] & 0x7FU) << shift;
+		if((frame[(*pos)++] & 0x80U) == 0) return 1;
+		shift += 7U;
+	}
+	return 0;
+}
+
+static void _DECODE_Quoted(const uint8_t* text, uint32_t len){
+	uint32_t i;
+	putchar('"');
+	for(i = 0; i < len; i++){
+		if(text[i] == '"') fputs("\"\"", stdout);
+		else if(text[i] == '\n') fputs("\\n", stdout);
+		else if(text[i] == '\r') fputs("\\r", stdout);
+		else putchar(text[i]);
+	}
+	fputs("\"\n", stdout);
+}
+
+static void _DECODE_Reply(const uint8_t* frame, uint32_t len){
+	uint32_t status, i;
+	uint16_t seq;
+	if((frame[0] & ~UARTCMD_REPLY) == UARTCMD_OFFLOAD_DATA && len >= 3U + 4U){
+		memcpy(&seq, &frame[1], 2);
+		printf(",offload,%u,%u\n", seq, len - 3U - 4U);
+		return;
+	}
+	if(len < 2U + 4U){
+		_DECODE_errors++;
+		return;
+	}
+	printf(",reply,%u,%u", frame[0] & ~UARTCMD_REPLY, frame[1]);
+	for(i = 2; i + 4U <= len - 4U; i += 4U){ //32-bit little-endian words, then the crc
+		memcpy(&status, &frame[i], 4);
+		printf(",%u", status);
+	}
+	putchar('\n');
+}
+
+//Writes a TELEM_REC_LOG record as its message, if the .elf has the format.
+static uint8_t _DECODE_Log(uint32_t tick, const uint32_t* values, uint32_t count){
+	char message[DECODE_MAX_MESSAGE];
+	if(_DECODE_formats == NULL || count < 2U) return 0;
+	if(values[0] < _DECODE_formatsAddr || values[0] - _DECODE_formatsAddr >= _DECODE_formatsSize) return 0;
+	_DECODE_Format(message, sizeof(message), &_DECODE_formats[values[0] - _DECODE_formatsAddr], &values[2], count - 2U);
+	printf("%u,log,%u,", tick, values[1]);
+	_DECODE_Quoted((const uint8_t*)message, (uint32_t)strlen(message));
+	return 1;
+}
+
+static void _DECODE_Record(const uint8_t* frame, uint32_t len){
+	uint32_t values[TELEM_MAX_VALUES];
+	uint32_t pos = 1, tick, count = 0, i;
+	uint8_t type = frame[0];
+	if(type & UARTCMD_REPLY){
+		_DECODE_Reply(frame, len);
+		return;
+	}
+	if(type == TELEM_REC_TEXT){
+		fputs(",text,", stdout);
+		_DECODE_Quoted(&frame[1], len - 1U);
+		return;
+	}
+	if(!_DECODE_Varint(frame, len, &pos, &tick)){
+		_DECODE_errors++;
+		return;
+	}
+	while(pos < len){
+		if(count == TELEM_MAX_VALUES || !_DECODE_Varint(frame, len, &pos, &values[count])){
+			_DECODE_errors++;
+			return;
+		}
+		count++;
+	}
+	if(type == TELEM_REC_LOG && _DECODE_Log(tick, values, count)) return;
+	if(type >= TELEM_REC_DRIVER && type <= TELEM_REC_HISTOGRAM){
+		printf("%u,%s", tick, _DECODE_names[type - TELEM_REC_DRIVER]);
+	}else{
+		printf("%u,%02x", tick, type);
+	}
+	for(i = 0; i < count; i++) printf(",%u", values[i]);
+	putchar('\n');
+}
+
+int main(int argc, char** argv){
+	static uint8_t frame[DECODE_MAX_FRAME];
+	FILE* in = stdin;
+	uint32_t len = 0;
+	int c;
+	if(argc > 2 && strcmp(argv[1], "-e") == 0){
+		if(!_DECODE_LoadElf(argv[2])){
+			fprintf(stderr, "%s: no .log_fmt section\n", argv[2]);
+			return 2;
+		}
+		argc -= 2;
+		argv += 2;
+	}
+	if(argc > 2){
+		fprintf(stderr, "usage: telem_decode [-e firmware.elf] [capture]\n");
+		return 2;
+	}
+	if(argc == 2 && (in = fopen(argv[1], "rb")) == NULL){
+		perror(argv[1]);
+		return 2;
+	}
+	while((c = fgetc(in)) != EOF){
+		if(c != 0){
+			if(len < DECODE_MAX_FRAME) frame[len] = (uint8_t)c;
+			len++;
+			continue;
+		}
+		if(len > DECODE_MAX_FRAME || (len && (len = _DECODE_Cobs(frame, len)) == 0)){
+			_DECODE_errors++; //too long, or cut by a lost byte
+		}else if(len){
+			_DECODE_Record(frame, len);
+		}
+		len = 0;
+	}
+	if(in != stdin) fclose(in);
+	if(_DECODE_errors) fprintf(stderr, "%u frame(s) did not decode\n", _DECODE_errors);
+	return _DECODE_errors != 0;
+}
@@ -0,0 +1,107 @@
+/**
+ * trace_json.c
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+Chrome trace-event JSON, for swo_decode and the simulation
+----------------------------------------------------------------------
+ */
+#include "trace_json.h"
+#include "trace.h"
+#include "isd1820.h"
+
+void TRACEJSON_Begin(TRACEJSON_StateTypeDef* state, FILE* out, TRACEJSON_NameTypeDef name){
+	state->out = out;
+	state->name = name;
+	state->events = 0;
+	state->pins = 0;
+}
+
+//Name of the handler at {addr}, or its address in hex.
+static const char* _TRACEJSON_Handler(TRACEJSON_StateTypeDef* state, uint32_t addr){
+	static char hex[16];
+	const char* name = state->name ? state->name(addr) : NULL;
+	if(name) return name;
+	snprintf(hex, sizeof(hex), "0x%08x", addr);
+	return hex;
+}
+
+//Starts the next event, with {ph} and {name}: args and the closing brace follow.
+static void _TRACEJSON_Event(TRACEJSON_StateTypeDef* state, uint64_t cycles, const char* ph, const char* name, const char* tid){
+	fprintf(state->out, "%s{\"name\":\"%s\",\"ph\":\"%s\",\"ts\":%.3f,\"pid\":1,\"tid\":\"%s\"",
+			state->events++ ? ",\n" : "[\n", name, ph, (double)cycles / TRACEJSON_CORE_MHZ, tid);
+}
+
+void TRACEJSON_Packet(TRACEJSON_StateTypeDef* state, uint64_t cycles, uint8_t port, uint32_t value){
+	static const char* const names[] = {
+		[TRACE_PORT_COMMAND] = "command",
+		[TRACE_PORT_TIMER]   = "timer",
+		[TRACE_PORT_RF]      = "rf",
+		[TRACE_PORT_DTMF]    = "dtmf",
+	};
+	char name[32];
+	switch(port){
+		case TRACE_PORT_ISR:
+			snprintf(name, sizeof(name), "IRQ %d", (int32_t)value >> 1);
+			_TRACEJSON_Event(state, cycles, (value & 1U) ? "B" : "E", name, "isr");
+			break;
+		case TRACE_PORT_TIM_IRQ:
+			_TRACEJSON_Event(state, cycles, value ? "B" : "E", "async timer", "isr");
+			break;
+		case TRACE_PORT_RUN:
+			_TRACEJSON_Event(state, cycles, value ? "B" : "E", value ? _TRACEJSON_Handler(state, value) : "", "main");
+			break;
+		case TRACE_PORT_POST:
+			_TRACEJSON_Event(state, cycles, "i", "post", "main");
+			fprintf(state->out, ",\"s\":\"t\",\"args\":{\"handler\":\"%s\"}", _TRACEJSON_Handler(state, value));
+			break;
+		case TRACE_PORT_PIN:
+			if((value >> 1) == ISD1820_OP_IDLE) state->pins = 0;
+			else if(value & 1U) state->pins |= (uint8_t)(1U << (value >> 1));
+			else state->pins &= (uint8_t)~(1U << (value >> 1));
+			_TRACEJSON_Event(state, cycles, "C", "pins", "main");
+			fprintf(state->out, ",\"args\":{\"REC\":%u,\"PL\":%u,\"PE\":%u}", (state->pins >> ISD1820_OP_RECORD) & 1U,
+					(state->pins >> ISD1820_OP_PLAY) & 1U, (state->pins >> ISD1820_OP_PLAY_COMPLETE) & 1U);
+			break;
+		case TRACE_PORT_FT:
+			_TRACEJSON_Event(state, cycles, "C", "FT", "main");
+			fprintf(state->out, ",\"args\":{\"FT\":%u}", value);
+			break;
+		default:
+			if(port < sizeof(names) / sizeof(names[0]) && names[port]){
+				_TRACEJSON_Event(state, cycles, "i", names[port], "main");
+			}else{
+				snprintf(name, sizeof(name), "port %u", port);
+				_TRACEJSON_Event(state, cycles, "i", name, "main");
+			}
+			fprintf(state->out, ",\"s\":\"t\",\"args\":{\"value\":%u}", value);
+			break;
+	}
+	fputc('}', state->out);
+}
+
+void TRACEJSON_Span(TRACEJSON_StateTypeDef* state, uint64_t cycles, const char* name, uint8_t begin){
+	_TRACEJSON_Event(state, cycles, begin ? "B" : "E", name, name);
+	fputc('}', state->out);
+}
+
+void TRACEJSON_Counter(TRACEJSON_StateTypeDef* state, uint64_t cycles, const char* name, uint32_t value){
+	_TRACEJSON_Event(state, cycles, "C", name, "main");
+	fprintf(state->out, ",\"args\":{\"%s\":%u}}", name, value);
+}
+
+void TRACEJSON_End(TRACEJSON_StateTypeDef* state){
+	fputs(state->events ? "\n]\n" : "[]\n", state->out);
+}
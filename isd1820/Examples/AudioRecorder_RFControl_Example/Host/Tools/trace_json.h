@@ -0,0 +1,75 @@
+/**
+ * trace_json.h
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+Chrome trace-event JSON, for swo_decode and the simulation
+----------------------------------------------------------------------
+Writes the events of trace.h as Chrome trace-event JSON (Perfetto,
+chrome://tracing), with the mapping given there, each as it comes:
+memory does not grow with the trace. swo_decode -j writes the packets
+of an SWO capture; the HAL simulation (Shim/sim.h) writes the TRACE()
+stores of the firmware run on the host, and its own GPIO edges and
+timer runs with TRACEJSON_Counter() and TRACEJSON_Span().
+----------------------------------------------------------------------
+ */
+#ifndef TRACE_JSON_H
+#define TRACE_JSON_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#define TRACEJSON_CORE_MHZ 84.0 //timestamp clock: ts = cycles / 84 [us]
+
+typedef const char* (*TRACEJSON_NameTypeDef)(uint64_t addr); //function at an address, NULL if unknown
+
+typedef struct {
+	FILE* out;
+	TRACEJSON_NameTypeDef name; //names the handlers of TRACE_PORT_POST and RUN, NULL for hex
+	uint32_t events;            //events written
+	uint8_t pins;               //ISD1820 pin levels: bit n for ISD1820_OP_x n
+} TRACEJSON_StateTypeDef;
+
+void TRACEJSON_Begin(TRACEJSON_StateTypeDef* state, FILE* out, TRACEJSON_NameTypeDef name);
+/**
+ * @brief  Starts a trace on {out}.
+ * @retval None
+ */
+
+void TRACEJSON_Packet(TRACEJSON_StateTypeDef* state, uint64_t cycles, uint8_t port, uint32_t value);
+/**
+ * @brief  Writes the event of a TRACE({port}, {value}) at {cycles}.
+ * @retval None
+ */
+
+void TRACEJSON_Span(TRACEJSON_StateTypeDef* state, uint64_t cycles, const char* name, uint8_t begin);
+/**
+ * @brief  Begins ({begin} 1) or ends span {name} at {cycles}, on its own track.
+ * @retval None
+ */
+
+void TRACEJSON_Counter(TRACEJSON_StateTypeDef* state, uint64_t cycles, const char* name, uint32_t value);
+/**
+ * @brief  Sets counter {name} to {value} at {cycles}.
+ * @retval None
+ */
+
+void TRACEJSON_End(TRACEJSON_StateTypeDef* state);
+/**
+ * @brief  Closes the event array. {out} is left open.
+ * @retval None
+ */
+
+#endif
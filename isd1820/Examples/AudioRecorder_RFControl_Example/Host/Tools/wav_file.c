@@ -0,0 +1,96 @@
+/**
+ * wav_file.c
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+WAV files, for the host tools and simulations
+----------------------------------------------------------------------
+ */
+#include "wav_file.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define WAV_FORMAT_PCM 1U
+
+static uint32_t _WAV_Le(const uint8_t* bytes, uint8_t size){
+	uint32_t value = 0;
+	while(size--) value = (value << 8) | bytes[size];
+	return value;
+}
+
+int16_t* WAV_Read(const char* path, uint32_t* rate, uint32_t* count){
+	FILE* file = fopen(path, "rb");
+	uint8_t header[12], chunk[8], format[16], frame[16 * 2];
+	uint32_t size, channels = 0, bits = 0, frames, i, c;
+	int32_t sum;
+	int16_t* samples;
+	if(file == NULL) return NULL;
+	if(fread(header, 1, 12, file) != 12U || memcmp(header, "RIFF", 4) != 0 || memcmp(&header[8], "WAVE", 4) != 0){
+		fclose(file);
+		return NULL;
+	}
+	while(fread(chunk, 1, 8, file) == 8U){
+		size = _WAV_Le(&chunk[4], 4);
+		if(memcmp(chunk, "fmt ", 4) == 0 && size >= sizeof(format)){
+			if(fread(format, 1, sizeof(format), file) != sizeof(format)) break;
+			fseek(file, (long)(size - sizeof(format) + (size & 1U)), SEEK_CUR);
+			if(_WAV_Le(format, 2) != WAV_FORMAT_PCM) break;
+			channels = _WAV_Le(&format[2], 2);
+			*rate = _WAV_Le(&format[4], 4);
+			bits = _WAV_Le(&format[14], 2);
+			continue;
+		}
+		if(memcmp(chunk, "data", 4) != 0){
+			fseek(file, (long)(size + (size & 1U)), SEEK_CUR);
+			continue;
+		}
+		if(channels == 0 || channels > 16U || (bits != 8U && bits != 16U)) break;
+		frames = size / (channels * bits / 8U);
+		samples = malloc((frames ? frames : 1U) * sizeof(int16_t));
+		for(i = 0; samples && i < frames && fread(frame, bits / 8U, channels, file) == channels; i++){
+			for(sum = 0, c = 0; c < channels; c++){
+				sum += (bits == 8U) ? ((int32_t)frame[c] - 128) << 8 : (int16_t)_WAV_Le(&frame[2U * c], 2);
+			}
+			samples[i] = (int16_t)(sum / (int32_t)channels);
+		}
+		fclose(file);
+		*count = i;
+		return samples;
+	}
+	fclose(file);
+	return NULL;
+}
+
+uint8_t WAV_Write(const char* path, const int16_t* samples, uint32_t count, uint32_t rate){
+	FILE* file = fopen(path, "wb");
+	uint8_t header[44];
+	uint32_t i, bytes = count * 2U;
+	const uint32_t fields[][3] = { //offset, value, size
+		{4, 36U + bytes, 4}, {16, 16, 4}, {20, WAV_FORMAT_PCM, 2}, {22, 1, 2},
+		{24, rate, 4}, {28, rate * 2U, 4}, {32, 2, 2}, {34, 16, 2}, {40, bytes, 4},
+	};
+	if(file == NULL) return 0;
+	memcpy(header, "RIFF....WAVEfmt ....................data", 40);
+	for(i = 0; i < sizeof(fields) / sizeof(fields[0]); i++){
+		memcpy(&header[fields[i][0]], &fields[i][1], fields[i][2]); //little-endian host
+	}
+	fwrite(header, 1, sizeof(header), file);
+	for(i = 0; i < count; i++){
+		fputc(samples[i] & 0xFF, file);
+		fputc((samples[i] >> 8) & 0xFF, file);
+	}
+	return fclose(file) == 0;
+}
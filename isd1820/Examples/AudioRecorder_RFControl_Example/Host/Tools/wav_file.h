@@ -0,0 +1,44 @@
+/**
+ * wav_file.h
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+----------------------------------------------------------------------
+ * Created on: October 19, 2026.
+----------------------------------------------------------------------
+WAV files, for the host tools and simulations
+----------------------------------------------------------------------
+Reads 8 and 16-bit PCM WAV files, any channel count, mixed down to
+mono 16-bit samples. Writes mono 16-bit PCM, the format offload.h
+sends.
+----------------------------------------------------------------------
+ */
+#ifndef WAV_FILE_H
+#define WAV_FILE_H
+
+#include <stdint.h>
+
+int16_t* WAV_Read(const char* path, uint32_t* rate, uint32_t* count);
+/**
+ * @brief  Reads the samples of the WAV file {path}.
+ * @param  rate: Receives the sample rate [Hz].
+ * @param  count: Receives the sample count.
+ * @retval The samples, to free(), or NULL if the file cannot be read or is no PCM WAV.
+ */
+
+uint8_t WAV_Write(const char* path, const int16_t* samples, uint32_t count, uint32_t rate);
+/**
+ * @brief  Writes {count} {samples} at {rate} Hz to the WAV file {path}.
+ * @retval 1, or 0 if the file cannot be written.
+ */
+
+#endif
@@ -58,17 +58,221 @@ https://wiki.keyestudio.com/KS0463_keyestudio_ISD1820_Voice_Recording_and_Playba
 #include "isd1820.h"
 #include "main.h"
 
+#ifndef ISD1820_TRACE
+#define ISD1820_TRACE(event, value) ((void)0)
+#endif
+
 #define FIX_TIMER_TRIGGER(handle_ptr) (__HAL_TIM_CLEAR_FLAG(handle_ptr, TIM_SR_UIF))
 
 TIM_HandleTypeDef* _ISD1280_asyncTimer;
 
-struct {
-	uint8_t FT;
-	uint8_t PL;
-	uint8_t PE;
-	uint8_t REC;
-	uint32_t Counter;
-} _ISD1280_Status;
+#define ISD1820_STATUS_DEADLINE_MAX (ISD1820_STATUS_DEADLINE_Msk >> ISD1820_STATUS_DEADLINE_Pos)
+#define ISD1820_STATUS_ACTIVE_Msk   (ISD1820_STATUS_BUSY | ISD1820_STATUS_OP_Msk | ISD1820_STATUS_GEN_Msk | ISD1820_STATUS_DEADLINE_Msk)
+
+#define ISD1820_ENTER_CRITICAL(primask) do{ (primask) = __get_PRIMASK(); __disable_irq(); }while(0)
+#define ISD1820_EXIT_CRITICAL(primask)  __set_PRIMASK(primask)
+
+static volatile uint32_t _ISD1280_Status;
+static volatile uint32_t _ISD1280_asyncStatus; //status word of the operation owned by the async timer
+static volatile ISD1820_PolicyTypeDef _ISD1280_Policy = ISD1820_POLICY_RECORD_PREEMPTS_PLAY;
+
+static ISD1820_SequenceTypeDef _ISD1280_Sequence;
+
+//SEQ is bumped on every update, GEN only when {start} is 1. Neither is affected by {clear}.
+static uint32_t _ISD1820_StatusUpdate(uint32_t clear, uint32_t set, uint32_t start){
+	uint32_t old, status;
+	do{
+		old = __LDREXW(&_ISD1280_Status);
+		status = (old & ~(clear | ISD1820_STATUS_SEQ_Msk | ISD1820_STATUS_GEN_Msk)) | set
+				| ((old + (1UL << ISD1820_STATUS_SEQ_Pos)) & ISD1820_STATUS_SEQ_Msk)
+				| ((old + (start << ISD1820_STATUS_GEN_Pos)) & ISD1820_STATUS_GEN_Msk);
+	}while(__STREXW(status, &_ISD1280_Status));
+	return status;
+}
+
+static uint32_t _ISD1820_StatusStart(uint32_t op, uint32_t duration){
+	uint32_t deadline = (HAL_GetTick() + duration) & ISD1820_STATUS_DEADLINE_MAX;
+	return _ISD1820_StatusUpdate(ISD1820_STATUS_ACTIVE_Msk,
+			ISD1820_STATUS_BUSY | (op << ISD1820_STATUS_OP_Pos) | (deadline << ISD1820_STATUS_DEADLINE_Pos), 1);
+}
+
+static uint32_t _ISD1820_StatusFinish(void){
+	return _ISD1820_StatusUpdate(ISD1820_STATUS_ACTIVE_Msk, 0, 0);
+}
+
+//Async timer counting frequency [Hz].
+static uint32_t _ISD1820_AsyncTickHz(void){
+	TIM_TypeDef* instance = _ISD1280_asyncTimer->Instance;
+	uint32_t clock;
+	if(instance == TIM1 || instance == TIM8 || instance == TIM9 || instance == TIM10 || instance == TIM11){
+		clock = HAL_RCC_GetPCLK2Freq();
+		if((RCC->CFGR & RCC_CFGR_PPRE2) != RCC_CFGR_PPRE2_DIV1) clock *= 2; //APB2 timers run at 2x PCLK2 when prescaled
+	}else{
+		clock = HAL_RCC_GetPCLK1Freq();
+		if((RCC->CFGR & RCC_CFGR_PPRE1) != RCC_CFGR_PPRE1_DIV1) clock *= 2; //APB1 timers run at 2x PCLK1 when prescaled
+	}
+	return clock / (instance->PSC + 1U);
+}
+
+static uint32_t _ISD1820_AsyncCountsToMs(uint32_t counter){
+	return (uint32_t)(((uint64_t)counter + 1U) * 1000U / _ISD1820_AsyncTickHz());
+}
+
+uint32_t ISD1820_GetStatus(void){
+	return _ISD1280_Status;
+}
+
+uint32_t ISD1820_GetRemaining(uint32_t status){
+	uint32_t remaining;
+	if(!(status & ISD1820_STATUS_BUSY)) return 0;
+	remaining = (ISD1820_STATUS_DEADLINE(status) - HAL_GetTick()) & ISD1820_STATUS_DEADLINE_MAX;
+	if(remaining > (ISD1820_STATUS_DEADLINE_MAX >> 1)) return 0; //deadline already passed
+	return remaining;
+}
+
+static void _ISD1820_WriteOpPin(uint32_t op, GPIO_PinState state){
+	ISD1820_TRACE(ISD1820_TRACE_PIN, (op << 1) | state);
+	switch(op){
+		case ISD1820_OP_RECORD:
+			HAL_GPIO_WritePin(REC_GPIO_Port, REC_Pin, state);
+			break;
+		case ISD1820_OP_PLAY:
+			HAL_GPIO_WritePin(PL_GPIO_Port, PL_Pin, state);
+			break;
+		case ISD1820_OP_PLAY_COMPLETE:
+			HAL_GPIO_WritePin(PE_GPIO_Port, PE_Pin, state);
+			break;
+		default:
+			break;
+	}
+}
+
+static uint8_t _ISD1820_Preempts(uint32_t op, uint32_t running){
+	switch(_ISD1280_Policy){
+		case ISD1820_POLICY_RECORD_PREEMPTS_PLAY:
+			return (op == ISD1820_OP_RECORD) && (running != ISD1820_OP_RECORD);
+		case ISD1820_POLICY_PLAY_REPLACES_PLAY:
+			return running != ISD1820_OP_RECORD; //record preempts play, play replaces play
+		default:
+			return 0;
+	}
+}
+
+//Must be called with interrupts disabled. Stops the async timer and forgets the running sequence.
+static void _ISD1820_StopAsync(void){
+	_ISD1280_Sequence.steps = NULL;
+	if(_ISD1280_asyncStatus){
+		HAL_TIM_Base_Stop_IT(_ISD1280_asyncTimer);
+		FIX_TIMER_TRIGGER(_ISD1280_asyncTimer); //a pending update is then taken as stale
+		_ISD1280_asyncStatus = 0;
+	}
+}
+
+//Must be called with interrupts disabled.
+static void _ISD1820_Abort(void){
+	ISD1820_TRACE(ISD1820_TRACE_PIN, ISD1820_OP_IDLE << 1);
+	HAL_GPIO_WritePin(REC_GPIO_Port, REC_Pin, 0);
+	HAL_GPIO_WritePin(PL_GPIO_Port, PL_Pin, 0);
+	HAL_GPIO_WritePin(PE_GPIO_Port, PE_Pin, 0);
+	_ISD1820_StopAsync();
+}
+
+//Must be called with interrupts disabled. Returns the new status word, or 0 if the policy rejects the request.
+//{preempted} receives the status of the aborted operation, or 0.
+static uint32_t _ISD1820_Claim(uint32_t op, uint32_t duration, uint32_t* preempted){
+	uint32_t status = _ISD1280_Status;
+	*preempted = 0;
+	if(status & ISD1820_STATUS_BUSY){
+		if(!_ISD1820_Preempts(op, ISD1820_STATUS_OP(status))) return 0;
+		_ISD1820_Abort();
+		*preempted = status;
+	}
+	status = _ISD1820_StatusStart(op, duration);
+	ISD1820_TRACE(ISD1820_TRACE_COMMAND, status);
+	return status;
+}
+
+static uint32_t _ISD1820_Begin(uint32_t op, uint32_t duration){
+	uint32_t primask, status, preempted;
+	ISD1820_ENTER_CRITICAL(primask);
+	status = _ISD1820_Claim(op, duration, &preempted);
+	if(status) _ISD1820_WriteOpPin(op, 1);
+	ISD1820_EXIT_CRITICAL(primask);
+	if(preempted) ISD1820_OperationAbortCallback(preempted);
+	return status;
+}
+
+//Ends the operation described by {status}, unless it was cancelled or preempted in the meantime.
+//An async operation ended before its timer (ie. ISD1820_StopRecording()) stops the timer and its sequence.
+static uint8_t _ISD1820_End(uint32_t status){
+	uint32_t primask;
+	uint8_t owner;
+	ISD1820_ENTER_CRITICAL(primask);
+	owner = ((_ISD1280_Status ^ status) & ISD1820_STATUS_ACTIVE_Msk) == 0;
+	if(owner){
+		if(((_ISD1280_asyncStatus ^ status) & ISD1820_STATUS_ACTIVE_Msk) == 0) _ISD1820_StopAsync();
+		_ISD1820_WriteOpPin(ISD1820_STATUS_OP(status), 0);
+		_ISD1820_StatusFinish();
+	}
+	ISD1820_EXIT_CRITICAL(primask);
+	if(owner) ISD1820_OperationCpltCallback(status);
+	return owner;
+}
+
+//Busy-waits {delay} milliseconds. Returns early (0) as soon as the operation is cancelled or preempted.
+static uint8_t _ISD1820_Wait(uint32_t status, uint32_t delay){
+	uint32_t tickstart = HAL_GetTick();
+	while((HAL_GetTick() - tickstart) < delay){
+		if((_ISD1280_Status ^ status) & ISD1820_STATUS_ACTIVE_Msk) return 0;
+	}
+	return 1;
+}
+
+static HAL_StatusTypeDef _ISD1820_BeginAsync(uint32_t op, uint32_t counter){
+	uint32_t primask, status, preempted, duration = _ISD1820_AsyncCountsToMs(counter);
+	HAL_StatusTypeDef result = HAL_BUSY;
+	if(counter == 0) return HAL_ERROR; //with ARR at 0 the timer does not count: no update event would end it
+	ISD1820_ENTER_CRITICAL(primask);
+	status = _ISD1820_Claim(op, duration, &preempted);
+	if(status){
+		FIX_TIMER_TRIGGER(_ISD1280_asyncTimer);
+		__HAL_TIM_SET_AUTORELOAD(_ISD1280_asyncTimer, counter);
+		__HAL_TIM_SET_COUNTER(_ISD1280_asyncTimer, 0);
+		_ISD1280_asyncStatus = status;
+		result = HAL_TIM_Base_Start_IT(_ISD1280_asyncTimer);
+		if(result == HAL_OK){
+			_ISD1820_WriteOpPin(op, 1);
+		}else{ //nothing would end the operation: roll the claim back
+			_ISD1280_asyncStatus = 0;
+			_ISD1820_StatusFinish();
+			result = HAL_ERROR;
+		}
+	}
+	ISD1820_EXIT_CRITICAL(primask);
+	if(preempted) ISD1820_OperationAbortCallback(preempted);
+	return result;
+}
+
+//Starts the next step of the running sequence. Called from the async timer interrupt.
+static void _ISD1820_SequenceNext(void){
+	const ISD1820_StepTypeDef* step;
+	if(_ISD1280_Sequence.steps == NULL) return;
+	if(++_ISD1280_Sequence.index >= _ISD1280_Sequence.count){
+		_ISD1280_Sequence.steps = NULL;
+		return;
+	}
+	step = &_ISD1280_Sequence.steps[_ISD1280_Sequence.index];
+	if(_ISD1820_BeginAsync(step->op, ISD1820_AsyncMsToCounts(step->duration)) != HAL_OK){
+		_ISD1280_Sequence.steps = NULL;
+	}
+}
+
+static HAL_StatusTypeDef _ISD1820_Run(uint32_t op, uint32_t duration){
+	uint32_t status = _ISD1820_Begin(op, duration);
+	if(!status) return HAL_BUSY;
+	_ISD1820_Wait(status, duration);
+	return _ISD1820_End(status) ? HAL_OK : HAL_ERROR;
+}
 
 //HAL_TIM_Base_Start_IT(_ISD1280_asyncTimer);
 //__HAL_TIM_SET_AUTORELOAD(_ISD1280_asyncTimer, counter)
@@ -79,104 +283,163 @@ void ISD1820_AsyncTimerSet(TIM_HandleTypeDef* tim){
 	_ISD1280_asyncTimer = tim;
 }
 
+uint32_t ISD1820_AsyncMsToCounts(uint32_t ms){
+	uint32_t counts = (uint32_t)((uint64_t)ms * _ISD1820_AsyncTickHz() / 1000U);
+	return counts > 2U ? counts - 1U : 1U; //ARR 1, two counts, is the shortest period the timer runs
+}
+
+void ISD1820_SetPolicy(ISD1820_PolicyTypeDef policy){
+	_ISD1280_Policy = policy;
+}
+
+void ISD1820_Cancel(void){
+	uint32_t primask, status;
+	ISD1820_ENTER_CRITICAL(primask);
+	status = _ISD1280_Status;
+	if(status & ISD1820_STATUS_BUSY){
+		_ISD1820_Abort();
+		_ISD1820_StatusFinish();
+	}
+	ISD1820_EXIT_CRITICAL(primask);
+	if(status & ISD1820_STATUS_BUSY) ISD1820_OperationAbortCallback(status);
+}
+
 void ISD1820_ResetPins(void) {
-	HAL_GPIO_WritePin(REC_GPIO_Port, REC_Pin, 0);
-	HAL_GPIO_WritePin(PL_GPIO_Port, PL_Pin, 0);
-	HAL_GPIO_WritePin(PE_GPIO_Port, PE_Pin, 0);
+	uint32_t primask, status;
+	ISD1820_ENTER_CRITICAL(primask);
+	status = _ISD1280_Status;
+	_ISD1820_Abort();
 	HAL_GPIO_WritePin(FT_GPIO_Port, FT_Pin, 0);
-	_ISD1280_Status.FT = 0;
-	_ISD1280_Status.PL = 0;
-	_ISD1280_Status.PE = 0;
-	_ISD1280_Status.REC = 0;
+	_ISD1820_StatusUpdate(ISD1820_STATUS_ACTIVE_Msk | ISD1820_STATUS_FT, 0, 0);
+	ISD1820_EXIT_CRITICAL(primask);
+	if(status & ISD1820_STATUS_BUSY) ISD1820_OperationAbortCallback(status);
 }
 
 void ISD1820_AsyncInit(TIM_HandleTypeDef* tim) {
-	ISD1820_AsyncTimerSet(_ISD1280_asyncTimer);
+	ISD1820_AsyncTimerSet(tim);
 	ISD1820_ResetPins();
 }
 
-void ISD1820_RecordAsync(uint32_t counter){
-	FIX_TIMER_TRIGGER(_ISD1280_asyncTimer);
-	__HAL_TIM_SET_AUTORELOAD(_ISD1280_asyncTimer, counter);
-	_ISD1280_Status.REC = 1;
-	__HAL_TIM_SET_COUNTER(_ISD1280_asyncTimer, 0);
-	HAL_TIM_Base_Start_IT(_ISD1280_asyncTimer);
-	HAL_GPIO_WritePin(REC_GPIO_Port, REC_Pin, 1);
+HAL_StatusTypeDef ISD1820_RecordAsync(uint32_t counter){
+	return _ISD1820_BeginAsync(ISD1820_OP_RECORD, counter);
 }
 
-void ISD1820_PlayAsync(uint32_t counter){
-	FIX_TIMER_TRIGGER(_ISD1280_asyncTimer);
-	__HAL_TIM_SET_AUTORELOAD(_ISD1280_asyncTimer, counter);
-	_ISD1280_Status.PL = 1;
-	__HAL_TIM_SET_COUNTER(_ISD1280_asyncTimer, 0);
-	HAL_TIM_Base_Start_IT(_ISD1280_asyncTimer);
-	HAL_GPIO_WritePin(PL_GPIO_Port, PL_Pin, 1);
+HAL_StatusTypeDef ISD1820_PlayAsync(uint32_t counter){
+	return _ISD1820_BeginAsync(ISD1820_OP_PLAY, counter);
+}
+
+HAL_StatusTypeDef ISD1820_SequenceStart(const ISD1820_StepTypeDef* steps, uint8_t count){
+	uint32_t primask;
+	HAL_StatusTypeDef result;
+	if(count == 0) return HAL_ERROR;
+	ISD1820_ENTER_CRITICAL(primask);
+	result = _ISD1820_BeginAsync(steps[0].op, ISD1820_AsyncMsToCounts(steps[0].duration));
+	if(result == HAL_OK){
+		_ISD1280_Sequence.count = count;
+		_ISD1280_Sequence.index = 0;
+		_ISD1280_Sequence.steps = steps;
+	}
+	ISD1820_EXIT_CRITICAL(primask);
+	return result;
+}
+
+uint8_t ISD1820_SequenceActive(void){
+	return _ISD1280_Sequence.steps != NULL;
 }
 
 void ISD1820_AsyncTimHandler(void){
-	HAL_GPIO_WritePin(REC_GPIO_Port, REC_Pin, 0);
-	HAL_GPIO_WritePin(PL_GPIO_Port, PL_Pin, 0);
-//	HAL_GPIO_WritePin(PE_GPIO_Port, PE_Pin, 0);
-//	HAL_GPIO_WritePin(FT_GPIO_Port, FT_Pin, 0);
-	_ISD1280_Status.PL = 0;
-	_ISD1280_Status.REC = 0;
-//	_ISD1280_Status.PE = 0;
-//	_ISD1280_Status.FT = 0;
+	uint32_t status = _ISD1280_asyncStatus;
+	if(!status) return; //stale update event of a cancelled operation
+	ISD1820_TRACE(ISD1820_TRACE_TIMER, status);
+	_ISD1280_asyncStatus = 0;
 	HAL_TIM_Base_Stop_IT(_ISD1280_asyncTimer);
 	__HAL_TIM_SET_COUNTER(_ISD1280_asyncTimer, 0);
+	if(_ISD1820_End(status)) _ISD1820_SequenceNext();
 }
 
-void ISD1820_StartRecording(void){
-	HAL_GPIO_WritePin(REC_GPIO_Port, REC_Pin, 1);
+#ifdef ISD1820_TIM_IRQHandler
+void ISD1820_TIM_IRQHandler(void){
+	TIM_TypeDef* instance = _ISD1280_asyncTimer->Instance;
+	ISD1820_TRACE(ISD1820_TRACE_IRQ, 1);
+	if(instance->SR & TIM_SR_UIF){
+		instance->SR = ~TIM_SR_UIF;
+		ISD1820_AsyncTimHandler();
+	}
+	ISD1820_TRACE(ISD1820_TRACE_IRQ, 0);
+}
+#endif
+
+HAL_StatusTypeDef ISD1820_StartRecording(void){
+	return _ISD1820_Begin(ISD1820_OP_RECORD, 0) ? HAL_OK : HAL_BUSY;
 }
 
 void ISD1820_StopRecording(void){
-	HAL_GPIO_WritePin(REC_GPIO_Port, REC_Pin, 0);
+	uint32_t status = _ISD1280_Status;
+	if(ISD1820_STATUS_OP(status) == ISD1820_OP_RECORD){
+		_ISD1820_End(status);
+	}else{
+		HAL_GPIO_WritePin(REC_GPIO_Port, REC_Pin, 0);
+	}
 }
 
-void ISD1820_StartPlaying(void){
-	HAL_GPIO_WritePin(PL_GPIO_Port, PL_Pin, 1);
+HAL_StatusTypeDef ISD1820_StartPlaying(void){
+	return _ISD1820_Begin(ISD1820_OP_PLAY, 0) ? HAL_OK : HAL_BUSY;
 }
 
 void ISD1820_StopPlaying(void){
-	HAL_GPIO_WritePin(PL_GPIO_Port, PL_Pin, 0);
+	uint32_t status = _ISD1280_Status;
+	if(ISD1820_STATUS_OP(status) == ISD1820_OP_PLAY){
+		_ISD1820_End(status);
+	}else{
+		HAL_GPIO_WritePin(PL_GPIO_Port, PL_Pin, 0);
+	}
 }
 
-void ISD1820_Record(uint16_t rec_time){
-	HAL_GPIO_WritePin(REC_GPIO_Port, REC_Pin, 1);
-	HAL_Delay(rec_time);
-	HAL_GPIO_WritePin(REC_GPIO_Port, REC_Pin, 0);
+HAL_StatusTypeDef ISD1820_Record(uint16_t rec_time){
+	return _ISD1820_Run(ISD1820_OP_RECORD, rec_time);
 }
 
-void ISD1820_PlayComplete(void){
-	HAL_GPIO_WritePin(PE_GPIO_Port, PE_Pin, 1);
-	HAL_Delay(100);
-	HAL_GPIO_WritePin(PE_GPIO_Port, PE_Pin, 0);
+HAL_StatusTypeDef ISD1820_PlayComplete(void){
+	return _ISD1820_Run(ISD1820_OP_PLAY_COMPLETE, 100);
 }
 
-void ISD1820_Play(uint16_t play_time){
-	HAL_GPIO_WritePin(PL_GPIO_Port, PL_Pin, 1);
-	HAL_Delay(play_time);
-	HAL_GPIO_WritePin(PL_GPIO_Port, PL_Pin, 0);
+HAL_StatusTypeDef ISD1820_Play(uint16_t play_time){
+	return _ISD1820_Run(ISD1820_OP_PLAY, play_time);
 }
 
-void ISD1820_RecordAndPlay(uint16_t rec_time, uint16_t play_time){
+HAL_StatusTypeDef ISD1820_RecordAndPlay(uint16_t rec_time, uint16_t play_time){
+	HAL_StatusTypeDef result;
 	//Record:
-	HAL_GPIO_WritePin(REC_GPIO_Port, REC_Pin, 1);
-	HAL_Delay(rec_time);
-	HAL_GPIO_WritePin(REC_GPIO_Port, REC_Pin, 0);
+	result = _ISD1820_Run(ISD1820_OP_RECORD, rec_time);
+	if(result != HAL_OK) return result;
 	HAL_Delay(100);
 	//---
 	//Play:
-	HAL_GPIO_WritePin(PL_GPIO_Port, PL_Pin, 1);
-	HAL_Delay(play_time);
-	HAL_GPIO_WritePin(PL_GPIO_Port, PL_Pin, 0);
+	return _ISD1820_Run(ISD1820_OP_PLAY, play_time);
 	//---
 }
 void ISD1820_EnableFeedThrough(void){
 	HAL_GPIO_WritePin(FT_GPIO_Port, FT_Pin, 1);
+	ISD1820_TRACE(ISD1820_TRACE_FT, 1);
+	_ISD1820_StatusUpdate(0, ISD1820_STATUS_FT, 0);
 }
 
 void ISD1820_DisableFeedThrough(void){
 	HAL_GPIO_WritePin(FT_GPIO_Port, FT_Pin, 0);
+	ISD1820_TRACE(ISD1820_TRACE_FT, 0);
+	_ISD1820_StatusUpdate(ISD1820_STATUS_FT, 0, 0);
+}
+
+__weak void ISD1820_OperationCpltCallback(uint32_t status){
+	/* Prevent unused argument(s) compilation warning */
+	UNUSED(status);
+	/* NOTE : This function should not be modified, when the callback is needed,
+	          ISD1820_OperationCpltCallback could be implemented in the user file */
+}
+
+__weak void ISD1820_OperationAbortCallback(uint32_t status){
+	/* Prevent unused argument(s) compilation warning */
+	UNUSED(status);
+	/* NOTE : This function should not be modified, when the callback is needed,
+	          ISD1820_OperationAbortCallback could be implemented in the user file */
 }
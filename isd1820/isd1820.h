@@ -60,28 +60,178 @@ https://wiki.keyestudio.com/KS0463_keyestudio_ISD1820_Voice_Recording_and_Playba
 
 /* C++ detection */
 #ifdef __cplusplus
-extern C {
+extern "C" {
 #endif
 
 #include "stm32f4xx_hal.h"
 
+/* Lean async timer interrupt:
+ * Define ISD1820_TIM_IRQHandler as the vector name of the async timer (ie. #define ISD1820_TIM_IRQHandler TIM5_IRQHandler in main.h)
+ * to let the driver own that interrupt. The driver handler only checks the update flag (UIF) and goes straight to
+ * ISD1820_AsyncTimHandler(), skipping the capture/compare/trigger/break checks done by HAL_TIM_IRQHandler.
+ * In that case the IRQ handler must not be generated in stm32f4xx_it.c.
+ */
+
+/* Trace hooks:
+ * Define ISD1820_TRACE(event, value) (ie. in main.h) to observe the driver from the inside, ie. with ITM stores.
+ * It is expanded inline in the driver, sometimes with interrupts disabled, so it must be a few cycles at most.
+ * It expands to nothing by default.
+ */
+#define ISD1820_TRACE_COMMAND 0U //value: status word of the operation just started
+#define ISD1820_TRACE_PIN     1U //value: ISD1820_OP_x << 1 | level (ISD1820_OP_IDLE: REC, PL and PE released)
+#define ISD1820_TRACE_TIMER   2U //value: status word of the operation ended by the async timer
+#define ISD1820_TRACE_FT      3U //value: feed through level
+#define ISD1820_TRACE_IRQ     4U //value: 1 on async timer interrupt entry, 0 on exit (ISD1820_TIM_IRQHandler only)
+
+/* Driver status word:
+ * The whole driver state is kept in one 32-bit word, only ever modified with LDREX/STREX, so a single load
+ * (ISD1820_GetStatus()) gives a consistent snapshot from thread or interrupt context without locking.
+ *	bit  0     BUSY: a record/play operation is running.
+ *	bit  1     FT: feed through is enabled.
+ *	bits 2-3   OP: current operation (ISD1820_OP_x).
+ *	bits 4-8   SEQ: incremented on every status change.
+ *	bits 9-13  GEN: incremented on every operation start, so two operations with the same op and deadline differ.
+ *	bits 14-31 DEADLINE: low 18 bits of the HAL tick [ms] at which the running operation ends (131s ahead at most).
+ * An operation is identified by BUSY, OP, GEN and DEADLINE (SEQ also moves with feed through changes).
+ */
+#define ISD1820_STATUS_BUSY_Pos      0U
+#define ISD1820_STATUS_BUSY          (0x1UL << ISD1820_STATUS_BUSY_Pos)
+#define ISD1820_STATUS_FT_Pos        1U
+#define ISD1820_STATUS_FT            (0x1UL << ISD1820_STATUS_FT_Pos)
+#define ISD1820_STATUS_OP_Pos        2U
+#define ISD1820_STATUS_OP_Msk        (0x3UL << ISD1820_STATUS_OP_Pos)
+#define ISD1820_STATUS_SEQ_Pos       4U
+#define ISD1820_STATUS_SEQ_Msk       (0x1FUL << ISD1820_STATUS_SEQ_Pos)
+#define ISD1820_STATUS_GEN_Pos       9U
+#define ISD1820_STATUS_GEN_Msk       (0x1FUL << ISD1820_STATUS_GEN_Pos)
+#define ISD1820_STATUS_DEADLINE_Pos  14U
+#define ISD1820_STATUS_DEADLINE_Msk  (0x3FFFFUL << ISD1820_STATUS_DEADLINE_Pos)
+
+#define ISD1820_OP_IDLE          0U
+#define ISD1820_OP_RECORD        1U
+#define ISD1820_OP_PLAY          2U
+#define ISD1820_OP_PLAY_COMPLETE 3U
+
+#define ISD1820_STATUS_OP(status)       (((status) & ISD1820_STATUS_OP_Msk) >> ISD1820_STATUS_OP_Pos)
+#define ISD1820_STATUS_SEQ(status)      (((status) & ISD1820_STATUS_SEQ_Msk) >> ISD1820_STATUS_SEQ_Pos)
+#define ISD1820_STATUS_GEN(status)      (((status) & ISD1820_STATUS_GEN_Msk) >> ISD1820_STATUS_GEN_Pos)
+#define ISD1820_STATUS_DEADLINE(status) (((status) & ISD1820_STATUS_DEADLINE_Msk) >> ISD1820_STATUS_DEADLINE_Pos)
+
+uint32_t ISD1820_GetStatus(void);
+/**
+ * @brief  Returns a snapshot of the driver status word. Lock-free, callable from any context.
+ * @retval Status word (see ISD1820_STATUS_x).
+ */
+
+uint32_t ISD1820_GetRemaining(uint32_t status);
+/**
+ * @brief  Computes the time left on the operation described by a status snapshot.
+ * @param  status: Status word returned by ISD1820_GetStatus().
+ * @retval Remaining time [milliseconds], 0 if idle or the deadline has passed.
+ */
+
+/* Preemption policies:
+ * Decide what happens when an operation is requested while another one is running. A preempted or cancelled
+ * operation has its pins released right away (interrupts are only masked for a handful of register writes), and
+ * a blocking call waiting on it returns HAL_ERROR on its next poll.
+ */
+typedef enum {
+	ISD1820_POLICY_RECORD_PREEMPTS_PLAY = 0, //Record aborts a running play. Anything else is rejected while busy. Default.
+	ISD1820_POLICY_PLAY_REPLACES_PLAY,       //As above, and a new play also aborts a running play.
+	ISD1820_POLICY_REJECT_IF_BUSY            //Every request is rejected while busy.
+} ISD1820_PolicyTypeDef;
+
+void ISD1820_SetPolicy(ISD1820_PolicyTypeDef policy);
+/**
+ * @brief  Selects how new requests interact with a running operation.
+ * @param  policy: One of ISD1820_POLICY_x.
+ * @retval None
+ */
+
+void ISD1820_Cancel(void);
+/**
+ * @brief  Aborts the running operation (blocking or async) and releases REC, PL and PE. Safe to call from an ISR.
+ * @retval None
+ */
+
 void ISD1820_AsyncTimerSet(TIM_HandleTypeDef* tim);
 
 void ISD1820_ResetPins(void);
 
 void ISD1820_AsyncInit(TIM_HandleTypeDef* tim);
 
-void ISD1820_RecordAsync(uint32_t counter);
+HAL_StatusTypeDef ISD1820_RecordAsync(uint32_t counter);
+/**
+ * @brief  Starts recording and returns. The async timer interrupt releases REC after {counter}+1 timer counts.
+ * @note   Ending it early (ie. ISD1820_StopRecording()) also stops the async timer.
+ * @retval HAL_OK, HAL_BUSY if rejected by the preemption policy, or HAL_ERROR if {counter} is 0 (the timer would
+ *         not count) or the async timer fails to start.
+ */
 
-void ISD1820_PlayAsync(uint32_t counter);
+HAL_StatusTypeDef ISD1820_PlayAsync(uint32_t counter);
+/**
+ * @brief  Starts playing and returns. The async timer interrupt releases PL after {counter}+1 timer counts.
+ * @note   Ending it early (ie. ISD1820_StopPlaying()) also stops the async timer.
+ * @retval HAL_OK, HAL_BUSY if rejected by the preemption policy, or HAL_ERROR if {counter} is 0 (the timer would
+ *         not count) or the async timer fails to start.
+ */
+
+uint32_t ISD1820_AsyncMsToCounts(uint32_t ms);
+/**
+ * @brief  Converts a duration to the {counter} argument of the async functions, from the async timer clock and prescaler.
+ * @param  ms: Duration [milliseconds].
+ * @retval Async timer counter value, at least 1: durations under two timer counts, 0 included, last two counts.
+ */
+
+/* Sequences:
+ * A sequence is a table of steps run back to back on the async timer, ie. record 10s, wait 100ms, play 8s:
+ *	static const ISD1820_StepTypeDef record_and_play[] = {
+ *		{ISD1820_OP_RECORD, 10000}, {ISD1820_OP_IDLE, 100}, {ISD1820_OP_PLAY, 8000}
+ *	};
+ *	ISD1820_SequenceStart(record_and_play, 3);
+ * Each step is started from the timer interrupt that ends the previous one, so the flow needs no polling and no
+ * heap: the table can live in flash and the driver only keeps a pointer and two indexes. An ISD1820_OP_IDLE step
+ * is a pause, 0ms included (two timer counts). Cancelling, preempting or stopping (ie. ISD1820_StopPlaying()) any
+ * step drops the rest of the sequence.
+ * Steps run in table order only: a flow that branches or waits on a condition (ie. play again if a key is held)
+ * cannot be written as a step table, and is run from the completion callback instead.
+ */
+typedef struct {
+	uint32_t op;       //ISD1820_OP_RECORD, ISD1820_OP_PLAY, ISD1820_OP_PLAY_COMPLETE (PE held for duration) or ISD1820_OP_IDLE (pause)
+	uint32_t duration; //[milliseconds]
+} ISD1820_StepTypeDef;
+
+typedef struct {
+	const ISD1820_StepTypeDef* volatile steps; //NULL when no sequence is running
+	uint8_t count;
+	uint8_t index;
+} ISD1820_SequenceTypeDef; //what the driver keeps of a running sequence, the whole of its state
+
+HAL_StatusTypeDef ISD1820_SequenceStart(const ISD1820_StepTypeDef* steps, uint8_t count);
+/**
+ * @brief  Starts running {count} steps from {steps} on the async timer. {steps} must stay valid until the sequence ends.
+ * @retval HAL_OK, HAL_BUSY if the first step is rejected by the preemption policy, or HAL_ERROR if {count} is 0
+ *         or the async timer fails to start.
+ */
+
+uint8_t ISD1820_SequenceActive(void);
+/**
+ * @brief  Tells whether a sequence is still running.
+ * @retval 1 if a sequence is running, 0 otherwise.
+ */
 
 void ISD1820_AsyncTimHandler(void);
+/**
+ * @brief  Ends the running asynchronous operation. Call it from HAL_TIM_PeriodElapsedCallback() for the async timer,
+ *         unless ISD1820_TIM_IRQHandler is defined (the driver calls it from the timer interrupt itself).
+ * @retval None
+ */
 
-void ISD1820_StartRecording(void);
+HAL_StatusTypeDef ISD1820_StartRecording(void);
 /**
  * @brief  Starts recording audio using ISD1820 chip by setting REC_Pin to high until Pin is set to low or ISD1820_StopRecording is called or time limit is reached.
  * @note   Recording takes precedence over Playing. The recording time limit depends on the resistance of resistor R4. For R4=100k, the limit is 10 seconds.
- * @retval None
+ * @retval HAL_OK, or HAL_BUSY if rejected by the preemption policy.
  */
 
 void ISD1820_StopRecording(void);
@@ -91,11 +241,11 @@ void ISD1820_StopRecording(void);
  * @retval None
  */
 
-void ISD1820_StartPlaying(void);
+HAL_StatusTypeDef ISD1820_StartPlaying(void);
 /**
  * @brief  Starts playing audio using ISD1820 chip by setting PL_Pin to high.
  * @note   If not stopped by other means (ie. ISD1820_StopPlaying()), plays until the end of the record.
- * @retval None
+ * @retval HAL_OK, or HAL_BUSY if rejected by the preemption policy.
  */
 
 void ISD1820_StopPlaying(void);
@@ -104,36 +254,36 @@ void ISD1820_StopPlaying(void);
  * @retval None
  */
 
-void ISD1820_Record(uint16_t rec_time);
+HAL_StatusTypeDef ISD1820_Record(uint16_t rec_time);
 /**
  * @brief  Records audio using ISD1820 chip. It records a total of {rec_time} milliseconds.
  * @note   The recording time limit depends on the resistance of resistor R4. For R4=100k, the limit is 10 seconds.
  * @param  rec_time: Recording time required [milliseconds].
- * @retval None
+ * @retval HAL_OK, HAL_BUSY if rejected by the preemption policy, or HAL_ERROR if cancelled or preempted.
  */
 
-void ISD1820_PlayComplete(void);
+HAL_StatusTypeDef ISD1820_PlayComplete(void);
 /**
  * @brief  Plays audio stored on EEPROM to the end.
- * @retval None
+ * @retval HAL_OK, HAL_BUSY if rejected by the preemption policy, or HAL_ERROR if cancelled or preempted.
  */
 
-void ISD1820_Play(uint16_t play_time);
+HAL_StatusTypeDef ISD1820_Play(uint16_t play_time);
 /**
  * @brief  Plays audio stored on EEPROM up to {play_time} milliseconds.
  * @note   If the audio stored has less than {play_time} milliseconds
  * @param  rec_time: Recording time required [milliseconds].
  * @param  play_time: Play time [milliseconds].
- * @retval None
+ * @retval HAL_OK, HAL_BUSY if rejected by the preemption policy, or HAL_ERROR if cancelled or preempted.
  */
 
-void ISD1820_RecordAndPlay(uint16_t rec_time, uint16_t play_time);
+HAL_StatusTypeDef ISD1820_RecordAndPlay(uint16_t rec_time, uint16_t play_time);
 /**
  * @brief  Records audio using ISD1820 chip and then play it back. It records a total of [rec_time] milliseconds.
  * @note   The recording time limit depends on the resistance of resistor R4. For R4=100k, the limit is 10 seconds.
  * @param  rec_time: Recording time required [milliseconds].
  * @param  play_time: Play time [milliseconds].
- * @retval None
+ * @retval HAL_OK, HAL_BUSY if rejected by the preemption policy, or HAL_ERROR if cancelled or preempted.
  */
 
 void ISD1820_EnableFeedThrough(void);
@@ -148,6 +298,22 @@ void ISD1820_DisableFeedThrough(void);
  * @retval None
  */
 
+void ISD1820_OperationCpltCallback(uint32_t status);
+/**
+ * @brief  Called when a record/play operation reaches its end. Weak, to be implemented by the application.
+ * @note   Runs in the async timer interrupt for async operations and in the caller's context for blocking ones.
+ * @param  status: Status word of the operation that ended.
+ * @retval None
+ */
+
+void ISD1820_OperationAbortCallback(uint32_t status);
+/**
+ * @brief  Called when a record/play operation is cancelled or preempted. Weak, to be implemented by the application.
+ * @note   Runs in the context that called ISD1820_Cancel() or requested the preempting operation.
+ * @param  status: Status word of the operation that was aborted.
+ * @retval None
+ */
+
 /* C++ detection */
 #ifdef __cplusplus
 }